@@ -0,0 +1,162 @@
+/**
+ * @file auth_bench.cpp
+ * @brief Benchmark nativo: costo de FrameAuth por trama (env:native_auth_bench)
+ *
+ * Sella con FrameAuth::seal() y abre con FrameAuth::open() (otra instancia,
+ * con la sesión abierta por un saludo y su control de repeticiones) los dos payloads grandes del protocolo:
+ * el lote atmosférico crudo (48 bytes) y GroundGpsPacket (30 bytes). Informa
+ * nanosegundos por trama y, en x86, ciclos del TSC. Antes verifica el vector
+ * de prueba de RFC 8439 (2.8.2) para no medir una implementación rota.
+ *
+ * El costo en el ESP8266 lo da el comando 'a' por consola del gateway
+ * (AppLogic::benchmarkAuth(), con ESP.getCycleCount()). Aquí se agrega lo
+ * que los 8 bytes del sello cuestan en tiempo en el aire (DutyCycle).
+ *
+ * @example
+ * ```
+ * pio run -e native_auth_bench
+ * .pio/build/native_auth_bench/program --iterations 200000
+ * ```
+ */
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+#include <chrono>
+#include "config.h"
+#include "protocol.h"
+#include "frame_auth.h"
+#include "duty_cycle.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#endif
+
+namespace {
+
+    const uint8_t MESH_HEADER_LEN = RH_RF95_HEADER_LEN + 5 + 1;  ///< Como en RadioManager
+    const uint8_t NETWORK_KEY[FrameAuth::KEY_LEN] = AUTH_NETWORK_KEY;
+
+    /** RFC 8439, 2.8.2: AEAD con la frase de "sunscreen". */
+    bool rfcVectorOk()
+    {
+        uint8_t key[FrameAuth::KEY_LEN];
+        for (uint8_t i = 0; i < sizeof(key); i++) {
+            key[i] = (uint8_t)(0x80 + i);
+        }
+        const uint8_t nonce[FrameAuth::NONCE_LEN] = {0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+        const uint8_t aad[] = {0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7};
+        const uint8_t expectedTag[16] = {0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+                                         0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91};
+        const char *plain = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the "
+                            "future, sunscreen would be it.";
+        uint8_t data[128];
+        size_t len = strlen(plain);
+        memcpy(data, plain, len);
+        uint8_t tag[16];
+        FrameAuth::encrypt(key, nonce, aad, sizeof(aad), data, len, tag);
+        if (data[0] != 0xd3 || data[1] != 0x1a || memcmp(tag, expectedTag, sizeof(tag)) != 0) {
+            return false;
+        }
+        return FrameAuth::decrypt(key, nonce, aad, sizeof(aad), data, len, tag, sizeof(tag)) &&
+               memcmp(data, plain, len) == 0;
+    }
+
+    /** Marca de tiempo en ciclos del TSC (0 fuera de x86). */
+    inline uint64_t ticks()
+    {
+#ifdef BENCH_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /** Sesión de receiver con sender (0x12 -> 0x01) como la abren los saludos de RadioManager. */
+    bool handshake(FrameAuth &sender, FrameAuth &receiver)
+    {
+        uint8_t greeting[FrameAuth::GREETING_OVERHEAD];
+        uint32_t challenge;
+        receiver.requestSession(0x12);
+        uint8_t len = receiver.sealGreeting(0x01, 0x12, Protocol::HELLO, greeting, 0, 0);
+        if (sender.openGreeting(0x01, 0x12, Protocol::HELLO, greeting, len, challenge) != FrameAuth::STALE) {
+            return false;
+        }
+        len = sender.sealGreeting(0x12, 0x01, Protocol::HELLO, greeting, 0, challenge);
+        return receiver.openGreeting(0x12, 0x01, Protocol::HELLO, greeting, len, challenge) == FrameAuth::OK;
+    }
+
+    /** Costo medio de sellar y abrir una trama de len bytes. */
+    void measure(const char *name, uint8_t len, uint32_t iterations)
+    {
+        FrameAuth sender(NETWORK_KEY, AUTH_COUNTER_BLOCK);
+        FrameAuth receiver(NETWORK_KEY, AUTH_COUNTER_BLOCK);
+        uint8_t frame[RX_QUEUE_FRAME_LEN];
+        double sealNs = 0;
+        double openNs = 0;
+        uint64_t sealTicks = 0;
+        uint64_t openTicks = 0;
+        uint32_t failures = handshake(sender, receiver) ? 0 : iterations;
+
+        for (uint32_t i = 0; i < iterations; i++) {
+            for (uint8_t b = 0; b < len; b++) {
+                frame[b] = (uint8_t)(i + b);
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            uint64_t k0 = ticks();
+            uint8_t sealedLen = sender.seal(0x12, 0x01, Protocol::DATA_ATMOSPHERIC, frame, len);
+            uint64_t k1 = ticks();
+            auto t1 = std::chrono::steady_clock::now();
+            FrameAuth::Result result = receiver.open(0x12, 0x01, Protocol::DATA_ATMOSPHERIC, frame, sealedLen);
+            uint64_t k2 = ticks();
+            auto t2 = std::chrono::steady_clock::now();
+            if (result != FrameAuth::OK || sealedLen != len || frame[len - 1] != (uint8_t)(i + len - 1)) {
+                failures++;
+            }
+            sealNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            openNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+            sealTicks += k1 - k0;
+            openTicks += k2 - k1;
+        }
+
+        const Protocol::RadioProfile &fast = Protocol::RADIO_PROFILES[Protocol::RADIO_PROFILE_DEFAULT];
+        const Protocol::RadioProfile &slow = Protocol::RADIO_PROFILES[0];
+        uint32_t fastPlain = DutyCycle::timeOnAirUs(MESH_HEADER_LEN + len, fast.spreadingFactor, fast.bandwidthKhz);
+        uint32_t fastSealed = DutyCycle::timeOnAirUs(MESH_HEADER_LEN + len + FrameAuth::OVERHEAD, fast.spreadingFactor,
+                                                     fast.bandwidthKhz);
+        uint32_t slowPlain = DutyCycle::timeOnAirUs(MESH_HEADER_LEN + len, slow.spreadingFactor, slow.bandwidthKhz);
+        uint32_t slowSealed = DutyCycle::timeOnAirUs(MESH_HEADER_LEN + len + FrameAuth::OVERHEAD, slow.spreadingFactor,
+                                                     slow.bandwidthKhz);
+
+        printf("%-22s %4u %9.0f %9.0f %10.0f %10.0f %8.1f%% %8.1f%% %6u\n", name, len, sealNs / iterations,
+               openNs / iterations, (double)sealTicks / iterations, (double)openTicks / iterations,
+               100.0 * (fastSealed - fastPlain) / fastPlain, 100.0 * (slowSealed - slowPlain) / slowPlain, failures);
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 200000;
+    if (argc == 3 && strcmp(argv[1], "--iterations") == 0) {
+        iterations = strtoul(argv[2], nullptr, 10);
+    } else if (argc != 1) {
+        printf("Uso: %s [--iterations N]\n", argv[0]);
+        return 1;
+    }
+    if (!rfcVectorOk()) {
+        printf("ChaCha20-Poly1305 no reproduce el vector de RFC 8439\n");
+        return 1;
+    }
+    printf("Vector de RFC 8439 2.8.2: OK\n");
+    printf("Sello: %u bytes (contador %u + tag %u)\n\n", (unsigned)FrameAuth::OVERHEAD,
+           (unsigned)FrameAuth::COUNTER_LEN, (unsigned)FrameAuth::TAG_LEN);
+
+    const Protocol::RadioProfile &slow = Protocol::RADIO_PROFILES[0];
+    printf("%-22s %4s %9s %9s %10s %10s %9s %9s %6s\n", "payload", "B", "sellar_ns", "abrir_ns", "sellar_tsc",
+           "abrir_tsc", "aire_SF7", "aire_SF12", "fallas");
+    measure("atmosferico crudo", sizeof(Protocol::AtmosphericSample) * NUMERO_MUESTRAS_ATMOSFERICAS, iterations);
+    measure("suelo/GPS", sizeof(Protocol::GroundGpsPacket), iterations);
+    printf("\n(aire: tiempo en el aire extra por el sello a SF7/125 kHz y SF%u/%u kHz)\n", slow.spreadingFactor,
+           slow.bandwidthKhz);
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file json_bench.cpp
+ * @brief Benchmark nativo: payloads MQTT con String contra JsonWriter (env:native_bench)
+ *
+ * Arma los mismos mensajes que publica el gateway de dos formas:
+ * - String: el código que usaba AppLogic antes de JsonWriter (una
+ *   publicación por muestra atmosférica, concatenación con String(float)).
+ * - JsonWriter: tablas de telemetry_schema.h sobre un char[] (un nodo con
+ *   todas sus muestras, como publishAtmosphericData()).
+ *
+ * Por cada variante informa mensajes/s, bytes/s y reservas de heap por
+ * mensaje (contadas con HeapTracker). El String del shim usa std::string,
+ * que no reserva para cadenas de hasta 15 bytes: las reservas de la
+ * variante String son un piso de las del ESP8266.
+ *
+ * @example
+ * ```
+ * pio run -e native_bench
+ * .pio/build/native_bench/program --iterations 200000
+ * ```
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include "config.h"
+#include "protocol.h"
+#include "json_writer.h"
+#include "telemetry_schema.h"
+#include "heap_tracker.h"
+
+namespace {
+
+    /** Resultado de una variante. */
+    struct Result {
+        double seconds;
+        uint64_t bytes;
+        uint32_t messages;
+        uint32_t allocs;
+    };
+
+    // ===== Variante String (código anterior de AppLogic) =====
+
+    String legacyAtmospheric(uint8_t nodeId, const Protocol::AtmosphericSample &data)
+    {
+        String payload = "{";
+        payload += "\"nodeId\":" + String(nodeId);
+        payload += ",\"temperature\":" + String(data.temp / 10.0, 1);
+        payload += ",\"moisture\":" + String(data.moisture / 10.0, 1);
+        payload += "}";
+        return payload;
+    }
+
+    String legacyGround(uint8_t nodeId, const Protocol::GroundGpsPacket &data)
+    {
+        String payload = "{";
+        payload += "\"nodeId\":" + String(nodeId);
+        payload += ",\"temperature\":" + String(data.ground.temp / 10.0, 1);
+        payload += ",\"moisture\":" + String(data.ground.moisture / 10.0, 1);
+        payload += ",\"n\":" + String(data.ground.n);
+        payload += ",\"p\":" + String(data.ground.p);
+        payload += ",\"k\":" + String(data.ground.k);
+        payload += ",\"ec\":" + String(data.ground.EC);
+        payload += ",\"ph\":" + String(data.ground.PH / 10.0, 1);
+        payload += ",\"volt\":3.33";
+        payload += ",\"latitude\":" + String(data.gps.latitude, 7);
+        payload += ",\"longitude\":" + String(data.gps.longitude, 7);
+        payload += "}";
+        return payload;
+    }
+
+    // ===== Variante JsonWriter (código actual) =====
+
+    size_t writerAtmosphericNode(JsonWriter &json, uint8_t nodeId, const Protocol::AtmosphericSample *samples)
+    {
+        json.reset();
+        json.beginArray().beginObject().fixed("nodeId", nodeId).beginArray("samples");
+        for (uint8_t i = 0; i < NUMERO_MUESTRAS_ATMOSFERICAS; i++) {
+            json.beginObject()
+                .fields(&samples[i], Telemetry::ATMOSPHERIC_FIELDS, Telemetry::ATMOSPHERIC_FIELD_COUNT)
+                .endObject();
+        }
+        json.endArray().endObject().endArray();
+        return json.ok() ? json.length() : 0;
+    }
+
+    size_t writerGround(JsonWriter &json, uint8_t nodeId, const Protocol::GroundGpsPacket &data)
+    {
+        json.reset();
+        json.beginObject()
+            .fixed("nodeId", nodeId)
+            .fields(&data, Telemetry::GROUND_FIELDS, Telemetry::GROUND_FIELD_COUNT)
+            .endObject();
+        return json.ok() ? json.length() : 0;
+    }
+
+    // ===== Datos de prueba =====
+
+    void fillSamples(Protocol::AtmosphericSample *samples, uint32_t seed)
+    {
+        for (uint8_t i = 0; i < NUMERO_MUESTRAS_ATMOSFERICAS; i++) {
+            samples[i].temp = (int16_t)((int32_t)((seed + i * 37) % 1200) - 400);
+            samples[i].moisture = (uint16_t)((seed + i * 53) % 1001);
+            samples[i].hour = (uint8_t)((seed / 60 + i) % 24);
+            samples[i].minute = (uint8_t)((seed + i * 5) % 60);
+        }
+    }
+
+    void fillGround(Protocol::GroundGpsPacket &p, uint32_t seed)
+    {
+        memset(&p, 0, sizeof(p));
+        p.ground.temp = (int16_t)((int32_t)(seed % 1200) - 400);
+        p.ground.moisture = (uint16_t)(seed % 1001);
+        p.ground.n = (uint16_t)(seed % 2000);
+        p.ground.p = (uint16_t)((seed * 3) % 2000);
+        p.ground.k = (uint16_t)((seed * 7) % 2000);
+        p.ground.EC = (uint16_t)((seed * 11) % 20001);
+        p.ground.PH = (uint8_t)(30 + seed % 61);
+        p.gps.latitude = -345678901 + (int32_t)(seed % 1000);
+        p.gps.longitude = -581234567 - (int32_t)(seed % 1000);
+        p.energy.volt = (uint16_t)(330 + seed % 90);
+    }
+
+    template <typename Fn>
+    Result run(uint32_t iterations, Fn build)
+    {
+        Result r = {0, 0, 0, 0};
+        uint32_t allocsBefore = HeapTracker::stats().allocs;
+        auto start = std::chrono::steady_clock::now();
+        {
+            HeapTracker::Scope tracked(true);
+            for (uint32_t i = 0; i < iterations; i++) {
+                r.messages += build(i, r.bytes);
+            }
+        }
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        r.allocs = HeapTracker::stats().allocs - allocsBefore;
+        return r;
+    }
+
+    void report(const char *name, const Result &r)
+    {
+        printf("%-26s %9u %12.0f %10.2f %10.1f %12.2f\n", name, r.messages,
+               r.messages / r.seconds, r.bytes / r.seconds / 1e6,
+               r.messages ? (double)r.bytes / r.messages : 0.0,
+               r.messages ? (double)r.allocs / r.messages : 0.0);
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 200000;
+    if (argc == 3 && strcmp(argv[1], "--iterations") == 0) {
+        iterations = strtoul(argv[2], nullptr, 10);
+    } else if (argc != 1) {
+        printf("Uso: %s [--iterations N]\n", argv[0]);
+        return 1;
+    }
+
+    char buffer[MQTT_BUFFER_SIZE];
+    JsonWriter json(buffer, sizeof(buffer));
+    Protocol::AtmosphericSample samples[NUMERO_MUESTRAS_ATMOSFERICAS];
+    Protocol::GroundGpsPacket ground;
+
+    fillSamples(samples, 7);
+    fillGround(ground, 7);
+    printf("Ejemplo String (atmosférico, 1 muestra): %s\n", legacyAtmospheric(0x42, samples[0]).c_str());
+    writerAtmosphericNode(json, 0x42, samples);
+    printf("Ejemplo JsonWriter (atmosférico, 1 nodo): %.120s...\n", json.c_str());
+    printf("Ejemplo String (suelo): %s\n", legacyGround(0x42, ground).c_str());
+    writerGround(json, 0x42, ground);
+    printf("Ejemplo JsonWriter (suelo): %s\n\n", json.c_str());
+
+    printf("%-26s %9s %12s %10s %10s %12s\n", "variante", "mensajes", "mensajes/s", "MB/s", "B/mensaje", "reservas/msg");
+
+    // Atmosférico: el String publicaba una vez por muestra; JsonWriter una vez por nodo
+    report("atmosferico String", run(iterations, [&](uint32_t i, uint64_t &bytes) {
+        fillSamples(samples, i);
+        for (uint8_t s = 0; s < NUMERO_MUESTRAS_ATMOSFERICAS; s++) {
+            bytes += legacyAtmospheric((uint8_t)i, samples[s]).length();
+        }
+        return (uint32_t)NUMERO_MUESTRAS_ATMOSFERICAS;
+    }));
+    report("atmosferico JsonWriter", run(iterations, [&](uint32_t i, uint64_t &bytes) {
+        fillSamples(samples, i);
+        bytes += writerAtmosphericNode(json, (uint8_t)i, samples);
+        return 1u;
+    }));
+    report("suelo String", run(iterations, [&](uint32_t i, uint64_t &bytes) {
+        fillGround(ground, i);
+        bytes += legacyGround((uint8_t)i, ground).length();
+        return 1u;
+    }));
+    report("suelo JsonWriter", run(iterations, [&](uint32_t i, uint64_t &bytes) {
+        fillGround(ground, i);
+        bytes += writerGround(json, (uint8_t)i, ground);
+        return 1u;
+    }));
+    return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file heap_tracker.cpp
+ * @brief operator new/delete con contabilidad para la simulación nativa
+ */
+
+#include "heap_tracker.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+    /** Cabecera antepuesta a cada bloque para conocer su tamaño al liberar. */
+    struct alignas(16) BlockHeader {
+        size_t size;
+        bool tracked;
+    };
+
+    HeapTracker::Stats counters = {0, 0, 0, 0};
+    bool tracking = false;
+
+    void *allocate(size_t size)
+    {
+        BlockHeader *hdr = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+        if (hdr == nullptr) {
+            throw std::bad_alloc();
+        }
+        hdr->size = size;
+        hdr->tracked = tracking;
+        if (tracking) {
+            counters.inUse += size;
+            counters.allocs++;
+            if (counters.inUse > counters.peak) {
+                counters.peak = counters.inUse;
+            }
+        }
+        return hdr + 1;
+    }
+
+    void release(void *ptr)
+    {
+        if (ptr == nullptr) {
+            return;
+        }
+        BlockHeader *hdr = static_cast<BlockHeader *>(ptr) - 1;
+        if (hdr->tracked) {
+            counters.inUse -= hdr->size;
+            counters.frees++;
+        }
+        std::free(hdr);
+    }
+
+} // namespace
+
+namespace HeapTracker {
+
+    Scope::Scope(bool track) : previous(tracking)
+    {
+        tracking = track;
+    }
+
+    Scope::~Scope()
+    {
+        tracking = previous;
+    }
+
+    const Stats &stats()
+    {
+        return counters;
+    }
+
+} // namespace HeapTracker
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *ptr) noexcept { release(ptr); }
+void operator delete[](void *ptr) noexcept { release(ptr); }
+void operator delete(void *ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { release(ptr); }
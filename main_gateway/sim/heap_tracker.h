@@ -0,0 +1,52 @@
+/**
+ * @file heap_tracker.h
+ * @brief Contabilidad del heap usado por el firmware durante la simulación
+ *
+ * Reemplaza operator new/delete globales. Solo se contabilizan las reservas
+ * hechas mientras el firmware está "en ejecución" (HeapTracker::Scope); la
+ * memoria del simulador (red virtual, colas de eventos) queda fuera.
+ */
+
+#ifndef SIM_HEAP_TRACKER_H
+#define SIM_HEAP_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @def SIM_HEAP_BYTES
+ * @brief Heap libre típico de un ESP8266 con WiFi + PubSubClient al arrancar.
+ */
+#ifndef SIM_HEAP_BYTES
+#define SIM_HEAP_BYTES 45000
+#endif
+
+namespace HeapTracker {
+
+    /**
+     * @struct Stats
+     * @brief Métricas de uso de heap del firmware.
+     */
+    struct Stats {
+        size_t inUse;        ///< Bytes reservados actualmente
+        size_t peak;         ///< Máximo de bytes reservados
+        uint32_t allocs;     ///< Reservas totales
+        uint32_t frees;      ///< Liberaciones totales
+    };
+
+    /**
+     * @brief Activa o pausa la contabilidad (anidable)
+     */
+    class Scope {
+    public:
+        explicit Scope(bool track);
+        ~Scope();
+    private:
+        bool previous;
+    };
+
+    const Stats &stats();
+
+} // namespace HeapTracker
+
+#endif // SIM_HEAP_TRACKER_H
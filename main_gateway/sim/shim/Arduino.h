@@ -0,0 +1,172 @@
+/**
+ * @file Arduino.h
+ * @brief Shim mínimo del core Arduino/ESP8266 para compilar el gateway en Linux (env:native)
+ *
+ * Solo implementa lo que usan los fuentes de main_gateway/src. El tiempo es
+ * virtual: millis() devuelve el reloj de la simulación y delay() lo avanza,
+ * de modo que las esperas del firmware no consumen tiempo real.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <string>
+#include <array>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x00
+#define OUTPUT 0x01
+
+#define HEX 16
+#define DEC 10
+
+#define F(x) (x)
+#define PROGMEM
+
+// ===== Reloj virtual =====
+
+namespace SimClock {
+    /** @brief Tiempo virtual actual en milisegundos */
+    unsigned long now();
+    /** @brief Avanza el reloj virtual */
+    void advance(unsigned long ms);
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// ===== String =====
+
+/**
+ * @class String
+ * @brief Subconjunto de la clase String de Arduino respaldado por std::string.
+ *
+ * Reserva memoria en el heap igual que la original, así las mediciones de
+ * heap de la simulación reflejan el costo real de concatenar Strings.
+ */
+class String
+{
+public:
+    String(const char *cstr = "");
+    String(const char *cstr, unsigned int length);
+    String(const String &other) = default;
+    String &operator=(const String &other) = default;
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+
+    unsigned int length() const { return s.length(); }
+    const char *c_str() const { return s.c_str(); }
+    void reserve(unsigned int size) { s.reserve(size); }
+
+    String &operator+=(const String &rhs) { s += rhs.s; return *this; }
+    String &operator+=(const char *rhs) { s += rhs; return *this; }
+    String &operator+=(char c) { s += c; return *this; }
+
+    bool operator==(const String &rhs) const { return s == rhs.s; }
+    bool operator==(const char *rhs) const { return s == rhs; }
+    bool operator!=(const String &rhs) const { return s != rhs.s; }
+    bool operator!=(const char *rhs) const { return s != rhs; }
+
+    int indexOf(char c) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    long toInt() const;
+    void toCharArray(char *buf, unsigned int bufsize) const;
+
+    friend String operator+(const String &lhs, const String &rhs);
+    friend String operator+(const String &lhs, const char *rhs);
+    friend String operator+(const char *lhs, const String &rhs);
+
+private:
+    std::string s;
+};
+
+// ===== Serial =====
+
+/**
+ * @class SimSerial
+ * @brief Salida serie del firmware; se descarta salvo que la simulación esté en modo verbose.
+ */
+class SimSerial
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char *s);
+    size_t print(const String &s) { return print(s.c_str()); }
+    size_t print(char c);
+    size_t print(int v, int base = DEC);
+    size_t print(unsigned int v, int base = DEC);
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(double v, int digits = 2);
+    size_t println();
+    template <typename T>
+    size_t println(const T &v) { size_t n = print(v); return n + println(); }
+    template <typename T>
+    size_t println(const T &v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() {}
+
+    /** @brief Habilita/inhabilita la salida por stdout */
+    void setEnabled(bool on) { enabled = on; }
+
+private:
+    bool enabled = false;
+};
+
+extern SimSerial Serial;
+
+// ===== ESP =====
+
+/**
+ * @class SimEsp
+ * @brief Sustituto del objeto ESP con un heap virtual del tamaño del ESP8266.
+ */
+class SimEsp
+{
+public:
+    uint32_t getFreeHeap();
+    uint32_t getSketchSize() { return 0; }
+    uint32_t getFreeSketchSpace() { return 0; }
+    /** Nanosegundos del reloj real del host: los "ciclos" de una CPU de 1 GHz. */
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return 1000; }
+    void restart();
+};
+
+extern SimEsp ESP;
+
+#endif // SIM_ARDUINO_H
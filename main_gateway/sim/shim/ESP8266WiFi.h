@@ -0,0 +1,87 @@
+/**
+ * @file ESP8266WiFi.h
+ * @brief Shim de ESP8266WiFi para la simulación nativa
+ *
+ * La conexión WiFi se considera inmediata; SimWiFi::setAvailable() permite
+ * simular caídas del enlace. Los eventos GotIP y Disconnected se disparan
+ * en el momento, dentro de begin(), disconnect() y setAvailable().
+ */
+
+#ifndef SIM_ESP8266WIFI_H
+#define SIM_ESP8266WIFI_H
+
+#include "Arduino.h"
+#include <functional>
+#include <memory>
+
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 };
+
+class IPAddress
+{
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    String toString() const;
+    uint8_t operator[](int index) const { return octets[index]; }
+private:
+    uint8_t octets[4];
+};
+
+/** Eventos de estación del core ESP8266 (solo los campos usados). */
+struct WiFiEventStationModeGotIP {
+    IPAddress ip;
+};
+
+struct WiFiEventStationModeDisconnected {
+    uint8_t reason;
+};
+
+/** En el core es un shared_ptr opaco: el evento queda registrado mientras exista. */
+struct WiFiEventHandlerOpaque;
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+class SimWiFi
+{
+public:
+    bool mode(WiFiMode_t m) { currentMode = m; return true; }
+    wl_status_t begin();
+    wl_status_t begin(const char *ssid, const char *passphrase);
+    bool disconnect(bool wifioff = false);
+    void persistent(bool on) { (void)on; }
+    bool setAutoReconnect(bool on) { (void)on; return true; }
+    WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP &)> f);
+    WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected &)> f);
+    wl_status_t status() const { return connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    String macAddress() const;
+    IPAddress localIP() const;
+
+    /** @brief Define si el punto de acceso está disponible (por defecto sí) */
+    void setAvailable(bool on);
+    /** @brief Define la MAC que devuelve macAddress() */
+    void setMac(const char *mac) { strncpy(mac_, mac, sizeof(mac_) - 1); }
+
+private:
+    WiFiMode_t currentMode = WIFI_OFF;
+    bool connected = false;
+    bool available = true;
+    std::function<void(const WiFiEventStationModeGotIP &)> gotIpEvent;
+    std::function<void(const WiFiEventStationModeDisconnected &)> disconnectedEvent;
+
+    void notifyDisconnected(uint8_t reason);
+    char mac_[18] = "5C:CF:7F:00:00:01";
+};
+
+extern SimWiFi WiFi;
+
+/**
+ * @class WiFiClient
+ * @brief Cliente TCP vacío; PubSubClient solo necesita la referencia.
+ */
+class WiFiClient
+{
+public:
+    bool connected() const { return WiFi.status() == WL_CONNECTED; }
+    void setTimeout(unsigned long ms) { (void)ms; }
+};
+
+#endif // SIM_ESP8266WIFI_H
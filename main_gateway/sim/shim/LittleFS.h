@@ -0,0 +1,61 @@
+/**
+ * @file LittleFS.h
+ * @brief Shim de LittleFS en memoria para la simulación nativa
+ *
+ * Los archivos viven en RAM del host durante la corrida; no se cuentan en el
+ * heap del firmware. Cubre lo que usa src/: begin, format, exists, remove,
+ * open ("r", "r+", "w", "w+", "a") y File con read/write/seek/size/flush.
+ */
+
+#ifndef SIM_LITTLEFS_H
+#define SIM_LITTLEFS_H
+
+#include "Arduino.h"
+#include <memory>
+#include <vector>
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class File
+{
+public:
+    File() = default;
+    File(std::shared_ptr<std::vector<uint8_t>> data, size_t pos, bool writable)
+        : data(data), pos(pos), writable(writable) {}
+
+    explicit operator bool() const { return data != nullptr; }
+    size_t read(uint8_t *buf, size_t len);
+    size_t write(const uint8_t *buf, size_t len);
+    bool seek(uint32_t offset, SeekMode mode = SeekSet);
+    size_t position() const { return pos; }
+    size_t size() const { return data ? data->size() : 0; }
+    void flush() {}
+    void close() { data.reset(); }
+
+private:
+    std::shared_ptr<std::vector<uint8_t>> data;
+    size_t pos = 0;
+    bool writable = false;
+};
+
+class LittleFSClass
+{
+public:
+    bool begin();
+    void end() {}
+    bool format();
+    bool exists(const char *path);
+    bool remove(const char *path);
+    File open(const char *path, const char *mode);
+
+    /** @brief Simula un sistema de archivos que no monta (para probar la cola deshabilitada) */
+    static void setAvailable(bool on);
+};
+
+extern LittleFSClass LittleFS;
+
+#endif // SIM_LITTLEFS_H
@@ -0,0 +1,65 @@
+/**
+ * @file PubSubClient.h
+ * @brief Shim de PubSubClient que cuenta publicaciones en lugar de enviarlas
+ */
+
+#ifndef SIM_PUBSUBCLIENT_H
+#define SIM_PUBSUBCLIENT_H
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+
+#ifndef MQTT_MAX_PACKET_SIZE
+#define MQTT_MAX_PACKET_SIZE 256
+#endif
+
+/** Cabecera fija + longitud del tópico que PubSubClient antepone al payload. */
+#define MQTT_MAX_HEADER_SIZE 5
+
+class PubSubClient
+{
+public:
+    /**
+     * @struct Stats
+     * @brief Contadores globales de tráfico MQTT de la simulación.
+     */
+    struct Stats {
+        uint32_t connects;
+        uint32_t publishes;
+        uint32_t failed;
+        uint32_t payloadBytes;
+    };
+
+    explicit PubSubClient(WiFiClient &client) : client(&client) {}
+    PubSubClient &setClient(WiFiClient &c) { client = &c; return *this; }
+    PubSubClient &setServer(const char *domain, uint16_t port) { (void)domain; (void)port; return *this; }
+    bool setBufferSize(uint16_t size) { bufferSize = size; return true; }
+    uint16_t getBufferSize() const { return bufferSize; }
+    PubSubClient &setSocketTimeout(uint16_t seconds) { (void)seconds; return *this; }
+    bool connect(const char *id);
+    bool connected() const;
+    void disconnect() { isConnected = false; }
+    bool publish(const char *topic, const char *payload);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int plength);
+    /** @brief Publicación por partes: sin límite de buffer, el largo se declara antes */
+    bool beginPublish(const char *topic, unsigned int plength, bool retained);
+    size_t write(uint8_t b) { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size);
+    int endPublish();
+    bool loop() { return connected(); }
+    int state() const { return connected() ? 0 : -1; }
+
+    static const Stats &stats();
+    /** @brief Define si el broker está disponible (por defecto sí); al caer se cortan las sesiones */
+    static void setBrokerAvailable(bool on);
+
+private:
+    WiFiClient *client;
+    bool isConnected = false;
+    uint16_t bufferSize = MQTT_MAX_PACKET_SIZE;
+    bool streaming = false;       ///< Hay un beginPublish() abierto
+    unsigned int streamExpected = 0;
+    unsigned int streamWritten = 0;
+};
+
+#endif // SIM_PUBSUBCLIENT_H
@@ -0,0 +1,83 @@
+/**
+ * @file RHMesh.h
+ * @brief RHMesh falso para la simulación nativa
+ *
+ * Mantiene la misma firma que RadioHead para que radio_manager.cpp compile sin
+ * cambios. Los envíos y recepciones se resuelven en VirtualNetwork con reloj
+ * virtual: sendtoWait() consume el tiempo de aire del primer salto (y el
+ * descubrimiento de ruta si no hay ruta conocida), igual que la librería real.
+ * La tabla de rutas de RHRouter vive en VirtualNetwork.
+ */
+
+#ifndef SIM_RHMESH_H
+#define SIM_RHMESH_H
+
+#include "Arduino.h"
+#include "RH_RF95.h"
+
+#define RH_DEFAULT_TIMEOUT 200
+#define RH_DEFAULT_RETRIES 3
+#define RH_MESH_ARP_TIMEOUT 4000
+#define RH_ROUTING_TABLE_SIZE 10
+
+#define RH_ROUTER_ERROR_NONE              0
+#define RH_ROUTER_ERROR_INVALID_LENGTH    1
+#define RH_ROUTER_ERROR_NO_ROUTE          2
+#define RH_ROUTER_ERROR_TIMEOUT           3
+#define RH_ROUTER_ERROR_NO_REPLY          4
+#define RH_ROUTER_ERROR_UNABLE_TO_DELIVER 5
+
+#define RH_MAX_MESSAGE_LEN 255
+#define RH_ROUTER_MAX_MESSAGE_LEN (RH_MAX_MESSAGE_LEN - 5)
+#define RH_MESH_MAX_MESSAGE_LEN (RH_ROUTER_MAX_MESSAGE_LEN - 1)
+
+class RHRouter
+{
+public:
+    typedef enum {
+        Invalid = 0,
+        Discovering,
+        Valid
+    } RouteState;
+
+    typedef struct {
+        uint8_t dest;
+        uint8_t next_hop;
+        uint8_t state;
+    } RoutingTableEntry;
+
+    void addRouteTo(uint8_t dest, uint8_t next_hop, uint8_t state = Valid);
+    RoutingTableEntry *getRouteTo(uint8_t dest);
+    bool deleteRouteTo(uint8_t dest);
+    void clearRoutingTable();
+};
+
+class RHMesh : public RHRouter
+{
+public:
+    RHMesh(RH_RF95 &driver, uint8_t thisAddress = 0) : driver(&driver), address(thisAddress) {}
+    virtual ~RHMesh() = default;
+    bool init() { clearRoutingTable(); return driver->init(); }
+    uint8_t thisAddress() const { return address; }
+    void setThisAddress(uint8_t addr) { address = addr; }
+    void setTimeout(uint16_t timeout) { (void)timeout; }
+    void setRetries(uint8_t retries) { (void)retries; }
+    uint32_t retransmissions();
+    bool available();
+
+    uint8_t sendtoWait(uint8_t *buf, uint8_t len, uint8_t dest, uint8_t flags = 0);
+    bool recvfromAck(uint8_t *buf, uint8_t *len, uint8_t *source = nullptr, uint8_t *dest = nullptr,
+                     uint8_t *id = nullptr, uint8_t *flags = nullptr, uint8_t *hops = nullptr);
+    bool recvfromAckTimeout(uint8_t *buf, uint8_t *len, uint16_t timeout, uint8_t *source = nullptr,
+                            uint8_t *dest = nullptr, uint8_t *id = nullptr, uint8_t *flags = nullptr,
+                            uint8_t *hops = nullptr);
+
+protected:
+    virtual bool doArp(uint8_t address);
+
+private:
+    RH_RF95 *driver;
+    uint8_t address;
+};
+
+#endif // SIM_RHMESH_H
@@ -0,0 +1,56 @@
+/**
+ * @file RH_RF95.h
+ * @brief Driver RH_RF95 falso para la simulación nativa
+ *
+ * Solo guarda la configuración del módem y se la informa a VirtualNetwork,
+ * que modela el canal.
+ */
+
+#ifndef SIM_RH_RF95_H
+#define SIM_RH_RF95_H
+
+#include "Arduino.h"
+
+#define RH_BROADCAST_ADDRESS 0xff
+#define RH_RF95_HEADER_LEN 4
+#define RH_RF95_MAX_MESSAGE_LEN (255 - RH_RF95_HEADER_LEN)
+
+class RH_RF95
+{
+public:
+    typedef enum {
+        Bw125Cr45Sf128 = 0, ///< Bw = 125 kHz, Cr = 4/5, Sf = 128chips/symbol, CRC on
+        Bw500Cr45Sf128,     ///< Bw = 500 kHz, Cr = 4/5, Sf = 128chips/symbol, CRC on
+        Bw31_25Cr48Sf512,   ///< Bw = 31.25 kHz, Cr = 4/8, Sf = 512chips/symbol, CRC on
+        Bw125Cr48Sf4096,    ///< Bw = 125 kHz, Cr = 4/8, Sf = 4096chips/symbol, CRC on
+        Bw125Cr45Sf2048,    ///< Bw = 125 kHz, Cr = 4/5, Sf = 2048chips/symbol, CRC on
+    } ModemConfigChoice;
+
+    RH_RF95(uint8_t slaveSelectPin = 10, uint8_t interruptPin = 2) { (void)slaveSelectPin; (void)interruptPin; }
+    bool init() { return true; }
+    bool sleep() { return true; }
+    bool setFrequency(float centre) { (void)centre; return true; }
+    bool setModemConfig(ModemConfigChoice index);
+    void setTxPower(int8_t power, bool useRFO = false);
+    void setSpreadingFactor(uint8_t sf);
+    void setSignalBandwidth(long sbw);
+    void setCodingRate4(uint8_t denominator) { codingRate4 = denominator; }
+    int16_t lastRssi();
+    int lastSNR();
+
+    uint8_t getSpreadingFactor() const { return spreadingFactor; }
+    long getSignalBandwidth() const { return bandwidth; }
+    uint8_t getCodingRate4() const { return codingRate4; }
+    int8_t getTxPower() const { return txPower; }
+
+private:
+    uint8_t spreadingFactor = 7;
+    long bandwidth = 125000;
+    uint8_t codingRate4 = 5;
+    int8_t txPower = 13;
+
+    /** Informa la configuración a VirtualNetwork (el gateway es el único RH_RF95 real). */
+    void publishModem();
+};
+
+#endif // SIM_RH_RF95_H
@@ -0,0 +1,46 @@
+/**
+ * @file RTClib.h
+ * @brief Shim de RTClib (DS1307) derivado del reloj virtual de la simulación
+ */
+
+#ifndef SIM_RTCLIB_H
+#define SIM_RTCLIB_H
+
+#include "Arduino.h"
+
+class DateTime
+{
+public:
+    DateTime(uint32_t unixtime = 946684800UL);
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+    DateTime(const char *date, const char *time);
+    uint16_t year() const { return y; }
+    uint8_t month() const { return m; }
+    uint8_t day() const { return d; }
+    uint8_t hour() const { return hh; }
+    uint8_t minute() const { return mm; }
+    uint8_t second() const { return ss; }
+    uint32_t unixtime() const;
+private:
+    uint16_t y;
+    uint8_t m, d, hh, mm, ss;
+};
+
+/**
+ * @class RTC_DS1307
+ * @brief DS1307 virtual: la hora avanza con millis() desde el último adjust().
+ */
+class RTC_DS1307
+{
+public:
+    bool begin() { return true; }
+    bool isrunning() const { return running; }
+    void adjust(const DateTime &dt);
+    DateTime now() const;
+private:
+    bool running = true;
+    uint32_t baseUnix = 1735732800UL; // 2025-01-01 12:00:00
+    unsigned long baseMillis = 0;
+};
+
+#endif // SIM_RTCLIB_H
@@ -0,0 +1,19 @@
+/**
+ * @file SPI.h
+ * @brief Shim vacío de SPI (la radio es virtual)
+ */
+
+#ifndef SIM_SPI_H
+#define SIM_SPI_H
+
+#include "Arduino.h"
+
+class SPIClass
+{
+public:
+    void begin() {}
+};
+
+extern SPIClass SPI;
+
+#endif // SIM_SPI_H
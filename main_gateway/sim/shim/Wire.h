@@ -0,0 +1,24 @@
+/**
+ * @file Wire.h
+ * @brief Shim de I2C: todas las direcciones responden (DS1307 presente)
+ */
+
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire
+{
+public:
+    void begin() {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t addr) { lastAddr = addr; }
+    uint8_t endTransmission() { return lastAddr == 0x68 ? 0 : 2; }
+private:
+    uint8_t lastAddr = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
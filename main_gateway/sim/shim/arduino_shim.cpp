@@ -0,0 +1,179 @@
+/**
+ * @file arduino_shim.cpp
+ * @brief Implementación del shim Arduino para la simulación nativa
+ */
+
+#include "Arduino.h"
+#include "../heap_tracker.h"
+
+#include <chrono>
+#include <random>
+
+SimSerial Serial;
+SimEsp ESP;
+
+namespace {
+    unsigned long clockMs = 0;
+    std::mt19937 arduinoRng(1);
+
+    std::string toBase(unsigned long value, unsigned char base, bool negative)
+    {
+        if (base < 2 || base > 36) {
+            base = 10;
+        }
+        char tmp[72];
+        int pos = sizeof(tmp) - 1;
+        tmp[pos] = '\0';
+        do {
+            unsigned digit = value % base;
+            tmp[--pos] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            value /= base;
+        } while (value != 0 && pos > 1);
+        if (negative) {
+            tmp[--pos] = '-';
+        }
+        return std::string(&tmp[pos]);
+    }
+
+    std::string toDecimal(double value, unsigned char decimalPlaces)
+    {
+        char tmp[64];
+        snprintf(tmp, sizeof(tmp), "%.*f", decimalPlaces, value);
+        return std::string(tmp);
+    }
+}
+
+// ===== Reloj virtual =====
+
+unsigned long SimClock::now() { return clockMs; }
+void SimClock::advance(unsigned long ms) { clockMs += ms; }
+
+unsigned long millis() { return clockMs; }
+unsigned long micros() { return clockMs * 1000UL; }
+void delay(unsigned long ms) { clockMs += ms; }
+void delayMicroseconds(unsigned int us) { (void)us; }
+void yield() {}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+
+long random(long max) { return max <= 0 ? 0 : (long)(arduinoRng() % (unsigned long)max); }
+long random(long min, long max) { return max <= min ? min : min + random(max - min); }
+void randomSeed(unsigned long seed) { arduinoRng.seed(seed); }
+
+// ===== String =====
+
+String::String(const char *cstr) : s(cstr ? cstr : "") {}
+String::String(const char *cstr, unsigned int length) : s(cstr, length) {}
+String::String(char c) : s(1, c) {}
+String::String(unsigned char value, unsigned char base) : s(toBase(value, base, false)) {}
+String::String(int value, unsigned char base)
+    : s(base == 10 && value < 0 ? toBase(-(long)value, base, true) : toBase((unsigned int)value, base, false)) {}
+String::String(unsigned int value, unsigned char base) : s(toBase(value, base, false)) {}
+String::String(long value, unsigned char base)
+    : s(base == 10 && value < 0 ? toBase(-value, base, true) : toBase((unsigned long)value, base, false)) {}
+String::String(unsigned long value, unsigned char base) : s(toBase(value, base, false)) {}
+String::String(float value, unsigned char decimalPlaces) : s(toDecimal(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : s(toDecimal(value, decimalPlaces)) {}
+
+int String::indexOf(char c) const
+{
+    size_t pos = s.find(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const
+{
+    return substring(from, s.length());
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to) {
+        std::swap(from, to);
+    }
+    if (from >= s.length()) {
+        return String();
+    }
+    to = std::min<unsigned int>(to, s.length());
+    return String(s.c_str() + from, to - from);
+}
+
+long String::toInt() const
+{
+    return strtol(s.c_str(), nullptr, 10);
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize) const
+{
+    if (bufsize == 0) {
+        return;
+    }
+    size_t n = std::min<size_t>(bufsize - 1, s.length());
+    memcpy(buf, s.c_str(), n);
+    buf[n] = '\0';
+}
+
+String operator+(const String &lhs, const String &rhs) { String r(lhs); r += rhs; return r; }
+String operator+(const String &lhs, const char *rhs) { String r(lhs); r += rhs; return r; }
+String operator+(const char *lhs, const String &rhs) { String r(lhs); r += rhs; return r; }
+
+// ===== Serial =====
+
+size_t SimSerial::printf(const char *format, ...)
+{
+    if (!enabled) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+size_t SimSerial::print(const char *s)
+{
+    if (!enabled) {
+        return 0;
+    }
+    fputs(s, stdout);
+    return strlen(s);
+}
+
+size_t SimSerial::print(char c)
+{
+    if (!enabled) {
+        return 0;
+    }
+    fputc(c, stdout);
+    return 1;
+}
+
+size_t SimSerial::print(int v, int base) { return print(String(v, (unsigned char)base)); }
+size_t SimSerial::print(unsigned int v, int base) { return print(String(v, (unsigned char)base)); }
+size_t SimSerial::print(long v, int base) { return print(String(v, (unsigned char)base)); }
+size_t SimSerial::print(unsigned long v, int base) { return print(String(v, (unsigned char)base)); }
+size_t SimSerial::print(double v, int digits) { return print(String(v, (unsigned char)digits)); }
+size_t SimSerial::println() { return print("\n"); }
+
+// ===== ESP =====
+
+uint32_t SimEsp::getFreeHeap()
+{
+    size_t used = HeapTracker::stats().inUse;
+    return used >= SIM_HEAP_BYTES ? 0 : (uint32_t)(SIM_HEAP_BYTES - used);
+}
+
+uint32_t SimEsp::getCycleCount()
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SimEsp::restart()
+{
+    fprintf(stderr, "ESP.restart() llamado por el firmware\n");
+    exit(2);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file littlefs_shim.cpp
+ * @brief LittleFS en memoria para la simulación nativa
+ */
+
+#include "LittleFS.h"
+#include "heap_tracker.h"
+#include <map>
+#include <string>
+
+LittleFSClass LittleFS;
+
+namespace {
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+    bool available = true;
+}
+
+size_t File::read(uint8_t *buf, size_t len)
+{
+    if (!data || pos >= data->size()) {
+        return 0;
+    }
+    size_t n = std::min(len, data->size() - pos);
+    memcpy(buf, data->data() + pos, n);
+    pos += n;
+    return n;
+}
+
+size_t File::write(const uint8_t *buf, size_t len)
+{
+    if (!data || !writable) {
+        return 0;
+    }
+    HeapTracker::Scope untracked(false);
+    if (pos + len > data->size()) {
+        data->resize(pos + len);
+    }
+    memcpy(data->data() + pos, buf, len);
+    pos += len;
+    return len;
+}
+
+bool File::seek(uint32_t offset, SeekMode mode)
+{
+    if (!data) {
+        return false;
+    }
+    size_t base = mode == SeekSet ? 0 : (mode == SeekCur ? pos : data->size());
+    if (base + offset > data->size()) {
+        return false;
+    }
+    pos = base + offset;
+    return true;
+}
+
+bool LittleFSClass::begin()
+{
+    return available;
+}
+
+bool LittleFSClass::format()
+{
+    if (!available) {
+        return false;
+    }
+    files.clear();
+    return true;
+}
+
+bool LittleFSClass::exists(const char *path)
+{
+    return available && files.count(path) != 0;
+}
+
+bool LittleFSClass::remove(const char *path)
+{
+    return available && files.erase(path) != 0;
+}
+
+File LittleFSClass::open(const char *path, const char *mode)
+{
+    if (!available) {
+        return File();
+    }
+    HeapTracker::Scope untracked(false);
+    auto it = files.find(path);
+    bool create = mode[0] == 'w' || mode[0] == 'a';
+    if (it == files.end()) {
+        if (!create) {
+            return File();
+        }
+        it = files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+    }
+    if (mode[0] == 'w') {
+        it->second->clear();
+    }
+    bool writable = mode[0] != 'r' || mode[1] == '+';
+    return File(it->second, mode[0] == 'a' ? it->second->size() : 0, writable);
+}
+
+void LittleFSClass::setAvailable(bool on)
+{
+    available = on;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file peripherals_shim.cpp
+ * @brief WiFi, MQTT, RTC, I2C y SPI virtuales para la simulación nativa
+ */
+
+#include "ESP8266WiFi.h"
+#include "PubSubClient.h"
+#include "RTClib.h"
+#include "Wire.h"
+#include "SPI.h"
+
+SimWiFi WiFi;
+TwoWire Wire;
+SPIClass SPI;
+
+namespace {
+    PubSubClient::Stats mqttStats = {0, 0, 0, 0};
+    bool brokerAvailable = true;
+
+    const uint8_t daysInMonth[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    bool isLeap(uint16_t y) { return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0; }
+}
+
+// ===== WiFi =====
+
+String IPAddress::toString() const
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+}
+
+wl_status_t SimWiFi::begin()
+{
+    return status();
+}
+
+wl_status_t SimWiFi::begin(const char *ssid, const char *passphrase)
+{
+    (void)ssid;
+    (void)passphrase;
+    connected = available;
+    if (connected) {
+        if (gotIpEvent) {
+            WiFiEventStationModeGotIP event = {localIP()};
+            gotIpEvent(event);
+        }
+    } else {
+        notifyDisconnected(201);  // REASON_NO_AP_FOUND
+    }
+    return status();
+}
+
+bool SimWiFi::disconnect(bool wifioff)
+{
+    if (connected) {
+        connected = false;
+        notifyDisconnected(8);  // REASON_ASSOC_LEAVE
+    }
+    if (wifioff) {
+        currentMode = WIFI_OFF;
+    }
+    return true;
+}
+
+String SimWiFi::macAddress() const
+{
+    return String(mac_);
+}
+
+IPAddress SimWiFi::localIP() const
+{
+    return connected ? IPAddress(192, 168, 4, 2) : IPAddress();
+}
+
+void SimWiFi::setAvailable(bool on)
+{
+    available = on;
+    if (!on && connected) {
+        connected = false;
+        notifyDisconnected(200);  // REASON_BEACON_TIMEOUT
+    }
+}
+
+WiFiEventHandler SimWiFi::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP &)> f)
+{
+    gotIpEvent = f;
+    return WiFiEventHandler();
+}
+
+WiFiEventHandler SimWiFi::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected &)> f)
+{
+    disconnectedEvent = f;
+    return WiFiEventHandler();
+}
+
+void SimWiFi::notifyDisconnected(uint8_t reason)
+{
+    if (disconnectedEvent) {
+        WiFiEventStationModeDisconnected event = {reason};
+        disconnectedEvent(event);
+    }
+}
+
+// ===== PubSubClient =====
+
+bool PubSubClient::connect(const char *id)
+{
+    (void)id;
+    isConnected = brokerAvailable && WiFi.status() == WL_CONNECTED;
+    if (isConnected) {
+        mqttStats.connects++;
+    }
+    return isConnected;
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload)
+{
+    return publish(topic, reinterpret_cast<const uint8_t *>(payload), strlen(payload));
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int plength)
+{
+    (void)payload;
+    // Igual que la librería: falla si el mensaje no entra en el buffer interno
+    if (!connected() || MQTT_MAX_HEADER_SIZE + 2 + strlen(topic) + plength > bufferSize) {
+        mqttStats.failed++;
+        return false;
+    }
+    mqttStats.publishes++;
+    mqttStats.payloadBytes += plength;
+    return true;
+}
+
+bool PubSubClient::beginPublish(const char *topic, unsigned int plength, bool retained)
+{
+    (void)topic;
+    (void)retained;
+    if (!connected()) {
+        mqttStats.failed++;
+        return false;
+    }
+    streaming = true;
+    streamExpected = plength;
+    streamWritten = 0;
+    return true;
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size)
+{
+    (void)buffer;
+    if (!streaming || !connected()) {
+        return 0;
+    }
+    streamWritten += size;
+    return size;
+}
+
+int PubSubClient::endPublish()
+{
+    // El broker corta la sesión si el payload no coincide con el largo declarado
+    bool ok = streaming && connected() && streamWritten == streamExpected;
+    streaming = false;
+    if (!ok) {
+        mqttStats.failed++;
+        return 0;
+    }
+    mqttStats.publishes++;
+    mqttStats.payloadBytes += streamWritten;
+    return 1;
+}
+
+const PubSubClient::Stats &PubSubClient::stats()
+{
+    return mqttStats;
+}
+
+bool PubSubClient::connected() const
+{
+    return isConnected && brokerAvailable && WiFi.status() == WL_CONNECTED;
+}
+
+void PubSubClient::setBrokerAvailable(bool on)
+{
+    brokerAvailable = on;
+}
+
+// ===== RTClib =====
+
+DateTime::DateTime(uint32_t t)
+{
+    ss = t % 60; t /= 60;
+    mm = t % 60; t /= 60;
+    hh = t % 24;
+    uint32_t days = t / 24;
+    y = 1970;
+    while (days >= (isLeap(y) ? 366U : 365U)) {
+        days -= isLeap(y) ? 366 : 365;
+        y++;
+    }
+    m = 1;
+    while (true) {
+        uint8_t dim = daysInMonth[m - 1] + ((m == 2 && isLeap(y)) ? 1 : 0);
+        if (days < dim) {
+            break;
+        }
+        days -= dim;
+        m++;
+    }
+    d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
+    : y(year), m(month), d(day), hh(hour), mm(min), ss(sec)
+{
+}
+
+DateTime::DateTime(const char *date, const char *time)
+{
+    // date = "Mmm dd yyyy", time = "hh:mm:ss" (formato de __DATE__/__TIME__)
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    const char *p = strstr(months, std::string(date, 3).c_str());
+    m = p ? (uint8_t)((p - months) / 3 + 1) : 1;
+    d = (uint8_t)atoi(date + 4);
+    y = (uint16_t)atoi(date + 7);
+    hh = (uint8_t)atoi(time);
+    mm = (uint8_t)atoi(time + 3);
+    ss = (uint8_t)atoi(time + 6);
+}
+
+uint32_t DateTime::unixtime() const
+{
+    uint32_t days = 0;
+    for (uint16_t yr = 1970; yr < y; yr++) {
+        days += isLeap(yr) ? 366 : 365;
+    }
+    for (uint8_t mo = 1; mo < m; mo++) {
+        days += daysInMonth[mo - 1] + ((mo == 2 && isLeap(y)) ? 1 : 0);
+    }
+    days += d - 1;
+    return ((days * 24 + hh) * 60 + mm) * 60 + ss;
+}
+
+void RTC_DS1307::adjust(const DateTime &dt)
+{
+    baseUnix = dt.unixtime();
+    baseMillis = millis();
+    running = true;
+}
+
+DateTime RTC_DS1307::now() const
+{
+    return DateTime((uint32_t)(baseUnix + (millis() - baseMillis) / 1000UL));
+}
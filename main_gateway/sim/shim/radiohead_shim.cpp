@@ -0,0 +1,126 @@
+/**
+ * @file radiohead_shim.cpp
+ * @brief RH_RF95 y RHMesh falsos: delegan en VirtualNetwork
+ *
+ * Todo lo que reserva la red virtual queda fuera de la contabilidad de heap
+ * del firmware (HeapTracker::Scope(false)).
+ */
+
+#include "RHMesh.h"
+#include "../heap_tracker.h"
+#include "../virtual_network.h"
+
+bool RH_RF95::setModemConfig(ModemConfigChoice index)
+{
+    static const struct { long bw; uint8_t cr; uint8_t sf; } table[] = {
+        {125000, 5, 7}, {500000, 5, 7}, {31250, 8, 9}, {125000, 8, 12}, {125000, 5, 11},
+    };
+    if ((unsigned)index >= sizeof(table) / sizeof(table[0])) {
+        return false;
+    }
+    bandwidth = table[index].bw;
+    codingRate4 = table[index].cr;
+    spreadingFactor = table[index].sf;
+    publishModem();
+    return true;
+}
+
+void RH_RF95::setTxPower(int8_t power, bool useRFO)
+{
+    (void)useRFO;
+    txPower = power;
+    publishModem();
+}
+
+void RH_RF95::setSpreadingFactor(uint8_t sf)
+{
+    spreadingFactor = sf;
+    publishModem();
+}
+
+void RH_RF95::setSignalBandwidth(long sbw)
+{
+    bandwidth = sbw;
+    publishModem();
+}
+
+void RH_RF95::publishModem()
+{
+    VirtualNetwork::instance().setGatewayModem(spreadingFactor, (uint16_t)(bandwidth / 1000), txPower);
+}
+
+int16_t RH_RF95::lastRssi()
+{
+    return VirtualNetwork::instance().lastRssi();
+}
+
+int RH_RF95::lastSNR()
+{
+    return VirtualNetwork::instance().lastSnr();
+}
+
+uint8_t RHMesh::sendtoWait(uint8_t *buf, uint8_t len, uint8_t dest, uint8_t flags)
+{
+    HeapTracker::Scope untracked(false);
+    return VirtualNetwork::instance().send(buf, len, dest, flags);
+}
+
+bool RHMesh::recvfromAck(uint8_t *buf, uint8_t *len, uint8_t *source, uint8_t *dest,
+                         uint8_t *id, uint8_t *flags, uint8_t *hops)
+{
+    HeapTracker::Scope untracked(false);
+    if (!VirtualNetwork::instance().receive(buf, len, source, flags, hops)) {
+        return false;
+    }
+    if (dest != nullptr) *dest = address;
+    if (id != nullptr) *id = 0;
+    return true;
+}
+
+bool RHMesh::recvfromAckTimeout(uint8_t *buf, uint8_t *len, uint16_t timeout, uint8_t *source,
+                                uint8_t *dest, uint8_t *id, uint8_t *flags, uint8_t *hops)
+{
+    HeapTracker::Scope untracked(false);
+    if (!VirtualNetwork::instance().receiveTimeout(buf, len, timeout, source, flags, hops)) {
+        return false;
+    }
+    if (dest != nullptr) *dest = address;
+    if (id != nullptr) *id = 0;
+    return true;
+}
+
+void RHRouter::addRouteTo(uint8_t dest, uint8_t next_hop, uint8_t state)
+{
+    VirtualNetwork::instance().addRoute(dest, next_hop, state);
+}
+
+RHRouter::RoutingTableEntry *RHRouter::getRouteTo(uint8_t dest)
+{
+    return VirtualNetwork::instance().route(dest);
+}
+
+bool RHRouter::deleteRouteTo(uint8_t dest)
+{
+    return VirtualNetwork::instance().deleteRoute(dest);
+}
+
+void RHRouter::clearRoutingTable()
+{
+    VirtualNetwork::instance().clearRoutes();
+}
+
+bool RHMesh::doArp(uint8_t dest)
+{
+    HeapTracker::Scope untracked(false);
+    return VirtualNetwork::instance().discover(dest);
+}
+
+uint32_t RHMesh::retransmissions()
+{
+    return VirtualNetwork::instance().retransmissions();
+}
+
+bool RHMesh::available()
+{
+    return VirtualNetwork::instance().available();
+}
@@ -0,0 +1,427 @@
+/**
+ * @file sim_main.cpp
+ * @brief Punto de entrada de la simulación nativa del gateway (env:native)
+ *
+ * Arma el gateway igual que main_gateway.ino (NodeIdentity, RadioManager,
+ * RtcManager, AppLogic) sobre la red virtual y lo hace correr con reloj
+ * virtual hasta completar la cantidad de ciclos atmosféricos pedida.
+ *
+ * Por cada ciclo informa duración, pedidos, reintentos, respuestas, fallas,
+ * descubrimientos de ruta y uso de heap del firmware; al final imprime el
+ * resumen del canal y de MQTT. Con --reboot el gateway se destruye y se vuelve
+ * a armar a mitad de la corrida; LittleFS (rutas, cola) sobrevive al reinicio.
+ *
+ * @example
+ * ```
+ * pio run -e native
+ * .pio/build/native/program --nodes 50 --loss 0.05 --hops 3 --cycles 5
+ * ```
+ */
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <algorithm>
+#include <vector>
+#include "crc8.h"
+#include "node_identity.h"
+#include "radio_manager.h"
+#include "rtc_manager.h"
+#include "app_logic.h"
+#include "logger.h"
+#include "config.h"
+#include "heap_tracker.h"
+#include "virtual_network.h"
+
+namespace {
+
+    /**
+     * @struct Options
+     * @brief Parámetros de la simulación tomados de la línea de comandos.
+     */
+    struct Options {
+        unsigned nodes = MAX_NODES;       ///< Nodos remotos virtuales
+        unsigned latency = 40;            ///< Latencia de respuesta atmosférica (ms)
+        unsigned jitter = 20;             ///< Jitter de respuesta (ms)
+        unsigned groundLatency = 3000;    ///< Latencia de respuesta de suelo/GPS (ms)
+        bool groundCache = false;         ///< Nodos con CAP_GROUND_CACHE
+        float loss = 0.02f;               ///< Pérdida por intento y por salto
+        unsigned hops = 1;                ///< Saltos máximos (cada nodo toma 1..hops)
+        unsigned cycles = 3;              ///< Ciclos atmosféricos a completar
+        unsigned long maxTime = 3600000UL; ///< Tiempo virtual máximo en ms (0 = sin límite)
+        unsigned long brokerDownFrom = 0;  ///< Inicio de la caída del broker MQTT en ms
+        unsigned long brokerDownTo = 0;    ///< Fin de la caída del broker MQTT en ms (0 = sin caída)
+        unsigned long wifiDownFrom = 0;    ///< Inicio de la caída del punto de acceso WiFi en ms
+        unsigned long wifiDownTo = 0;      ///< Fin de la caída del punto de acceso WiFi en ms (0 = sin caída)
+        unsigned long rebootAt = 0;        ///< Reinicio del gateway en ms (0 = sin reinicio)
+        unsigned long counterLossAt = 0;   ///< Pérdida de /auth_counter.bin en los nodos en ms (0 = sin pérdida)
+        unsigned long replayHelloAt = 0;   ///< Repetición del primer HELLO de cada nodo en ms (0 = sin repetición)
+        bool snrSet = false;              ///< Se pidió un rango de SNR para los vecinos directos
+        int snrMin = 0;                   ///< SNR mínima de los vecinos directos (dB)
+        int snrMax = 0;                   ///< SNR máxima de los vecinos directos (dB)
+        unsigned seed = 1;                ///< Semilla del generador aleatorio
+        bool verbose = false;             ///< Mostrar la salida Serial del firmware
+        bool dumpLog = false;             ///< Volcar el anillo de registros al terminar
+    };
+
+    void usage(const char *prog)
+    {
+        printf("Uso: %s [opciones]\n"
+               "  --nodes N           nodos remotos (default %u)\n"
+               "  --latency MS        latencia de respuesta atmosférica (default 40)\n"
+               "  --jitter MS         jitter de respuesta (default 20)\n"
+               "  --ground-latency MS latencia de respuesta suelo/GPS (default 3000)\n"
+               "  --ground-cache      nodos con caché de suelo/GPS: responden sin leer el RS485\n"
+               "  --loss P            pérdida por intento y salto, 0..1 (default 0.02)\n"
+               "  --hops H            saltos máximos, cada nodo toma 1..H (default 1)\n"
+               "  --cycles N          ciclos atmosféricos a completar (default 3)\n"
+               "  --max-time S        tiempo virtual máximo en segundos, 0 = sin límite (default 3600)\n"
+               "  --broker-down A:B   broker MQTT caído entre los segundos A y B\n"
+               "  --wifi-down A:B     punto de acceso WiFi caído entre los segundos A y B\n"
+               "  --snr MIN:MAX       SNR de los vecinos directos en dB, uniforme (default 3:7)\n"
+               "  --reboot S          reinicia el gateway a los S segundos (LittleFS se conserva)\n"
+               "  --counter-loss S    los nodos se reinician sin su contador de FrameAuth a los S segundos\n"
+               "  --replay-hello S    se repite el primer HELLO de cada nodo a los S segundos (después de --counter-loss)\n"
+               "  --seed N            semilla aleatoria (default 1)\n"
+               "  --verbose           mostrar la salida Serial del firmware\n"
+               "  --dump-log          volcar el log en RAM del firmware al terminar\n",
+               prog, (unsigned)MAX_NODES);
+    }
+
+    /** @brief Lee "A:B" en segundos y lo guarda en ms */
+    bool parseWindow(const char *val, unsigned long &from, unsigned long &to)
+    {
+        char *sep = nullptr;
+        from = strtoul(val, &sep, 10) * 1000UL;
+        if (sep == nullptr || *sep != ':') return false;
+        to = strtoul(sep + 1, nullptr, 10) * 1000UL;
+        return true;
+    }
+
+    bool parseOptions(int argc, char **argv, Options &opt)
+    {
+        for (int i = 1; i < argc; i++) {
+            const char *arg = argv[i];
+            const char *val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (strcmp(arg, "--verbose") == 0) {
+                opt.verbose = true;
+                continue;
+            }
+            if (strcmp(arg, "--dump-log") == 0) {
+                opt.dumpLog = true;
+                continue;
+            }
+            if (strcmp(arg, "--ground-cache") == 0) {
+                opt.groundCache = true;
+                continue;
+            }
+            if (val == nullptr) {
+                return false;
+            }
+            if (strcmp(arg, "--nodes") == 0) opt.nodes = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--latency") == 0) opt.latency = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--jitter") == 0) opt.jitter = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--ground-latency") == 0) opt.groundLatency = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--loss") == 0) opt.loss = strtof(val, nullptr);
+            else if (strcmp(arg, "--hops") == 0) opt.hops = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--cycles") == 0) opt.cycles = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--max-time") == 0) opt.maxTime = strtoul(val, nullptr, 10) * 1000UL;
+            else if (strcmp(arg, "--seed") == 0) opt.seed = strtoul(val, nullptr, 10);
+            else if (strcmp(arg, "--reboot") == 0) opt.rebootAt = strtoul(val, nullptr, 10) * 1000UL;
+            else if (strcmp(arg, "--counter-loss") == 0) opt.counterLossAt = strtoul(val, nullptr, 10) * 1000UL;
+            else if (strcmp(arg, "--replay-hello") == 0) opt.replayHelloAt = strtoul(val, nullptr, 10) * 1000UL;
+            else if (strcmp(arg, "--broker-down") == 0) {
+                if (!parseWindow(val, opt.brokerDownFrom, opt.brokerDownTo)) return false;
+            }
+            else if (strcmp(arg, "--wifi-down") == 0) {
+                if (!parseWindow(val, opt.wifiDownFrom, opt.wifiDownTo)) return false;
+            }
+            else if (strcmp(arg, "--snr") == 0) {
+                char *sep = nullptr;
+                opt.snrMin = (int)strtol(val, &sep, 10);
+                if (sep == nullptr || *sep != ':') return false;
+                opt.snrMax = (int)strtol(sep + 1, nullptr, 10);
+                opt.snrSet = true;
+            }
+            else return false;
+            i++;
+        }
+        return opt.nodes > 0 && opt.nodes <= 253 && opt.hops > 0 && opt.loss >= 0.0f && opt.loss < 1.0f &&
+               opt.snrMin <= opt.snrMax && opt.snrMin >= -30 && opt.snrMax <= 30 &&
+               (opt.replayHelloAt == 0 || opt.replayHelloAt > opt.counterLossAt);
+    }
+
+    /**
+     * @brief Crea los nodos virtuales con IDs 1..254 salteando el del gateway
+     */
+    void populate(VirtualNetwork &net, const Options &opt, uint8_t gatewayId)
+    {
+        // Como en el firmware, el ID es el CRC-8 de la MAC (NodeIdentity::crc8): IDs dispersos.
+        // Una MAC cuyo ID ya está tomado no entraría en la tabla del gateway; se prueba otra.
+        unsigned added = 0;
+        for (unsigned attempt = 0; attempt < 4096 && added < opt.nodes; attempt++) {
+            const uint8_t mac[6] = {0x24, 0x0A, 0xC4, (uint8_t)random(256), (uint8_t)random(256), (uint8_t)random(256)};
+            uint8_t id = Crc8::compute(mac, sizeof(mac), 0x00);
+            if (id == gatewayId) {
+                continue;
+            }
+            VirtualNodeConfig cfg;
+            cfg.latencyMs = opt.latency;
+            cfg.jitterMs = opt.jitter;
+            cfg.groundLatencyMs = opt.groundLatency;
+            cfg.groundCache = opt.groundCache;
+            cfg.loss = opt.loss;
+            cfg.hops = 1 + random(opt.hops);
+            cfg.rssi = -60 - 15 * cfg.hops - random(20);
+            cfg.snr = 10 - 3 * cfg.hops - random(4);
+            if (opt.snrSet && cfg.hops == 1) {
+                cfg.snr = opt.snrMin + random(opt.snrMax - opt.snrMin + 1);
+            }
+            if (net.addNode(id, mac, cfg)) {
+                added++;
+            }
+        }
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        usage(argv[0]);
+        return 1;
+    }
+    Serial.setEnabled(opt.verbose);
+    randomSeed(opt.seed);
+
+    VirtualNetwork &net = VirtualNetwork::instance();
+    RadioManager *radio = nullptr;
+    RtcManager *rtc = nullptr;
+    AppLogic *logic = nullptr;
+    uint8_t gatewayId;
+    {
+        // Mismo armado que setup() en main_gateway.ino
+        HeapTracker::Scope tracked(true);
+        NodeIdentity identity;
+        gatewayId = identity.getNodeID();
+        radio = new RadioManager(gatewayId);
+        radio->init();
+        rtc = new RtcManager();
+        rtc->begin();
+        net.begin(gatewayId, opt.seed);
+        logic = new AppLogic(identity, *radio, *rtc);
+        logic->begin();
+    }
+    populate(net, opt, gatewayId);
+
+    printf("Gateway 0x%02X, %u nodos, latencia %u+%u ms, pérdida %.3f, saltos 1..%u\n",
+           gatewayId, (unsigned)net.nodeCount(), opt.latency, opt.jitter, opt.loss, opt.hops);
+    printf("Heap del firmware tras setup(): %u B en uso, libre %u B\n",
+           (unsigned)HeapTracker::stats().inUse, ESP.getFreeHeap());
+    printf("%5s %9s %8s %8s %8s %8s %9s %6s %6s %8s %9s %8s %9s\n",
+           "ciclo", "inicio_s", "dur_ms", "pedidos", "reint", "resp", "fallas", "datos", "rutas", "aire_ms",
+           "heap_uso", "heap_max", "allocs");
+
+    const PollEngine *poll = &logic->getAtmosphericPoll();
+    bool wasActive = false;
+    unsigned long reportedStart = 0; // startedAt del último ciclo impreso
+    unsigned completed = 0;
+    uint32_t allocsAtStart = 0;
+    uint32_t dataAtLastCycle = 0;
+    uint32_t routesAtLastCycle = 0;
+    uint32_t airtimeAtLastCycle = 0;
+    uint32_t airtimeBeforeReboot = 0;  ///< DutyCycle vuelve a cero con cada RadioManager
+    uint16_t outboxPeak = 0;
+    unsigned sessionsLost = 0;       ///< Nodos con sesión en el gateway cuando --counter-loss los reinició
+    uint32_t resyncsAtLoss = 0;
+    unsigned replayedHellos = 0;     ///< HELLO viejos agendados por --replay-hello
+    uint32_t resyncsAtReplay = 0;
+    uint32_t rejectsAtReplay = 0;    ///< Repetidas y sin sesión en el gateway antes de --replay-hello
+    bool wifiUp = true;
+    while (completed < opt.cycles && (opt.maxTime == 0 || millis() < opt.maxTime)) {
+        if (opt.brokerDownTo > 0) {
+            PubSubClient::setBrokerAvailable(millis() < opt.brokerDownFrom || millis() >= opt.brokerDownTo);
+        }
+        if (opt.wifiDownTo > 0) {
+            bool up = millis() < opt.wifiDownFrom || millis() >= opt.wifiDownTo;
+            if (up != wifiUp) {
+                WiFi.setAvailable(up);
+                wifiUp = up;
+            }
+        }
+        if (opt.rebootAt > 0 && millis() >= opt.rebootAt) {
+            // Se pierde la RAM (tabla de nodos, tabla de RHRouter); LittleFS y el DS1307 quedan
+            HeapTracker::Scope tracked(true);
+            opt.rebootAt = 0;
+            airtimeBeforeReboot += radio->getDutyCycle().totalMs();
+            airtimeAtLastCycle = 0;
+            delete logic;
+            delete radio;
+            NodeIdentity identity;
+            radio = new RadioManager(gatewayId);
+            radio->init();
+            logic = new AppLogic(identity, *radio, *rtc);
+            logic->begin();
+            poll = &logic->getAtmosphericPoll();
+            wasActive = false;
+            reportedStart = 0;
+            printf("-- reinicio del gateway a los %.1f s, %u rutas restauradas\n", millis() / 1000.0,
+                   radio->getRoutes().count());
+        }
+        if (opt.counterLossAt > 0 && millis() >= opt.counterLossAt) {
+            opt.counterLossAt = 0;
+            const FrameAuth &auth = radio->getAuth();
+            for (unsigned id = 1; id < RH_BROADCAST_ADDRESS; id++) {
+                if (id != gatewayId && auth.hasSession((uint8_t)id)) {
+                    sessionsLost++;
+                }
+            }
+            resyncsAtLoss = auth.resyncs();
+            net.loseCounters();
+            printf("-- los nodos se reinician sin /auth_counter.bin a los %.1f s, %u tenían sesión en el gateway\n",
+                   millis() / 1000.0, sessionsLost);
+        }
+        if (opt.replayHelloAt > 0 && millis() >= opt.replayHelloAt) {
+            opt.replayHelloAt = 0;
+            const FrameAuth &auth = radio->getAuth();
+            resyncsAtReplay = auth.resyncs();
+            rejectsAtReplay = auth.stale() + auth.replays();
+            replayedHellos = net.replayOldHellos();
+            printf("-- se repite el primer HELLO de %u nodos a los %.1f s\n", replayedHellos, millis() / 1000.0);
+        }
+        {
+            HeapTracker::Scope tracked(true);
+            logic->update();
+        }
+        bool active = poll->isActive();
+        if (active && !wasActive) {
+            allocsAtStart = HeapTracker::stats().allocs;
+        } else if (!active && (wasActive || poll->stats().startedAt != reportedStart)) {
+            // También los ciclos que empiezan y terminan en el mismo update(): todos enviaron en slot
+            const PollEngine::CycleStats &c = poll->stats();
+            const HeapTracker::Stats &h = HeapTracker::stats();
+            completed++;
+            // datos y rutas: DATA_ATMOSPHERIC entregados (incluye envíos en slot) y
+            // descubrimientos de ruta desde el ciclo anterior; aire_ms: lo que
+            // RadioManager anotó en DutyCycle desde el ciclo anterior
+            uint32_t airtime = radio->getDutyCycle().totalMs();
+            printf("%5u %9.1f %8lu %8u %8u %8u %9u %6u %6u %8u %9u %8u %9u\n",
+                   completed, c.startedAt / 1000.0, c.duration, c.requests, c.retries,
+                   c.replies, c.failures, net.stats().atmosReplies - dataAtLastCycle,
+                   net.stats().routeDiscoveries - routesAtLastCycle, airtime - airtimeAtLastCycle,
+                   (unsigned)h.inUse, (unsigned)h.peak, (unsigned)(h.allocs - allocsAtStart));
+            dataAtLastCycle = net.stats().atmosReplies;
+            reportedStart = c.startedAt;
+            allocsAtStart = h.allocs;
+            routesAtLastCycle = net.stats().routeDiscoveries;
+            airtimeAtLastCycle = airtime;
+        }
+        wasActive = active;
+        if (logic->getOutbox().count() > outboxPeak) {
+            outboxPeak = logic->getOutbox().count();
+        }
+        SimClock::advance(1);
+    }
+
+    if (opt.dumpLog) {
+        Serial.setEnabled(true);
+        Log::dump(false);
+        Serial.setEnabled(opt.verbose);
+    }
+
+    const VirtualNetwork::Stats &n = net.stats();
+    const PubSubClient::Stats &m = PubSubClient::stats();
+    printf("\nTiempo virtual: %.1f s, ciclos completados: %u/%u\n", millis() / 1000.0, completed, opt.cycles);
+    printf("Canal: %u tramas gateway, %u tramas nodos, %.1f s de aire (%.1f%%)\n",
+           n.gatewayFrames, n.nodeFrames, n.airtimeMs / 1000.0, millis() ? 100.0 * n.airtimeMs / millis() : 0.0);
+    // Lo que cuenta RadioManager contra lo que la red virtual vio transmitir al gateway
+    DutyCycle &duty = radio->getDutyCycle();
+    printf("Aire del gateway: %u ms contados, %u ms en el canal; ventana %u/%u ms, %u envíos frenados\n",
+           airtimeBeforeReboot + duty.totalMs(), n.gatewayAirtimeMs, duty.usedMs(millis()), duty.budgetMs(),
+           duty.denied());
+    printf("Rutas: %u descubrimientos; enlace: %u reintentos, %u perdidas, %u rx ocupado\n",
+           n.routeDiscoveries, n.linkRetries, n.lostFrames, n.rxOverruns);
+    printf("Recepción: cola RX pico %u/%u, %u llena; %u tramas descartadas sin leer por sendtoWait/ARP\n",
+           radio->getRxQueue().peak(), (unsigned)RX_QUEUE_DEPTH, radio->getRxQueue().overflows(), n.unreadDiscards);
+    printf("Nodos: %u HELLO, %u/%u atmosféricos (%u en slot), %u/%u suelo (entregados/pedidos)\n",
+           n.hellos, n.atmosReplies, n.atmosRequests + n.slotPushes, n.slotPushes, n.groundReplies, n.groundRequests);
+    printf("Atmosféricos: %u comprimidos, %u B de payload enviados\n", n.packedSends, n.atmosBytes);
+    const SequenceTracker &seq = logic->getBatchSequence();
+    printf("Lotes: %u duplicados descartados, %u perdidos, %u reinicios de nodo; %u/%u confirmados con BATCH_ACK\n",
+           seq.duplicates(), seq.gaps(), seq.restarts(), n.batchAcks, n.batchAckWaits);
+    if (AUTH_ENABLED == 1) {
+        const FrameAuth &auth = radio->getAuth();
+        printf("FrameAuth: +%u B por trama (%u en saludos), contador del gateway %u; en el gateway %u rechazadas por "
+               "tag, %u repetidas, %u sin sesión y %u sesiones renovadas; %u saludos de nodos, %u sin abrir en los "
+               "nodos\n", (unsigned)FrameAuth::OVERHEAD, (unsigned)FrameAuth::GREETING_OVERHEAD, auth.counter(),
+               auth.forged(), auth.replays(), auth.stale(), auth.resyncs(), n.greetings, n.authRejects);
+        if (auth.resyncs() - resyncsAtLoss < sessionsLost) {
+            printf("FrameAuth: %u de %u nodos reiniciados siguen sin sesión nueva en el gateway\n",
+                   sessionsLost - (auth.resyncs() - resyncsAtLoss), sessionsLost);
+            return 3;
+        }
+        if (replayedHellos > 0) {
+            uint32_t rejects = auth.stale() + auth.replays() - rejectsAtReplay;
+            printf("FrameAuth: %u HELLO viejos leídos por el gateway, %u rechazos y %u sesiones renovadas desde la "
+                   "repetición\n", n.replaysRead, rejects, auth.resyncs() - resyncsAtReplay);
+            if (auth.resyncs() != resyncsAtReplay || rejects < n.replaysRead) {
+                printf("FrameAuth: un HELLO viejo reabrió una sesión\n");
+                return 3;
+            }
+        }
+    }
+    // ADR: perfiles con que responden los nodos y si el gateway los espera en el mismo
+    unsigned perProfile[Protocol::RADIO_PROFILE_COUNT] = {};
+    unsigned mismatches = 0;
+    for (unsigned id = 1; id < RH_BROADCAST_ADDRESS; id++) {
+        uint8_t profile;
+        int8_t txPower;
+        if (!net.nodeLinkProfile((uint8_t)id, profile, txPower)) {
+            continue;
+        }
+        perProfile[profile]++;
+        const LinkAdr &adr = logic->getLinkAdr();
+        if (adr.profile((uint8_t)id) != profile || adr.txPower((uint8_t)id) != txPower) {
+            mismatches++;
+        }
+    }
+    printf("ADR: %u cambios (último a los %.1f s), %u vueltas al default, %u tramas en otro perfil, %u desfasados\n",
+           n.adrCommands, n.lastAdrCommandAt / 1000.0, n.adrFallbacks, n.profileMisses, mismatches);
+    printf("Perfiles:");
+    for (uint8_t p = 0; p < Protocol::RADIO_PROFILE_COUNT; p++) {
+        if (perProfile[p] > 0) {
+            printf(" SF%u/%u=%u", Protocol::RADIO_PROFILES[p].spreadingFactor, Protocol::RADIO_PROFILES[p].bandwidthKhz,
+                   perProfile[p]);
+        }
+    }
+    printf("\n");
+    // Los enlaces que más alargan el ciclo, según lo que el gateway publica en MQTT_TOPIC_LINKS
+    const LinkStats &links = logic->getLinkStats();
+    std::vector<uint8_t> slowest;
+    for (unsigned id = 1; id < RH_BROADCAST_ADDRESS; id++) {
+        if (links.seen((uint8_t)id) && links.entry((uint8_t)id).rttMs > 0) {
+            slowest.push_back((uint8_t)id);
+        }
+    }
+    std::sort(slowest.begin(), slowest.end(), [&links](uint8_t a, uint8_t b) {
+        return links.entry(a).rttMs > links.entry(b).rttMs;
+    });
+    printf("Enlaces más lentos:");
+    for (size_t i = 0; i < slowest.size() && i < 3; i++) {
+        const LinkStats::Entry &e = links.entry(slowest[i]);
+        printf(" 0x%02X %u ms (%u%% reint, %u saltos, SNR %.1f)", slowest[i], e.rttMs, e.retryRate * 100 / 255,
+               e.hops + 1, e.snr / 16.0);
+    }
+    printf("%s\n", slowest.empty() ? " sin mediciones" : "");
+    printf("MQTT: %u conexiones, %u publicaciones (%u B), %u fallidas\n",
+           m.connects, m.publishes, (unsigned)m.payloadBytes, m.failed);
+    const UplinkManager::Stats &u = logic->getUplink().getStats();
+    printf("Enlace: %s, %u intentos WiFi, %u intentos MQTT, %u caídas\n",
+           UplinkManager::stateName(logic->getUplink().getState()), u.wifiAttempts, u.mqttAttempts, u.drops);
+    printf("Cola persistente: pico %u, %u pendientes, %u descartados\n",
+           outboxPeak, logic->getOutbox().count(), (unsigned)logic->getOutbox().dropped());
+    printf("Heap: pico %u B, %u reservas, libre mínimo %u B\n",
+           (unsigned)HeapTracker::stats().peak, HeapTracker::stats().allocs,
+           (unsigned)(SIM_HEAP_BYTES - HeapTracker::stats().peak));
+    return completed == opt.cycles ? 0 : 2;
+}
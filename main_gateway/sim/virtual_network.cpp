@@ -0,0 +1,921 @@
+/**
+ * @file virtual_network.cpp
+ * @brief Implementación de la red LoRa mesh virtual
+ */
+
+#include "virtual_network.h"
+#include "atmos_codec.h"
+#include "link_adr.h"
+#include "frame_auth.h"
+#include "heap_tracker.h"
+
+namespace {
+    const uint8_t ROUTED_HEADER_LEN = RH_RF95_HEADER_LEN + 5 + 1; ///< RF95 + RHRouter + RHMesh
+    const uint8_t ACK_LEN = RH_RF95_HEADER_LEN + 1;               ///< ACK de RHReliableDatagram
+    const uint8_t ROUTE_REQUEST_LEN = ROUTED_HEADER_LEN + 2;      ///< Pedido de ruta sin lista de saltos
+    const uint8_t NETWORK_KEY[FrameAuth::KEY_LEN] = AUTH_NETWORK_KEY;
+}
+
+VirtualNetwork &VirtualNetwork::instance()
+{
+    static VirtualNetwork network;
+    return network;
+}
+
+void VirtualNetwork::begin(uint8_t gatewayAddress, uint32_t seed)
+{
+    nodes.clear();
+    clearRoutes();
+    rxBuffer.clear();
+    pending = decltype(pending)();
+    for (int i = 0; i < 256; i++) {
+        index[i] = -1;
+    }
+    gateway = gatewayAddress;
+    txBusyFrom = txBusyUntil = 0;
+    rng.seed(seed);
+    counters = Stats();
+    gatewayRetransmissions = 0;
+}
+
+bool VirtualNetwork::addNode(uint8_t address, const uint8_t *mac, const VirtualNodeConfig &cfg)
+{
+    if (address == 0 || address == RH_BROADCAST_ADDRESS || address == gateway || index[address] >= 0) {
+        return false;
+    }
+    Node node = {};
+    node.address = address;
+    node.cfg = cfg;
+    node.cfg.hops = cfg.hops == 0 ? 1 : cfg.hops;
+    memcpy(node.hello.mac, mac, sizeof(node.hello.mac));
+    node.hello.protocolVersion = Protocol::PROTOCOL_VERSION;
+    node.hello.firmwareVersion = 1;
+    node.hello.capabilities = Protocol::CAP_ATMOSPHERIC | Protocol::CAP_GROUND_GPS | Protocol::CAP_SLOT_SCHEDULE |
+                              Protocol::CAP_PACKED_ATMOSPHERIC | Protocol::CAP_LINK_ADR | Protocol::CAP_BATCH_SEQUENCE;
+    if (cfg.groundCache) {
+        node.hello.capabilities |= Protocol::CAP_GROUND_CACHE;
+    }
+    node.linkProfile = Protocol::RADIO_PROFILE_DEFAULT;
+    node.linkTxPower = RADIO_TX_POWER;
+    for (uint8_t i = 0; i < FrameAuth::SALT_LEN; i++) {
+        node.authSalt[i] = (uint8_t)uniform(255);
+    }
+    node.temp = (int16_t)(150 + uniform(100));
+    node.moisture = (uint16_t)(400 + uniform(300));
+    index[address] = (int16_t)nodes.size();
+    nodes.push_back(node);
+    return true;
+}
+
+size_t VirtualNetwork::nodeCount() const
+{
+    return nodes.size();
+}
+
+uint8_t VirtualNetwork::send(const uint8_t *buf, uint8_t len, uint8_t dest, uint8_t flags)
+{
+    // Las colas de la red virtual son memoria del simulador, no del firmware
+    HeapTracker::Scope simulator(false);
+    unsigned long now = millis();
+    deliverDue(now);
+    if (len > RH_MESH_MAX_MESSAGE_LEN) {
+        return RH_ROUTER_ERROR_INVALID_LENGTH;
+    }
+    uint32_t elapsed = 0;
+    uint8_t result = RH_ROUTER_ERROR_NONE;
+
+    if (dest == RH_BROADCAST_ADDRESS) {
+        // Broadcast: sin ACK, cada nodo lo recibe si sobrevive a todos sus saltos
+        elapsed = airtimeMs(len + ROUTED_HEADER_LEN);
+        counters.gatewayFrames++;
+        counters.airtimeMs += elapsed;
+        counters.gatewayAirtimeMs += elapsed;
+        for (Node &node : nodes) {
+            bool heard = gatewayListens(Protocol::RADIO_PROFILE_DEFAULT);
+            for (uint8_t h = 0; h < node.cfg.hops && heard; h++) {
+                heard = !chance(h == 0 ? lastHopLoss(node, Protocol::RADIO_PROFILE_DEFAULT, gatewayTxPower) : node.cfg.loss);
+            }
+            if (heard) {
+                nodeHears(node, flags, dest, buf, len, now + elapsed * node.cfg.hops + SIM_TURNAROUND_MS * (node.cfg.hops - 1));
+            }
+        }
+    } else {
+        discardUnread(false);
+        Node *node = find(dest);
+        if (node == nullptr) {
+            elapsed = unansweredDiscovery();
+            result = RH_ROUTER_ERROR_NO_ROUTE;
+        } else if (route(dest) == nullptr && !discoverRoute(*node, elapsed)) {
+            result = RH_ROUTER_ERROR_NO_ROUTE;
+        } else {
+            uint32_t framesBefore = counters.gatewayFrames;
+            bool firstHop = hopWithRetries(len, gatewayListens(Protocol::RADIO_PROFILE_DEFAULT) &&
+                                                    route(dest)->next_hop == nextHopOf(*node) ?
+                                                lastHopLoss(*node, Protocol::RADIO_PROFILE_DEFAULT, gatewayTxPower) : 1.0f,
+                                            elapsed, counters.gatewayFrames);
+            uint32_t attempts = counters.gatewayFrames - framesBefore;
+            counters.gatewayAirtimeMs += attempts * airtimeMs(len + ROUTED_HEADER_LEN);
+            gatewayRetransmissions += attempts - 1;
+            if (!firstHop) {
+                // Igual que RHMesh: sin ACK del próximo salto se borra la ruta
+                deleteRoute(dest);
+                result = RH_ROUTER_ERROR_UNABLE_TO_DELIVER;
+            } else {
+                // Saltos restantes: los retransmiten otros nodos, el gateway ya quedó libre
+                uint32_t relay = 0;
+                bool delivered = true;
+                for (uint8_t h = 1; h < node->cfg.hops && delivered; h++) {
+                    delivered = hopWithRetries(len, node->cfg.loss, relay, counters.nodeFrames);
+                }
+                if (delivered) {
+                    nodeHears(*node, flags, dest, buf, len, now + elapsed + relay);
+                } else {
+                    counters.lostFrames++;
+                }
+            }
+        }
+    }
+
+    txBusyFrom = now;
+    txBusyUntil = now + elapsed;
+    SimClock::advance(elapsed);
+    return result;
+}
+
+bool VirtualNetwork::available()
+{
+    HeapTracker::Scope simulator(false);
+    deliverDue(millis());
+    return !rxBuffer.empty();
+}
+
+bool VirtualNetwork::receive(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flags, uint8_t *hops)
+{
+    HeapTracker::Scope simulator(false);
+    deliverDue(millis());
+    if (rxBuffer.empty()) {
+        return false;
+    }
+    Frame frame = rxBuffer.front();
+    rxBuffer.pop_front();
+    if (frame.replayed) counters.replaysRead++;
+    else if (frame.flags == Protocol::MessageType::HELLO && frame.periodic) counters.hellos++;
+    else if (frame.flags == Protocol::MessageType::DATA_ATMOSPHERIC) counters.atmosReplies++;
+    else if (frame.flags == Protocol::MessageType::DATA_GPS_CROUND) counters.groundReplies++;
+
+    uint8_t copy = frame.len < *len ? frame.len : *len;
+    memcpy(buf, frame.data, copy);
+    *len = copy;
+    if (from != nullptr) *from = frame.from;
+    if (flags != nullptr) *flags = frame.flags;
+    if (hops != nullptr) *hops = frame.hops;
+
+    Node *node = find(frame.from);
+    rssi = node->cfg.rssi + (frame.txPower - RADIO_TX_POWER) + (int16_t)uniform(6) - 3;
+    snr = (int8_t)lround(linkSnr(*node, frame.profile, frame.txPower)) + (int8_t)uniform(4) - 2;
+
+    // La trama entra a la tabla de rutas del gateway y se confirma con un ACK en el perfil de la radio
+    addRoute(frame.from, nextHopOf(*node));
+    uint32_t ack = SIM_TURNAROUND_MS + airtimeMs(ACK_LEN, gatewaySf, gatewayBwKhz);
+    counters.gatewayFrames++;
+    counters.airtimeMs += ack - SIM_TURNAROUND_MS;
+    counters.gatewayAirtimeMs += ack - SIM_TURNAROUND_MS;
+    txBusyFrom = millis();
+    txBusyUntil = txBusyFrom + ack;
+    SimClock::advance(ack);
+
+    frameConsumed(frame);
+    return true;
+}
+
+bool VirtualNetwork::receiveTimeout(uint8_t *buf, uint8_t *len, uint16_t timeout, uint8_t *from, uint8_t *flags, uint8_t *hops)
+{
+    HeapTracker::Scope simulator(false);
+    unsigned long end = millis() + timeout;
+    while (true) {
+        if (receive(buf, len, from, flags, hops)) {
+            return true;
+        }
+        unsigned long now = millis();
+        if ((long)(end - now) <= 0) {
+            return false;
+        }
+        unsigned long next = end;
+        if (!pending.empty() && (long)(pending.top().at - end) < 0) {
+            next = pending.top().at;
+        }
+        SimClock::advance((long)(next - now) > 0 ? next - now : 1);
+    }
+}
+
+int16_t VirtualNetwork::lastRssi() const
+{
+    return rssi;
+}
+
+int8_t VirtualNetwork::lastSnr() const
+{
+    return snr;
+}
+
+void VirtualNetwork::setGatewayModem(uint8_t spreadingFactor, uint16_t bandwidthKhz, int8_t txPower)
+{
+    gatewaySf = spreadingFactor;
+    gatewayBwKhz = bandwidthKhz;
+    gatewayTxPower = txPower;
+}
+
+bool VirtualNetwork::nodeLinkProfile(uint8_t address, uint8_t &profile, int8_t &txPower) const
+{
+    if (index[address] < 0) {
+        return false;
+    }
+    const Node &node = nodes[index[address]];
+    profile = node.linkProfile;
+    txPower = node.linkTxPower;
+    return true;
+}
+
+void VirtualNetwork::loseCounters()
+{
+    for (Node &node : nodes) {
+        for (uint8_t i = 0; i < FrameAuth::SALT_LEN; i++) {
+            node.authSalt[i] = (uint8_t)uniform(255);
+        }
+        node.authCounter = 0;
+        node.gatewaySession = false;
+        node.authChallenge = 0;
+        node.authEcho = 0;
+    }
+}
+
+unsigned VirtualNetwork::replayOldHellos()
+{
+    HeapTracker::Scope simulator(false);
+    unsigned replayed = 0;
+    for (Node &node : nodes) {
+        if (node.firstHelloLen == 0) {
+            continue;
+        }
+        // Ya sellado: se agenda como cualquier trama del nodo pero sin sellar de nuevo
+        Frame frame = {};
+        frame.sentAt = millis() + uniform(SIM_GREETING_JITTER_MS);
+        frame.from = node.address;
+        frame.flags = Protocol::MessageType::HELLO;
+        frame.hops = node.cfg.hops - 1;
+        frame.profile = Protocol::RADIO_PROFILE_DEFAULT;
+        frame.txPower = RADIO_TX_POWER;
+        frame.sealed = true;
+        frame.replayed = true;
+        frame.len = node.firstHelloLen;
+        memcpy(frame.data, node.firstHello, frame.len);
+        uint32_t elapsed = 0;
+        for (uint8_t h = 1; h < node.cfg.hops && !frame.lost; h++) {
+            frame.lost = !hopWithRetries(frame.len, node.cfg.loss, elapsed, counters.nodeFrames);
+        }
+        frame.at = frame.sentAt + elapsed + airtimeMs(frame.len + ROUTED_HEADER_LEN);
+        pending.push(frame);
+        replayed++;
+    }
+    return replayed;
+}
+
+uint32_t VirtualNetwork::retransmissions() const
+{
+    return gatewayRetransmissions;
+}
+
+const VirtualNetwork::Stats &VirtualNetwork::stats() const
+{
+    return counters;
+}
+
+uint32_t VirtualNetwork::airtimeMs(uint8_t payloadLen, uint8_t spreadingFactor, uint16_t bandwidthKhz)
+{
+    // Fórmula de Semtech (AN1200.13) con CR4/5, header explícito, CRC, preámbulo 8
+    const int sf = spreadingFactor;
+    const double symbolMs = (double)(1 << sf) / bandwidthKhz;
+    const int lowDataRate = symbolMs > 16.0 ? 1 : 0;  // LowDataRateOptimize (SF11/12 a 125 kHz)
+    int numerator = 8 * payloadLen - 4 * sf + 28 + 16;
+    int divisor = 4 * (sf - 2 * lowDataRate);
+    int blocks = numerator > 0 ? (numerator + divisor - 1) / divisor : 0;
+    double symbols = 8 + 4.25 + 8 + blocks * 5;
+    return (uint32_t)ceil(symbols * symbolMs);
+}
+
+VirtualNetwork::Node *VirtualNetwork::find(uint8_t address)
+{
+    return index[address] < 0 ? nullptr : &nodes[index[address]];
+}
+
+bool VirtualNetwork::chance(float p)
+{
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < p;
+}
+
+uint32_t VirtualNetwork::uniform(uint32_t max)
+{
+    return max == 0 ? 0 : std::uniform_int_distribution<uint32_t>(0, max)(rng);
+}
+
+/** Igual que AppLogic::slotPosition() del nodo: posición entre los IDs marcados. */
+bool VirtualNetwork::slotPosition(const uint8_t *nodes, uint8_t address, uint16_t &position)
+{
+    if ((nodes[address / 8] & (1 << (address % 8))) == 0) {
+        return false;
+    }
+    position = 0;
+    for (uint8_t i = 0; i < address / 8; i++) {
+        position += __builtin_popcount(nodes[i]);
+    }
+    position += __builtin_popcount(nodes[address / 8] & ((1 << (address % 8)) - 1));
+    return true;
+}
+
+bool VirtualNetwork::hopWithRetries(uint8_t len, float loss, uint32_t &elapsed, uint32_t &frames)
+{
+    uint32_t dataAir = airtimeMs(len + ROUTED_HEADER_LEN);
+    for (uint8_t attempt = 0; attempt <= RH_DEFAULT_RETRIES; attempt++) {
+        frames++;
+        counters.airtimeMs += dataAir;
+        elapsed += dataAir;
+        if (!chance(loss)) {
+            uint32_t ackAir = airtimeMs(ACK_LEN);
+            counters.airtimeMs += ackAir;
+            elapsed += SIM_TURNAROUND_MS + ackAir;
+            return true;
+        }
+        // RHReliableDatagram espera entre timeout y 2*timeout antes de reintentar
+        elapsed += RH_DEFAULT_TIMEOUT + uniform(RH_DEFAULT_TIMEOUT);
+        if (attempt < RH_DEFAULT_RETRIES) {
+            counters.linkRetries++;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief SNR del último salto en dB con el perfil y la potencia dados
+ * @details cfg.snr es la del perfil default a RADIO_TX_POWER; duplicar el
+ * ancho de banda duplica el ruido (-3 dB).
+ */
+float VirtualNetwork::linkSnr(const Node &node, uint8_t profile, int8_t txPower) const
+{
+    return node.cfg.snr + (txPower - RADIO_TX_POWER) -
+           10.0f * log10f(Protocol::RADIO_PROFILES[profile].bandwidthKhz / 125.0f);
+}
+
+/**
+ * @brief Pérdida por intento del último salto
+ * @details Con margen de SNR la pérdida es cfg.loss; debajo de la SNR mínima
+ * del SF la probabilidad de recibir cae a la mitad cada ~1.4 dB. Los nodos de
+ * varios saltos llegan por un vecino que no se modela: usan cfg.loss.
+ */
+float VirtualNetwork::lastHopLoss(const Node &node, uint8_t profile, int8_t txPower) const
+{
+    if (node.cfg.hops > 1) {
+        return node.cfg.loss;
+    }
+    float margin = linkSnr(node, profile, txPower) -
+                   LinkAdr::requiredSnr(Protocol::RADIO_PROFILES[profile].spreadingFactor) / 10.0f;
+    if (margin >= 0.0f) {
+        return node.cfg.loss;
+    }
+    return 1.0f - (1.0f - node.cfg.loss) * expf(margin / 2.0f);
+}
+
+bool VirtualNetwork::gatewayListens(uint8_t profile) const
+{
+    return Protocol::RADIO_PROFILES[profile].spreadingFactor == gatewaySf &&
+           Protocol::RADIO_PROFILES[profile].bandwidthKhz == gatewayBwKhz;
+}
+
+RHRouter::RoutingTableEntry *VirtualNetwork::route(uint8_t dest)
+{
+    for (RHRouter::RoutingTableEntry &r : routes) {
+        if (r.dest == dest && r.state != RHRouter::Invalid) {
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+void VirtualNetwork::addRoute(uint8_t dest, uint8_t nextHop, uint8_t state)
+{
+    // Igual que RHRouter::addRouteTo(): actualiza, ocupa un hueco o descarta la más vieja
+    for (RHRouter::RoutingTableEntry &r : routes) {
+        if (r.dest == dest) {
+            r.next_hop = nextHop;
+            r.state = state;
+            return;
+        }
+    }
+    for (RHRouter::RoutingTableEntry &r : routes) {
+        if (r.state == RHRouter::Invalid) {
+            r = {dest, nextHop, state};
+            return;
+        }
+    }
+    memmove(&routes[0], &routes[1], sizeof(routes) - sizeof(routes[0]));
+    routes[RH_ROUTING_TABLE_SIZE - 1] = {dest, nextHop, state};
+}
+
+bool VirtualNetwork::deleteRoute(uint8_t dest)
+{
+    for (uint8_t i = 0; i < RH_ROUTING_TABLE_SIZE; i++) {
+        if (routes[i].dest == dest) {
+            memmove(&routes[i], &routes[i + 1], sizeof(routes[0]) * (RH_ROUTING_TABLE_SIZE - i - 1));
+            routes[RH_ROUTING_TABLE_SIZE - 1].state = RHRouter::Invalid;
+            return true;
+        }
+    }
+    return false;
+}
+
+void VirtualNetwork::clearRoutes()
+{
+    for (RHRouter::RoutingTableEntry &r : routes) {
+        r.state = RHRouter::Invalid;
+    }
+}
+
+bool VirtualNetwork::discover(uint8_t dest)
+{
+    HeapTracker::Scope simulator(false);
+    unsigned long now = millis();
+    deliverDue(now);
+    discardUnread(true);
+    Node *node = find(dest);
+    uint32_t elapsed = 0;
+    bool found = false;
+    if (node == nullptr) {
+        elapsed = unansweredDiscovery();
+    } else {
+        found = discoverRoute(*node, elapsed);
+    }
+    txBusyFrom = now;
+    txBusyUntil = now + elapsed;
+    SimClock::advance(elapsed);
+    return found;
+}
+
+uint8_t VirtualNetwork::nextHopOf(const Node &node) const
+{
+    if (node.cfg.hops <= 1) {
+        return node.address;
+    }
+    // Cada nodo lejano sale siempre por el mismo vecino directo
+    unsigned direct = 0;
+    for (const Node &n : nodes) {
+        direct += n.cfg.hops == 1;
+    }
+    unsigned pick = direct > 0 ? node.address % direct : 0;
+    for (const Node &n : nodes) {
+        if (n.cfg.hops == 1 && pick-- == 0) {
+            return n.address;
+        }
+    }
+    return node.address;
+}
+
+bool VirtualNetwork::discoverRoute(Node &node, uint32_t &elapsed)
+{
+    counters.routeDiscoveries++;
+    // El pedido de ruta se inunda sin ACK; cada salto agrega un byte a la lista
+    uint32_t spent = 0;
+    bool ok = true;
+    for (uint8_t h = 0; h < node.cfg.hops && ok; h++) {
+        uint32_t air = airtimeMs(ROUTE_REQUEST_LEN + h);
+        counters.airtimeMs += air;
+        if (h == 0) {
+            counters.gatewayFrames++;
+            counters.gatewayAirtimeMs += air;
+        } else {
+            counters.nodeFrames++;
+        }
+        spent += air + SIM_TURNAROUND_MS;
+        ok = !chance(node.cfg.loss);
+    }
+    // La respuesta vuelve por unicast confiable salto a salto
+    for (uint8_t h = 0; h < node.cfg.hops && ok; h++) {
+        ok = hopWithRetries(ROUTE_REQUEST_LEN + node.cfg.hops - ROUTED_HEADER_LEN, node.cfg.loss, spent, counters.nodeFrames);
+    }
+    if (!ok || spent > RH_MESH_ARP_TIMEOUT) {
+        elapsed += RH_MESH_ARP_TIMEOUT;
+        return false;
+    }
+    elapsed += spent;
+    addRoute(node.address, nextHopOf(node));
+    return true;
+}
+
+uint32_t VirtualNetwork::unansweredDiscovery()
+{
+    // Nadie responde al pedido de ruta: RHMesh espera RH_MESH_ARP_TIMEOUT
+    counters.routeDiscoveries++;
+    counters.gatewayFrames++;
+    counters.airtimeMs += airtimeMs(ROUTE_REQUEST_LEN);
+    counters.gatewayAirtimeMs += airtimeMs(ROUTE_REQUEST_LEN);
+    return RH_MESH_ARP_TIMEOUT;
+}
+
+/**
+ * @brief Un nodo abre una trama del gateway como RadioManager::openReceived() del firmware
+ * @details Sin la sal vigente del gateway la descarta y agenda un saludo
+ * vacío; un saludo del gateway con el eco de su desafío le da la sal.
+ */
+void VirtualNetwork::nodeHears(Node &node, uint8_t flags, uint8_t dest, const uint8_t *buf, uint8_t len,
+                               unsigned long arrival)
+{
+    if (AUTH_ENABLED != 1) {
+        nodeReceives(node, flags, buf, len, arrival);
+        return;
+    }
+    uint8_t plain[RH_MESH_MAX_MESSAGE_LEN];
+    uint8_t plainLen = len;
+    memcpy(plain, buf, len);
+    uint32_t counter;
+    bool fresh;
+    if (flags == Protocol::MessageType::HELLO || flags == Protocol::MessageType::ANNOUNCE) {
+        uint8_t salt[FrameAuth::SALT_LEN];
+        uint32_t challenge;
+        uint32_t echo;
+        if (!FrameAuth::openGreetingFrame(NETWORK_KEY, gateway, dest, flags, plain, plainLen, salt, counter,
+                                          challenge, echo)) {
+            counters.authRejects++;
+            return;
+        }
+        fresh = node.gatewaySession && memcmp(salt, node.gatewaySalt, FrameAuth::SALT_LEN) == 0;
+        if (node.authChallenge != 0 && echo == node.authChallenge) {
+            // El gateway devolvió el desafío: su sal es la vigente
+            memcpy(node.gatewaySalt, salt, FrameAuth::SALT_LEN);
+            node.gatewaySession = true;
+            node.authChallenge = 0;
+            fresh = true;
+        }
+        if (challenge != 0) {
+            node.authEcho = challenge;
+        }
+        if (!fresh || challenge != 0) {
+            nodeGreets(node, !fresh, arrival + (challenge != 0 ? SIM_TURNAROUND_MS : uniform(SIM_GREETING_JITTER_MS)));
+        }
+    } else {
+        fresh = node.gatewaySession &&
+                FrameAuth::openFrame(NETWORK_KEY, node.gatewaySalt, gateway, dest, flags, plain, plainLen, counter);
+        if (!fresh) {
+            nodeGreets(node, true, arrival + uniform(SIM_GREETING_JITTER_MS));
+        }
+    }
+    if (!fresh) {
+        counters.authRejects++;
+        return;
+    }
+    nodeReceives(node, flags, plain, plainLen, arrival);
+}
+
+/**
+ * @brief Agenda el saludo vacío del nodo al gateway (uno en camino a la vez)
+ * @param renew Sin sesión vigente: el saludo pide un desafío
+ */
+void VirtualNetwork::nodeGreets(Node &node, bool renew, unsigned long at)
+{
+    if (renew && node.authChallenge == 0) {
+        node.authChallenge = 1 + uniform(0xFFFFFFFEUL);
+    }
+    if (node.greetingQueued) {
+        return;  // Se sella al salir: lleva el desafío y el eco de ese momento
+    }
+    node.greetingQueued = true;
+    counters.greetings++;
+    uint8_t empty[1];
+    nodeSends(node, Protocol::MessageType::HELLO, empty, 0, at);
+}
+
+void VirtualNetwork::nodeReceives(Node &node, uint8_t flags, const uint8_t *buf, uint8_t len, unsigned long arrival)
+{
+    switch (flags) {
+    case Protocol::MessageType::ANNOUNCE: {
+        if (!node.heardAnnounce) {
+            // Cada nodo arrancó en otro momento: el primer HELLO cae en cualquier punto del período
+            node.heardAnnounce = true;
+            nodeSends(node, Protocol::MessageType::HELLO, reinterpret_cast<uint8_t *>(&node.hello),
+                      sizeof(node.hello), arrival + uniform(SIM_HELLO_INTERVAL));
+        }
+        Protocol::SlotSchedule schedule = {};
+        if (len < offsetof(Protocol::SlotSchedule, features)) {
+            break;
+        }
+        memcpy(&schedule, buf, len < sizeof(schedule) ? len : sizeof(schedule));
+        node.gatewayFeatures = schedule.features;
+        uint16_t position;
+        if (!slotPosition(schedule.nodes, node.address, position)) {
+            break;
+        }
+        counters.slotPushes++;
+        sendAtmospheric(node, arrival + schedule.firstSlotMs + (unsigned long)position * schedule.slotMs, false);
+        break;
+    }
+    case Protocol::MessageType::LINK_PROFILE: {
+        Protocol::LinkProfileCommand command;
+        if (len != sizeof(command)) {
+            break;
+        }
+        memcpy(&command, buf, sizeof(command));
+        if (command.key != Protocol::KEY || command.profile >= Protocol::RADIO_PROFILE_COUNT) {
+            break;
+        }
+        if (command.profile != node.linkProfile || command.txPower != node.linkTxPower) {
+            counters.adrCommands++;
+            counters.lastAdrCommandAt = arrival;
+        }
+        node.linkProfile = command.profile;
+        node.linkTxPower = command.txPower;
+        node.linkFailures = 0;
+        break;
+    }
+    case Protocol::MessageType::BATCH_ACK: {
+        // Como AppLogic::handleBatchAck() del nodo: solo cuenta el del último lote atmosférico
+        Protocol::BatchAck ack;
+        if (len < sizeof(ack)) {
+            break;
+        }
+        memcpy(&ack, buf, sizeof(ack));
+        if (ack.key == Protocol::KEY && node.atmosAckPending && ack.seq == node.atmosSeq) {
+            node.atmosAckPending = false;
+            counters.batchAcks++;
+        }
+        break;
+    }
+    case Protocol::MessageType::REQUEST_DATA_ATMOSPHERIC:
+        if (len >= 2) {
+            node.gatewayFeatures = buf[1];
+        }
+        if (len >= sizeof(Protocol::PollWindow)) {
+            // Pedido broadcast: slot según la posición en el bitmap, en el perfil default
+            Protocol::PollWindow window;
+            memcpy(&window, buf, sizeof(window));
+            uint16_t position;
+            if (node.heardAnnounce && slotPosition(window.nodes, node.address, position)) {
+                counters.slotPushes++;
+                sendAtmospheric(node, arrival + window.firstSlotMs + (unsigned long)position * window.slotMs, false);
+            }
+            break;
+        }
+        counters.atmosRequests++;
+        if (node.heardAnnounce) {
+            sendAtmospheric(node, arrival + node.cfg.latencyMs + uniform(node.cfg.jitterMs), true);
+        }
+        break;
+    case Protocol::MessageType::REQUEST_DATA_GPC_GROUND: {
+        counters.groundRequests++;
+        if (len >= 2) {
+            node.gatewayFeatures = buf[1];
+        }
+        if (!node.heardAnnounce) {
+            break;
+        }
+        Protocol::GroundGpsPacket packet = {};
+        packet.ground.temp = (int16_t)(180 + uniform(50));
+        packet.ground.moisture = (uint16_t)(300 + uniform(200));
+        packet.ground.PH = (uint8_t)(60 + uniform(15));
+        packet.gps.latitude = -345000000;
+        packet.gps.longitude = -585000000;
+        packet.energy.volt = (uint16_t)(1200 + uniform(60));
+        // Cada pedido es una lectura nueva: siempre un lote nuevo
+        uint8_t payload[sizeof(Protocol::BatchHeader) + sizeof(packet) + sizeof(Protocol::GroundAge)];
+        uint8_t payloadLen = withBatchHeader(node, true, reinterpret_cast<uint8_t *>(&packet), sizeof(packet), payload);
+        if (!node.cfg.groundCache) {
+            nodeSends(node, Protocol::MessageType::DATA_GPS_CROUND, payload, payloadLen,
+                      arrival + node.cfg.groundLatencyMs + uniform(node.cfg.jitterMs));
+            break;
+        }
+        // Con caché la lectura ya está hecha: responde como al pedido atmosférico
+        if (node.gatewayFeatures & Protocol::FEATURE_GROUND_AGE) {
+            Protocol::GroundAge age = {SIM_GROUND_CACHE_AGE_S};
+            memcpy(payload + payloadLen, &age, sizeof(age));
+            payloadLen += sizeof(age);
+        }
+        nodeSends(node, Protocol::MessageType::DATA_GPS_CROUND, payload, payloadLen,
+                  arrival + node.cfg.latencyMs + uniform(node.cfg.jitterMs));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void VirtualNetwork::sendAtmospheric(Node &node, unsigned long at, bool useLinkProfile)
+{
+    Protocol::AtmosphericSample samples[NUMERO_MUESTRAS_ATMOSFERICAS];
+    for (uint8_t i = 0; i < NUMERO_MUESTRAS_ATMOSFERICAS; i++) {
+        // La muestra más nueva es la última, tomada justo antes del envío
+        unsigned long age = (unsigned long)(NUMERO_MUESTRAS_ATMOSFERICAS - 1 - i) * SIM_SAMPLE_PERIOD_S * 1000UL;
+        unsigned long taken = at > age ? at - age : 0;
+        node.temp = (int16_t)(node.temp + (int16_t)uniform(6) - 3);
+        node.moisture = (uint16_t)(node.moisture + (int16_t)uniform(10) - 5);
+        samples[i].temp = node.temp;
+        samples[i].moisture = node.moisture;
+        samples[i].hour = (uint8_t)((taken / 3600000UL) % 24);
+        samples[i].minute = (uint8_t)((taken / 60000UL) % 60);
+    }
+
+    uint8_t packed[sizeof(samples)];
+    size_t len = 0;
+    if (node.gatewayFeatures & Protocol::FEATURE_PACKED_ATMOSPHERIC) {
+        len = AtmosCodec::encode(samples, NUMERO_MUESTRAS_ATMOSFERICAS, SIM_SAMPLE_PERIOD_S, packed, sizeof(packed));
+    }
+    if (len == 0) {
+        memcpy(packed, samples, sizeof(samples));
+        len = sizeof(samples);
+    } else {
+        counters.packedSends++;
+    }
+    // El lote cambia cuando el nodo tomó una muestra desde el último envío
+    unsigned long sample = at / (SIM_SAMPLE_PERIOD_S * 1000UL);
+    uint8_t payload[sizeof(Protocol::BatchHeader) + sizeof(samples)];
+    uint8_t payloadLen = withBatchHeader(node, !node.batchSent || sample != node.batchSample, packed, (uint8_t)len, payload);
+    node.batchSample = sample;
+    bool sequenced = payloadLen > len;
+    node.atmosSeq = node.batchSeq;
+    node.atmosAckPending = sequenced && (node.gatewayFeatures & Protocol::FEATURE_BATCH_ACK);
+    if (node.atmosAckPending) {
+        counters.batchAckWaits++;
+    }
+    // Igual que el firmware del nodo: solo la respuesta a un pedido usa el perfil del enlace
+    uint8_t profile = Protocol::RADIO_PROFILE_DEFAULT;
+    int8_t txPower = RADIO_TX_POWER;
+    if (useLinkProfile && (node.linkProfile != profile || node.linkTxPower != txPower)) {
+        profile = node.linkProfile;
+        txPower = node.linkTxPower;
+        at += SIM_ADR_SWITCH_GUARD_MS;
+    }
+    counters.atmosBytes += payloadLen;
+    nodeSends(node, Protocol::MessageType::DATA_ATMOSPHERIC, payload, payloadLen, at, profile, txPower);
+}
+
+/**
+ * @brief Antepone Protocol::BatchHeader como el firmware del nodo, si el gateway lo acepta
+ * @param newBatch false si es el mismo lote del envío anterior (repite el número)
+ * @return Largo escrito en out
+ */
+uint8_t VirtualNetwork::withBatchHeader(Node &node, bool newBatch, const uint8_t *data, uint8_t len, uint8_t *out)
+{
+    if (!(node.gatewayFeatures & Protocol::FEATURE_BATCH_SEQUENCE)) {
+        memcpy(out, data, len);
+        return len;
+    }
+    if (newBatch && node.batchSent && ++node.batchSeq == 0) {
+        node.batchSeq = 1;  // 0 queda para el primer lote tras un arranque
+    }
+    node.batchSent = true;
+    Protocol::BatchHeader header = {node.batchSeq};
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), data, len);
+    return (uint8_t)(sizeof(header) + len);
+}
+
+void VirtualNetwork::nodeSends(Node &node, uint8_t flags, const uint8_t *data, uint8_t len, unsigned long sentAt,
+                               uint8_t profile, int8_t txPower)
+{
+    Frame frame;
+    frame.sentAt = sentAt;
+    frame.from = node.address;
+    frame.flags = flags;
+    frame.hops = node.cfg.hops - 1;
+    frame.attempt = 0;
+    frame.lost = false;
+    frame.profile = profile;
+    frame.txPower = txPower;
+    frame.len = len;
+    frame.sealed = AUTH_ENABLED != 1;
+    frame.periodic = flags == Protocol::MessageType::HELLO && len > 0;
+    frame.replayed = false;
+    memcpy(frame.data, data, len);
+    if (!frame.sealed) {
+        // Se sella al llegar (deliverDue): los envíos se agendan fuera de orden
+        len += flags == Protocol::MessageType::HELLO ? FrameAuth::GREETING_OVERHEAD : FrameAuth::OVERHEAD;
+    }
+
+    // Saltos previos al gateway; el último se resuelve al llegar (ver deliverDue)
+    uint32_t elapsed = 0;
+    for (uint8_t h = 1; h < node.cfg.hops && !frame.lost; h++) {
+        frame.lost = !hopWithRetries(len, node.cfg.loss, elapsed, counters.nodeFrames);
+    }
+    const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[profile];
+    frame.at = sentAt + elapsed + airtimeMs(len + ROUTED_HEADER_LEN, p.spreadingFactor, p.bandwidthKhz);
+    pending.push(frame);
+}
+
+void VirtualNetwork::deliverDue(unsigned long now)
+{
+    while (!pending.empty() && (long)(pending.top().at - now) <= 0) {
+        Frame frame = pending.top();
+        pending.pop();
+        if (!frame.sealed) {
+            Node *sender = find(frame.from);
+            if (frame.flags == Protocol::MessageType::HELLO) {
+                frame.len = FrameAuth::sealGreetingFrame(NETWORK_KEY, sender->authSalt, frame.from, gateway,
+                                                         frame.flags, sender->authCounter++, sender->authChallenge,
+                                                         sender->authEcho, frame.data, frame.len);
+                sender->authEcho = 0;
+                if (frame.periodic && sender->firstHelloLen == 0) {
+                    sender->firstHelloLen = frame.len;
+                    memcpy(sender->firstHello, frame.data, frame.len);
+                }
+            } else {
+                frame.len = FrameAuth::sealFrame(NETWORK_KEY, sender->authSalt, frame.from, gateway, frame.flags,
+                                                 sender->authCounter++, frame.data, frame.len);
+            }
+            frame.sealed = true;
+        }
+        if (frame.lost) {
+            counters.lostFrames++;
+            frameConsumed(frame);
+            continue;
+        }
+
+        Node *node = find(frame.from);
+        const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[frame.profile];
+        uint32_t air = airtimeMs(frame.len + ROUTED_HEADER_LEN, p.spreadingFactor, p.bandwidthKhz);
+        counters.nodeFrames++;
+        counters.airtimeMs += air;
+
+        bool gatewayBusy = (long)(frame.at - txBusyFrom) >= 0 && (long)(frame.at - txBusyUntil) < 0;
+        bool bufferFull = rxBuffer.size() >= SIM_RX_DEPTH;
+        bool tuned = gatewayListens(frame.profile);
+        bool linkFrame = frame.profile != Protocol::RADIO_PROFILE_DEFAULT || frame.txPower != RADIO_TX_POWER;
+        if (!gatewayBusy && !bufferFull && tuned && !chance(lastHopLoss(*node, frame.profile, frame.txPower))) {
+            if (linkFrame) {
+                node->linkFailures = 0;
+            }
+            rxBuffer.push_back(frame);
+            continue;
+        }
+        if (gatewayBusy || bufferFull) {
+            counters.rxOverruns++;
+        } else if (!tuned) {
+            counters.profileMisses++;
+        }
+        retryFrame(frame);
+    }
+}
+
+/**
+ * @brief Sin ACK del gateway: el nodo reintenta como RHReliableDatagram
+ */
+void VirtualNetwork::retryFrame(Frame frame)
+{
+    Node *node = find(frame.from);
+    bool linkFrame = frame.profile != Protocol::RADIO_PROFILE_DEFAULT || frame.txPower != RADIO_TX_POWER;
+    if (++frame.attempt > RH_DEFAULT_RETRIES) {
+        counters.lostFrames++;
+        if (linkFrame && ++node->linkFailures >= SIM_ADR_NODE_MAX_FAILURES) {
+            // Como el firmware del nodo: sin ACK en su perfil vuelve al default
+            counters.adrFallbacks++;
+            node->linkProfile = Protocol::RADIO_PROFILE_DEFAULT;
+            node->linkTxPower = RADIO_TX_POWER;
+            node->linkFailures = 0;
+        }
+        frameConsumed(frame);
+        return;
+    }
+    counters.linkRetries++;
+    // Timeout de ACK escalado al perfil como en RadioManager::applyProfile()
+    const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[frame.profile];
+    uint32_t air = airtimeMs(frame.len + ROUTED_HEADER_LEN, p.spreadingFactor, p.bandwidthKhz);
+    uint32_t timeout = RH_DEFAULT_TIMEOUT + 30 * (1UL << p.spreadingFactor) / p.bandwidthKhz;
+    frame.at += timeout + uniform(timeout) + air;
+    pending.push(frame);
+}
+
+/**
+ * @brief El gateway lee y tira las tramas que tenía sin leer
+ * @param acknowledged true si se confirman (RHMesh::doArp): el nodo no reintenta y se pierden
+ */
+void VirtualNetwork::discardUnread(bool acknowledged)
+{
+    while (!rxBuffer.empty()) {
+        Frame frame = rxBuffer.front();
+        rxBuffer.pop_front();
+        counters.unreadDiscards++;
+        if (acknowledged) {
+            counters.lostFrames++;
+            frameConsumed(frame);
+        } else {
+            retryFrame(frame);
+        }
+    }
+}
+
+void VirtualNetwork::frameConsumed(const Frame &frame)
+{
+    if (frame.flags == Protocol::MessageType::HELLO && !frame.periodic && !frame.replayed) {
+        find(frame.from)->greetingQueued = false;
+    }
+    // Los nodos registrados repiten el HELLO cada SIM_HELLO_INTERVAL pase lo que pase con el anterior
+    if (frame.flags == Protocol::MessageType::HELLO && frame.periodic) {
+        Node *node = find(frame.from);
+        nodeSends(*node, Protocol::MessageType::HELLO, reinterpret_cast<uint8_t *>(&node->hello),
+                  sizeof(node->hello), frame.sentAt + SIM_HELLO_INTERVAL);
+    }
+}
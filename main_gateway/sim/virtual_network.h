@@ -0,0 +1,316 @@
+/**
+ * @file virtual_network.h
+ * @brief Red LoRa mesh virtual que rodea al gateway en la simulación nativa
+ *
+ * Modela N nodos remotos con latencia, pérdida y cantidad de saltos
+ * configurables. El gateway corre el firmware real (AppLogic, RadioManager);
+ * el RHMesh falso delega aquí cada envío y recepción.
+ *
+ * Simplificaciones conocidas:
+ * - El tráfico de control va en Protocol::RADIO_PROFILE_DEFAULT (SF7/BW125/CR4-5).
+ *   Un vecino directo con LINK_PROFILE responde los pedidos atmosféricos en su
+ *   perfil y potencia; el gateway solo la oye si su radio está en ese perfil.
+ *   En el último salto de un vecino directo la pérdida crece cuando la SNR del
+ *   enlace cae debajo de la mínima del SF. No hay colisiones entre nodos, solo
+ *   entre el gateway transmitiendo y las tramas que le llegan.
+ * - El ANNOUNCE broadcast alcanza a toda la red (los nodos reales lo
+ *   retransmiten como inundación); cada nodo lo pierde con la tasa de pérdida.
+ *   Si trae Protocol::SlotSchedule los nodos envían en su slot como el firmware;
+ *   lo mismo con el REQUEST_DATA_ATMOSPHERIC broadcast (Protocol::PollWindow).
+ * - Las muestras atmosféricas son una caminata aleatoria por nodo tomada cada
+ *   SIM_SAMPLE_PERIOD_S; se comprimen con AtmosCodec si el gateway anuncia
+ *   Protocol::FEATURE_PACKED_ATMOSPHERIC. No guardan un anillo de muestras:
+ *   solo cuentan los BATCH_ACK que confirman su último lote.
+ * - Los saltos intermedios no consumen tiempo del gateway, solo latencia.
+ * - La tabla de rutas del gateway se modela como la de RHRouter
+ *   (RH_ROUTING_TABLE_SIZE entradas, se descarta la más vieja); los nodos
+ *   siempre conocen la ruta de vuelta al gateway. El primer salto hacia un
+ *   nodo a más de un salto es un vecino directo fijo; una ruta con otro
+ *   próximo salto (p. ej. restaurada de una topología vieja) no entrega.
+ * - Con AUTH_ENABLED los nodos sellan y abren como el firmware
+ *   (FrameAuth::sealFrame/openFrame y los saludos), pero no controlan
+ *   repeticiones: el canal virtual no repite tramas del gateway. Cada nodo
+ *   arranca con una sal al azar y sin sesión con el gateway; la abre con el
+ *   saludo vacío de RadioManager del nodo al primer ANNOUNCE, así que el
+ *   HELLO periódico empieza con el ANNOUNCE siguiente.
+ */
+
+#ifndef SIM_VIRTUAL_NETWORK_H
+#define SIM_VIRTUAL_NETWORK_H
+
+#include <Arduino.h>
+#include <RHMesh.h>
+#include <deque>
+#include <queue>
+#include <random>
+#include "config.h"
+#include "protocol.h"
+#include "frame_auth.h"
+
+/**
+ * @def SIM_RX_DEPTH
+ * @brief Tramas que el gateway puede tener recibidas sin leer (FIFO del RF95 = 1)
+ */
+#ifndef SIM_RX_DEPTH
+#define SIM_RX_DEPTH 1
+#endif
+
+#define SIM_TURNAROUND_MS 5          /**< @brief Conmutación RX/TX y procesamiento por salto */
+#define SIM_HELLO_INTERVAL 60000     /**< @brief Período de HELLO de los nodos (INTERVALOHELLO del nodo) */
+#define SIM_GREETING_JITTER_MS 2000  /**< @brief Espera al azar del saludo tras un ANNOUNCE (GREETING_JITTER_MS del nodo) */
+#define SIM_SAMPLE_PERIOD_S 35       /**< @brief Período de muestreo atmosférico de los nodos (SAMPLEINTERVALMSATMOSPHERIC) */
+#define SIM_ADR_SWITCH_GUARD_MS 30   /**< @brief Espera del nodo antes de responder en su perfil (ADR_SWITCH_GUARD_MS) */
+#define SIM_ADR_NODE_MAX_FAILURES 2  /**< @brief Respuestas perdidas antes de volver al default (ADR_NODE_MAX_FAILURES) */
+#define SIM_GROUND_CACHE_AGE_S 5     /**< @brief Antigüedad de la lectura de un nodo con caché (GROUND_PREFETCH_LEAD_MS) */
+
+/**
+ * @struct VirtualNodeConfig
+ * @brief Comportamiento de un nodo remoto virtual.
+ */
+struct VirtualNodeConfig {
+    uint16_t latencyMs;       ///< Procesamiento antes de responder un pedido atmosférico
+    uint16_t jitterMs;        ///< Variación aleatoria sumada a la latencia [0, jitter]
+    uint32_t groundLatencyMs; ///< Lectura RS485 + GPS antes de responder DATA_GPS_CROUND
+    bool groundCache;         ///< CAP_GROUND_CACHE: responde de la lectura previa tras latencyMs
+    float loss;               ///< Probabilidad de perder una trama por intento y por salto
+    uint8_t hops;             ///< Saltos entre el gateway y el nodo (1 = vecino directo)
+    int16_t rssi;             ///< RSSI medio visto por el gateway en dBm
+    int8_t snr;               ///< SNR medio visto por el gateway en dB (perfil default a RADIO_TX_POWER)
+};
+
+/**
+ * @class VirtualNetwork
+ * @brief Cola de eventos temporizados con las tramas que llegan al gateway.
+ */
+class VirtualNetwork
+{
+public:
+    /**
+     * @struct Stats
+     * @brief Contadores acumulados del canal virtual.
+     */
+    struct Stats {
+        uint32_t gatewayFrames;   ///< Tramas transmitidas por el gateway (incluye reintentos de enlace)
+        uint32_t nodeFrames;      ///< Tramas transmitidas por los nodos (todos los saltos)
+        uint32_t airtimeMs;       ///< Tiempo de aire total ocupado en el canal
+        uint32_t gatewayAirtimeMs;///< Parte de airtimeMs transmitida por el gateway
+        uint32_t routeDiscoveries;///< Descubrimientos de ruta iniciados por el gateway
+        uint32_t linkRetries;     ///< Reintentos de RHReliableDatagram por falta de ACK
+        uint32_t lostFrames;      ///< Tramas perdidas definitivamente
+        uint32_t rxOverruns;      ///< Tramas que encontraron al gateway ocupado o con el buffer lleno
+        uint32_t unreadDiscards;  ///< Tramas sin leer descartadas por un envío o un ARP del gateway
+        uint32_t atmosRequests;   ///< REQUEST_DATA_ATMOSPHERIC recibidos por los nodos
+        uint32_t groundRequests;  ///< REQUEST_DATA_GPC_GROUND recibidos por los nodos
+        uint32_t hellos;          ///< HELLO leídos por el gateway
+        uint32_t atmosReplies;    ///< DATA_ATMOSPHERIC leídos por el gateway
+        uint32_t slotPushes;      ///< DATA_ATMOSPHERIC enviados en slot (sin pedido o por pedido broadcast)
+        uint32_t packedSends;     ///< DATA_ATMOSPHERIC enviados comprimidos
+        uint32_t atmosBytes;      ///< Bytes de payload DATA_ATMOSPHERIC enviados por los nodos
+        uint32_t groundReplies;   ///< DATA_GPS_CROUND leídos por el gateway
+        uint32_t adrCommands;     ///< LINK_PROFILE que cambiaron el perfil de un nodo
+        uint32_t lastAdrCommandAt;///< millis() del último cambio de perfil
+        uint32_t adrFallbacks;    ///< Nodos que volvieron solos al perfil default
+        uint32_t profileMisses;   ///< Tramas enviadas en un perfil que el gateway no escuchaba
+        uint32_t authRejects;     ///< Tramas del gateway que un nodo no pudo abrir con FrameAuth
+        uint32_t greetings;       ///< Saludos vacíos de FrameAuth enviados por los nodos
+        uint32_t replaysRead;     ///< HELLO viejos de replayOldHellos() leídos por el gateway
+        uint32_t batchAckWaits;   ///< DATA_ATMOSPHERIC numerados que esperan BATCH_ACK (con FEATURE_BATCH_ACK)
+        uint32_t batchAcks;       ///< BATCH_ACK que confirmaron el último lote atmosférico del nodo
+    };
+
+    static VirtualNetwork &instance();
+
+    /**
+     * @brief Reinicia la red
+     * @param gatewayAddress Dirección mesh del gateway
+     * @param seed Semilla del generador aleatorio
+     */
+    void begin(uint8_t gatewayAddress, uint32_t seed);
+
+    /**
+     * @brief Agrega un nodo remoto
+     * @param mac MAC que el nodo anuncia en su HELLO (6 bytes)
+     * @return false si la dirección es inválida o ya existe
+     */
+    bool addNode(uint8_t address, const uint8_t *mac, const VirtualNodeConfig &cfg);
+
+    size_t nodeCount() const;
+
+    /**
+     * @brief Hay una trama recibida sin leer (equivalente a RHGenericDriver::available)
+     */
+    bool available();
+
+    /**
+     * @brief Envío del gateway (equivalente a RHMesh::sendtoWait)
+     * @details Avanza el reloj virtual el tiempo que el gateway queda bloqueado.
+     * Un envío unicast descarta sin ACK la trama que haya sin leer, como
+     * RHReliableDatagram::sendtoWait() mientras espera su ACK.
+     * @return Código RH_ROUTER_ERROR_*
+     */
+    uint8_t send(const uint8_t *buf, uint8_t len, uint8_t dest, uint8_t flags);
+
+    /**
+     * @brief Recepción del gateway (equivalente a RHMesh::recvfromAck)
+     */
+    bool receive(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flags, uint8_t *hops);
+
+    /**
+     * @brief Recepción con espera (equivalente a RHMesh::recvfromAckTimeout)
+     */
+    bool receiveTimeout(uint8_t *buf, uint8_t *len, uint16_t timeout, uint8_t *from, uint8_t *flags, uint8_t *hops);
+
+    int16_t lastRssi() const;
+    int8_t lastSnr() const;
+
+    /**
+     * @brief Configuración actual de la radio del gateway (la informa el RH_RF95 falso)
+     */
+    void setGatewayModem(uint8_t spreadingFactor, uint16_t bandwidthKhz, int8_t txPower);
+
+    /**
+     * @brief Perfil y potencia con que un nodo responde los pedidos
+     * @return false si no hay nodo con esa dirección
+     */
+    bool nodeLinkProfile(uint8_t address, uint8_t &profile, int8_t &txPower) const;
+
+    /**
+     * @brief Todos los nodos se reinician sin /auth_counter.bin
+     * @details Cada uno sigue con una sal nueva, el contador en 0 y sin
+     * sesión con el gateway, que se entera por el próximo saludo.
+     */
+    void loseCounters();
+
+    /**
+     * @brief Cada nodo repite el primer HELLO que envió, tal como salió al aire
+     * @details Un atacante que lo grabó; tras loseCounters() trae la sal vieja.
+     * @return HELLO repetidos (nodos que ya habían enviado uno)
+     */
+    unsigned replayOldHellos();
+
+    /**
+     * @name Tabla de rutas del gateway (la usa el RHRouter falso)
+     * @{
+     */
+    RHRouter::RoutingTableEntry *route(uint8_t dest);
+    void addRoute(uint8_t dest, uint8_t nextHop, uint8_t state = RHRouter::Valid);
+    bool deleteRoute(uint8_t dest);
+    void clearRoutes();
+    /** @} */
+
+    /**
+     * @brief Descubrimiento de ruta sin datos (equivalente a RHMesh::doArp)
+     * @details Avanza el reloj virtual lo que dura la inundación o RH_MESH_ARP_TIMEOUT.
+     * La trama que haya sin leer se confirma y se pierde, como en RHMesh::doArp().
+     */
+    bool discover(uint8_t dest);
+
+    /**
+     * @brief Reenvíos de RHReliableDatagram hechos por el gateway (RHReliableDatagram::retransmissions)
+     */
+    uint32_t retransmissions() const;
+
+    const Stats &stats() const;
+
+    /**
+     * @brief Tiempo en el aire de una trama LoRa CR4/5 con CRC
+     * @param payloadLen Bytes de la trama incluyendo las cabeceras de RadioHead
+     * @param spreadingFactor SF 7..12
+     * @param bandwidthKhz Ancho de banda en kHz
+     * @return Tiempo en milisegundos (redondeado hacia arriba)
+     */
+    static uint32_t airtimeMs(uint8_t payloadLen, uint8_t spreadingFactor = 7, uint16_t bandwidthKhz = 125);
+
+private:
+    /** Nodo remoto virtual. */
+    struct Node {
+        uint8_t address;
+        VirtualNodeConfig cfg;
+        Protocol::HelloPacket hello;   ///< HELLO binario como el del firmware del nodo
+        bool heardAnnounce;
+        uint8_t gatewayFeatures;       ///< Último Protocol::GatewayFeature recibido
+        int16_t temp;                  ///< Última temperatura muestreada
+        uint16_t moisture;             ///< Última humedad muestreada
+        uint8_t linkProfile;           ///< Perfil ordenado por LINK_PROFILE
+        int8_t linkTxPower;            ///< Potencia ordenada por LINK_PROFILE
+        uint8_t linkFailures;          ///< Respuestas seguidas perdidas en ese perfil
+        uint16_t batchSeq;             ///< Protocol::BatchHeader del último lote enviado
+        bool batchSent;                ///< Ya envió un lote desde el arranque
+        unsigned long batchSample;     ///< Período de muestreo del último lote atmosférico
+        uint16_t atmosSeq;             ///< Número del último lote atmosférico
+        bool atmosAckPending;          ///< Ese lote espera BATCH_ACK
+        uint8_t authSalt[FrameAuth::SALT_LEN];    ///< Sal de FrameAuth de este arranque del nodo
+        uint32_t authCounter;                     ///< Próximo contador de FrameAuth del nodo
+        bool gatewaySession;                      ///< Conoce la sal del gateway
+        uint8_t gatewaySalt[FrameAuth::SALT_LEN]; ///< Sal del gateway
+        uint32_t authChallenge;        ///< Desafío pedido al gateway y no devuelto (0 = ninguno)
+        uint32_t authEcho;             ///< Desafío del gateway a devolver en el próximo saludo (0 = ninguno)
+        bool greetingQueued;           ///< Hay un saludo vacío en camino
+        uint8_t firstHelloLen;         ///< Largo sellado de firstHello (0 = todavía no envió)
+        uint8_t firstHello[sizeof(Protocol::HelloPacket) + FrameAuth::GREETING_OVERHEAD]; ///< Primer HELLO, sellado
+    };
+
+    /** Trama en camino hacia el gateway. */
+    struct Frame {
+        unsigned long at;      ///< Llegada al gateway
+        unsigned long sentAt;  ///< Salida del nodo (para encadenar HELLOs)
+        uint8_t from;
+        uint8_t flags;
+        uint8_t hops;
+        uint8_t attempt;       ///< Intentos de entrega en el último salto
+        bool lost;             ///< Perdida en un salto intermedio
+        uint8_t profile;       ///< Perfil en que se transmite el último salto
+        int8_t txPower;        ///< Potencia del último salto en dBm
+        bool sealed;           ///< Ya lleva contador y tag de FrameAuth
+        bool periodic;         ///< HELLO periódico: al consumirse se agenda el siguiente
+        bool replayed;         ///< Copia de replayOldHellos()
+        uint8_t len;
+        uint8_t data[RH_MESH_MAX_MESSAGE_LEN];
+    };
+
+    struct Later {
+        bool operator()(const Frame &a, const Frame &b) const { return (long)(a.at - b.at) > 0; }
+    };
+
+    std::vector<Node> nodes;
+    int16_t index[256];
+    std::priority_queue<Frame, std::vector<Frame>, Later> pending;
+    std::deque<Frame> rxBuffer;
+    RHRouter::RoutingTableEntry routes[RH_ROUTING_TABLE_SIZE]; ///< Tabla de rutas del gateway (orden de alta)
+    unsigned long txBusyFrom = 0;
+    unsigned long txBusyUntil = 0;
+    uint8_t gateway = 0;
+    int16_t rssi = 0;
+    int8_t snr = 0;
+    uint8_t gatewaySf = 7;
+    uint16_t gatewayBwKhz = 125;
+    int8_t gatewayTxPower = RADIO_TX_POWER;
+    std::mt19937 rng;
+    Stats counters = {};
+    uint32_t gatewayRetransmissions = 0;
+
+    Node *find(uint8_t address);
+    bool chance(float p);
+    uint32_t uniform(uint32_t max);
+    static bool slotPosition(const uint8_t *nodes, uint8_t address, uint16_t &position);
+    bool hopWithRetries(uint8_t len, float loss, uint32_t &elapsed, uint32_t &frames);
+    float linkSnr(const Node &node, uint8_t profile, int8_t txPower) const;
+    float lastHopLoss(const Node &node, uint8_t profile, int8_t txPower) const;
+    bool gatewayListens(uint8_t profile) const;
+    uint8_t nextHopOf(const Node &node) const;
+    bool discoverRoute(Node &node, uint32_t &elapsed);
+    uint32_t unansweredDiscovery();
+    void nodeHears(Node &node, uint8_t flags, uint8_t dest, const uint8_t *buf, uint8_t len, unsigned long arrival);
+    void nodeGreets(Node &node, bool renew, unsigned long at);
+    void nodeReceives(Node &node, uint8_t flags, const uint8_t *buf, uint8_t len, unsigned long arrival);
+    void sendAtmospheric(Node &node, unsigned long at, bool useLinkProfile);
+    uint8_t withBatchHeader(Node &node, bool newBatch, const uint8_t *data, uint8_t len, uint8_t *out);
+    void nodeSends(Node &node, uint8_t flags, const uint8_t *data, uint8_t len, unsigned long sentAt,
+                   uint8_t profile = Protocol::RADIO_PROFILE_DEFAULT, int8_t txPower = RADIO_TX_POWER);
+    void deliverDue(unsigned long now);
+    void retryFrame(Frame frame);
+    void discardUnread(bool acknowledged);
+    void frameConsumed(const Frame &frame);
+};
+
+#endif // SIM_VIRTUAL_NETWORK_H
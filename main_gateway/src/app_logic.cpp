@@ -1,6 +1,8 @@
 // 03:00 16/6/2025
 //  AppLogic.cpp (Lógica para un nodo sensor)
 #include "app_logic.h"  // Incluye la definición de la clase AppLogic.
+#include "telemetry_schema.h"
+#include "logger.h"
 
 // TODO:queda implementar logica  errores y posible reinicio si se acomulan
 // TODO: poner funcion RTC y terminar tests
@@ -26,14 +28,21 @@
  * debería ser actualizada para tomar `gwAddress`. Por ahora, documento la versión actual del .cpp
  * e inicializo `gatewayAddress` a un valor por defecto o inválido si no se proporciona.
  */
-AppLogic::AppLogic(NodeIdentity identity, RadioManager radioMgr, RtcManager& rtcMgr)
+AppLogic::AppLogic(NodeIdentity identity, RadioManager& radioMgr, RtcManager& rtcMgr)
   : nodeIdentity(identity),
     radio(radioMgr),
     rtc(rtcMgr),
-    mqttClient(wifiClient) {
+    mqttClient(wifiClient),
+    uplink(wifiClient, mqttClient),
+    mqttBatch(mqttPayload, sizeof(mqttPayload)),
+    atmosPoll(Protocol::MessageType::REQUEST_DATA_ATMOSPHERIC),
+    groundPoll(Protocol::MessageType::REQUEST_DATA_GPC_GROUND, GROUND_POLL_REPLY_TIMEOUT),
+    adr(nodeTable),
+    linkStats(nodeTable),
+    batchSequence(nodeTable) {
   gatewayAddress = nodeIdentity.getNodeID();
-  wifiConnected = false;
-  mqttConnected = false;
+  // Un solo buffer para toda la vida del cliente; alcanza para el lote atmosférico
+  mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
   // begin();
 }
 
@@ -45,6 +54,8 @@ AppLogic::AppLogic(NodeIdentity identity, RadioManager radioMgr, RtcManager& rtc
  * al `gatewayAddress` para anunciar la presencia de este nodo sensor en la red.
  */
 void AppLogic::begin() {
+  outbox.begin();
+  uplink.begin();
 }
 
 /**
@@ -60,104 +71,175 @@ void AppLogic::begin() {
  */
 void AppLogic::update() {
 
-  handleHello();
+  handleIncoming();
   handleUartRequest();
 
-  // Mantener conexión MQTT activa
-  if (wifiConnected && mqttConnected) {
-    mqttClient.loop();
-  }
+  // Conexión WiFi/MQTT: avanza sin bloquear; mientras no haya enlace se encola
+  uplink.update(millis());
 
   timer();
+  servicePoll();
+  serviceGroundPoll();
+
+  // Fin del ciclo atmosférico: se publica el lote incompleto
+  if (mqttBatchNodes > 0 && !atmosPoll.isActive() && !slotWindowOpen) {
+    flushAtmosphericBatch();
+  }
+  drainOutbox();
+  publishLinkStats();
+  warmUpRoutes();
+  radio.update();
+}
+
+const PollEngine &AppLogic::getAtmosphericPoll() const {
+  return atmosPoll;
+}
+
+const OutboxQueue &AppLogic::getOutbox() const {
+  return outbox;
+}
+
+const UplinkManager &AppLogic::getUplink() const {
+  return uplink;
+}
+
+const LinkAdr &AppLogic::getLinkAdr() const {
+  return adr;
+}
+
+const LinkStats &AppLogic::getLinkStats() const {
+  return linkStats;
+}
+
+const SequenceTracker &AppLogic::getBatchSequence() const {
+  return batchSequence;
 }
 /**
- * @brief Envía un mensaje HELLO al Gateway.
+ * @brief Despacha los mensajes recibidos según su tipo.
  *
- * Crea un mensaje de tipo `Protocol::HELLO`.
- * Establece el `nodeID` del mensaje con la identidad de este nodo.
- * El `jsonPayload` para un mensaje HELLO es actualmente una cadena JSON vacía "{}".
- * Serializa el mensaje y lo envía a través de `radio.sendMessage()` al `gatewayAddress`.
- * Registra el envío en la consola serial.
+ * Se llama en cada update(). Las respuestas DATA_ATMOSPHERIC y DATA_GPS_CROUND
+ * llegan por aquí en cualquier momento del ciclo de sondeo, no dentro de una
+ * espera bloqueante; RadioManager las guarda en su RxQueue aunque el gateway
+ * esté transmitiendo otro pedido.
  */
-
-void AppLogic::handleHello() {
-  uint8_t buf[RH_MESH_MAX_MESSAGE_LEN];  // Buffer for the received message
-  uint8_t len;                           // Maximum buffer length
-  uint8_t from;                          // Sender address
-  uint8_t flag;                          // Protocol detection FLAG
-
-  bool triSend = radio.recvMessage(buf, &len, &from, &flag);
-  if (triSend) {
-    Serial.printf("AppLogic::handleHello(): Message received. Sender: 0x%02X, Length: %d, Flag: 0x%02X\n", from, len, flag);
-
-    // Check if the FLAG corresponds to the HELLO message type
-            if (static_cast<Protocol::MessageType>(flag) == Protocol::MessageType::HELLO && len == MAC_STR_LEN_WITH_NULL) {
-      Serial.printf("AppLogic::handleHello(): Message is of type HELLO.\n");
-              char receivedMac[MAC_STR_LEN_WITH_NULL];
-      // Copiar los bytes recibidos al buffer de la MAC
-              memcpy(receivedMac, buf, MAC_STR_LEN_WITH_NULL);
-      // Check if it's the very first node being registered
-      Serial.printf("AppLogic::handleHello(): start the proses to registerNewNode.\n");
-      registerNewNode(*receivedMac, from);
-      Serial.printf("AppLogic::handleHello(): Exiting.\n");
+void AppLogic::handleIncoming() {
+  // Como mucho una cola llena por llamada: lo que llegue mientras tanto espera al próximo update()
+  for (uint8_t i = 0; i < RX_QUEUE_DEPTH; i++) {
+    if (!dispatchReceived()) {
       return;
     }
-      else  // The flag is not HELLO
-    {
-    Serial.printf("AppLogic::handleHello(): Message received, but FLAG (0x%02X or Length: %d", flag, len);
-  
-    Serial.printf(") is not HELLO. Ignoring message.\n");
-    return;
   }
-  
-}
 }
 
-bool AppLogic::registerNewNode(char receivedMac, uint8_t from) {
-  // This 'if' block handles the initial state where no nodes are recorded yet.
-  if (mapNodesIDsMac.empty())  // registro de una
-  {
+bool AppLogic::dispatchReceived() {
+  uint8_t buf[RX_QUEUE_FRAME_LEN];  // Buffer for the received message
+  uint8_t len = sizeof(buf);        // Maximum buffer length
+  uint8_t from;                     // Sender address
+  uint8_t flag;                     // Protocol detection FLAG
 
-    Serial.printf("AppLogic::handleHello(): First node detected. Registering 0x%02X as node 0.\n", from);
-    mapNodesIDsMac[from] = String(receivedMac);
-    Serial.printf("AppLogic::handleHello(): First node registered. Exiting.\n");
-    return true;  // Exit the function as the first node has been processed succesful.
+  if (!radio.recvMessage(buf, &len, &from, &flag)) {
+    return false;
+  }
+  LOG_D("AppLogic::handleIncoming(): Message received. Sender: 0x%02X, Length: %d, Flag: 0x%02X", from, len, flag);
+  bool linkReply = linkExchangeOpen && from == linkExchangeNode;
+  // Perfil de la radio al recibir: el switch puede cerrar el intercambio y volver al default
+  uint8_t rxProfile = radio.getProfile();
+
+  switch (static_cast<Protocol::MessageType>(flag)) {
+    case Protocol::MessageType::HELLO:
+      handleHello(buf, len, from);
+      break;
+    case Protocol::MessageType::DATA_ATMOSPHERIC:
+      handleAtmosphericReply(buf, len, from);
+      break;
+    case Protocol::MessageType::DATA_GPS_CROUND:
+      handleGroundReply(buf, len, from);
+      break;
+    default:
+      LOG_W("AppLogic::handleIncoming(): FLAG 0x%02X no esperado. Ignoring message.", flag);
+      break;
   }
 
-  // If not the first node, check if it's already registered
-  Serial.printf("AppLogic::handleHello(): Searching if node 0x%02X is already registered among %d existing nodes.\n", from, mapNodesIDsMac.size());
+  // Después del switch: el HELLO que registra al nodo ya cuenta como su primera muestra
+  linkStats.onFrame(from, radio.lastRssi(), radio.lastSnr(), radio.lastHops(), millis());
+  adr.onFrame(from, radio.lastHops(), radio.lastSnr(), radio.lastRssi(), rxProfile,
+              linkReply ? adr.txPower(from) : (int8_t)RADIO_TX_POWER);
 
-  // 'it' será un iterador al elemento si se encuentra
-  auto it1 = mapNodesIDsMac.find(from);
+  if (linkReply && flag == Protocol::MessageType::DATA_ATMOSPHERIC) {
+    closeLinkExchange(true);
+  }
+  if (batchAckPending) {
+    sendBatchAck();
+  }
+  return true;
+}
 
-  // Comprobar si el iterador no es el final del mapa (es decir, la clave se encontró)
-  if (it1 != mapNodesIDsMac.end()) {
-    Serial.printf("  ¡Clave encontrada!\n");
-            if (it1->second == String(receivedMac, MAC_STR_LEN_WITH_NULL)) {
-      Serial.printf("nodo ya registrado\n");
-      return true;  // Exit the function as the first node has been processed succesful.
-            } else if (it1->second != String(receivedMac, MAC_STR_LEN_WITH_NULL)) {
-      Serial.printf("nodo ya registrado con mismo key pero diferente se prosede a envio changeID, MAC: ");
-      Serial.printf(it1->second.c_str());  // it1->second es el valor (la String de la MAC)
-      Serial.printf("AppLogic::handleHello(): envio send change ID.\n");
-      //sendChangeID(from);
-      return false;  // Exit the function as the first node hasn't been processed .
+/**
+ * @brief Procesa un mensaje HELLO de un nodo sensor.
+ *
+ * El HELLO binario (Protocol::HelloPacket) se usa tal cual desde el buffer.
+ * El HELLO de firmware viejo trae la MAC en texto con terminador; se convierte
+ * a binario y se registra como protocolo 1 con capacidades atmosférica y suelo.
+ */
+void AppLogic::handleHello(uint8_t *buf, uint8_t len, uint8_t from) {
+  Protocol::HelloPacket hello;
+  if (len == sizeof(Protocol::HelloPacket)) {
+    memcpy(&hello, buf, sizeof(hello));
+  } else if (len == MAC_STR_LEN_WITH_NULL) {
+    // La MAC llega como texto "AA:BB:CC:DD:EE:FF" y se guarda en binario
+    if (!NodeTable::parseMac(reinterpret_cast<const char *>(buf), hello.mac)) {
+      LOG_W("AppLogic::handleHello(): MAC invalida de 0x%02X. Ignoring message.", from);
+      return;
     }
+    hello.protocolVersion = 1;
+    hello.firmwareVersion = 0;
+    hello.capabilities = Protocol::CAP_ATMOSPHERIC | Protocol::CAP_GROUND_GPS;
   } else {
-    Serial.printf("AppLogic::handleHello(): Nuevo Nodo ya que no esta registrado su key. Registering 0x%02X as node 0.\n", from);
-    mapNodesIDsMac[from] = String(receivedMac);
-    return true;  // Exit the function as the first node has been processed succesful.
+    LOG_W("AppLogic::handleHello(): Length %d is not a HELLO. Ignoring message.", len);
+    return;
+  }
+  LOG_D("AppLogic::handleHello(): HELLO v%u de 0x%02X (firmware v%u, capacidades 0x%02X).",
+        hello.protocolVersion, from, hello.firmwareVersion, hello.capabilities);
+  if (registerNewNode(hello, from)) {
+    updateLinkProfile(from);
   }
-  return true;
+}
+
+bool AppLogic::registerNewNode(const Protocol::HelloPacket &hello, uint8_t from) {
+  if (!nodeTable.contains(from)) {
+    if (nodeTable.full()) {
+      LOG_W("AppLogic::handleHello(): Tabla llena (MAX_NODES = %u), 0x%02X no se registra.", nodeTable.count(), from);
+      return false;
+    }
+    nodeTable.add(from, hello.mac);
+    nodeTable.setInfo(from, hello.protocolVersion, hello.capabilities);
+    adr.reset(from);
+    linkStats.reset(from);
+    batchSequence.reset(from);
+    LOG_I("AppLogic::handleHello(): Nuevo Nodo 0x%02X registrado (%u nodos).", from, nodeTable.count());
+    return true;
+  }
+
+  if (nodeTable.macEquals(from, hello.mac)) {
+    // Un nodo actualizado por OTA anuncia su nueva versión en el siguiente HELLO
+    nodeTable.setInfo(from, hello.protocolVersion, hello.capabilities);
+    LOG_D("nodo ya registrado");
+    return true;
+  }
+
+  LOG_W("AppLogic::handleHello(): Nodo 0x%02X ya registrado con otra MAC (..:%02X:%02X:%02X), se prosede a envio changeID.",
+from, nodeTable.mac(from)[3], nodeTable.mac(from)[4], nodeTable.mac(from)[5]);
+  //sendChangeID(from);
+  return false;  // Exit the function as the first node hasn't been processed .
 }
 void AppLogic::sendChangeID(uint8_t from) {
   // Declara IDsAcotados con el tamaño máximo de mensaje que puede enviar el radio.
   // Esto asegura que el búfer local es lo suficientemente grande.
   uint8_t IDsAcotados[RH_MESH_MAX_MESSAGE_LEN];
-  uint8_t counterNodes = mapNodesIDsMac.size();
-  Serial.printf("AppLogic::sendChangeID(): Enviando solicitud de cambio de ID a 0x%02X\n", from);
-  Serial.printf("AppLogic::sendChangeID(): counterNodes actual: %d\n", counterNodes);
-  Serial.printf("AppLogic::sendChangeID(): RH_MESH_MAX_MESSAGE_LEN: %d\n", RH_MESH_MAX_MESSAGE_LEN);
+  uint16_t counterNodes = nodeTable.count();
+  LOG_I("AppLogic::sendChangeID(): Enviando solicitud de cambio de ID a 0x%02X", from);
+  LOG_D("AppLogic::sendChangeID(): counterNodes actual: %d", counterNodes);
+  LOG_D("AppLogic::sendChangeID(): RH_MESH_MAX_MESSAGE_LEN: %d", RH_MESH_MAX_MESSAGE_LEN);
 
   // Calcula la cantidad de bytes que realmente necesitamos copiar de nodeIDs.
   // Esto debe ser el menor entre:
@@ -171,16 +253,13 @@ void AppLogic::sendChangeID(uint8_t from) {
   if (bytesToCopy > 0) {
     // Copia los IDs registrados (hasta el límite del búfer de mensaje)
     size_t i = 0;
-    for (const auto &pair : mapNodesIDsMac) {
-      if ((i + 1) <= bytesToCopy) {
-        IDsAcotados[i] = pair.first;
-        i++;
-      }
+    uint8_t id;
+    for (uint16_t cursor = 0; i < bytesToCopy && nodeTable.next(cursor, id); cursor = id + 1) {
+      IDsAcotados[i++] = id;
     }
-    Serial.printf("AppLogic::sendChangeID(): Se copiaron ");
-    Serial.printf("Se copiaron %d bytes de nodeIDs a IDsAcotados.\n", bytesToCopy);
+    LOG_D("AppLogic::sendChangeID(): Se copiaron %u bytes de nodeIDs a IDsAcotados.", (unsigned)bytesToCopy);
   } else {
-    Serial.printf("AppLogic::sendChangeID(): No hay IDs de nodos para copiar (counterNodes es 0).\n");
+    LOG_D("AppLogic::sendChangeID(): No hay IDs de nodos para copiar (counterNodes es 0).");
     // Si no hay nodos, el mensaje puede ser solo el 'from' o un mensaje vacío si tiene sentido.
     // En este caso, IDsAcotados ya está "vacío" o con basura, así que solo pondremos 'from'.
   }
@@ -189,7 +268,7 @@ void AppLogic::sendChangeID(uint8_t from) {
   // Esto sobrescribe el primer byte si se copió algo de nodeIDs.
   // Asegúrate de que esto sea el comportamiento deseado.
   IDsAcotados[0] = from;
-      Serial.printf("AppLogic::sendChangeID(): Primer byte de IDsAcotados establecido a 0x%02X\n", IDsAcotados[0]);
+      LOG_D("AppLogic::sendChangeID(): Primer byte de IDsAcotados establecido a 0x%02X", IDsAcotados[0]);
 
   // Envía el mensaje. La longitud del mensaje es bytesToCopy, ya que eso es lo que copiamos de nodeIDs
   // y lo que queremos enviar (más el ajuste del primer byte).
@@ -199,501 +278,590 @@ void AppLogic::sendChangeID(uint8_t from) {
   // Si el mensaje es "cambia tu ID a X", el contenido y la longitud serían diferentes.
   // Asumiendo que el mensaje es una lista de IDs de nodos registrados para que 'from' sepa con quién no colisionar.
   radio.sendMessage(from, IDsAcotados, bytesToCopy, Protocol::MessageType::ERROR_DIRECCION);
-  Serial.printf("AppLogic::sendChangeID(): Mensaje de cambio de ID enviado.\n");
+  LOG_I("AppLogic::sendChangeID(): Mensaje de cambio de ID enviado.");
 }
 
 void AppLogic::timer() {
   // DEBUG_PRINTLN("entro timer ");
   unsigned long tiempoActual = millis();
 
-  if (tiempoActual - temBuf >= INTERVALOANNOUNCE) {
+  if (ATMOSPHERIC_SLOTTED_MODE == 1) {
+    // Cada ANNOUNCE abre una supertrama: anuncia el gateway y reparte los slots
+    if (tiempoActual - temBuf >= INTERVALOATMOSPHERIC) {
+      temBuf = tiempoActual;
+      sendAnnounce();
+    }
+  } else if (tiempoActual - temBuf >= INTERVALOANNOUNCE) {
     temBuf = tiempoActual;
     sendAnnounce();
-  } else if (tiempoActual - temBuf1 >= INTERVALOATMOSPHERIC && mapNodesIDsMac.empty() == false) {
+  } else if (tiempoActual - temBuf1 >= INTERVALOATMOSPHERIC && nodeTable.empty() == false) {
     temBuf1 = tiempoActual;
-    Serial.printf("salto timer requestAtmosphericData\n");
-    requestAtmosphericData();
+    LOG_D("salto timer requestAtmosphericData");
+    publishGatewayMetrics();
+    if (ATMOSPHERIC_BROADCAST_POLL == 1) {
+      sendPollWindow();
+    } else {
+      requestAtmosphericData();
+    }
+  }
+  // La ventana de slots la abre el ANNOUNCE o el pedido broadcast
+  if (slotWindowOpen && (long)(tiempoActual - slotWindowEnd) >= 0) {
+    closeSlotWindow();
   }
   
   // Lógica condicional para requestGroundGpsData basada en USE_TIMER_FOR_GROUND_REQUEST
   if (USE_TIMER_FOR_GROUND_REQUEST == 1) {
     // Modo temporizador: usar millis() como atmospheric
     static unsigned long temBufGround = 0;
-    if (tiempoActual - temBufGround >= INTERVALO_GROUND_REQUEST && mapNodesIDsMac.empty() == false) {
+    // No se bloquea la radio mientras los nodos están enviando en sus slots
+    if (tiempoActual - temBufGround >= INTERVALO_GROUND_REQUEST && nodeTable.empty() == false && !slotWindowOpen) {
       temBufGround = tiempoActual;
-      Serial.printf("salto timer requestGroundGpsData (modo temporizador)\n");
+      LOG_D("salto timer requestGroundGpsData (modo temporizador)");
       requestGroundGpsData();
     }
   } else {
     // Modo comparación de horas: usar compareHsAndMs() como antes
-    if(compareHsAndMs() && mapNodesIDsMac.empty() == false) {
-      Serial.printf("salto hora requestGroundGpsData (modo comparación de horas)\n");
+    if(compareHsAndMs() && nodeTable.empty() == false) {
+      LOG_D("salto hora requestGroundGpsData (modo comparación de horas)");
       requestGroundGpsData();
     }
   }
 }
 
 /**
- * @brief Maneja un mensaje ANNOUNCE.
+ * @brief Envía el ANNOUNCE (broadcast) con la KEY del protocolo.
  *
+ * Con ATMOSPHERIC_SLOTTED_MODE el payload es un Protocol::SlotSchedule: cada
+ * nodo registrado a un salto recibe un slot según su posición en el bitmap y envía
+ * DATA_ATMOSPHERIC en ese momento sin esperar REQUEST_DATA_ATMOSPHERIC.
+ * Los nodos con firmware viejo solo miran buf[0] (KEY) y siguen funcionando.
  */
 void AppLogic::sendAnnounce() {
-  Serial.printf("enviando announce KEY:\n");
   uint8_t key = Protocol::KEY;
-      Serial.printf("enviando announce KEY: %d\n", key);
-    Serial.printf("Resultado envío: %d\n", radio.sendMessage(RH_BROADCAST_ADDRESS, &key, sizeof(key), static_cast<uint8_t>(Protocol::MessageType::ANNOUNCE)));
-  return;
+  LOG_D("enviando announce KEY: %d", key);
+  closeLinkExchange(false);  // El broadcast va en el perfil default
+  routeWarmupNext = 0;       // Nueva vuelta de calentamiento de rutas
+  if (ATMOSPHERIC_SLOTTED_MODE != 1) {
+    if (!radio.sendMessage(RH_BROADCAST_ADDRESS, &key, sizeof(key), static_cast<uint8_t>(Protocol::MessageType::ANNOUNCE))) {
+      LOG_W("ANNOUNCE no enviado");
+    }
+    return;
+  }
+  publishGatewayMetrics();   // Cierra el ciclo anterior
+
+  Protocol::SlotSchedule schedule;
+  memset(&schedule, 0, sizeof(schedule));
+  schedule.key = key;
+  schedule.slotMs = SLOT_DURATION_MS;
+  schedule.firstSlotMs = SLOT_FIRST_OFFSET_MS;
+  // Un broadcast no se retransmite: los nodos a varios saltos no lo oyen y se piden después
+  size_t slots = markDirectNodes(schedule.nodes);
+  schedule.features = gatewayFeatures();
+  // Los enlaces con perfil propio conservan su slot: el envío en slot sale en el perfil
+  // default, y solo el que no llegue se pide después, de a uno, en su perfil
+  memset(slotReported, 0, sizeof(slotReported));
+
+  bool ok = radio.sendMessage(RH_BROADCAST_ADDRESS, reinterpret_cast<uint8_t *>(&schedule), sizeof(schedule),
+                              static_cast<uint8_t>(Protocol::MessageType::ANNOUNCE));
+  if (!ok) {
+    LOG_W("ANNOUNCE no enviado");
+  }
+
+  // La ventana se cuenta desde el fin de la transmisión, igual que en los nodos
+  slotWindowEnd = millis() + SLOT_FIRST_OFFSET_MS + slots * SLOT_DURATION_MS + SLOT_GUARD_MS;
+  slotWindowOpen = slots > 0;
+  LOG_D("[sendAnnounce] %d slots de %d ms, ventana de %lu ms.",
+        (int)slots, SLOT_DURATION_MS, slotWindowEnd - millis());
+  if (!slotWindowOpen && !nodeTable.empty()) {
+    requestAtmosphericData();  // Ningún vecino directo: se pide a todos unicast
+  }
+}
+
+void AppLogic::closeSlotWindow() {
+  slotWindowOpen = false;
+  int reported = 0;
+  for (uint8_t i = 0; i < Protocol::SLOT_BITMAP_BYTES; i++) {
+    reported += __builtin_popcount(slotReported[i] & nodeTable.bitmap()[i]);
+  }
+  LOG_I("[closeSlotWindow] %d de %d nodos enviaron en su slot.", reported, (int)nodeTable.count());
+  // Si todos enviaron el ciclo queda vacío y termina en el próximo servicePoll()
+  requestAtmosphericData();
 }
 
 /**
- * @brief solicita los datos actuales de atmospheic a los nodos.
+ * @brief Abre el ciclo atmosférico del modo sondeo con un solo pedido broadcast.
+ *
+ * El pedido lleva el bitmap de los nodos a un salto (markDirectNodes()) y
+ * cada uno responde en el slot de su posición en el bitmap, como en el
+ * SlotSchedule del ANNOUNCE: los IDs son el CRC-8 de la MAC y no son
+ * consecutivos, así que el slot no puede salir del ID. Los enlaces con perfil
+ * propio también tienen slot y responden en el perfil default. Al vencer la
+ * ventana, closeSlotWindow() arranca el sondeo unicast, que saltea a los que
+ * ya respondieron (los nodos a varios saltos nunca oyen el broadcast).
+ */
+void AppLogic::sendPollWindow() {
+  if (atmosPoll.isActive() || slotWindowOpen) {
+    requestAtmosphericData();  // Avisa que el ciclo anterior sigue en curso
+    return;
+  }
+  closeLinkExchange(false);  // El broadcast va en el perfil default
+  memset(slotReported, 0, sizeof(slotReported));
+
+  Protocol::PollWindow window;
+  window.key = Protocol::KEY;
+  window.features = gatewayFeatures();
+  window.slotMs = SLOT_DURATION_MS;
+  window.firstSlotMs = SLOT_FIRST_OFFSET_MS;
+  size_t slots = markDirectNodes(window.nodes);
+  if (slots == 0 ||
+      !radio.sendMessage(RH_BROADCAST_ADDRESS, reinterpret_cast<uint8_t *>(&window), sizeof(window),
+                         static_cast<uint8_t>(Protocol::MessageType::REQUEST_DATA_ATMOSPHERIC))) {
+    requestAtmosphericData();  // Sondeo nodo por nodo
+    return;
+  }
+  slotWindowEnd = millis() + SLOT_FIRST_OFFSET_MS + slots * SLOT_DURATION_MS + SLOT_GUARD_MS;
+  slotWindowOpen = true;
+  LOG_D("[sendPollWindow] Pedido broadcast con %d slots, ventana de %lu ms.",
+        (int)slots, slotWindowEnd - millis());
+}
 
+/**
+ * @brief Inicia un ciclo de solicitud de datos atmosféricos.
+ *
+ * No envía nada: servicePoll() recorre los nodos registrados desde update(),
+ * con hasta POLL_MAX_IN_FLIGHT solicitudes en vuelo y un deadline por nodo.
  */
 void AppLogic::requestAtmosphericData() {
+  if (!atmosPoll.startCycle(millis())) {
+    const PollEngine::CycleStats &st = atmosPoll.stats();
+    LOG_W("[requestAtmosphericData] Ciclo anterior en curso (%u pedidos, %u respuestas). Se omite este ciclo.",
+          st.requests, st.replies);
+    return;
+  }
+  LOG_D("[requestAtmosphericData] Iniciando ciclo de solicitud a %d nodos.", (int)nodeTable.count());
+}
 
-  Serial.printf("DEBUG: [requestAtmosphericData] Iniciando ciclo de solicitud a nodos.\n");
+void AppLogic::servicePoll() {
+  unsigned long now = millis();
+  uint8_t nodeId;
 
-  // Verificar memoria disponible antes de crear arrays grandes
-  if (ESP.getFreeHeap() < 2048) {
-    Serial.printf("DEBUG: ADVERTENCIA: Memoria baja antes de procesar datos atmosféricos\n");
-    return; // Salir si la memoria es muy baja
+  // 0. Respuesta en el perfil de un enlace: no se envía nada hasta recibirla o abandonarla
+  if (linkExchangeOpen) {
+    if ((long)(now - linkExchangeUntil) < 0) {
+      return;
+    }
+    closeLinkExchange(false);
+  }
+  if (!atmosPoll.isActive()) {
+    return;
+  }
+  // Sin presupuesto de ciclo de trabajo no se pide nada; los vencidos esperan su reintento
+  if (!radio.canTransmit(POLL_REQUEST_LEN)) {
+    return;
   }
 
-  std::array<Protocol::AtmosphericSample, NUMERO_MUESTRAS_ATMOSFERICAS> atmosSamples;
-  uint8_t buf[RH_MESH_MAX_MESSAGE_LEN];  // Búfer para el mensaje recibido
-  uint8_t key = Protocol::KEY;
-  uint8_t len = 0;                                                                       // Longitud máxima del búfer
-  uint8_t from;                                                                          // Dirección del remitente
-  uint8_t flag = static_cast<uint8_t>(Protocol::MessageType::REQUEST_DATA_ATMOSPHERIC);  // FLAG de detecccion protocolo
-  uint8_t nodeId = 0;
-
-  // Calcula el tamaño esperado de los datos atmosféricos para validación
-      size_t expectedAtmosphericDataSize = sizeof(Protocol::AtmosphericSample) * NUMERO_MUESTRAS_ATMOSFERICAS;
-  Serial.printf("DEBUG: Tamano de buffer para recv: ");
-  Serial.printf("%d", RH_MESH_MAX_MESSAGE_LEN);
-  Serial.printf(", Tamano esperado de muestras: ");
-  Serial.printf("%d\n", expectedAtmosphericDataSize);
-
-
-  for (const auto &pair : mapNodesIDsMac) {
-    nodeId = pair.first;
-    Serial.printf("DEBUG: [requestAtmosphericData] Procesando nodo ID: 0x");
-    Serial.printf("%02X\n", nodeId);
-
-    Serial.printf("DEBUG: Enviando REQUEST_DATA_ATMOSPHERIC a 0x");
-    // Envio de la solicitud
-    Serial.printf("%02X", nodeId);
-    Serial.printf(" con payload de ");
-    Serial.printf("%d", len);  // Aquí 'len' es el tamaño completo del buffer de recepción, no el payload del REQUEST
-    Serial.printf(" bytes (manager.sendMessage).\n");
-
-    // NOTA: Si el mensaje REQUEST_DATA_ATMOSPHERIC no lleva payload,
-    // es posible que quieras usar `0` para `len` o pasar un puntero nulo como `data`.
-    // Tu lógica actual pasa `buf` y `len` completos, lo cual está bien si se espera un payload.
-
-    radio.sendMessage(nodeId, &key, sizeof(key), flag);
-
-    // Delay antes de esperar respuesta
-    delay(DELAY_BEFORE_RETRY_ATMOSPHERIC);
-
-    bool t = false;
-    t = false;
-    uint8_t intentos = 0;
-    while (t == false && intentos <= connectionRetries) {
-      intentos++;
-      Serial.printf("DEBUG: Intento %d de recepcion para nodo 0x%02X (Timeout: %d ms).\n", intentos, nodeId, TIMEOUTGRAL);
-
-      uint8_t current_recv_len = sizeof(buf);  // Reiniciar len para cada llamada a recvMessageTimeout
-
-      // Intenta recibir un mensaje.
-      if (radio.recvMessageTimeout(buf, &current_recv_len, &from, &flag, TIMEOUTGRAL)) {
-        Serial.printf("DEBUG: Mensaje recibido. Remitente: 0x%02X, Tipo: 0x%02X, Longitud: %d\n", from, flag, current_recv_len);
-
-        // Verifica tipo de mensaje y remitente
-        if (static_cast<Protocol::MessageType>(flag) == Protocol::MessageType::DATA_ATMOSPHERIC && from == nodeId) {
-          Serial.printf("DEBUG: Tipo de mensaje y remitente coinciden.\n");
-
-          // 1. Verificar tamaño del payload recibido
-          if (current_recv_len != expectedAtmosphericDataSize) {
-            Serial.printf("DEBUG: ERROR: Tamano de payload INCORRECTO. Recibido: ");
-            Serial.printf("%d", current_recv_len);
-            Serial.printf(" bytes, Esperado: ");
-            Serial.printf("%d", expectedAtmosphericDataSize);
-            Serial.printf(" bytes.\n");
-
-
-            // No se modifica 't', el bucle continuará si hay reintentos.
-          } else {
-            Serial.printf("DEBUG: Tamano de payload CORRECTO. Realizando memcpy.\n");
-            // 2. Convertir a nuestra estructura
-            memcpy(atmosSamples.data(), buf, current_recv_len);
-            AtmosphericSampleNodes[nodeId] = atmosSamples;
-            Serial.printf("DEBUG: Datos de nodo ");
-            Serial.printf("%02X", nodeId);
-            Serial.printf(" almacenados.\n");
-            
-            // Publicar datos por MQTT
-            for (const auto& sample : atmosSamples) {
-                publishAtmosphericData(nodeId, sample);
-            }
-            
-            t = true;  // Marca como exitoso
-
-
-
-            //_--------------------------------borrar
-            if (1 == 1) {
-              Serial.printf("--- DEBUG: Imprimiendo muestras atmosfericas almacenadas ---\n");
-
-              if (AtmosphericSampleNodes.empty()) {
-                Serial.printf("DEBUG: El mapa AtmosphericSampleNodes esta vacio.\n");
-                return;
-              }
-
-              // Itera sobre cada entrada (par clave-valor) en el mapa
-              for (const auto &pair : AtmosphericSampleNodes) {
-                uint8_t nodeId = pair.first;  // La clave es el ID del nodo
-                            // Accedemos al std::array de AtmosphericSample usando .second
-            const std::array<Protocol::AtmosphericSample, NUMERO_MUESTRAS_ATMOSFERICAS> &samples = pair.second;
-
-                Serial.printf("DEBUG: Nodo ID: ");
-                Serial.printf("%02X", nodeId);  // Convierte el ID a String hexadecimal para imprimir
-                Serial.printf(" ----\n");
-
-                // Itera sobre cada AtmosphericSample dentro del array para este nodo
-                for (size_t i = 0; i < samples.size(); ++i) {
-                  const Protocol::AtmosphericSample &sample = samples[i];  // Obtén una referencia a la muestra actual
-
-                  Serial.printf("DEBUG:   Muestra ");
-                  Serial.printf("%d", i + 1);  // Para empezar a contar desde 1
-                  Serial.printf(": ");
-
-                  // Temperatura: Se divide por 10.0 para obtener el valor flotante
-                  Serial.printf("Temp=");
-                  Serial.printf("%.1f", (float)sample.temp / 10.0);  // Imprimir float
-                  Serial.printf("C, ");
-
-                  // Humedad: Se divide por 10.0 para obtener el valor flotante
-                  Serial.printf("Hum=");
-                  Serial.printf("%.1f", (float)sample.moisture / 10.0);  // Imprimir float
-                  Serial.printf("%%");
-
-                  // Hora y Minuto: Requiere lógica de formato manual para el cero inicial
-                  Serial.printf(", Hora=");
-                  if (sample.hour < 10) {
-                    Serial.printf("0");  // Rellena con cero si es necesario
-                  }
-                  Serial.printf("%d", sample.hour);
-                  Serial.printf(":");
-                  if (sample.minute < 10) {
-                    Serial.printf("0");  // Rellena con cero si es necesario
-                  }
-                  Serial.printf("%d", sample.minute);
-
-                  Serial.printf("\n");  // Nueva línea para la siguiente muestra
-                }
-                Serial.printf("DEBUG: ---- Fin de muestras para Nodo ID: 0x");
-                Serial.printf("%02X", nodeId);
-                Serial.printf(" ----\n");
-              }
-              Serial.printf("--- DEBUG: Fin de impresion de muestras atmosfericas ---\n");
-            }
+  // 1. Solicitudes vencidas: reintento o descarte
+  switch (atmosPoll.checkExpired(now, nodeId)) {
+    case PollEngine::RETRY:
+      LOG_D("[servicePoll] Timeout de nodo 0x%02X, reintentando.", nodeId);
+      linkStats.onRequest(nodeId, true);
+      if (!sendPollRequest(nodeId)) {
+        atmosPoll.expire(nodeId, now);
+      }
+      return;  // Un envío por llamada
+    case PollEngine::FAILED:
+      LOG_W("Fallo al obtener datos de nodo 0x%02X despues de todos los intentos.", nodeId);
+      break;
+    default:
+      break;
+  }
 
+  // 2. Nuevo pedido si hay lugar en la tabla
+  if (atmosPoll.hasFreeSlot() && atmosPoll.cursor() <= 255) {
+    if (nextRegisteredNode(atmosPoll.cursor(), nodeId)) {
+      if (adr.usesLinkProfile(nodeId) && atmosPoll.pending() > 0) {
+        return;  // Se pide solo: mientras espera en su perfil no se oyen las otras respuestas
+      }
+      atmosPoll.track(nodeId, now);
+      linkStats.onRequest(nodeId, false);
+      if (!sendPollRequest(nodeId)) {
+        atmosPoll.expire(nodeId, millis());
+      }
+      return;
+    }
+    atmosPoll.closeQueue();
+  }
 
+  // 3. Fin de ciclo
+  if (atmosPoll.finishIfDone(now)) {
+    const PollEngine::CycleStats &st = atmosPoll.stats();
+    LOG_I("[requestAtmosphericData] Ciclo finalizado en %lu ms: %u pedidos, %u reintentos, %u respuestas, %u fallos.",
+          st.duration, st.requests, st.retries, st.replies, st.failures);
+  }
+}
 
+bool AppLogic::sendPollRequest(uint8_t nodeId) {
+  // Los nodos de protocolo 2 solo miran el tipo; los de 3 leen features del segundo byte
+  uint8_t request[POLL_REQUEST_LEN] = { Protocol::KEY, gatewayFeatures() };
+  LOG_D("Enviando REQUEST_DATA_ATMOSPHERIC a 0x%02X", nodeId);
+  if (!radio.sendMessage(nodeId, request, sizeof(request), atmosPoll.requestType())) {
+    return false;
+  }
+  if (adr.usesLinkProfile(nodeId)) {
+    openLinkExchange(nodeId);
+  }
+  return true;
+}
 
-            break;  // Salir del bucle while
-          }
-        } else {
-          Serial.printf("DEBUG: Mensaje recibido pero NO ES LA RESPUESTA ESPERADA (tipo o remitente incorrecto).\n");
-        }
-      }
-      if (t == false) {
-        // Delay antes de reintentar
-        delay(DELAY_BEFORE_RETRY_ATMOSPHERIC);
-        radio.sendMessage(nodeId, &key, sizeof(key), flag);
-      }
+void AppLogic::openLinkExchange(uint8_t nodeId) {
+  // El ACK del gateway sale con la misma potencia que usa el nodo: enlace simétrico
+  radio.applyProfile(adr.profile(nodeId), adr.txPower(nodeId));
+  linkExchangeNode = nodeId;
+  linkExchangeUntil = millis() + ADR_EXCHANGE_TIMEOUT_MS;
+  linkExchangeOpen = true;
+}
 
-    }  // Fin del while de reintentos
+void AppLogic::closeLinkExchange(bool replied) {
+  if (!linkExchangeOpen) {
+    return;
+  }
+  linkExchangeOpen = false;
+  radio.applyProfile(Protocol::RADIO_PROFILE_DEFAULT);
+  // Cerrar antes de la respuesta cuenta como pérdida: el nodo tampoco recibirá el ACK
+  if (replied) {
+    adr.onReplyOk(linkExchangeNode);
+  } else if (adr.onReplyLost(linkExchangeNode)) {
+    LOG_W("[ADR] Enlace 0x%02X sin respuesta en su perfil, vuelve al default.", linkExchangeNode);
+  }
+}
 
-    if (!t) {
-      Serial.printf("DEBUG: Fallo al obtener datos de nodo 0x");
-      Serial.printf("%02X", nodeId);
-      Serial.printf(" despues de todos los intentos.\n");
+/**
+ * @brief Ordena al nodo el perfil y la potencia que calcula LinkAdr.
+ *
+ * Solo para nodos que declararon CAP_LINK_ADR. El cambio se registra cuando
+ * el nodo confirma la recepción (ACK de RadioHead); si no llega se reintenta
+ * con el próximo HELLO. Sin cambios no se envía nada: los HELLO periódicos no
+ * repiten el comando. Si el nodo se reinició y volvió al default, sus
+ * respuestas perdidas en el perfil devuelven el enlace al default
+ * (LinkAdr::onReplyLost()) y el próximo HELLO lo vuelve a evaluar.
+ */
+void AppLogic::updateLinkProfile(uint8_t nodeId) {
+  if (ADR_ENABLED != 1 || !nodeTable.hasCapability(nodeId, Protocol::CAP_LINK_ADR)) {
+    return;
+  }
+  uint8_t profile;
+  int8_t txPower;
+  if (!adr.evaluate(nodeId, profile, txPower)) {
+    return;
+  }
+  Protocol::LinkProfileCommand command = { Protocol::KEY, profile, txPower };
+  if (!radio.sendMessage(nodeId, reinterpret_cast<uint8_t *>(&command), sizeof(command),
+                         static_cast<uint8_t>(Protocol::MessageType::LINK_PROFILE))) {
+    LOG_W("[ADR] LINK_PROFILE no confirmado por 0x%02X.", nodeId);
+    return;
+  }
+  adr.apply(nodeId, profile, txPower);
+  LOG_I("[ADR] Enlace 0x%02X: SF%u / %u kHz, %d dBm (SNR %d/10 dB).", nodeId,
+        Protocol::RADIO_PROFILES[profile].spreadingFactor, Protocol::RADIO_PROFILES[profile].bandwidthKhz,
+        txPower, adr.link(nodeId).snr);
+}
+
+uint8_t AppLogic::gatewayFeatures() const {
+  uint8_t features = 0;
+  if (ATMOS_PACKED_ENCODING == 1) {
+    features |= Protocol::FEATURE_PACKED_ATMOSPHERIC;
+  }
+  if (BATCH_SEQUENCE_ENABLED == 1) {
+    features |= Protocol::FEATURE_BATCH_SEQUENCE;
+  }
+  if (GROUND_CACHE_ENABLED == 1) {
+    features |= Protocol::FEATURE_GROUND_AGE;
+  }
+  if (BATCH_SEQUENCE_ENABLED == 1 && BATCH_ACK_ENABLED == 1) {
+    features |= Protocol::FEATURE_BATCH_ACK;
+  }
+  return features;
+}
+
+size_t AppLogic::markDirectNodes(uint8_t *nodes) const {
+  memset(nodes, 0, Protocol::SLOT_BITMAP_BYTES);
+  size_t marked = 0;
+  uint8_t id;
+  for (uint16_t cursor = 0; nodeTable.next(cursor, id); cursor = (uint16_t)id + 1) {
+    if (linkStats.entry(id).hops == 0) {
+      nodes[id / 8] |= (uint8_t)(1 << (id % 8));
+      marked++;
     }
-    Serial.printf("DEBUG: ---\n");  // Separador entre nodos
-    
-    // Delay entre procesamiento de nodos
-    delay(DELAY_BETWEEN_NODES);
-  }                               // Fin del for de nodos
-  Serial.printf("DEBUG: [requestAtmosphericData] Finalizado el ciclo de solicitud.\n");
+  }
+  return marked;
+}
+
+bool AppLogic::stripBatchHeader(uint8_t from, uint8_t *&buf, uint8_t &len, uint16_t &seq) const {
+  // El nodo agrega la cabecera solo si la declaró y el gateway anuncia FEATURE_BATCH_SEQUENCE
+  if (BATCH_SEQUENCE_ENABLED != 1 || !nodeTable.hasCapability(from, Protocol::CAP_BATCH_SEQUENCE) ||
+      len < sizeof(Protocol::BatchHeader)) {
+    return false;
+  }
+  Protocol::BatchHeader header;
+  memcpy(&header, buf, sizeof(header));
+  seq = header.seq;
+  buf += sizeof(header);
+  len -= sizeof(header);
+  return true;
+}
+
+bool AppLogic::isDuplicateBatch(uint8_t from, uint16_t seq) {
+  switch (batchSequence.check(from, seq)) {
+    case SequenceTracker::DUPLICATE:
+      LOG_D("Lote %u de 0x%02X duplicado, se descarta.", seq, from);
+      return true;
+    case SequenceTracker::LATE:
+      LOG_D("Lote %u de 0x%02X llego tarde.", seq, from);
+      break;
+    case SequenceTracker::RESTART:
+      LOG_I("Nodo 0x%02X reiniciado: numeracion de lotes desde %u.", from, seq);
+      break;
+    default:
+      break;
+  }
+  return false;
+}
+
+/**
+ * @brief Envía el BATCH_ACK que dejó pendiente handleAtmosphericReply().
+ *
+ * Si no llega, el nodo conserva el lote en su anillo y lo repite en el
+ * próximo envío con el mismo número: el gateway lo descarta como duplicado y
+ * lo vuelve a confirmar.
+ */
+void AppLogic::sendBatchAck() {
+  batchAckPending = false;
+  Protocol::BatchAck ack = { Protocol::KEY, batchAckSeq };
+  if (!radio.sendMessage(batchAckNode, reinterpret_cast<uint8_t *>(&ack), sizeof(ack),
+                         static_cast<uint8_t>(Protocol::MessageType::BATCH_ACK))) {
+    LOG_D("BATCH_ACK del lote %u no confirmado por 0x%02X.", batchAckSeq, batchAckNode);
+  }
+}
+
+bool AppLogic::nextRegisteredNode(uint16_t start, uint8_t &nodeId) {
+  if (start > 255) {
+    return false;
+  }
+  // Los nodos que ya enviaron en su slot no se piden
+  while (nodeTable.next(start, nodeId)) {
+    if (!slotReportedBy(nodeId)) {
+      return true;
+    }
+    start = (uint16_t)nodeId + 1;
+  }
+  return false;
 }
 
+bool AppLogic::slotReportedBy(uint8_t nodeId) const {
+  return (slotReported[nodeId / 8] & (1 << (nodeId % 8))) != 0;
+}
 
 /**
- * @brief solicita los datos actuales de Ground y Gps a los nodos.
+ * @brief Valida, almacena y publica una respuesta DATA_ATMOSPHERIC.
+ *
+ * El lote llega crudo (exactamente NUMERO_MUESTRAS_ATMOSFERICAS muestras) o,
+ * si el nodo recibió FEATURE_PACKED_ATMOSPHERIC, comprimido con AtmosCodec.
+ * Acepta también respuestas tardías (después de un reintento o de cerrado el
+ * slot): los datos siguen siendo válidos y así no se pierde el frame.
+ */
+void AppLogic::handleAtmosphericReply(uint8_t *buf, uint8_t len, uint8_t from) {
+  const size_t expectedAtmosphericDataSize = sizeof(Protocol::AtmosphericSample) * NUMERO_MUESTRAS_ATMOSFERICAS;
+
+  if (!nodeTable.contains(from)) {
+    LOG_W("DATA_ATMOSPHERIC de nodo no registrado 0x%02X. Ignorando.", from);
+    return;
+  }
+  uint16_t seq = 0;
+  bool sequenced = stripBatchHeader(from, buf, len, seq);
+
+  Protocol::AtmosphericSample received[NUMERO_MUESTRAS_ATMOSFERICAS];
+  uint8_t count = 0;
+  if (len == expectedAtmosphericDataSize) {
+    memcpy(received, buf, len);
+  } else if (ATMOS_PACKED_ENCODING == 1 &&
+             AtmosCodec::decode(buf, len, received, NUMERO_MUESTRAS_ATMOSFERICAS, count) &&
+             count == NUMERO_MUESTRAS_ATMOSFERICAS) {
+    LOG_D("DATA_ATMOSPHERIC comprimido de 0x%02X: %d bytes (crudo %d).", from, len, (int)expectedAtmosphericDataSize);
+  } else {
+    LOG_W("Tamano de payload INCORRECTO de 0x%02X. Recibido: %d bytes, Esperado: %d bytes.",
+          from, len, (int)expectedAtmosphericDataSize);
+    return;  // El slot sigue en vuelo y se reintenta al vencer
+  }
+
+  unsigned long rtt;
+  if (atmosPoll.elapsed(from, millis(), rtt)) {
+    linkStats.onReply(from, rtt);
+  }
+  atmosPoll.complete(from);
+  if (ATMOSPHERIC_SLOTTED_MODE == 1 || ATMOSPHERIC_BROADCAST_POLL == 1) {
+    slotReported[from / 8] |= (uint8_t)(1 << (from % 8));
+  }
+  // Con número de lote el nodo espera el BATCH_ACK para avanzar su anillo, también si es un duplicado
+  if (sequenced && BATCH_ACK_ENABLED == 1) {
+    batchAckPending = true;
+    batchAckNode = from;
+    batchAckSeq = seq;
+  }
+  // Un duplicado también responde al pedido, pero sus datos ya se publicaron
+  if (sequenced && isDuplicateBatch(from, seq)) {
+    return;
+  }
+
+  Protocol::AtmosphericSample *atmosSamples = nodeTable.atmospheric(from);
+  memcpy(atmosSamples, received, sizeof(received));
+  LOG_D("Datos de nodo %02X almacenados.", from);
+
+  // Publicar datos por MQTT (una entrada por nodo con todas sus muestras)
+  publishAtmosphericData(from, atmosSamples);
+}
+
+
+/**
+ * @brief Inicia un ciclo de solicitud de datos de suelo/GPS.
+ *
+ * Como requestAtmosphericData(): no envía nada, serviceGroundPoll() pide a los
+ * nodos con CAP_GROUND_GPS desde update() y las respuestas DATA_GPS_CROUND
+ * llegan por handleIncoming().
  */
 void AppLogic::requestGroundGpsData() {
+  if (!groundPoll.startCycle(millis())) {
+    LOG_W("[requestGroundGpsData] Ciclo anterior en curso (%u pedidos, %u respuestas). Se omite este ciclo.",
+          groundPoll.stats().requests, groundPoll.stats().replies);
+    return;
+  }
+  LOG_D("[requestGroundGpsData] Iniciando ciclo de solicitud de suelo/GPS.");
+}
 
-  // DEBUG: Inicio de la función principal de solicitud de datos de suelo y GPS.
-  Serial.printf("DEBUG: [requestGroundGpsData] -- INICIO --\n");
+void AppLogic::serviceGroundPoll() {
+  unsigned long now = millis();
+  uint8_t nodeId;
 
-  // std::array<GroundGpsPacket, CANTIDAD_MUESTRAS_SUELO> groundSamples; // Ya está definido como miembro del mapa
-  uint8_t buf[RH_MESH_MAX_MESSAGE_LEN] = { 0 };  // Búfer para el mensaje recibido
-  uint8_t len = sizeof(buf);                     // Longitud máxima del búfer
-  uint8_t from;                                  // Dirección del remitente
-  uint8_t flag = static_cast<uint8_t>(Protocol::MessageType::REQUEST_DATA_GPC_GROUND);
-  uint8_t nodeId;  // FLAG de detección protocolo
-  uint8_t key = Protocol::KEY;
+  // Con un intercambio ADR o slots abiertos se espera: igual que servicePoll()
+  if (!groundPoll.isActive() || linkExchangeOpen || slotWindowOpen) {
+    return;
+  }
+  if (!radio.canTransmit(POLL_REQUEST_LEN)) {
+    return;
+  }
 
-      size_t expectedGroundcDataSize = sizeof(Protocol::GroundGpsPacket);
-
-  // DEBUG: Mostrar tamaño esperado de los datos.
-  Serial.printf("DEBUG: Tamano esperado de datos: ");
-  Serial.printf("%d", expectedGroundcDataSize);
-  Serial.printf(" bytes.\n");
-
-
-  for (const auto &pair : mapNodesIDsMac) {
-    nodeId = pair.first;
-
-    // Inicio del contador de tiempo para este nodo
-    unsigned long tiempoInicioNodo = millis();
-
-    // DEBUG: Procesando un nuevo nodo.
-    Serial.printf("DEBUG: Procesando nodo ID: 0x");
-    Serial.printf("%02X\n", nodeId);
-    Serial.printf("\n");
-
-    Serial.printf("DEBUG: Enviando REQUEST_DATA_GPC_GROUND a 0x");
-    Serial.printf("%02X", nodeId);
-    Serial.printf(".\n");
-
-    radio.sendMessage(nodeId, &key, sizeof(key), flag);
-
-    // Delay antes de esperar respuesta
-    delay(DELAY_BEFORE_RETRY_GROUND);
-
-    bool t = false;
-    uint8_t intentos = 0;
-    while (t == false && intentos <= connectionRetries) {
-
-      intentos++;
-      // DEBUG: Mostrar el número de intento actual.
-      Serial.printf("DEBUG: Intento de recepcion #");
-      Serial.printf("%d", intentos);
-      Serial.printf(" para nodo 0x");
-      Serial.printf("%02X", nodeId);
-      Serial.printf(".\n");
-
-      // Inicio del contador de tiempo para este intento
-      unsigned long tiempoInicio = millis();
-      Serial.printf("DEBUG: Iniciando espera de respuesta... \n");
-
-      // Intenta recibir un mensaje.
-      if (radio.recvMessageTimeout(buf, &len, &from, &flag, TIMEOUTGRAL)) {
-
-        // Calcular tiempo transcurrido
-        unsigned long tiempoTranscurrido = millis() - tiempoInicio;
-        Serial.printf("DEBUG: Respuesta recibida en ");
-        Serial.printf("%lu", tiempoTranscurrido);
-        Serial.printf(" ms.\n");
-
-        // DEBUG: Mensaje recibido. Mostrar remitente, tipo y longitud.
-        Serial.printf("DEBUG: Mensaje recibido de 0x");
-        Serial.printf("%02X", from);
-        Serial.printf(", Tipo: 0x");
-        Serial.printf("%02X", flag);
-        Serial.printf(", Longitud: ");
-        Serial.printf("%d\n", len);
-
-        if (static_cast<Protocol::MessageType>(flag) == Protocol::MessageType::DATA_GPS_CROUND && from == nodeId) {
-          // DEBUG: El mensaje es el esperado.
-          Serial.printf("DEBUG: Mensaje es DATA_GPS_CROUND del nodo correcto.\n");
-
-          // 1. Verificar tamaño
-          if (len != expectedGroundcDataSize) {
-
-            // DEBUG: Mensaje de error por tamaño incorrecto.
-            Serial.printf("DEBUG: ERROR: Tamano incorrecto. Recibido: ");
-            Serial.printf("%d", len);
-            Serial.printf(", Esperado: ");
-            Serial.printf("%d", expectedGroundcDataSize);
-            Serial.printf(".\n");
-
-            t = false;
-            continue;  // Continúa al siguiente intento
-          } else {
-                  // *** LA LÓGICA CLAVE: Insertar un solo GroundGpsPacket en el array del mapa ***
-
-                // Paso 1: Asegurarse de que el nodo ya existe en el mapa o crearlo con un array por defecto.
-                // Si el nodo no existe, groundGpsSamplesNodes[nodeId] lo creará con un array inicializado.
-                // Si ya existe, obtendrá una referencia a ese array.
-                std::array<Protocol::GroundGpsPacket, CANTIDAD_MUESTRAS_SUELO>& nodeSamples = groundGpsSamplesNodes[nodeId];
-
-                // Paso 2: Copia los bytes del búfer 'buf' directamente a una variable temporal de GroundGpsPacket.
-                // Esto es necesario para asegurar una copia limpia y manejable.
-                Protocol::GroundGpsPacket receivedPacket;
-                memcpy(&receivedPacket, buf, expectedGroundcDataSize); // Copia el contenido del búfer al paquete temporal
-
-                // Paso 3: Define la 'count' (posición) donde quieres almacenar este paquete.
-
-                // Verificar que la posición 'count' sea válida
-                if (countGroundSamples < CANTIDAD_MUESTRAS_SUELO) {
-                    nodeSamples[countGroundSamples] = receivedPacket; // Asigna el paquete recibido a la posición 'count'
-                    Serial.printf("DEBUG: Paquete de nodo 0x");
-                    Serial.printf("%02X", nodeId);
-                    Serial.printf(" almacenado en posicion ");
-                    Serial.printf("%d", countGroundSamples);
-                    Serial.printf(".\n");
-                    
-                    // Publicar datos por MQTT
-                    publishGroundData(nodeId, receivedPacket);
-                    
-                    countGroundSamples ++;
-                    t = true; // Marca como exitoso
-                    
-                } else {
-                    Serial.printf("DEBUG: ERROR: Posicion 'count' (");
-                    Serial.printf("%d", countGroundSamples);
-                    Serial.printf(") excede el tamano del array (");
-                    Serial.printf("%d", CANTIDAD_MUESTRAS_SUELO);
-                    Serial.printf("). Paquete no almacenado. reinicio contador.\n");
-                    countGroundSamples = 0;
-                    break;
-                }
-
-           
-            //----------------------------borrar -----------------
-            // Este bloque de debug está aquí en tu código original. No lo muevo para no alterar la lógica.
-            if (1 == 1) {  // Esto es siempre verdadero, por lo que siempre se ejecuta.
-              Serial.printf("--- DEBUG: Imprimiendo muestras de suelo y GPS almacenadas (DEBUG INTERNO) ---\n");
-
-              if (groundGpsSamplesNodes.empty()) {
-                Serial.printf("DEBUG: El mapa groundGpsSamplesNodes esta vacio.\n");
-                // return; // Esta línea podría salir de la función principal, lo cual afectaría la lógica.
-                // Mantengo tu código, pero si se llama aquí, no debería salir de la función requestGroundGpsData.
-              }
-
-              for (const auto &pair_inner : groundGpsSamplesNodes) {  // Usar 'pair_inner' para evitar conflicto de nombre
-                uint8_t nodeId_inner = pair_inner.first;
-                const std::array<Protocol::GroundGpsPacket, CANTIDAD_MUESTRAS_SUELO> &packets_inner = pair_inner.second;
-
-                Serial.printf("DEBUG: Nodo ID (interno): 0x");
-                Serial.printf("%02X", nodeId_inner);
-                Serial.printf(" ----\n");
-
-                for (size_t i_inner = 0; i_inner < packets_inner.size(); ++i_inner) {
-                                  const Protocol::GroundGpsPacket &packet_inner = packets_inner[i_inner];
-                const Protocol::GroundSensor &ground_inner = packet_inner.ground;
-                const Protocol::GpsSensor &gps_inner = packet_inner.gps;
-
-                  Serial.printf("DEBUG:   Paquete ");
-                  Serial.printf("%d", i_inner + 1);
-                  Serial.printf(" (Suelo + GPS): ");
-                  Serial.printf("\n");
-
-                  Serial.printf("DEBUG:     [SUELO] Temp=");
-                  Serial.printf("%.1f", (float)ground_inner.temp / 10.0);
-                  Serial.printf("C, Hum=");
-                  Serial.printf("%.1f", (float)ground_inner.moisture / 10.0);
-                  Serial.printf("%%, N=");
-                  Serial.printf("%d", ground_inner.n);
-                  Serial.printf(", P=");
-                  Serial.printf("%d", ground_inner.p);
-                  Serial.printf(", K=");
-                  Serial.printf("%d", ground_inner.k);
-                  Serial.printf(", EC=");
-                  Serial.printf("%d", ground_inner.EC);
-                  Serial.printf(", PH=");
-                  Serial.printf("%.1f", (float)ground_inner.PH / 10.0);
-                  Serial.printf("\n");
-
-                  Serial.printf("DEBUG:     [GPS] Lat=");
-                  Serial.printf("%.7f", (float)gps_inner.latitude / 10000000.0);
-                  Serial.printf(", Lon=");
-                  Serial.printf("%.7f", (float)gps_inner.longitude / 10000000.0);
-                  Serial.printf(", Alt=");
-                  Serial.printf("%d", gps_inner.altitude);
-                  Serial.printf("m, Hora=");
-
-                  if (gps_inner.hour < 10) { Serial.printf("0"); }
-                  Serial.printf("%d", gps_inner.hour);
-                  Serial.printf(":");
-                  if (gps_inner.minute < 10) { Serial.printf("0"); }
-                  Serial.printf("%d", gps_inner.minute);
-
-                  Serial.printf(", Flags=");
-                  Serial.printf("%02X", gps_inner.flags);
-
-                  if (gps_inner.flags & 0x01) { Serial.printf(" (Ubicacion Valida)"); }
-                  if (gps_inner.flags & 0x02) { Serial.printf(" (Altitud Valida)"); }
-                  if (gps_inner.flags & 0x04) { Serial.printf(" (Hora Valida)"); }
-
-                  Serial.printf("\n");
-                  Serial.printf("DEBUG:   --------------------\n");
-                }
-                Serial.printf("DEBUG: ---- Fin de muestras para Nodo ID (interno): ");
-                Serial.printf("%02X", nodeId_inner);
-                Serial.printf(" ----\n");
-              }
-              Serial.printf("--- DEBUG: Fin de impresion de muestras de suelo y GPS (DEBUG INTERNO) ---\n");
-            }  // Fin del if (1 == 1)
-            //----------------------------borrar -----------------
-
-            break;  // Salir del bucle while (reintentos)
-          }
-        } else {
-          // DEBUG: Mensaje recibido pero no coincide con el tipo o remitente esperado.
-          Serial.printf("DEBUG: Mensaje inesperado. Tipo recibido: 0x");
-          Serial.printf("%02X", flag);
-          Serial.printf(", Remitente recibido: 0x");
-          Serial.printf("%02X", from);
-          Serial.printf(".\n");
-        }
-      } else {
-        // Calcular tiempo transcurrido en caso de timeout
-        unsigned long tiempoTranscurrido = millis() - tiempoInicio;
-        Serial.printf("DEBUG: Timeout despues de ");
-        Serial.printf("%lu", tiempoTranscurrido);
-        Serial.printf(" ms. No se recibio respuesta de ");
-        Serial.printf("%02X", nodeId);
-        Serial.printf(".\n");
+  switch (groundPoll.checkExpired(now, nodeId)) {
+    case PollEngine::RETRY:
+      LOG_D("No exitoso. Reenviando solicitud de suelo/GPS a 0x%02X.", nodeId);
+      if (!sendGroundRequest(nodeId)) {
+        groundPoll.expire(nodeId, now);
+      }
+      return;  // Un envío por llamada
+    case PollEngine::FAILED:
+      LOG_W("Fallo definitivo de suelo/GPS para nodo 0x%02X.", nodeId);
+      break;
+    default:
+      break;
+  }
+
+  if (groundPoll.hasFreeSlot() && groundPoll.cursor() <= 255) {
+    for (uint16_t cursor = groundPoll.cursor(); nodeTable.next(cursor, nodeId); cursor = (uint16_t)nodeId + 1) {
+      if (!nodeTable.hasCapability(nodeId, Protocol::CAP_GROUND_GPS)) {
+        continue;
       }
-      if (t == false) {
-        // DEBUG: Se reenvía el mensaje si no hubo éxito.
-        Serial.printf("DEBUG: No exitoso. Reenviando solicitud a ");
-        Serial.printf("%02X", nodeId);
-        Serial.printf(".\n");
-        // Delay antes de reintentar
-        delay(DELAY_BEFORE_RETRY_GROUND);
-        radio.sendMessage(nodeId, &key, sizeof(key), flag);
+      groundPoll.track(nodeId, now, groundReplyTimeout(nodeId));
+      if (!sendGroundRequest(nodeId)) {
+        groundPoll.expire(nodeId, millis());
       }
-    }  // Fin del while de reintentos
+      return;
+    }
+    groundPoll.closeQueue();
+  }
 
-    if (!t) {
-      // DEBUG: Fallo final al obtener datos.
-      Serial.printf("DEBUG: Fallo definitivo para nodo ");
-      Serial.printf("%02X", nodeId);
-      Serial.printf(".\n");
+  if (groundPoll.finishIfDone(now)) {
+    const PollEngine::CycleStats &st = groundPoll.stats();
+    LOG_I("[requestGroundGpsData] Ciclo finalizado en %lu ms: %u pedidos, %u reintentos, %u respuestas, %u fallos.",
+          st.duration, st.requests, st.retries, st.replies, st.failures);
+  }
+}
+
+bool AppLogic::sendGroundRequest(uint8_t nodeId) {
+  // Empieza como el pedido atmosférico; los nodos anteriores ignoran el resto
+  Protocol::GroundRequest request = { Protocol::KEY, gatewayFeatures(), groundIntervalS() };
+  uint8_t len = GROUND_CACHE_ENABLED == 1 ? sizeof(request) : POLL_REQUEST_LEN;
+  LOG_D("Enviando REQUEST_DATA_GPC_GROUND a 0x%02X.", nodeId);
+  return radio.sendMessage(nodeId, reinterpret_cast<uint8_t *>(&request), len, groundPoll.requestType());
+}
+
+uint16_t AppLogic::groundReplyTimeout(uint8_t nodeId) const {
+  if (GROUND_CACHE_ENABLED == 1 && nodeTable.hasCapability(nodeId, Protocol::CAP_GROUND_CACHE)) {
+    return GROUND_CACHED_REPLY_TIMEOUT;
+  }
+  return GROUND_POLL_REPLY_TIMEOUT;
+}
+
+uint16_t AppLogic::groundIntervalS() const {
+  if (USE_TIMER_FOR_GROUND_REQUEST != 1) {
+    return 0;
+  }
+  return (uint16_t)(INTERVALO_GROUND_REQUEST / 1000UL);
+}
+
+/**
+ * @brief Valida, almacena y publica una respuesta DATA_GPS_CROUND.
+ *
+ * Como en handleAtmosphericReply(), una respuesta tardía (después de un
+ * reintento o del fin del ciclo) se acepta igual. Un nodo con
+ * CAP_GROUND_CACHE agrega Protocol::GroundAge: la lectura puede ser de antes
+ * del pedido y se avisa si es más vieja que dos intervalos.
+ */
+void AppLogic::handleGroundReply(uint8_t *buf, uint8_t len, uint8_t from) {
+  const size_t expectedGroundcDataSize = sizeof(Protocol::GroundGpsPacket);
+
+  if (!nodeTable.contains(from)) {
+    LOG_W("DATA_GPS_CROUND de nodo no registrado 0x%02X. Ignorando.", from);
+    return;
+  }
+  uint16_t seq = 0;
+  bool sequenced = stripBatchHeader(from, buf, len, seq);
+  Protocol::GroundAge age = { 0 };
+  if (GROUND_CACHE_ENABLED == 1 && len == expectedGroundcDataSize + sizeof(age)) {
+    memcpy(&age, buf + expectedGroundcDataSize, sizeof(age));
+    len = expectedGroundcDataSize;
+    if (groundIntervalS() != 0 && age.ageS > 2UL * groundIntervalS()) {
+      LOG_W("Suelo/GPS de 0x%02X con %u s de antigüedad: el nodo no está leyendo el RS485.", from, age.ageS);
     }
-    
-    // Resumen del tiempo total para este nodo
-    unsigned long tiempoTotalNodo = millis() - tiempoInicioNodo;
-    Serial.printf("DEBUG: Tiempo total para nodo ");
-    Serial.printf("%02X", nodeId);
-    Serial.printf(": ");
-    Serial.printf("%lu", tiempoTotalNodo);
-    Serial.printf(" ms.\n");
-    
-    Serial.printf("DEBUG: --- Fin de procesamiento para nodo ---\n");
-    
-    // Delay entre procesamiento de nodos
-    delay(DELAY_BETWEEN_NODES);
-  }  // Fin del for de nodos
+  }
+  if (len != expectedGroundcDataSize) {
+    LOG_W("Tamano de suelo/GPS incorrecto de 0x%02X. Recibido: %u, Esperado: %u.",
+          from, len, (unsigned)expectedGroundcDataSize);
+    return;  // El pedido sigue en vuelo y se reintenta al vencer
+  }
+  if (sequenced && isDuplicateBatch(from, seq)) {
+    groundPoll.complete(from);
+    return;
+  }
+  if (countGroundSamples >= CANTIDAD_MUESTRAS_SUELO) {
+    LOG_W("Posicion 'count' (%u) excede el tamano del array (%u). Paquete no almacenado. reinicio contador.",
+          countGroundSamples, CANTIDAD_MUESTRAS_SUELO);
+    countGroundSamples = 0;
+    return;
+  }
+
+  unsigned long rtt;
+  if (groundPoll.elapsed(from, millis(), rtt)) {
+    LOG_D("Respuesta de suelo/GPS de 0x%02X en %lu ms (lectura de hace %u s).", from, rtt, age.ageS);
+  }
+  groundPoll.complete(from);
+
+  // Las muestras se guardan en nodeTable.ground(nodeId) (el slot existe desde que se registró)
+  Protocol::GroundGpsPacket receivedPacket;
+  memcpy(&receivedPacket, buf, expectedGroundcDataSize);
+  nodeTable.ground(from)[countGroundSamples] = receivedPacket;
+  LOG_D("Paquete de nodo 0x%02X almacenado en posicion %u.", from, countGroundSamples);
+  countGroundSamples++;
 
-  // DEBUG: Fin de la función principal.
-  Serial.printf("DEBUG: [requestGroundGpsData] -- FIN --\n");
+  // Publicar datos por MQTT
+  publishGroundData(from, receivedPacket);
 }
 bool AppLogic::compareHsAndMs() {
     //DEBUG_PRINTLN("compareHsAndMs: Iniciando función");
@@ -710,150 +878,352 @@ bool AppLogic::compareHsAndMs() {
         return false;
     }
     
-    // Obtener la hora actual del RTC
-    Serial.printf("compareHsAndMs: Obteniendo hora actual\n");
-    String currentTime = rtc.getTimeString();
-    Serial.printf("compareHsAndMs: Hora actual obtenida: ");
-    Serial.printf("%s\n", currentTime.c_str());
-    
-    // Verificar que la hora obtenida sea válida (no "00:00" que indica error)
-    if (currentTime == "00:00") {
-        Serial.printf("compareHsAndMs: Hora inválida obtenida del RTC, retornando false\n");
-        return false;
-    }
-    
-    // Comparar con cada intervalo de horas configurado
-    Serial.printf("compareHsAndMs: Comparando con ");
-    Serial.printf("%d", CANTIDAD_MUESTRAS_SUELO);
-    Serial.printf(" intervalos\n");
-    
+    // Comparar hora y minuto del DateTime ya leído: sin Strings por vuelta de loop()
     for (int i = 0; i < CANTIDAD_MUESTRAS_SUELO; i++) {
-        Serial.printf("compareHsAndMs: Procesando intervalo ");
-        Serial.printf("%d\n", i);
-        
-        String targetTime = String(intervaloHorasSuelo[i]) + ":00";
-        Serial.printf("compareHsAndMs: Hora objetivo: ");
-        Serial.printf("%s\n", targetTime.c_str());
-        
-        Serial.printf("compareHsAndMs: Llamando a compareHsAndMs del RTC\n");
-        if (rtc.compareHsAndMs(currentTime, targetTime)) {
-            Serial.printf("compareHsAndMs: Coincidencia encontrada - Hora actual: ");
-            Serial.printf("%s", currentTime.c_str());
-            Serial.printf(" con intervalo: ");
-            Serial.printf("%s\n", targetTime.c_str());
+        if (now.hour() == intervaloHorasSuelo[i] && now.minute() == 0) {
+            LOG_I("compareHsAndMs: Coincidencia con el intervalo %d (%d:00)", i, intervaloHorasSuelo[i]);
             return true;
         }
-        Serial.printf("compareHsAndMs: No coincidencia para este intervalo\n");
     }
     
-    Serial.printf("compareHsAndMs: No se encontraron coincidencias\n");
     return false;
 }
 
-// TODO: falta implementar
+/**
+ * @brief Comandos por consola serie.
+ *
+ * - 'l': vuelca el anillo de registros (Log::dump()).
+ * - 'r': vuelca los próximos saltos conocidos (RouteCache::dump()).
+ * - 'a': mide los ciclos de FrameAuth por trama (benchmarkAuth()).
+ */
 void AppLogic::handleUartRequest() {
+  if (Serial.available() == 0) {
+    return;
+  }
+  int command = Serial.read();
+  if (command == 'l') {
+    Log::dump();
+  } else if (command == 'r') {
+    radio.getRoutes().dump();
+  } else if (command == 'a') {
+    benchmarkAuth();
+  }
+}
 
-  return;
+/**
+ * @brief Ciclos de CPU por trama de FrameAuth con los payloads del protocolo.
+ *
+ * Sella y abre AUTH_BENCH_ITERATIONS veces un lote atmosférico crudo (48
+ * bytes) y un GroundGpsPacket (30), con la construcción de RadioManager:
+ * nonce de 12 bytes, 3 bytes de datos asociados y tag de 4. La radio no se
+ * atiende mientras tanto (unos 100 ms a 80 MHz).
+ */
+void AppLogic::benchmarkAuth() {
+  const uint16_t AUTH_BENCH_ITERATIONS = 100;
+  const uint8_t lengths[] = {sizeof(Protocol::AtmosphericSample) * NUMERO_MUESTRAS_ATMOSFERICAS,
+                             sizeof(Protocol::GroundGpsPacket)};
+  const uint8_t key[FrameAuth::KEY_LEN] = {0};  // El costo no depende de la clave
+  const uint8_t aad[3] = {0x01, 0x00, Protocol::DATA_ATMOSPHERIC};  // [remitente, destino, tipo]
+  uint8_t nonce[FrameAuth::NONCE_LEN] = {0};
+  uint8_t frame[RX_QUEUE_FRAME_LEN];
+  uint8_t tag[16];
+
+  for (uint8_t len : lengths) {
+    memset(frame, 0xA5, len);
+    uint32_t sealCycles = 0;
+    uint32_t openCycles = 0;
+    for (uint16_t i = 0; i < AUTH_BENCH_ITERATIONS; i++) {
+      nonce[0] = (uint8_t)i;
+      uint32_t start = ESP.getCycleCount();
+      FrameAuth::encrypt(key, nonce, aad, sizeof(aad), frame, len, tag);
+      uint32_t sealed = ESP.getCycleCount();
+      FrameAuth::decrypt(key, nonce, aad, sizeof(aad), frame, len, tag, FrameAuth::TAG_LEN);
+      openCycles += ESP.getCycleCount() - sealed;
+      sealCycles += sealed - start;
+      yield();
+    }
+    sealCycles /= AUTH_BENCH_ITERATIONS;
+    openCycles /= AUTH_BENCH_ITERATIONS;
+    Serial.printf("FrameAuth %u B: sellar %lu ciclos (%lu us), abrir %lu ciclos (%lu us) a %u MHz\n", len,
+                  (unsigned long)sealCycles, (unsigned long)(sealCycles / ESP.getCpuFreqMHz()),
+                  (unsigned long)openCycles, (unsigned long)(openCycles / ESP.getCpuFreqMHz()),
+                  (unsigned)ESP.getCpuFreqMHz());
+  }
 }
 
 // ===== MÉTODOS MQTT =====
 
-bool AppLogic::connectWiFi() {
-    if (WiFi.status() == WL_CONNECTED) {
-        return true;
+void AppLogic::publishAtmosphericData(uint8_t nodeId, const Protocol::AtmosphericSample *samples) {
+    if (!uplink.isOnline()) {
+        queueOutbox(Protocol::DATA_ATMOSPHERIC, nodeId, samples, OUTBOX_PAYLOAD_BYTES);
+        return;
     }
-    
-    Serial.printf("Conectando a WiFi: %s\n", WIFI_SSID);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.printf(".");
-        attempts++;
+    if (!appendAtmosphericNode(nodeId, samples)) {
+        flushAtmosphericBatch();
+        if (!appendAtmosphericNode(nodeId, samples)) {
+            LOG_E("Datos atmosféricos de nodo 0x%02X no entran en MQTT_BUFFER_SIZE", nodeId);
+            return;
+        }
     }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.printf("\nConectado a WiFi! IP: %s\n", WiFi.localIP().toString().c_str());
-        wifiConnected = true;
-        return true;
-    } else {
-        Serial.printf("\nError al conectar WiFi\n");
-        wifiConnected = false;
-        return false;
+    mqttBatchIds[mqttBatchNodes++] = nodeId;
+    if (mqttBatchNodes >= MQTT_ATMOS_BATCH_NODES) {
+        flushAtmosphericBatch();
     }
 }
 
-bool AppLogic::connectMQTT() {
-    if (!wifiConnected) {
-        if (!connectWiFi()) {
-            return false;
-        }
+/**
+ * @brief Escribe un nodo en el lote: {"nodeId":N,"samples":[{"time":"HH:MM","temperature":T,"moisture":M},...]}
+ *
+ * Los campos de cada muestra salen de Telemetry::ATMOSPHERIC_FIELDS. El
+ * escritor reserva el ']' que cierra el arreglo en flushAtmosphericBatch().
+ */
+bool AppLogic::appendAtmosphericNode(uint8_t nodeId, const Protocol::AtmosphericSample *samples) {
+    JsonWriter::Mark before = mqttBatch.mark();
+    if (mqttBatchNodes == 0) {
+        mqttBatch.beginArray();
     }
-    
-    if (mqttClient.connected()) {
-        return true;
+    mqttBatch.beginObject().fixed("nodeId", nodeId).beginArray("samples");
+    for (uint8_t i = 0; i < NUMERO_MUESTRAS_ATMOSFERICAS; i++) {
+        mqttBatch.beginObject()
+            .fields(&samples[i], Telemetry::ATMOSPHERIC_FIELDS, Telemetry::ATMOSPHERIC_FIELD_COUNT)
+            .endObject();
     }
-    
-    mqttClient.setClient(wifiClient);
-    mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
-    
-    Serial.printf("Conectando a MQTT: %s:%d\n", MQTT_SERVER, MQTT_PORT);
-    
-    if (mqttClient.connect(MQTT_CLIENT_ID)) {
-        Serial.printf("Conectado a MQTT!\n");
-        mqttConnected = true;
-        return true;
-    } else {
-        Serial.printf("Error al conectar MQTT\n");
-        mqttConnected = false;
+    mqttBatch.endArray().endObject();
+    if (!mqttBatch.ok()) {
+        mqttBatch.rewind(before);
         return false;
     }
+    return true;
 }
 
-void AppLogic::publishAtmosphericData(uint8_t nodeId, const Protocol::AtmosphericSample& data) {
-    if (!connectMQTT()) {
-        Serial.printf("No se pudo conectar MQTT para publicar datos atmosféricos\n");
+void AppLogic::flushAtmosphericBatch() {
+    if (mqttBatchNodes == 0) {
         return;
     }
-    
-    String payload = "{";
-    payload += "\"nodeId\":" + String(nodeId);
-    payload += ",\"temperature\":" + String(data.temp / 10.0, 1);
-    payload += ",\"moisture\":" + String(data.moisture / 10.0, 1);
-    payload += "}";
-    
-    if (mqttClient.publish(MQTT_TOPIC_ATMOSPHERIC, payload.c_str())) {
-        Serial.printf("Datos atmosféricos publicados para nodo 0x%02X\n", nodeId);
+    uint8_t nodes = mqttBatchNodes;
+    if (!sendAtmosphericBatch()) {
+        // Las muestras siguen en nodeTable: cada nodo reporta una vez por ciclo
+        for (uint8_t i = 0; i < nodes; i++) {
+            queueOutbox(Protocol::DATA_ATMOSPHERIC, mqttBatchIds[i], nodeTable.atmospheric(mqttBatchIds[i]), OUTBOX_PAYLOAD_BYTES);
+        }
+    }
+}
+
+bool AppLogic::sendAtmosphericBatch() {
+    mqttBatch.endArray();
+    bool sent = mqttClient.connected() &&
+                mqttClient.publish(MQTT_TOPIC_ATMOSPHERIC, reinterpret_cast<const uint8_t *>(mqttBatch.c_str()), mqttBatch.length());
+    if (sent) {
+        LOG_D("Datos atmosféricos publicados: %u nodos, %u bytes", mqttBatchNodes, (unsigned)mqttBatch.length());
     } else {
-        Serial.printf("Error al publicar datos atmosféricos para nodo 0x%02X\n", nodeId);
+        LOG_W("Error al publicar datos atmosféricos (%u nodos, %u bytes)", mqttBatchNodes, (unsigned)mqttBatch.length());
     }
+    mqttBatch.reset();
+    mqttBatchNodes = 0;
+    return sent;
 }
 
 void AppLogic::publishGroundData(uint8_t nodeId, const Protocol::GroundGpsPacket& data) {
-    if (!connectMQTT()) {
-        Serial.printf("No se pudo conectar MQTT para publicar datos de suelo\n");
-        return;
+    if (!uplink.isOnline() || !sendGroundData(nodeId, data)) {
+        queueOutbox(Protocol::DATA_GPS_CROUND, nodeId, &data, sizeof(data));
     }
-    
-    String payload = "{";
-    payload += "\"nodeId\":" + String(nodeId);
-    payload += ",\"temperature\":" + String(data.ground.temp / 10.0, 1);
-    payload += ",\"moisture\":" + String(data.ground.moisture / 10.0, 1);
-    payload += ",\"n\":" + String(data.ground.n);
-    payload += ",\"p\":" + String(data.ground.p);
-    payload += ",\"k\":" + String(data.ground.k);
-    payload += ",\"ec\":" + String(data.ground.EC);
-    payload += ",\"ph\":" + String(data.ground.PH / 10.0, 1);
-    payload += ",\"volt\":3.33";
-    payload += ",\"latitude\":" + String(data.gps.latitude, 7);
-    payload += ",\"longitude\":" + String(data.gps.longitude, 7);
-    payload += "}";
-    
-    if (mqttClient.publish(MQTT_TOPIC_GROUND, payload.c_str())) {
-        Serial.printf("Datos de suelo publicados para nodo 0x%02X\n", nodeId);
+}
+
+bool AppLogic::sendGroundData(uint8_t nodeId, const Protocol::GroundGpsPacket& data) {
+    char payload[MQTT_GROUND_PAYLOAD_SIZE];
+    JsonWriter json(payload, sizeof(payload));
+    json.beginObject()
+        .fixed("nodeId", nodeId)
+        .fields(&data, Telemetry::GROUND_FIELDS, Telemetry::GROUND_FIELD_COUNT)
+        .endObject();
+    if (!json.ok()) {
+        LOG_E("Datos de suelo de nodo 0x%02X no entran en MQTT_GROUND_PAYLOAD_SIZE", nodeId);
+        return true;  // Reintentar no cambia nada
+    }
+
+    if (mqttClient.connected() &&
+        mqttClient.publish(MQTT_TOPIC_GROUND, reinterpret_cast<const uint8_t *>(json.c_str()), json.length())) {
+        LOG_D("Datos de suelo publicados para nodo 0x%02X", nodeId);
+        return true;
+    }
+    LOG_W("Error al publicar datos de suelo para nodo 0x%02X", nodeId);
+    return false;
+}
+
+void AppLogic::publishLinkStats() {
+  unsigned long now = millis();
+  if (!uplink.isOnline() || now - linkStatsAt < LINK_STATS_PUBLISH_INTERVAL_MS) {
+    return;
+  }
+  linkStatsAt = now;
+
+  char header[LinkStats::HEADER_MAX_LEN];
+  size_t headerLen = (size_t)snprintf(header, sizeof(header), LinkStats::HEADER_FORMAT, now / 1000);
+  char row[LinkStats::ROW_MAX_LEN];
+  uint8_t id;
+
+  // Primera pasada: largo total, que PubSubClient necesita antes del payload
+  size_t total = headerLen + strlen(LinkStats::FOOTER);
+  uint16_t rows = 0;
+  for (uint16_t cursor = 0; nodeTable.next(cursor, id); cursor = (uint16_t)id + 1) {
+    size_t n = linkStats.formatRow(id, now, row, sizeof(row));
+    if (n > 0) {
+      total += n + (rows > 0 ? 1 : 0);
+      rows++;
+    }
+  }
+  if (rows == 0) {
+    return;
+  }
+
+  if (!mqttClient.beginPublish(MQTT_TOPIC_LINKS, total, false)) {
+    LOG_W("Error al publicar estadísticas de enlace (%u bytes)", (unsigned)total);
+    return;
+  }
+  mqttClient.write(reinterpret_cast<const uint8_t *>(header), headerLen);
+  bool first = true;
+  for (uint16_t cursor = 0; nodeTable.next(cursor, id); cursor = (uint16_t)id + 1) {
+    size_t n = linkStats.formatRow(id, now, row, sizeof(row));
+    if (n == 0) {
+      continue;
+    }
+    if (!first) {
+      mqttClient.write(',');
+    }
+    mqttClient.write(reinterpret_cast<const uint8_t *>(row), n);
+    first = false;
+  }
+  mqttClient.write(reinterpret_cast<const uint8_t *>(LinkStats::FOOTER), strlen(LinkStats::FOOTER));
+  if (mqttClient.endPublish()) {
+    LOG_D("Estadísticas de enlace publicadas: %u nodos, %u bytes", rows, (unsigned)total);
+  } else {
+    LOG_W("Error al publicar estadísticas de enlace (%u bytes)", (unsigned)total);
+  }
+}
+
+/**
+ * @brief Cierra la cuenta de tiempo en el aire del ciclo y la publica.
+ *
+ * El ciclo va de un ANNOUNCE (modo slots) o de un requestAtmosphericData() al
+ * siguiente, así que incluye todo lo que transmitió el gateway en ese período.
+ */
+void AppLogic::publishGatewayMetrics() {
+  DutyCycle &duty = radio.getDutyCycle();
+  unsigned long now = millis();
+  lastCycleAirtimeMs = duty.totalMs() - airtimeAtCycle;
+  airtimeAtCycle = duty.totalMs();
+  LOG_I("Tiempo en el aire del ciclo: %lu ms (%lu de %lu ms en la ventana)", (unsigned long)lastCycleAirtimeMs,
+        (unsigned long)duty.usedMs(now), (unsigned long)duty.budgetMs());
+  if (!uplink.isOnline()) {
+    return;  // No se encola: el próximo ciclo trae el acumulado de la ventana
+  }
+
+  char payload[MQTT_GATEWAY_PAYLOAD_SIZE];
+  JsonWriter json(payload, sizeof(payload));
+  json.beginObject()
+      .number("uptime", now / 1000)
+      .number("airtime_ms", lastCycleAirtimeMs)
+      .number("duty_window_ms", duty.usedMs(now))
+      .number("duty_budget_ms", duty.budgetMs())
+      .number("duty_denied", duty.denied())
+      .number("seq_dup", batchSequence.duplicates())
+      .number("seq_gap", batchSequence.gaps())
+      .number("seq_reset", batchSequence.restarts())
+      .number("auth_fail", radio.getAuth().forged())
+      .number("auth_replay", radio.getAuth().replays())
+      .number("auth_stale", radio.getAuth().stale())
+      .endObject();
+  if (!json.ok() ||
+      !mqttClient.publish(MQTT_TOPIC_GATEWAY, reinterpret_cast<const uint8_t *>(json.c_str()), json.length())) {
+    LOG_W("Error al publicar métricas del gateway");
+  }
+}
+
+/**
+ * @brief Calentamiento de rutas: un descubrimiento por vez, en momentos ociosos.
+ *
+ * RadioManager guarda y restaura las rutas, así que después de un reinicio los
+ * nodos conocidos no necesitan descubrimiento. Quedan los que perdieron la
+ * ruta (falló la entrega) y los que nunca la tuvieron: sin esto, el primer
+ * pedido del ciclo a cada uno inunda la red mientras el sondeo espera.
+ *
+ * Un descubrimiento sin respuesta bloquea la radio RH_MESH_ARP_TIMEOUT, así
+ * que no se lanza con sondeo, slots o intercambio ADR abiertos ni a menos de
+ * ese tiempo del próximo ANNOUNCE o ciclo. Entre uno y otro se espera
+ * ROUTE_WARMUP_INTERVAL_MS más un azar de hasta ROUTE_WARMUP_JITTER_MS, y cada
+ * nodo se intenta una vez por supertrama (sendAnnounce() reinicia la vuelta).
+ */
+void AppLogic::warmUpRoutes() {
+  unsigned long now = millis();
+  if (ROUTE_WARMUP_ENABLED != 1 || routeWarmupNext > 255 || (long)(now - routeWarmupAt) < 0 ||
+      atmosPoll.isActive() || groundPoll.isActive() || slotWindowOpen || linkExchangeOpen) {
+    return;
+  }
+  unsigned long announcePeriod = ATMOSPHERIC_SLOTTED_MODE == 1 ? INTERVALOATMOSPHERIC : INTERVALOANNOUNCE;
+  if (now - temBuf + RH_MESH_ARP_TIMEOUT >= announcePeriod ||
+      (ATMOSPHERIC_SLOTTED_MODE != 1 && now - temBuf1 + RH_MESH_ARP_TIMEOUT >= INTERVALOATMOSPHERIC)) {
+    return;
+  }
+
+  uint8_t nodeId;
+  uint8_t nextHop;
+  while (routeWarmupNext <= 255 && nodeTable.next(routeWarmupNext, nodeId)) {
+    routeWarmupNext = (uint16_t)nodeId + 1;
+    if (!radio.getRoutes().lookup(nodeId, nextHop)) {
+      bool found = radio.discoverRoute(nodeId);
+      LOG_D("Calentamiento de ruta a 0x%02X: %s", nodeId, found ? "ok" : "sin respuesta");
+      routeWarmupAt = millis() + ROUTE_WARMUP_INTERVAL_MS + random(ROUTE_WARMUP_JITTER_MS);
+      return;
+    }
+  }
+  routeWarmupNext = 256;
+}
+
+void AppLogic::queueOutbox(uint8_t type, uint8_t nodeId, const void *data, uint8_t len) {
+    if (outbox.push(type, nodeId, data, len)) {
+        LOG_D("Sin MQTT: datos de nodo 0x%02X encolados (%u pendientes).", nodeId, outbox.count());
     } else {
-        Serial.printf("Error al publicar datos de suelo para nodo 0x%02X\n", nodeId);
-        
+        LOG_E("Sin MQTT: datos de nodo 0x%02X descartados, cola no disponible.", nodeId);
+    }
+}
+
+void AppLogic::drainOutbox() {
+    if (outbox.count() == 0 || !uplink.isOnline() || millis() - outboxDrainAt < OUTBOX_DRAIN_INTERVAL_MS) {
+        return;
+    }
+    outboxDrainAt = millis();
+
+    OutboxRecord record;
+    uint8_t sent = 0;
+    while (sent < OUTBOX_DRAIN_BATCH && outbox.peek(record)) {
+        bool ok;
+        if (record.type == Protocol::DATA_GPS_CROUND) {
+            Protocol::GroundGpsPacket packet;
+            memcpy(&packet, record.data, sizeof(packet));
+            ok = sendGroundData(record.nodeId, packet);
+        } else {
+            if (mqttBatchNodes > 0) {
+                break;  // El lote en armado usa el mismo buffer; se sigue en la próxima tanda
+            }
+            Protocol::AtmosphericSample samples[NUMERO_MUESTRAS_ATMOSFERICAS];
+            memcpy(samples, record.data, sizeof(samples));
+            if (!appendAtmosphericNode(record.nodeId, samples)) {
+                // Solo en el lote y aun así no entra: tampoco va a entrar en la próxima tanda
+                LOG_E("Cola MQTT: datos de nodo 0x%02X no entran en MQTT_BUFFER_SIZE, se descartan", record.nodeId);
+                outbox.discard();
+                continue;
+            }
+            mqttBatchNodes = 1;
+            ok = sendAtmosphericBatch();
+        }
+        if (!ok) {
+            break;
+        }
+        outbox.pop();
+        sent++;
+    }
+    outbox.commit();
+    if (sent > 0) {
+        LOG_I("Cola MQTT: %u registros publicados, %u pendientes.", sent, outbox.count());
     }
 }
\ No newline at end of file
@@ -17,13 +17,21 @@
 #ifndef APP_LOGIC_H
 #define APP_LOGIC_H
 
-#include <map>
 #include <ESP8266WiFi.h>
 #include <PubSubClient.h>
 #include "node_identity.h" // Para NodeIdentity (dirección MAC, clave)
 #include "radio_manager.h" // Para RadioManager (gestión de radio LoRa)
 #include "protocol.h"      // Para Protocol (serialización/deserialización de mensajes)
+#include "atmos_codec.h"   // Para AtmosCodec (DATA_ATMOSPHERIC comprimido)
+#include "link_adr.h"      // Para LinkAdr (perfil de radio por enlace)
+#include "link_stats.h"    // Para LinkStats (calidad de enlace por nodo)
+#include "sequence_tracker.h" // Para SequenceTracker (lotes duplicados y perdidos)
 #include "rtc_manager.h"
+#include "poll_engine.h"   // Para PollEngine (sondeo no bloqueante)
+#include "node_table.h"    // Para NodeTable (registro de nodos y muestras)
+#include "json_writer.h"   // Para JsonWriter (payloads MQTT sin heap)
+#include "uplink_manager.h" // Para UplinkManager (WiFi/MQTT no bloqueante)
+#include "outbox_queue.h"  // Para OutboxQueue (lecturas pendientes de publicar)
 #include "config.h"
 
 /**
@@ -40,7 +48,7 @@
  * 
  * @note Esta clase es específica para ESP8266 y requiere inicialización
  *       de SPI para comunicación LoRa
- * @warning No exceder MAX_NODES (250) para evitar sobrecarga de memoria
+ * @warning Se registran hasta MAX_NODES nodos (100 por defecto, ajustable al compilar; ver config.h); las tablas por nodo se dimensionan con ese valor
  * 
  * @example
  * ```cpp
@@ -64,103 +72,339 @@
  */
 class AppLogic
 {
+public:
+    /**
+     * @brief Nodos registrados (MAC) y sus últimas muestras atmosféricas y de suelo/GPS
+     * @details Tabla de MAX_NODES slots con un índice por ID; sin reservas en el heap.
+     * adr, linkStats y batchSequence usan los mismos slots, por eso se declara antes.
+     * @note Ocupa sizeof(NodeTable) bytes (~12 KB en producción)
+     *
+     * @example
+     * ```cpp
+     * // Acceder a datos del nodo 0x42
+     * if (logic.nodeTable.contains(0x42)) {
+     *     Protocol::AtmosphericSample sample = logic.nodeTable.atmospheric(0x42)[0];
+     *     Protocol::GroundGpsPacket ground = logic.nodeTable.ground(0x42)[0];
+     * }
+     * ```
+     */
+    NodeTable nodeTable;
+
 private:
     NodeIdentity nodeIdentity; /**< @brief Gestor de identidad del nodo basado en MAC */
-    RadioManager radio;        /**< @brief Gestor de comunicación LoRa */
+    RadioManager& radio;       /**< @brief Referencia al gestor de comunicación LoRa (dueño del driver y su interrupción) */
     RtcManager& rtc;          /**< @brief Referencia al gestor de tiempo real */
     uint8_t gatewayAddress;   /**< @brief Dirección de red del Gateway */
 
     // Variables WiFi y MQTT
     WiFiClient wifiClient;    /**< @brief Cliente WiFi */
     PubSubClient mqttClient;  /**< @brief Cliente MQTT */
-    bool wifiConnected;       /**< @brief Estado de conexión WiFi */
-    bool mqttConnected;       /**< @brief Estado de conexión MQTT */
+    UplinkManager uplink;     /**< @brief Conexión WiFi/MQTT con reintentos; se avanza en update() */
 
-    std::map<uint8_t, String> mapNodesIDsMac; /**< @brief Mapeo de IDs de nodos a direcciones MAC */
+    static const uint8_t POLL_REQUEST_LEN = 2; /**< @brief KEY y features de REQUEST_DATA_ATMOSPHERIC y REQUEST_DATA_GPC_GROUND */
 
     /**
-     * @brief Intervalos de solicitud de datos de suelo/GPS (en horas)
-     * @details Los datos de suelo se solicitan a las 12:00 y 24:00 horas
+     * @brief Bytes de payload que entran en el buffer de PubSubClient
+     * @details Descuenta la cabecera fija, el largo del tópico y el tópico
+     */
+    static const size_t MQTT_PAYLOAD_SIZE = MQTT_BUFFER_SIZE - MQTT_MAX_HEADER_SIZE - 2 - (sizeof(MQTT_TOPIC_ATMOSPHERIC) - 1);
+    char mqttPayload[MQTT_PAYLOAD_SIZE]; /**< @brief Lote atmosférico en armado (arreglo JSON de nodos) */
+    JsonWriter mqttBatch;                /**< @brief Escritor sobre mqttPayload */
+    uint8_t mqttBatchNodes = 0;          /**< @brief Nodos en el lote actual */
+    uint8_t mqttBatchIds[MQTT_ATMOS_BATCH_NODES]; /**< @brief IDs del lote, para encolarlos si falla la publicación */
+
+    /**
+     * @brief Lecturas que no se pudieron publicar, persistidas en LittleFS
+     * @see drainOutbox()
+     */
+    OutboxQueue outbox;
+    unsigned long outboxDrainAt = 0; /**< @brief millis() de la última tanda de la cola */
+
+    /**
+     * @brief Tabla de solicitudes atmosféricas en vuelo
+     * @details Se recorre desde update() mediante servicePoll()
+     * @see requestAtmosphericData(), PollEngine
+     */
+    PollEngine atmosPoll;
+
+    /**
+     * @brief Tabla de solicitudes de suelo/GPS en vuelo
+     * @details Se recorre desde update() mediante serviceGroundPoll()
      * @see requestGroundGpsData()
      */
-    const int intervaloHorasSuelo[CANTIDAD_MUESTRAS_SUELO] = {12, 24};
-    
-    unsigned long temBuf = 0;  /**< @brief Buffer temporal para gestión de tiempo */
-    unsigned long temBuf1 = 0; /**< @brief Buffer temporal secundario */
+    PollEngine groundPoll;
+
+    /**
+     * @brief Nodos que ya enviaron DATA_ATMOSPHERIC en la supertrama actual
+     * @details Bitmap con el mismo formato que Protocol::SlotSchedule::nodes.
+     * Se limpia con cada ANNOUNCE o pedido broadcast; el sondeo de respaldo saltea estos nodos.
+     */
+    uint8_t slotReported[Protocol::SLOT_BITMAP_BYTES] = {0};
+    unsigned long slotWindowEnd = 0; /**< @brief millis() en que vence la ventana de slots */
+    bool slotWindowOpen = false;     /**< @brief Hay slots asignados pendientes de vencer */
 
     /**
-     * @brief Número máximo de reintentos para solicitudes de datos
-     * @details Después de este número de reintentos, el nodo se marca como inactivo
-     * @see nodesDown
+     * @brief Perfil de radio y potencia de cada vecino directo
+     * @see updateLinkProfile(), openLinkExchange()
      */
-    const uint8_t connectionRetries = 2;
+    LinkAdr adr;
+    bool linkExchangeOpen = false;       /**< @brief La radio está en el perfil de un enlace esperando su respuesta */
+    uint8_t linkExchangeNode = 0;        /**< @brief Nodo del intercambio abierto */
+    unsigned long linkExchangeUntil = 0; /**< @brief millis() en que se abandona la espera */
 
     /**
-     * @brief Flag que indica si los datos han sido actualizados
-     * @details Se activa después de requestAtmosphericData() o requestGroundGpsData()
+     * @brief RSSI, SNR, reintentos, RTT y saltos por nodo
+     * @see publishLinkStats()
      */
-    bool updatedData = false;
+    LinkStats linkStats;
+
+    /**
+     * @brief Último número de lote (Protocol::BatchHeader) aceptado de cada nodo
+     * @see stripBatchHeader(), isDuplicateBatch()
+     */
+    SequenceTracker batchSequence;
+    bool batchAckPending = false;        /**< @brief Hay un BATCH_ACK por enviar tras despachar la trama */
+    uint8_t batchAckNode = 0;            /**< @brief Destino del BATCH_ACK pendiente */
+    uint16_t batchAckSeq = 0;            /**< @brief Número de lote que confirma */
+    unsigned long linkStatsAt = 0;       /**< @brief millis() de la última publicación de linkStats */
+
+    uint16_t routeWarmupNext = 0;        /**< @brief Próximo ID a revisar en warmUpRoutes(); sendAnnounce() reinicia la vuelta */
+    unsigned long routeWarmupAt = 0;     /**< @brief millis() desde el que se permite el próximo descubrimiento */
+
+    uint32_t airtimeAtCycle = 0;         /**< @brief DutyCycle::totalMs() al comenzar el ciclo atmosférico */
+    uint32_t lastCycleAirtimeMs = 0;     /**< @brief Tiempo en el aire del gateway en el último ciclo completo */
+
+    /**
+     * @brief Intervalos de solicitud de datos de suelo/GPS (en horas)
+     * @details Los datos de suelo se solicitan a las 12:00 y 24:00 horas
+     * @see requestGroundGpsData()
+     */
+    const int intervaloHorasSuelo[CANTIDAD_MUESTRAS_SUELO] = {12, 24};
+    
+    unsigned long temBuf = 0;  /**< @brief Buffer temporal para gestión de tiempo */
+    unsigned long temBuf1 = 0; /**< @brief Buffer temporal secundario */
 
     /**
      * @brief Contador de muestras de suelo almacenadas
      * @details Controla la posición en el array de muestras diarias
-     * @see groundGpsSamplesNodes
+     * @see NodeTable::ground()
      */
     uint8_t countGroundSamples = 0;
     
     /**
      * @brief Envía mensaje ANNOUNCE a la red
-     * @details Broadcast que anuncia la presencia del Gateway
+     * @details Broadcast que anuncia la presencia del Gateway. Con
+     * ATMOSPHERIC_SLOTTED_MODE lleva además el calendario de slots
+     * (Protocol::SlotSchedule) y abre la ventana de envío de los nodos.
      * @see Protocol::ANNOUNCE
      */
     void sendAnnounce();
 
+    /**
+     * @brief Cierra la ventana de slots y sondea a los nodos que no enviaron
+     * @details Los nodos sin actualizar (firmware viejo, ANNOUNCE o pedido perdido)
+     * se piden con el PollEngine como en el modo sin slots.
+     */
+    void closeSlotWindow();
+
+    /**
+     * @brief Despacha los mensajes en la cola de recepción de la radio (hasta RX_QUEUE_DEPTH)
+     * @see dispatchReceived()
+     */
+    void handleIncoming();
+
+    /**
+     * @brief Saca un mensaje de la radio y lo despacha según su tipo
+     * @details HELLO va a handleHello(), DATA_ATMOSPHERIC a handleAtmosphericReply()
+     * y DATA_GPS_CROUND a handleGroundReply()
+     * @return false si no había mensajes
+     */
+    bool dispatchReceived();
+
     /**
      * @brief Procesa mensajes HELLO de nodos sensores
-     * @details Registra nuevos nodos en la red
+     * @details Registra nuevos nodos en la red. Acepta el HELLO binario
+     * (Protocol::HelloPacket) y el de firmware viejo con la MAC en texto.
+     * @param buf Payload recibido
+     * @param len Longitud del payload
+     * @param from ID del nodo remitente
      * @see Protocol::HELLO
      */
-    void handleHello();
+    void handleHello(uint8_t *buf, uint8_t len, uint8_t from);
     
     /**
      * @brief Registra un nuevo nodo en la red
-     * @param receivedMac Dirección MAC del nodo
+     * @param hello MAC, versión de protocolo y capacidades del nodo
      * @param from ID del nodo
-     * @return true si el registro fue exitoso, false en caso contrario
+     * @return true si el registro fue exitoso, false si el ID ya está tomado por otra MAC o la tabla está llena
      */
-    bool registerNewNode(char receivedMac, uint8_t from);
+    bool registerNewNode(const Protocol::HelloPacket &hello, uint8_t from);
     
     /**
-     * @brief Solicita datos atmosféricos a todos los nodos registrados
-     * @details Itera sobre todos los nodos conocidos y envía REQUEST_DATA_ATMOSPHERIC
+     * @brief Inicia un ciclo de solicitud de datos atmosféricos a todos los nodos registrados
+     * @details No bloquea: solo arma el ciclo en atmosPoll. Los REQUEST_DATA_ATMOSPHERIC
+     * se envían desde servicePoll() con hasta POLL_MAX_IN_FLIGHT nodos en vuelo.
      * @note Los datos se solicitan cada INTERVALOATMOSPHERIC milisegundos
-     * @warning No exceder MAX_NODES para evitar sobrecarga de memoria
-     * @return true si al menos un nodo respondió, false en caso contrario
+     * @warning Si el ciclo anterior no terminó, el nuevo se omite
      * 
-     * @example
-     * ```cpp
-     * if (logic.requestAtmosphericData()) {
-     *     Serial.println("Datos atmosféricos recibidos");
-     * }
-     * ```
-     * 
-     * @see AtmosphericSampleNodes, Protocol::REQUEST_DATA_ATMOSPHERIC
+     * @see NodeTable::atmospheric(), Protocol::REQUEST_DATA_ATMOSPHERIC
      */
     void requestAtmosphericData();
+
+    /**
+     * @brief Pide datos atmosféricos a los vecinos directos con un REQUEST_DATA_ATMOSPHERIC broadcast
+     * @details Abre la ventana de slots; al cerrarla se sondea solo a los que no respondieron.
+     * @see Protocol::PollWindow, ATMOSPHERIC_BROADCAST_POLL
+     */
+    void sendPollWindow();
+
+    /**
+     * @brief Avanza el ciclo de sondeo en curso
+     * @details Reenvía solicitudes vencidas, descarta nodos sin reintentos y
+     * pone en vuelo un pedido nuevo si hay slot libre. Envía como máximo un
+     * mensaje por llamada para no demorar la recepción.
+     */
+    void servicePoll();
+
+    /**
+     * @brief Envía REQUEST_DATA_ATMOSPHERIC a un nodo
+     * @param nodeId Nodo destino
+     * @return true si el mensaje fue reconocido por el siguiente salto
+     */
+    bool sendPollRequest(uint8_t nodeId);
+
+    /**
+     * @brief Pasa la radio al perfil del enlace para recibir la respuesta del nodo
+     * @details Mientras está abierto no se envían otros pedidos: la radio no
+     * escucha el perfil default. Se cierra con la respuesta, al vencer
+     * ADR_EXCHANGE_TIMEOUT_MS o antes de un ANNOUNCE.
+     */
+    void openLinkExchange(uint8_t nodeId);
+
+    /**
+     * @brief Devuelve la radio al perfil default si había un intercambio abierto
+     * @param replied true si llegó la respuesta; si no, cuenta como pérdida en LinkAdr
+     */
+    void closeLinkExchange(bool replied);
+
+    /**
+     * @brief Envía LINK_PROFILE si LinkAdr recomienda otro perfil o potencia para el nodo
+     * @details Se llama con cada HELLO, que siempre llega en el perfil default
+     */
+    void updateLinkProfile(uint8_t nodeId);
+
+    /**
+     * @brief Bitmap de Protocol::GatewayFeature que se anuncia a los nodos
+     */
+    uint8_t gatewayFeatures() const;
+
+    /**
+     * @brief Marca los nodos registrados a un salto, los únicos que oyen un broadcast
+     * @details La última trama de cada nodo (LinkStats) da sus saltos; un nodo
+     * con ruta de varios saltos no tiene slot y se pide unicast.
+     * @param nodes Bitmap de Protocol::SLOT_BITMAP_BYTES bytes a completar
+     * @return Nodos marcados (slots de la ventana)
+     */
+    size_t markDirectNodes(uint8_t *nodes) const;
+
+    /**
+     * @brief Busca el primer nodo registrado con ID mayor o igual a start
+     * @param start ID inicial de búsqueda (0-256)
+     * @param nodeId ID encontrado
+     * @return false si no hay más nodos
+     */
+    bool nextRegisteredNode(uint16_t start, uint8_t &nodeId);
+
+    /**
+     * @brief Indica si el nodo ya envió sus datos en la supertrama actual
+     * @param nodeId ID del nodo
+     */
+    bool slotReportedBy(uint8_t nodeId) const;
+
+    /**
+     * @brief Quita el Protocol::BatchHeader del payload si el nodo numera sus lotes
+     * @param buf Payload; avanza hasta los datos
+     * @param len Longitud; se descuenta la cabecera
+     * @param seq Número de lote leído
+     * @return false si el payload no trae número de lote
+     */
+    bool stripBatchHeader(uint8_t from, uint8_t *&buf, uint8_t &len, uint16_t &seq) const;
+
+    /**
+     * @brief Registra el número de lote e indica si ya se había aceptado
+     */
+    bool isDuplicateBatch(uint8_t from, uint16_t seq);
+
+    /**
+     * @brief Confirma al nodo el DATA_ATMOSPHERIC guardado (Protocol::BatchAck)
+     * @details Sale después del despacho, con el intercambio ADR ya cerrado:
+     * el nodo vuelve al perfil default apenas envía su respuesta.
+     */
+    void sendBatchAck();
+
+    /**
+     * @brief Almacena y publica un DATA_ATMOSPHERIC (respuesta a pedido o envío en slot)
+     * @param buf Payload recibido
+     * @param len Longitud del payload
+     * @param from ID del nodo remitente
+     */
+    void handleAtmosphericReply(uint8_t *buf, uint8_t len, uint8_t from);
     
     /**
-     * @brief Solicita datos de suelo/GPS a todos los nodos registrados
-     * @details Se ejecuta en horarios específicos (12:00 y 24:00)
+     * @brief Solicita datos de suelo/GPS a todos los nodos registrados con CAP_GROUND_GPS
+     * @details Se ejecuta en horarios específicos (12:00 y 24:00). No bloquea:
+     * solo arma el ciclo en groundPoll, que avanza serviceGroundPoll().
      * @note Verifica compareHsAndMs() antes de ejecutar
-     * @see groundGpsSamplesNodes, Protocol::REQUEST_DATA_GPS_GROUND
+     * @see NodeTable::ground(), Protocol::REQUEST_DATA_GPS_GROUND
      */
     void requestGroundGpsData();
+
+    /**
+     * @brief Avanza el ciclo de suelo/GPS en curso
+     * @details Como servicePoll(): reintentos, descarte y un pedido nuevo,
+     * un mensaje por llamada. Espera mientras haya slots o un intercambio ADR abiertos.
+     */
+    void serviceGroundPoll();
+
+    /**
+     * @brief Envía REQUEST_DATA_GPC_GROUND a un nodo
+     * @details Con GROUND_CACHE_ENABLED el payload es un Protocol::GroundRequest
+     * con el intervalo de pedidos, para que el nodo lea justo antes del próximo.
+     * @return true si el mensaje fue reconocido por el siguiente salto
+     */
+    bool sendGroundRequest(uint8_t nodeId);
+
+    /**
+     * @brief Espera por intento de la respuesta de suelo/GPS de un nodo
+     * @return GROUND_CACHED_REPLY_TIMEOUT si responde de su caché (CAP_GROUND_CACHE),
+     * si no GROUND_POLL_REPLY_TIMEOUT (lee el RS485 al recibir el pedido)
+     */
+    uint16_t groundReplyTimeout(uint8_t nodeId) const;
+
+    /**
+     * @brief Segundos entre pedidos de suelo que se informan en Protocol::GroundRequest
+     * @return 0 en modo comparación de horas (sin intervalo fijo)
+     */
+    uint16_t groundIntervalS() const;
+
+    /**
+     * @brief Almacena y publica un DATA_GPS_CROUND
+     * @param buf Payload recibido
+     * @param len Longitud del payload
+     * @param from ID del nodo remitente
+     */
+    void handleGroundReply(uint8_t *buf, uint8_t len, uint8_t from);
     
     /**
      * @brief Procesa solicitudes UART externas
-     * @details Permite comunicación serial para debugging y control
+     * @details Permite comunicación serial para debugging y control ('l' vuelca el log en RAM)
      */
     void handleUartRequest();
+
+    /**
+     * @brief Mide por consola los ciclos de CPU de FrameAuth por trama ('a')
+     */
+    void benchmarkAuth();
     
     /**
      * @brief Envía comando de cambio de ID a un nodo
@@ -183,72 +427,81 @@ private:
     bool compareHsAndMs();
 
     /**
-     * @brief Conecta a WiFi
-     * @details Intenta conectar a la red WiFi configurada
-     * @return true si la conexión fue exitosa
+     * @brief Agrega las muestras atmosféricas de un nodo al lote MQTT
+     * @details Publica el lote al llegar a MQTT_ATMOS_BATCH_NODES nodos o si
+     * el nodo no entra en el buffer. El resto se publica desde update() cuando
+     * termina el ciclo atmosférico.
+     * @param nodeId ID del nodo
+     * @param samples NUMERO_MUESTRAS_ATMOSFERICAS muestras del nodo
      */
-    bool connectWiFi();
+    void publishAtmosphericData(uint8_t nodeId, const Protocol::AtmosphericSample *samples);
 
     /**
-     * @brief Conecta a MQTT
-     * @details Intenta conectar al broker MQTT configurado
-     * @return true si la conexión fue exitosa
+     * @brief Escribe el objeto JSON de un nodo al final de mqttPayload
+     * @return false si no entra; el lote queda como estaba
      */
-    bool connectMQTT();
+    bool appendAtmosphericNode(uint8_t nodeId, const Protocol::AtmosphericSample *samples);
 
     /**
-     * @brief Publica datos atmosféricos por MQTT
-     * @param nodeId ID del nodo
-     * @param data Datos atmosféricos a publicar
+     * @brief Publica el lote atmosférico pendiente (si hay) y lo vacía
+     * @details Si no se puede publicar, las muestras de cada nodo del lote
+     * (todavía en nodeTable) pasan a la cola persistente.
      */
-    void publishAtmosphericData(uint8_t nodeId, const Protocol::AtmosphericSample& data);
+    void flushAtmosphericBatch();
 
     /**
-     * @brief Publica datos de suelo por MQTT
+     * @brief Cierra el lote atmosférico, lo publica si hay conexión y lo vacía
+     * @return true si el broker aceptó el mensaje
+     */
+    bool sendAtmosphericBatch();
+
+    /**
+     * @brief Publica datos de suelo por MQTT o los encola si no hay conexión
      * @param nodeId ID del nodo
      * @param data Datos de suelo a publicar
      */
     void publishGroundData(uint8_t nodeId, const Protocol::GroundGpsPacket& data);
 
-public:
     /**
-     * @brief Almacenamiento de datos de suelo/GPS por nodo
-     * @details Mapa donde cada elemento es un array de GroundGpsPacket
-     * @note CANTIDAD_MUESTRAS_SUELO muestras por día por nodo
-     * @warning No exceder MAX_NODES para evitar sobrecarga de memoria
-     * 
-     * @example
-     * ```cpp
-     * // Acceder a datos de suelo del nodo 0x42
-     * auto& nodeData = logic.groundGpsSamplesNodes[0x42];
-     * GroundGpsPacket sample = nodeData[0]; // Primera muestra del día
-     * ```
+     * @brief Arma y publica el JSON de un paquete de suelo
+     * @return false si hay que reintentar más tarde (sin conexión o publicación rechazada)
      */
-    std::map<std::uint8_t, std::array<Protocol::GroundGpsPacket, CANTIDAD_MUESTRAS_SUELO>> groundGpsSamplesNodes;
+    bool sendGroundData(uint8_t nodeId, const Protocol::GroundGpsPacket& data);
 
     /**
-     * @brief Almacenamiento de datos atmosféricos por nodo
-     * @details Mapa donde cada elemento es un array de AtmosphericSample
-     * @note NUMERO_MUESTRAS_ATMOSFERICAS muestras por nodo
-     * @warning No exceder 200-250 nodos para evitar sobrecarga de memoria
-     * 
-     * @example
-     * ```cpp
-     * // Acceder a datos atmosféricos del nodo 0x42
-     * auto& nodeData = logic.AtmosphericSampleNodes[0x42];
-     * AtmosphericSample sample = nodeData[0]; // Primera muestra
-     * ```
+     * @brief Guarda un paquete en la cola persistente
+     */
+    void queueOutbox(uint8_t type, uint8_t nodeId, const void *data, uint8_t len);
+
+    /**
+     * @brief Publica una tanda de la cola persistente si hay conexión MQTT
+     * @details Hasta OUTBOX_DRAIN_BATCH registros cada OUTBOX_DRAIN_INTERVAL_MS,
+     * para que vaciar una cola larga no demore update().
+     */
+    void drainOutbox();
+
+    /**
+     * @brief Publica linkStats en MQTT_TOPIC_LINKS cada LINK_STATS_PUBLISH_INTERVAL_MS
+     * @details Un solo mensaje con una fila por nodo registrado. Se escribe por
+     * partes (beginPublish/write) porque con muchos nodos supera MQTT_BUFFER_SIZE.
+     * Sin conexión no se encola: la próxima publicación trae datos más nuevos.
      */
-    std::map<std::uint8_t, std::array<Protocol::AtmosphericSample, NUMERO_MUESTRAS_ATMOSFERICAS>> AtmosphericSampleNodes;
+    void publishLinkStats();
 
     /**
-     * @brief Lista de nodos inactivos o con fallos
-     * @details Array que almacena IDs de nodos que no responden
-     * @note Se llena cuando se alcanza connectionRetries sin respuesta
-     * @see connectionRetries
+     * @brief Descubre en un momento ocioso la ruta de un nodo registrado que no tiene
+     * @see RadioManager::discoverRoute()
      */
-    uint8_t nodesDown[MAX_NODES];
+    void warmUpRoutes();
 
+    /**
+     * @brief Publica en MQTT_TOPIC_GATEWAY el tiempo en el aire del ciclo que termina
+     * @details Se llama al comenzar cada ciclo atmosférico. Sin conexión no se encola.
+     * @see RadioManager::getDutyCycle()
+     */
+    void publishGatewayMetrics();
+
+public:
     /**
      * @brief Constructor de AppLogic
      * @param identity Gestor de identidad del nodo
@@ -263,7 +516,7 @@ public:
      * AppLogic logic(identity, radio, rtc);
      * ```
      */
-    AppLogic(NodeIdentity identity, RadioManager radioMgr, RtcManager& rtcMgr);
+    AppLogic(NodeIdentity identity, RadioManager& radioMgr, RtcManager& rtcMgr);
 
     /**
      * @brief Inicializa la lógica de aplicación
@@ -295,6 +548,37 @@ public:
      * @see https://www.arduino.cc/reference/en/language/functions/time/delay/
      */
     void update();
+
+    /**
+     * @brief Sondeo atmosférico en curso o último terminado
+     * @return Referencia de solo lectura con el estado y las métricas del ciclo
+     */
+    const PollEngine &getAtmosphericPoll() const;
+
+    /**
+     * @brief Cola persistente de publicaciones pendientes
+     */
+    const OutboxQueue &getOutbox() const;
+
+    /**
+     * @brief Estado de la conexión WiFi/MQTT
+     */
+    const UplinkManager &getUplink() const;
+
+    /**
+     * @brief Estado ADR de los enlaces
+     */
+    const LinkAdr &getLinkAdr() const;
+
+    /**
+     * @brief Estadísticas de calidad de enlace por nodo
+     */
+    const LinkStats &getLinkStats() const;
+
+    /**
+     * @brief Lotes duplicados, perdidos y reinicios de nodos
+     */
+    const SequenceTracker &getBatchSequence() const;
 };
 
 #endif // APP_LOGIC_H
@@ -0,0 +1,200 @@
+/**
+ * @file atmos_codec.cpp
+ * @brief Implementación de la codificación delta + varint de muestras atmosféricas
+ */
+
+#include "atmos_codec.h"
+
+namespace {
+    const uint16_t MINUTES_PER_DAY = 1440;
+
+    /**
+     * @brief Hora de la muestra como número para restar
+     * @details Las horas válidas son minutos del día [0, 1440); las inválidas
+     * (p. ej. 255:255 por error de RTC) van después, sin perder información.
+     */
+    uint32_t timeKey(const Protocol::AtmosphericSample &s)
+    {
+        if (s.hour < 24 && s.minute < 60) {
+            return (uint32_t)s.hour * 60 + s.minute;
+        }
+        return MINUTES_PER_DAY + ((uint32_t)s.hour << 8 | s.minute);
+    }
+
+    bool setTime(Protocol::AtmosphericSample &s, uint32_t key)
+    {
+        if (key < MINUTES_PER_DAY) {
+            s.hour = (uint8_t)(key / 60);
+            s.minute = (uint8_t)(key % 60);
+            return true;
+        }
+        key -= MINUTES_PER_DAY;
+        if (key > 0xFFFF) {
+            return false;
+        }
+        s.hour = (uint8_t)(key >> 8);
+        s.minute = (uint8_t)key;
+        return true;
+    }
+
+    /** Escribe un varint (7 bits por byte, el bit alto indica que sigue otro). */
+    bool putVarint(uint32_t value, uint8_t *out, size_t capacity, size_t &pos)
+    {
+        do {
+            if (pos >= capacity) {
+                return false;
+            }
+            uint8_t b = value & 0x7F;
+            value >>= 7;
+            out[pos++] = value ? (b | 0x80) : b;
+        } while (value);
+        return true;
+    }
+
+    bool getVarint(const uint8_t *in, size_t len, size_t &pos, uint32_t &value)
+    {
+        value = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7) {
+            if (pos >= len) {
+                return false;
+            }
+            uint8_t b = in[pos++];
+            value |= (uint32_t)(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Zigzag: 0, -1, 1, -2... -> 0, 1, 2, 3... para que los deltas chicos ocupen un byte. */
+    bool putSigned(int32_t value, uint8_t *out, size_t capacity, size_t &pos)
+    {
+        return putVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31), out, capacity, pos);
+    }
+
+    bool getSigned(const uint8_t *in, size_t len, size_t &pos, int32_t &value)
+    {
+        uint32_t raw;
+        if (!getVarint(in, len, pos, raw)) {
+            return false;
+        }
+        value = (int32_t)(raw >> 1) ^ -(int32_t)(raw & 1);
+        return true;
+    }
+
+    /** Muestra i de un lote partido en dos tramos (p. ej. los de un buffer circular). */
+    const Protocol::AtmosphericSample &sampleAt(const Protocol::AtmosphericSample *first, uint8_t firstCount,
+                                                const Protocol::AtmosphericSample *second, uint8_t i)
+    {
+        return i < firstCount ? first[i] : second[i - firstCount];
+    }
+
+    /** Hora de la muestra i según el período, como la reconstruye decode(). */
+    uint32_t periodKey(uint32_t firstKey, uint8_t i, uint16_t periodSec)
+    {
+        return (firstKey + (uint32_t)i * periodSec / 60) % MINUTES_PER_DAY;
+    }
+}
+
+size_t AtmosCodec::encode(const Protocol::AtmosphericSample *samples, uint8_t count, uint16_t periodSec,
+                          uint8_t *out, size_t capacity)
+{
+    return encode(samples, count, nullptr, 0, periodSec, out, capacity);
+}
+
+size_t AtmosCodec::encode(const Protocol::AtmosphericSample *first, uint8_t firstCount,
+                          const Protocol::AtmosphericSample *second, uint8_t secondCount, uint16_t periodSec,
+                          uint8_t *out, size_t capacity)
+{
+    if (firstCount + secondCount == 0 || firstCount + secondCount > 255) {
+        return 0;
+    }
+    uint8_t count = (uint8_t)(firstCount + secondCount);
+    const Protocol::AtmosphericSample &head = sampleAt(first, firstCount, second, 0);
+
+    // El período solo sirve si reproduce exactamente la hora de cada muestra
+    bool periodic = timeKey(head) < MINUTES_PER_DAY;
+    for (uint8_t i = 1; i < count && periodic; i++) {
+        periodic = timeKey(sampleAt(first, firstCount, second, i)) == periodKey(timeKey(head), i, periodSec);
+    }
+
+    size_t limit = (size_t)count * sizeof(Protocol::AtmosphericSample) - 1;
+    if (capacity > limit) {
+        capacity = limit;
+    }
+    size_t pos = 0;
+    if (capacity < 2 + sizeof(Protocol::AtmosphericSample)) {
+        return 0;
+    }
+    out[pos++] = periodic ? FORMAT_PERIOD : FORMAT_EXPLICIT;
+    out[pos++] = count;
+    if (periodic && !putVarint(periodSec, out, capacity, pos)) {
+        return 0;
+    }
+    if (pos + sizeof(Protocol::AtmosphericSample) > capacity) {
+        return 0;
+    }
+    memcpy(out + pos, &head, sizeof(Protocol::AtmosphericSample));
+    pos += sizeof(Protocol::AtmosphericSample);
+
+    for (uint8_t i = 1; i < count; i++) {
+        const Protocol::AtmosphericSample &prev = sampleAt(first, firstCount, second, i - 1);
+        const Protocol::AtmosphericSample &cur = sampleAt(first, firstCount, second, i);
+        if (!putSigned((int32_t)cur.temp - prev.temp, out, capacity, pos) ||
+            !putSigned((int32_t)cur.moisture - prev.moisture, out, capacity, pos)) {
+            return 0;
+        }
+        if (!periodic && !putSigned((int32_t)(timeKey(cur) - timeKey(prev)), out, capacity, pos)) {
+            return 0;
+        }
+    }
+    return pos;
+}
+
+bool AtmosCodec::decode(const uint8_t *in, size_t len, Protocol::AtmosphericSample *samples, uint8_t capacity,
+                        uint8_t &count)
+{
+    if (len < 2 || (in[0] != FORMAT_PERIOD && in[0] != FORMAT_EXPLICIT)) {
+        return false;
+    }
+    bool periodic = in[0] == FORMAT_PERIOD;
+    count = in[1];
+    if (count == 0 || count > capacity) {
+        return false;
+    }
+    size_t pos = 2;
+    uint32_t periodSec = 0;
+    if (periodic && (!getVarint(in, len, pos, periodSec) || periodSec > 0xFFFF)) {
+        return false;
+    }
+    if (pos + sizeof(Protocol::AtmosphericSample) > len) {
+        return false;
+    }
+    memcpy(&samples[0], in + pos, sizeof(Protocol::AtmosphericSample));
+    pos += sizeof(Protocol::AtmosphericSample);
+
+    uint32_t firstKey = timeKey(samples[0]);
+    if (periodic && firstKey >= MINUTES_PER_DAY) {
+        return false;
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        Protocol::AtmosphericSample &cur = samples[i];
+        const Protocol::AtmosphericSample &prev = samples[i - 1];
+        int32_t dTemp, dMoisture;
+        if (!getSigned(in, len, pos, dTemp) || !getSigned(in, len, pos, dMoisture)) {
+            return false;
+        }
+        cur.temp = (int16_t)(prev.temp + dTemp);
+        cur.moisture = (uint16_t)(prev.moisture + dMoisture);
+        if (periodic) {
+            setTime(cur, periodKey(firstKey, i, (uint16_t)periodSec));
+        } else {
+            int32_t dTime;
+            if (!getSigned(in, len, pos, dTime) || !setTime(cur, timeKey(prev) + (uint32_t)dTime)) {
+                return false;
+            }
+        }
+    }
+    return pos == len;
+}
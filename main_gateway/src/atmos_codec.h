@@ -0,0 +1,74 @@
+/**
+ * @file atmos_codec.h
+ * @brief Codificación compacta (delta + varint) de un lote de AtmosphericSample
+ * @date 2025
+ *
+ * El lote crudo son NUMERO_MUESTRAS_ATMOSFERICAS * 6 bytes (48). Temperatura
+ * y humedad cambian poco entre muestras y la hora avanza de a un período fijo,
+ * así que se envía:
+ *
+ *   [formato][cantidad][período s, varint]   (período solo en FORMAT_PERIOD)
+ *   [primera muestra cruda, 6 bytes]
+ *   por cada muestra siguiente:
+ *     zigzag-varint(Δtemp) zigzag-varint(Δhumedad) [zigzag-varint(Δhora)]
+ *
+ * - FORMAT_PERIOD: la hora de la muestra i es la de la primera más i * período
+ *   (redondeado a minutos). Solo se usa si reconstruye exactamente todas.
+ * - FORMAT_EXPLICIT: cada muestra lleva el delta de su hora en minutos del
+ *   día; cubre reinicios del RTC y horas de error (SENSOR_ERROR_TIME_COMPONENT).
+ *
+ * La decodificación es exacta en ambos formatos. Si el resultado no es más
+ * corto que el lote crudo, encode() devuelve 0 y se envía el lote crudo; el
+ * receptor los distingue por largo (el crudo mide exactamente 48 bytes).
+ *
+ * El mismo archivo existe en el gateway y en el nodo, como protocol.h.
+ */
+
+#ifndef ATMOS_CODEC_H
+#define ATMOS_CODEC_H
+
+#include <Arduino.h>
+#include "protocol.h"
+
+namespace AtmosCodec {
+
+    const uint8_t FORMAT_PERIOD = 0xA0;    ///< Horas implícitas por período fijo
+    const uint8_t FORMAT_EXPLICIT = 0xA1;  ///< Delta de hora en cada muestra
+
+    /**
+     * @brief Codifica un lote de muestras
+     * @param samples Muestras en orden de toma
+     * @param count Cantidad de muestras (1-255)
+     * @param periodSec Período de muestreo en segundos
+     * @param out Buffer de salida
+     * @param capacity Bytes disponibles en out
+     * @return Bytes escritos, o 0 si no entra en out o no es más corto que el lote crudo
+     */
+    size_t encode(const Protocol::AtmosphericSample *samples, uint8_t count, uint16_t periodSec,
+                  uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Codifica un lote partido en dos tramos contiguos, sin juntarlos antes
+     * @details Igual que encode(samples, ...) con second a continuación de
+     * first: el lote de un buffer circular que cruza el fin del arreglo.
+     * @param second Puede ser nullptr si secondCount es 0
+     */
+    size_t encode(const Protocol::AtmosphericSample *first, uint8_t firstCount,
+                  const Protocol::AtmosphericSample *second, uint8_t secondCount, uint16_t periodSec,
+                  uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Decodifica un lote generado por encode()
+     * @param in Trama recibida
+     * @param len Largo de la trama
+     * @param samples Destino de las muestras
+     * @param capacity Muestras que entran en samples
+     * @param count Cantidad de muestras decodificadas
+     * @return false si la trama está truncada, tiene bytes de más o no entra en samples
+     */
+    bool decode(const uint8_t *in, size_t len, Protocol::AtmosphericSample *samples, uint8_t capacity,
+                uint8_t &count);
+
+} // namespace AtmosCodec
+
+#endif // ATMOS_CODEC_H
@@ -5,7 +5,6 @@
 
 #define DEBUG_PRINT(x) Serial.printf("%s", x)
 #define DEBUG_PRINTLN(x) Serial.printf("%s\n", x)
-#define MAX_NODES 250
 #define NUMERO_MUESTRAS_ATMOSFERICAS 8
 
 #define CANTIDAD_MUESTRAS_SUELO 8
@@ -22,7 +21,6 @@
 
 #define DEBUG_PRINT(x)
 #define DEBUG_PRINTLN(x)
-#define MAX_NODES 250
 #define NUMERO_MUESTRAS_ATMOSFERICAS 8
 
 #define CANTIDAD_MUESTRAS_SUELO 2
@@ -38,6 +36,19 @@
 
 #endif
 
+/**
+ * @def MAX_NODES
+ * @brief Nodos registrados como máximo (1 a 254); se cambia con -D MAX_NODES=N en platformio.ini.
+ * @details Dimensiona NodeTable y las tablas por nodo de LinkAdr, LinkStats,
+ * SequenceTracker y FrameAuth: cada nodo cuesta unos 157 bytes de RAM. Con
+ * 250 (el tope de los std::map anteriores) al ESP8266 le quedan unos 2,7 KB
+ * de heap libre, poco para WiFi y MQTT, así que la red se limita a 100 nodos.
+ * Un HELLO con la tabla llena no se registra y queda un LOG_W.
+ */
+#ifndef MAX_NODES
+#define MAX_NODES 100
+#endif
+
 // Configuración de delays para solicitudes de datos (más conservador en producción)
 //#define DELAY_BETWEEN_ATMOSPHERIC_REQUESTS 2000  /**< @brief Delay entre solicitudes atmosféricas en milisegundos (2 segundos) */
 //#define DELAY_BETWEEN_GROUND_REQUESTS 5000       /**< @brief Delay entre solicitudes de suelo/GPS en milisegundos (5 segundos) */
@@ -45,6 +56,65 @@
 #define DELAY_BEFORE_RETRY_ATMOSPHERIC 2000        /**< @brief Delay antes de reintentar solicitudes atmosféricas (500ms) */
 #define DELAY_BEFORE_RETRY_GROUND 10000           /**< @brief Delay antes de reintentar solicitudes de suelo/GPS (1.5 segundos) */
 
+// Configuración del sondeo no bloqueante (PollEngine)
+#define POLL_MAX_IN_FLIGHT 4      /**< @brief Solicitudes atmosféricas en vuelo simultáneas */
+#define POLL_REPLY_TIMEOUT (DELAY_BEFORE_RETRY_ATMOSPHERIC + TIMEOUTGRAL) /**< @brief Espera máxima de respuesta por intento en milisegundos */
+#define POLL_MAX_RETRIES 2        /**< @brief Reintentos por nodo antes de darlo por caído en el ciclo */
+#define GROUND_POLL_REPLY_TIMEOUT (DELAY_BEFORE_RETRY_GROUND + TIMEOUTGRAL) /**< @brief Espera de la respuesta de suelo/GPS por intento (el nodo lee el RS485) */
+#define GROUND_CACHED_REPLY_TIMEOUT POLL_REPLY_TIMEOUT /**< @brief Espera por intento a un nodo con CAP_GROUND_CACHE: responde de su última lectura, como el pedido atmosférico */
+
+// Recepción: cola de tramas entre la radio y el despacho (RxQueue)
+#define RX_QUEUE_DEPTH 4             /**< @brief Tramas recibidas en espera de despacho */
+#define RX_QUEUE_FRAME_LEN 64        /**< @brief Payload máximo por trama en cola, con el sello de FrameAuth; uno más largo se trunca y lo rechaza su handler */
+
+// Envío atmosférico por slots (TDMA): el ANNOUNCE lleva el calendario y los nodos envían sin pedido
+#define ATMOSPHERIC_SLOTTED_MODE 1   /**< @brief 1: ANNOUNCE con slots cada INTERVALOATMOSPHERIC; 0: sondeo nodo por nodo */
+#define SLOT_DURATION_MS 350         /**< @brief Duración de un slot: DATA_ATMOSPHERIC + ACK (~140 ms) y BATCH_ACK + ACK (~90 ms) a SF7, más margen de reloj */
+#define SLOT_FIRST_OFFSET_MS 500     /**< @brief Espera entre el ANNOUNCE y el slot 0 en milisegundos */
+#define SLOT_GUARD_MS 2000           /**< @brief Margen tras el último slot antes de sondear a los nodos que no enviaron */
+#define ATMOSPHERIC_BROADCAST_POLL 1 /**< @brief Con ATMOSPHERIC_SLOTTED_MODE 0: 1 = el ciclo abre con un pedido broadcast (Protocol::PollWindow) y solo se sondea a los que faltan */
+
+// DATA_ATMOSPHERIC comprimido (AtmosCodec)
+#define ATMOS_PACKED_ENCODING 1      /**< @brief 1: anunciar Protocol::FEATURE_PACKED_ATMOSPHERIC y aceptar lotes comprimidos */
+
+// Números de lote (Protocol::BatchHeader, SequenceTracker)
+#define BATCH_SEQUENCE_ENABLED 1     /**< @brief 1: anunciar Protocol::FEATURE_BATCH_SEQUENCE y descartar lotes duplicados */
+#define BATCH_ACK_ENABLED 1          /**< @brief Con BATCH_SEQUENCE_ENABLED: 1 = anunciar Protocol::FEATURE_BATCH_ACK y confirmar cada DATA_ATMOSPHERIC numerado con BATCH_ACK */
+
+// Suelo/GPS leído de antemano por el nodo (Protocol::CAP_GROUND_CACHE)
+#define GROUND_CACHE_ENABLED 1       /**< @brief 1: pedido con Protocol::GroundRequest, anunciar FEATURE_GROUND_AGE y esperar GROUND_CACHED_REPLY_TIMEOUT a los nodos con caché */
+
+// Tramas selladas con ChaCha20-Poly1305 (FrameAuth); toda la red debe tener el mismo valor y la misma clave
+#define AUTH_ENABLED 1               /**< @brief 1: sellar todo lo que se envía y descartar lo que no abre; 0: tramas en claro */
+#define AUTH_COUNTER_BLOCK 1024      /**< @brief Contadores reservados por escritura de /auth_counter.bin (un reinicio salta el resto) */
+#define AUTH_MAX_PEERS (MAX_NODES + 8) /**< @brief Remitentes con sesión en FrameAuth (sal y último contador, 16 B c/u); margen para nodos sin registrar */
+/** @brief Clave de red de 32 bytes (FrameAuth::KEY_LEN); cambiarla en cada instalación, igual en nodos y gateway */
+#define AUTH_NETWORK_KEY { \
+    0x3a, 0x91, 0x5c, 0x07, 0xe2, 0x48, 0xbd, 0x16, 0x6f, 0xd3, 0x20, 0x8e, 0x54, 0xc9, 0x7b, 0x02, \
+    0xa5, 0x1e, 0x63, 0xf8, 0x39, 0xd0, 0x4c, 0xb7, 0x12, 0x86, 0xeb, 0x5f, 0x70, 0x2d, 0x94, 0xc1 }
+
+// ADR: perfil de radio y potencia por enlace (LinkAdr)
+#define ADR_ENABLED 1                /**< @brief 1: ajustar SF/BW/potencia de cada vecino directo según su SNR */
+#define ADR_MARGIN_DB 5              /**< @brief Margen de SNR sobre el mínimo de demodulación del perfil */
+#define ADR_MIN_SAMPLES 3            /**< @brief Tramas medidas desde el último cambio antes de reevaluar el enlace */
+#define ADR_MAX_FAILURES 2           /**< @brief Respuestas perdidas seguidas en el perfil del enlace antes de volver al default */
+#define ADR_EXCHANGE_TIMEOUT_MS 3500 /**< @brief Espera de la respuesta en el perfil del enlace (48 bytes a SF12 ~2.3 s); menor que POLL_REPLY_TIMEOUT */
+#define ADR_TX_POWER_MIN 2           /**< @brief Potencia mínima que el ADR ordena en dBm */
+#define ADR_TX_POWER_MAX 20          /**< @brief Potencia máxima que el ADR ordena en dBm (PA_BOOST) */
+#define RADIO_TX_POWER 13            /**< @brief Potencia del tráfico de control en dBm (default de RH_RF95) */
+
+// Rutas mesh: próximos saltos persistidos (RouteCache) y descubrimiento en momentos ociosos
+#define ROUTE_CACHE_SAVE_INTERVAL_MS 600000 /**< @brief Pausa mínima entre escrituras de /routes.bin (desgaste de flash) */
+#define ROUTE_WARMUP_ENABLED 1              /**< @brief 1: descubrir fuera del sondeo la ruta de los nodos registrados que no tienen */
+#define ROUTE_WARMUP_INTERVAL_MS 5000       /**< @brief Pausa mínima entre dos descubrimientos de calentamiento */
+#define ROUTE_WARMUP_JITTER_MS 5000         /**< @brief Espera aleatoria sumada a la pausa para no coincidir con inundaciones de otros */
+
+// Tiempo en el aire y ciclo de trabajo (DutyCycle)
+#define RADIO_FREQUENCY_KHZ 434000UL   /**< @brief Frecuencia de la radio en kHz (la de init() de RH_RF95; debe coincidir con los nodos) */
+#define DUTY_CYCLE_ENFORCE 1           /**< @brief 1: no transmitir sin presupuesto en la sub-banda; 0: solo contabilizar */
+#define DUTY_CYCLE_WINDOW_MS 3600000UL /**< @brief Ventana móvil del ciclo de trabajo (ETSI EN 300 220: una hora) */
+#define DUTY_CYCLE_BUCKETS 60          /**< @brief Tramos de la ventana (60 = resolución de un minuto) */
+
 
 
 // lora
@@ -98,3 +168,34 @@
 #define MQTT_CLIENT_ID "esp8266_gateway"
 #define MQTT_TOPIC_ATMOSPHERIC "sensor/atmospheric"
 #define MQTT_TOPIC_GROUND "sensor/ground"
+#define MQTT_TOPIC_LINKS "sensor/links"  /**< @brief Tabla de calidad de enlace por nodo (LinkStats) */
+#define LINK_STATS_PUBLISH_INTERVAL_MS 300000 /**< @brief Período de publicación de LinkStats en milisegundos */
+#define MQTT_TOPIC_GATEWAY "sensor/gateway" /**< @brief Métricas del gateway por ciclo atmosférico (tiempo en el aire) */
+#define MQTT_GATEWAY_PAYLOAD_SIZE 256 /**< @brief Buffer en pila del JSON de métricas del gateway */
+#define MQTT_BUFFER_SIZE 1024      /**< @brief Buffer de PubSubClient (setBufferSize); un nodo atmosférico ocupa hasta 458 bytes de JSON */
+#define MQTT_ATMOS_BATCH_NODES 2   /**< @brief Nodos atmosféricos por publicación (1 = una publicación por nodo) */
+#define MQTT_GROUND_PAYLOAD_SIZE 192 /**< @brief Buffer en pila del JSON de suelo/GPS (máximo ~175 bytes) */
+
+// Cola persistente (LittleFS) de lecturas que no se pudieron publicar
+#define OUTBOX_CAPACITY 256          /**< @brief Registros en /outbox.bin (56 bytes c/u, 14 KB de flash) */
+#define OUTBOX_DRAIN_BATCH 4         /**< @brief Registros publicados por tanda al reconectar */
+#define OUTBOX_DRAIN_INTERVAL_MS 250 /**< @brief Pausa entre tandas para no demorar la atención de la radio */
+
+// Conexión WiFi/MQTT no bloqueante (UplinkManager)
+#define UPLINK_WIFI_CONNECT_TIMEOUT_MS 15000 /**< @brief Espera máxima del evento GotIP tras WiFi.begin() */
+#define UPLINK_BACKOFF_MIN_MS 1000           /**< @brief Espera del primer reintento (se duplica en cada fallo) */
+#define UPLINK_BACKOFF_MAX_MS 60000          /**< @brief Tope de la espera entre reintentos */
+#define UPLINK_SOCKET_TIMEOUT_MS 2000        /**< @brief Tope de la conexión TCP y del CONNACK en mqtt.connect() */
+
+// Registro por niveles (logger.h): LOG_LEVEL_NONE, _ERROR, _WARN, _INFO o _DEBUG
+#ifndef LOG_LEVEL
+#ifdef DEBUG_MODE
+#define LOG_LEVEL LOG_LEVEL_DEBUG   /**< @brief Nivel máximo compilado; los mensajes por encima no llegan al binario */
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO    /**< @brief Nivel máximo compilado; los mensajes por encima no llegan al binario */
+#endif
+#endif
+#ifndef LOG_SERIAL_LEVEL
+#define LOG_SERIAL_LEVEL LOG_LEVEL_WARN /**< @brief Nivel máximo que además se imprime en el momento por Serial */
+#endif
+#define LOG_RING_ENTRIES 64         /**< @brief Mensajes guardados en RAM (32 bytes c/u); 'l' por consola los vuelca */
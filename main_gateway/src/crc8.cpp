@@ -0,0 +1,18 @@
+/**
+ * @file crc8.cpp
+ * @brief Implementación del CRC-8 compartido
+ */
+
+#include "crc8.h"
+
+uint8_t Crc8::compute(const void *data, size_t len, uint8_t crc)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++) {
+        crc ^= bytes[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file crc8.h
+ * @brief CRC-8 (polinomio 0x07) compartido por los archivos en flash y el ID de nodo
+ * @date 2025
+ *
+ * RouteCache y OutboxQueue validan lo que leen de LittleFS con el valor
+ * inicial 0xFF (un bloque borrado, todo ceros, no da un CRC válido);
+ * NodeIdentity calcula el ID del nodo con valor inicial 0x00, igual que el nodo.
+ */
+
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <Arduino.h>
+
+namespace Crc8 {
+
+    const uint8_t INIT = 0xFF;  ///< Valor inicial de los archivos en flash
+
+    /**
+     * @brief CRC-8 de un buffer
+     * @param data Bytes de entrada
+     * @param len Cantidad de bytes
+     * @param crc Valor inicial, o el resultado de un tramo anterior para continuarlo
+     * @return CRC-8 acumulado
+     *
+     * @example
+     * ```cpp
+     * uint8_t crc = Crc8::compute(nextHops, sizeof(nextHops));
+     * ```
+     */
+    uint8_t compute(const void *data, size_t len, uint8_t crc = INIT);
+
+} // namespace Crc8
+
+#endif // CRC8_H
@@ -0,0 +1,129 @@
+/**
+ * @file duty_cycle.cpp
+ * @brief Implementación del cálculo de tiempo en el aire y del presupuesto de ciclo de trabajo
+ */
+
+#include "duty_cycle.h"
+#include "logger.h"
+
+static_assert(DUTY_CYCLE_WINDOW_MS / DUTY_CYCLE_BUCKETS <= 0xFFFF, "un tramo de DutyCycle debe entrar en uint16_t");
+static_assert(DUTY_CYCLE_BUCKETS <= 255, "DUTY_CYCLE_BUCKETS debe entrar en uint8_t");
+
+namespace {
+    /** Sub-bandas de ERC/REC 70-03 anexo 1 (dispositivos de corto alcance sin LBT/AFA). */
+    const DutyCycle::SubBand SUB_BANDS[] = {
+        {433050, 434790, 100},  // h1.4: 10%
+        {863000, 865000, 1},    // h1.3: 0.1%
+        {865000, 868000, 10},   // h1.4: 1%
+        {868000, 868600, 10},   // h1.5: 1%
+        {868700, 869200, 1},    // h1.6: 0.1%
+        {869400, 869650, 100},  // h1.7: 10%
+        {869700, 870000, 10},   // h1.9: 1%
+    };
+    const DutyCycle::SubBand UNRESTRICTED = {0, 0xFFFFFFFFUL, 1000};
+
+    const uint8_t PREAMBLE_SYMBOLS = 8;  ///< Default de RH_RF95
+}
+
+const DutyCycle::SubBand &DutyCycle::subBandFor(uint32_t frequencyKhz)
+{
+    for (const SubBand &b : SUB_BANDS) {
+        if (frequencyKhz >= b.fromKhz && frequencyKhz <= b.toKhz) {
+            return b;
+        }
+    }
+    return UNRESTRICTED;
+}
+
+uint32_t DutyCycle::timeOnAirUs(uint8_t frameLen, uint8_t spreadingFactor, uint16_t bandwidthKhz)
+{
+    const int32_t sf = spreadingFactor;
+    const uint32_t symbolUs = ((uint32_t)1 << sf) * 1000UL / bandwidthKhz;
+    const int32_t lowDataRate = symbolUs > 16000 ? 1 : 0;
+    const int32_t numerator = 8 * (int32_t)frameLen - 4 * sf + 28 + 16;  // + 16 por el CRC
+    const int32_t divisor = 4 * (sf - 2 * lowDataRate);
+    const int32_t blocks = numerator > 0 ? (numerator + divisor - 1) / divisor : 0;
+    // Preámbulo + 4.25 símbolos de sincronismo + 8 símbolos fijos + bloques de CR 4/5
+    const uint32_t quarterSymbols = (PREAMBLE_SYMBOLS + 8) * 4 + 17 + (uint32_t)blocks * 5 * 4;
+    return quarterSymbols * symbolUs / 4;
+}
+
+DutyCycle::DutyCycle(uint32_t frequencyKhz)
+    : band(subBandFor(frequencyKhz)), head(0), headStart(0), windowMs(0), totalAirMs(0), pendingUs(0),
+      deniedCount(0), throttled(false)
+{
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void DutyCycle::record(uint32_t airtimeUs, unsigned long now)
+{
+    advance(now);
+    uint32_t us = airtimeUs + pendingUs;
+    uint32_t ms = us / 1000;
+    pendingUs = (uint16_t)(us % 1000);
+    uint32_t room = 0xFFFF - buckets[head];
+    uint16_t added = (uint16_t)(ms < room ? ms : room);
+    buckets[head] += added;
+    windowMs += added;
+    totalAirMs += ms;
+}
+
+bool DutyCycle::allows(uint32_t airtimeUs, unsigned long now)
+{
+    if (band.limitPermille >= 1000) {
+        return true;
+    }
+    bool ok = usedMs(now) + (airtimeUs + 999) / 1000 <= budgetMs();
+    if (!ok) {
+        deniedCount++;
+        if (!throttled) {
+            LOG_W("DutyCycle: presupuesto agotado (%lu de %lu ms en la ventana)", (unsigned long)windowMs,
+                  (unsigned long)budgetMs());
+        }
+    }
+    throttled = !ok;
+    return ok;
+}
+
+uint32_t DutyCycle::usedMs(unsigned long now)
+{
+    advance(now);
+    return windowMs;
+}
+
+uint32_t DutyCycle::budgetMs() const
+{
+    return (uint32_t)(DUTY_CYCLE_WINDOW_MS / 1000) * band.limitPermille;
+}
+
+uint32_t DutyCycle::totalMs() const
+{
+    return totalAirMs;
+}
+
+uint32_t DutyCycle::denied() const
+{
+    return deniedCount;
+}
+
+const DutyCycle::SubBand &DutyCycle::subBand() const
+{
+    return band;
+}
+
+void DutyCycle::advance(unsigned long now)
+{
+    if (now - headStart >= DUTY_CYCLE_WINDOW_MS) {
+        // Más de una ventana sin transmitir: todo venció
+        memset(buckets, 0, sizeof(buckets));
+        windowMs = 0;
+        headStart = now - (now - headStart) % BUCKET_MS;
+        return;
+    }
+    while (now - headStart >= BUCKET_MS) {
+        headStart += BUCKET_MS;
+        head = (uint8_t)((head + 1) % DUTY_CYCLE_BUCKETS);
+        windowMs -= buckets[head];
+        buckets[head] = 0;
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file duty_cycle.h
+ * @brief Tiempo en el aire de cada trama y presupuesto de ciclo de trabajo por sub-banda
+ * @date 2025
+ *
+ * RadioManager calcula con timeOnAirUs() cuánto ocupa el canal cada trama que
+ * transmite el gateway (datos, reintentos, ACK, pedidos de ruta) y lo anota en
+ * una ventana móvil de DUTY_CYCLE_WINDOW_MS dividida en DUTY_CYCLE_BUCKETS
+ * tramos. El límite es el de la sub-banda de RADIO_FREQUENCY_KHZ según
+ * ETSI EN 300 220 (ERC/REC 70-03); fuera de esas bandas no hay límite (p. ej.
+ * 915 MHz, donde rige el tiempo de permanencia por canal y no el ciclo de
+ * trabajo).
+ *
+ * Un tramo viejo sale entero de la ventana, así que el uso informado puede
+ * incluir hasta un tramo de más: el error es hacia el lado seguro.
+ */
+
+#ifndef DUTY_CYCLE_H
+#define DUTY_CYCLE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @class DutyCycle
+ * @brief Contabilidad de tiempo en el aire de una sub-banda.
+ *
+ * @example
+ * ```cpp
+ * DutyCycle duty(RADIO_FREQUENCY_KHZ);
+ * uint32_t us = DutyCycle::timeOnAirUs(len + cabeceras, 7, 125);
+ * if (duty.allows(us, millis())) {
+ *     transmitir();
+ *     duty.record(us, millis());
+ * }
+ * ```
+ */
+class DutyCycle
+{
+public:
+    /**
+     * @struct SubBand
+     * @brief Rango de frecuencias con un mismo límite de ciclo de trabajo.
+     */
+    struct SubBand {
+        uint32_t fromKhz;        ///< Inicio de la sub-banda
+        uint32_t toKhz;          ///< Fin de la sub-banda
+        uint16_t limitPermille;  ///< Ciclo de trabajo permitido en milésimas (1000 = sin límite)
+    };
+
+    /**
+     * @brief Sub-banda que contiene la frecuencia (sin límite si no está en la tabla)
+     */
+    static const SubBand &subBandFor(uint32_t frequencyKhz);
+
+    /**
+     * @brief Tiempo en el aire de una trama LoRa (Semtech AN1200.13)
+     * @details Header explícito, CRC, preámbulo de 8 símbolos, CR 4/5 y
+     * LowDataRateOptimize cuando el símbolo dura más de 16 ms, como configura RH_RF95.
+     * @param frameLen Bytes de la trama incluyendo las cabeceras de RadioHead
+     * @return Microsegundos
+     */
+    static uint32_t timeOnAirUs(uint8_t frameLen, uint8_t spreadingFactor, uint16_t bandwidthKhz);
+
+    explicit DutyCycle(uint32_t frequencyKhz);
+
+    /**
+     * @brief Anota una transmisión
+     */
+    void record(uint32_t airtimeUs, unsigned long now);
+
+    /**
+     * @brief Indica si una transmisión de airtimeUs entra en el presupuesto de la ventana
+     * @details Cuenta las negativas y avisa por log al agotarse el presupuesto.
+     */
+    bool allows(uint32_t airtimeUs, unsigned long now);
+
+    /**
+     * @brief Tiempo en el aire dentro de la ventana móvil, en ms
+     */
+    uint32_t usedMs(unsigned long now);
+
+    /**
+     * @brief Tiempo en el aire permitido por ventana, en ms
+     */
+    uint32_t budgetMs() const;
+
+    /**
+     * @brief Tiempo en el aire acumulado desde el arranque, en ms
+     */
+    uint32_t totalMs() const;
+
+    /**
+     * @brief Transmisiones rechazadas por falta de presupuesto desde el arranque
+     */
+    uint32_t denied() const;
+
+    const SubBand &subBand() const;
+
+private:
+    static const unsigned long BUCKET_MS = DUTY_CYCLE_WINDOW_MS / DUTY_CYCLE_BUCKETS;
+
+    const SubBand &band;
+    uint16_t buckets[DUTY_CYCLE_BUCKETS];  ///< ms en el aire por tramo
+    uint8_t head;                          ///< Tramo actual
+    unsigned long headStart;               ///< millis() de inicio del tramo actual
+    uint32_t windowMs;                     ///< Suma de buckets
+    uint32_t totalAirMs;
+    uint16_t pendingUs;                    ///< Fracción de ms todavía no anotada
+    uint32_t deniedCount;
+    bool throttled;                        ///< La última consulta fue rechazada
+
+    void advance(unsigned long now);
+};
+
+#endif // DUTY_CYCLE_H
@@ -0,0 +1,296 @@
+/**
+ * @file frame_auth.h
+ * @brief Autenticación y cifrado de tramas con ChaCha20-Poly1305 (RFC 8439)
+ * @date 2025
+ *
+ * Protocol::KEY es un byte constante: cualquiera que escuche una trama puede
+ * fabricar otras. Con AUTH_ENABLED cada payload del protocolo viaja sellado
+ * con una clave de red compartida (AUTH_NETWORK_KEY):
+ *
+ *   [payload cifrado][contador, 4 bytes LE][tag Poly1305 truncado, 4 bytes]
+ *
+ * - Nonce (12 bytes): [contador LE][remitente][sal, 7 bytes]. La sal es
+ *   del remitente y se elige al azar en cada arranque; el contador tampoco
+ *   se repite dentro de una sal: se reservan bloques de AUTH_COUNTER_BLOCK
+ *   valores en flash (/auth_counter.bin) y un reinicio salta al bloque
+ *   siguiente. Si el archivo falta el contador vuelve a 0, pero con otra
+ *   sal de 56 bits el nonce no se repite.
+ * - Datos asociados: [remitente, destino, Protocol::MessageType]. Una trama
+ *   no puede reenviarse a otro destino ni cambiar de tipo.
+ * - Sesión: por remitente se recuerda su sal y el último contador aceptado,
+ *   y solo se acepta uno mayor. Una trama de un remitente sin sesión no se
+ *   puede abrir (UNKNOWN). La tabla tiene AUTH_MAX_PEERS entradas (16 bytes
+ *   c/u); llena, se reemplaza primero una sin sesión y si no hay, en orden
+ *   circular. Vive en RAM.
+ * - Saludo (HELLO, ANNOUNCE): lleva además la sal, un desafío y un eco
+ *
+ *   [payload cifrado][sal 7][desafío 4][eco 4][contador 4][tag 4]
+ *
+ *   con desafío y eco en los datos asociados. Con la misma sal de la sesión
+ *   vale como cualquier trama. Una sal nueva (primer contacto o reinicio del
+ *   remitente) solo se acepta si el eco es el desafío que este receptor le
+ *   pidió con requestSession(); si no, STALE y se le pide uno. Un saludo
+ *   viejo repetido no trae el desafío vigente: no reabre una sesión pasada.
+ *
+ *   Nodo (sal N)              Gateway (sal G)
+ *   HELLO [N, c1, 0]     ->   sin sesión: STALE, desafío c2
+ *                        <-   saludo [G, c2, c1]   eco c1: sesión G
+ *   saludo [N, 0, c2]    ->   eco c2: sesión N
+ *
+ * 8 bytes más por trama (un bloque de símbolos de más a SF7), 23 en los
+ * saludos, y en el peor caso de 64 bytes, dos bloques ChaCha20 y cinco de Poly1305 por trama. Un
+ * tag de 32 bits deja 2^-32 de probabilidad por intento de falsificación,
+ * suficiente para una red LoRa donde cada intento cuesta tiempo en el aire.
+ *
+ * El mismo archivo existe en el gateway y en el nodo, como protocol.h.
+ */
+
+#ifndef FRAME_AUTH_H
+#define FRAME_AUTH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @class FrameAuth
+ * @brief Sella y abre payloads del protocolo; lleva la sal y el contador propios y la sesión de cada remitente.
+ *
+ * @example
+ * ```cpp
+ * FrameAuth auth(clave, AUTH_COUNTER_BLOCK);
+ * auth.begin();
+ * uint8_t frame[len + FrameAuth::OVERHEAD];
+ * memcpy(frame, data, len);
+ * uint8_t sealedLen = auth.seal(yo, to, flag, frame, len);
+ * // Del otro lado:
+ * if (auth.open(from, yo, flag, frame, len) != FrameAuth::OK) descartar();
+ * ```
+ */
+class FrameAuth
+{
+public:
+    static const uint8_t KEY_LEN = 32;      ///< Clave de ChaCha20
+    static const uint8_t NONCE_LEN = 12;    ///< Nonce de RFC 8439
+    static const uint8_t SALT_LEN = 7;      ///< Sal del remitente: los bytes del nonce después de su dirección
+    static const uint8_t COUNTER_LEN = 4;   ///< Contador del remitente en la trama
+    static const uint8_t CHALLENGE_LEN = 4; ///< Desafío y eco de un saludo
+    static const uint8_t TAG_LEN = 4;       ///< Bytes del tag Poly1305 que viajan
+    static const uint8_t OVERHEAD = COUNTER_LEN + TAG_LEN;
+    static const uint8_t GREETING_OVERHEAD = SALT_LEN + 2 * CHALLENGE_LEN + OVERHEAD;
+    static const uint16_t MAX_PEERS = AUTH_MAX_PEERS;  ///< Remitentes con sesión recordada
+
+    /**
+     * @enum Result
+     * @brief Resultado de open() y openGreeting().
+     */
+    enum Result : uint8_t {
+        OK,       ///< Auténtica y nueva: frame queda descifrado
+        SHORT,    ///< Más corta que el sello
+        FORGED,   ///< El tag no coincide (clave o sal distinta, trama alterada o sin sellar)
+        REPLAY,   ///< Contador no mayor que el último aceptado del remitente
+        UNKNOWN,  ///< El remitente no tiene sesión: no se conoce su sal
+        STALE     ///< Saludo auténtico con otra sal y sin el eco del desafío vigente
+    };
+
+    /**
+     * @struct Snapshot
+     * @brief Sal, contadores y sesión del gateway que un nodo guarda en RTC durante el deep sleep.
+     *
+     * Sin él cada despertar pasa por begin(): sal nueva, un saludo más con el
+     * gateway y el primer seal() reserva un bloque nuevo en flash.
+     */
+    struct Snapshot {
+        uint32_t txCounter;         ///< Próximo contador propio
+        uint32_t txReserved;        ///< Fin del bloque reservado en flash
+        uint8_t salt[SALT_LEN];     ///< Sal propia
+        uint8_t peer;               ///< Remitente cuya sesión se guarda (el gateway)
+        uint8_t peerSalt[SALT_LEN]; ///< Sal de peer
+        uint32_t peerSeen;          ///< Último contador aceptado de peer + 1 (0 = sin sesión)
+    };
+
+    /**
+     * @param key Clave de red de KEY_LEN bytes (se copia)
+     * @param counterBlock Contadores reservados por escritura en flash
+     */
+    FrameAuth(const uint8_t *key, uint32_t counterBlock);
+
+    /**
+     * @brief Elige la sal de este arranque y retoma el contador desde el fin del último bloque reservado en flash
+     * @details El primer seal() reserva el bloque siguiente. LittleFS debe
+     * poder montarse. Si el archivo falta o es inválido (el primer arranque,
+     * o flash borrada) el contador arranca en 0.
+     * @return false si no había un contador válido guardado
+     */
+    bool begin();
+
+    /**
+     * @brief Cifra frame en su lugar y le agrega contador y tag
+     * @param frame Payload; debe tener lugar para len + OVERHEAD bytes
+     * @return Largo sellado, o 0 si no se pudo reservar contador en flash
+     */
+    uint8_t seal(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t len);
+
+    /**
+     * @brief Como seal(), como saludo: agrega la sal, el desafío pendiente para to y echo
+     * @param frame Payload; debe tener lugar para len + GREETING_OVERHEAD bytes
+     * @param echo Desafío recibido de to que se devuelve (0 = ninguno)
+     */
+    uint8_t sealGreeting(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t len, uint32_t echo);
+
+    /**
+     * @brief Verifica una trama sellada con la sesión del remitente y la descifra en su lugar
+     * @param len Largo recibido; con OK pasa a ser el del payload
+     * @details Con UNKNOWN o FORGED se pide una sesión (requestSession()).
+     */
+    Result open(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t &len);
+
+    /**
+     * @brief Verifica un saludo y, si trae otra sal con el eco del desafío vigente, abre la sesión
+     * @param len Largo recibido; con OK pasa a ser el del payload
+     * @param challenge Desafío del remitente, para devolver con sealGreeting() (0 = no pidió)
+     * @details Con STALE se pide una sesión (requestSession()).
+     */
+    Result openGreeting(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t &len, uint32_t &challenge);
+
+    /**
+     * @brief Elige un desafío para peer si no tiene uno pendiente
+     * @details El próximo saludo a peer lo lleva; se descarta cuando vuelve como eco.
+     */
+    void requestSession(uint8_t peer);
+
+    /**
+     * @brief Hay sesión con peer (se conoce su sal)
+     */
+    bool hasSession(uint8_t peer) const;
+
+    /**
+     * @brief Próximo contador que usará seal()
+     */
+    uint32_t counter() const;
+
+    /**
+     * @brief Tramas rechazadas por tag inválido o cortas desde el arranque
+     */
+    uint32_t forged() const;
+
+    /**
+     * @brief Tramas rechazadas por repetidas desde el arranque
+     */
+    uint32_t replays() const;
+
+    /**
+     * @brief Tramas de remitentes sin sesión y saludos sin el eco vigente (UNKNOWN, STALE) desde el arranque
+     */
+    uint32_t stale() const;
+
+    /**
+     * @brief Remitentes que volvieron con otra sal desde el arranque
+     */
+    uint32_t resyncs() const;
+
+    /**
+     * @brief Sal, contadores propios y la sesión de peer
+     */
+    Snapshot snapshot(uint8_t peer) const;
+
+    /**
+     * @brief Retoma la sal y los contadores de snapshot() tras begin()
+     * @details Solo si el bloque reservado coincide con el de flash; si no, se
+     * sigue con lo que eligió begin().
+     * @return false si no se retomó
+     */
+    bool restore(const Snapshot &saved);
+
+    /**
+     * @brief Sella con una sal y un contador dados, sin reservarlo ni avanzarlo
+     * @details seal() sin estado: para quien lleva el contador por su cuenta.
+     * @return Largo sellado (len + OVERHEAD), o 0 si no entra en un uint8_t
+     */
+    static uint8_t sealFrame(const uint8_t *key, const uint8_t *salt, uint8_t from, uint8_t to, uint8_t type,
+                             uint32_t counter, uint8_t *frame, uint8_t len);
+
+    /**
+     * @brief Verifica y descifra con la sal del remitente, sin controlar repeticiones
+     * @param len Largo recibido; si el tag coincide pasa a ser el del payload
+     * @param counter Contador del remitente que traía la trama
+     * @return false si es más corta que OVERHEAD o el tag no coincide
+     */
+    static bool openFrame(const uint8_t *key, const uint8_t *salt, uint8_t from, uint8_t to, uint8_t type,
+                          uint8_t *frame, uint8_t &len, uint32_t &counter);
+
+    /**
+     * @brief sealFrame() de un saludo
+     * @return Largo sellado (len + GREETING_OVERHEAD), o 0 si no entra en un uint8_t
+     */
+    static uint8_t sealGreetingFrame(const uint8_t *key, const uint8_t *salt, uint8_t from, uint8_t to,
+                                     uint8_t type, uint32_t counter, uint32_t challenge, uint32_t echo,
+                                     uint8_t *frame, uint8_t len);
+
+    /**
+     * @brief openFrame() de un saludo: la sal viene en la trama
+     * @param salt Recibe la sal del remitente (SALT_LEN bytes)
+     * @return false si es más corta que GREETING_OVERHEAD o el tag no coincide
+     */
+    static bool openGreetingFrame(const uint8_t *key, uint8_t from, uint8_t to, uint8_t type, uint8_t *frame,
+                                  uint8_t &len, uint8_t *salt, uint32_t &counter, uint32_t &challenge,
+                                  uint32_t &echo);
+
+    /**
+     * @brief AEAD ChaCha20-Poly1305 de RFC 8439: cifra data en su lugar
+     * @param tag Tag completo de 16 bytes
+     */
+    static void encrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aadLen,
+                        uint8_t *data, size_t len, uint8_t *tag);
+
+    /**
+     * @brief Verifica los primeros tagLen bytes del tag y, si coinciden, descifra data en su lugar
+     */
+    static bool decrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aadLen,
+                        uint8_t *data, size_t len, const uint8_t *tag, uint8_t tagLen);
+
+private:
+    /** Sesión de un remitente. */
+    struct Peer {
+        uint8_t id;               ///< Dirección del remitente
+        uint8_t salt[SALT_LEN];   ///< Su sal
+        uint32_t seen;            ///< Último contador aceptado + 1 (0 = sin sesión)
+        uint32_t challenge;       ///< Desafío que se le pidió y todavía no devolvió (0 = ninguno)
+    };
+
+    uint8_t key[KEY_LEN];
+    uint8_t salt[SALT_LEN]; ///< Sal propia de este arranque
+    uint32_t blockSize;     ///< Contadores por reserva
+    uint32_t txCounter;     ///< Próximo contador propio
+    uint32_t txReserved;    ///< Primer contador no reservado en flash
+    Peer peers[MAX_PEERS];
+    uint16_t peerCount;     ///< Entradas en uso
+    uint16_t peerEvict;     ///< Entrada a reemplazar con la tabla llena
+    uint32_t forgedCount;
+    uint32_t replayCount;
+    uint32_t staleCount;
+    uint32_t resyncCount;
+
+    /**
+     * @brief Sesión de un remitente (nullptr si no hay entrada)
+     */
+    const Peer *findPeer(uint8_t from) const;
+    Peer *findPeer(uint8_t from);
+
+    /**
+     * @brief Entrada de un remitente, creándola sin sesión si no existe
+     */
+    Peer *addPeer(uint8_t from);
+
+    /**
+     * @brief Próximo contador propio, reservando un bloque en flash si hace falta
+     * @return false si no se pudo reservar
+     */
+    bool nextCounter(uint32_t &counter);
+
+    /**
+     * @brief Guarda en flash el fin de un nuevo bloque de contadores
+     */
+    bool reserve(uint32_t upTo);
+};
+
+#endif // FRAME_AUTH_H
@@ -0,0 +1,257 @@
+/**
+ * @file json_writer.cpp
+ * @brief Implementación del escritor JSON sin heap
+ */
+
+#include "json_writer.h"
+
+JsonWriter::JsonWriter(char *buffer, size_t size) : buf(buffer), size(size)
+{
+    reset();
+}
+
+void JsonWriter::reset()
+{
+    len = 0;
+    level = 0;
+    hasItems = 0;
+    good = size > 0;
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+}
+
+bool JsonWriter::fits(size_t n, uint8_t extraClosers) const
+{
+    // Lugar para el elemento, los cierres pendientes y el '\0'
+    return len + n + level + extraClosers + 1 <= size;
+}
+
+bool JsonWriter::key(const char *key, size_t valueLen, uint8_t extraClosers)
+{
+    bool comma = (hasItems & (1u << level)) != 0;
+    size_t keyLen = key ? strlen(key) : 0;
+    size_t need = (comma ? 1 : 0) + (key ? keyLen + 3 : 0) + valueLen;
+    if (!good || !fits(need, extraClosers)) {
+        good = false;
+        return false;
+    }
+    if (comma) {
+        buf[len++] = ',';
+    }
+    if (key) {
+        buf[len++] = '"';
+        raw(key, keyLen);
+        buf[len++] = '"';
+        buf[len++] = ':';
+    }
+    hasItems |= (uint16_t)(1u << level);
+    return true;
+}
+
+void JsonWriter::raw(const char *s, size_t n)
+{
+    memcpy(buf + len, s, n);
+    len += n;
+    buf[len] = '\0';
+}
+
+void JsonWriter::close(char c)
+{
+    if (level == 0) {
+        return;
+    }
+    // El cierre ya estaba reservado: entra aunque el escritor esté lleno
+    level--;
+    buf[len++] = c;
+    buf[len] = '\0';
+}
+
+JsonWriter &JsonWriter::beginObject(const char *k)
+{
+    if (level >= MAX_DEPTH) {
+        good = false;
+    }
+    if (key(k, 1, 1)) {
+        raw("{", 1);
+        level++;
+        hasItems &= (uint16_t)~(1u << level);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject()
+{
+    close('}');
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray(const char *k)
+{
+    if (level >= MAX_DEPTH) {
+        good = false;
+    }
+    if (key(k, 1, 1)) {
+        raw("[", 1);
+        level++;
+        hasItems &= (uint16_t)~(1u << level);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray()
+{
+    close(']');
+    return *this;
+}
+
+size_t JsonWriter::formatFixed(char *out, bool negative, uint32_t magnitude, uint8_t decimals)
+{
+    // Dígitos al revés; al menos decimals + 1 para escribir 0.05 y no .05
+    char digits[12];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0 || n <= decimals);
+
+    size_t o = 0;
+    if (negative) {
+        out[o++] = '-';
+    }
+    while (n > 0) {
+        out[o++] = digits[--n];
+        if (n == decimals && decimals > 0) {
+            out[o++] = '.';
+        }
+    }
+    return o;
+}
+
+JsonWriter &JsonWriter::value(const char *k, bool negative, uint32_t magnitude, uint8_t decimals)
+{
+    char text[24];
+    size_t n = formatFixed(text, negative, magnitude, decimals > 9 ? 9 : decimals);
+    if (key(k, n)) {
+        raw(text, n);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::fixed(const char *k, int32_t v, uint8_t decimals)
+{
+    // 0u - v evita el desborde de -INT32_MIN
+    return value(k, v < 0, v < 0 ? 0u - (uint32_t)v : (uint32_t)v, decimals);
+}
+
+JsonWriter &JsonWriter::number(const char *k, uint32_t v)
+{
+    return value(k, false, v, 0);
+}
+
+JsonWriter &JsonWriter::string(const char *k, const char *v)
+{
+    size_t n = strlen(v);
+    if (key(k, n + 2)) {
+        raw("\"", 1);
+        raw(v, n);
+        raw("\"", 1);
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::time(const char *k, uint8_t hour, uint8_t minute)
+{
+    char text[7] = {'"', (char)('0' + hour / 10 % 10), (char)('0' + hour % 10), ':',
+                    (char)('0' + minute / 10 % 10), (char)('0' + minute % 10), '"'};
+    if (key(k, sizeof(text))) {
+        raw(text, sizeof(text));
+    }
+    return *this;
+}
+
+JsonWriter &JsonWriter::fields(const void *record, const JsonField *table, uint8_t count)
+{
+    const uint8_t *base = static_cast<const uint8_t *>(record);
+    for (uint8_t i = 0; i < count && good; i++) {
+        const JsonField &f = table[i];
+        const uint8_t *p = base + f.offset;
+        // memcpy: los structs del protocolo son empaquetados y el ESP8266 no tolera accesos desalineados
+        switch (f.type) {
+            case JsonType::INT8: {
+                int8_t v;
+                memcpy(&v, p, sizeof(v));
+                fixed(f.name, v, f.decimals);
+                break;
+            }
+            case JsonType::UINT8:
+                value(f.name, false, *p, f.decimals);
+                break;
+            case JsonType::INT16: {
+                int16_t v;
+                memcpy(&v, p, sizeof(v));
+                fixed(f.name, v, f.decimals);
+                break;
+            }
+            case JsonType::UINT16: {
+                uint16_t v;
+                memcpy(&v, p, sizeof(v));
+                value(f.name, false, v, f.decimals);
+                break;
+            }
+            case JsonType::INT32: {
+                int32_t v;
+                memcpy(&v, p, sizeof(v));
+                fixed(f.name, v, f.decimals);
+                break;
+            }
+            case JsonType::UINT32: {
+                uint32_t v;
+                memcpy(&v, p, sizeof(v));
+                value(f.name, false, v, f.decimals);
+                break;
+            }
+            case JsonType::TIME_HM:
+                time(f.name, p[0], p[1]);
+                break;
+        }
+    }
+    return *this;
+}
+
+bool JsonWriter::ok() const
+{
+    return good;
+}
+
+size_t JsonWriter::length() const
+{
+    return len;
+}
+
+uint8_t JsonWriter::depth() const
+{
+    return level;
+}
+
+const char *JsonWriter::c_str() const
+{
+    return buf;
+}
+
+JsonWriter::Mark JsonWriter::mark() const
+{
+    Mark m = {len, level, hasItems, good};
+    return m;
+}
+
+void JsonWriter::rewind(const Mark &m)
+{
+    len = m.len;
+    level = m.depth;
+    hasItems = m.hasItems;
+    good = m.good;
+    if (size > 0) {
+        buf[len] = '\0';
+    }
+}
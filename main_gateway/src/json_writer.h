@@ -0,0 +1,178 @@
+/**
+ * @file json_writer.h
+ * @brief Escritor JSON sin heap sobre un buffer provisto por el llamador
+ * @date 2025
+ *
+ * Reemplaza la construcción de payloads MQTT con String. Los valores de los
+ * paquetes del protocolo ya son enteros en punto fijo (décimas, centésimas,
+ * grados * 10^7), así que se escriben como entero + parte decimal sin pasar
+ * por float. Las comas entre elementos se ponen solas.
+ *
+ * Los campos de un struct se describen con una tabla JsonField (nombre,
+ * offset, tipo, decimales) y fields() los escribe todos; las tablas de los
+ * paquetes del protocolo están en telemetry_schema.h.
+ *
+ * El escritor siempre deja lugar para cerrar los objetos y arreglos abiertos:
+ * si algo no entra, ok() pasa a false y el buffer queda con JSON truncado
+ * en el último elemento completo. mark()/rewind() permiten deshacer un
+ * elemento que no entró.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+/**
+ * @enum JsonType
+ * @brief Tipo del campo en el struct de origen.
+ */
+enum class JsonType : uint8_t {
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    TIME_HM  ///< Dos uint8_t consecutivos (hora, minuto) escritos como "HH:MM"
+};
+
+/**
+ * @struct JsonField
+ * @brief Descripción de un campo de un struct empaquetado.
+ */
+struct JsonField {
+    const char *name;  ///< Clave JSON
+    uint8_t offset;    ///< offsetof() del campo en el struct
+    JsonType type;     ///< Tipo del campo
+    uint8_t decimals;  ///< Decimales del punto fijo (1 = décimas, 7 = * 10^7)
+};
+
+/**
+ * @class JsonWriter
+ * @brief Escribe JSON compacto en un char[] con comas y cierres automáticos.
+ *
+ * @example
+ * ```cpp
+ * char buf[192];
+ * JsonWriter json(buf, sizeof(buf));
+ * json.beginObject().fixed("nodeId", 66)
+ *     .fields(&packet, Telemetry::GROUND_FIELDS, Telemetry::GROUND_FIELD_COUNT)
+ *     .endObject();
+ * if (json.ok()) mqttClient.publish(topic, (const uint8_t *)json.c_str(), json.length());
+ * ```
+ */
+class JsonWriter
+{
+public:
+    static const uint8_t MAX_DEPTH = 8;  ///< Niveles de anidamiento soportados
+
+    /**
+     * @struct Mark
+     * @brief Estado guardado para deshacer con rewind().
+     */
+    struct Mark {
+        size_t len;
+        uint8_t depth;
+        uint16_t hasItems;
+        bool good;
+    };
+
+    /**
+     * @brief Constructor
+     * @param buffer Buffer de salida (queda siempre terminado en '\0')
+     * @param size Tamaño del buffer en bytes
+     */
+    JsonWriter(char *buffer, size_t size);
+
+    /**
+     * @brief Vacía el buffer
+     */
+    void reset();
+
+    /**
+     * @brief Abre un objeto
+     * @param key Clave si está dentro de otro objeto; nullptr en un arreglo o en la raíz
+     */
+    JsonWriter &beginObject(const char *key = nullptr);
+    JsonWriter &endObject();
+
+    /**
+     * @brief Abre un arreglo
+     * @param key Clave si está dentro de un objeto; nullptr en un arreglo o en la raíz
+     */
+    JsonWriter &beginArray(const char *key = nullptr);
+    JsonWriter &endArray();
+
+    /**
+     * @brief Escribe un número en punto fijo
+     * @param key Clave (nullptr dentro de un arreglo)
+     * @param value Valor entero escalado
+     * @param decimals Decimales (hasta 9): fixed("t", -405, 1) escribe "t":-40.5
+     */
+    JsonWriter &fixed(const char *key, int32_t value, uint8_t decimals = 0);
+
+    /**
+     * @brief Escribe un entero sin signo de 32 bits
+     */
+    JsonWriter &number(const char *key, uint32_t value);
+
+    /**
+     * @brief Escribe una cadena (sin escapar: solo para texto propio)
+     */
+    JsonWriter &string(const char *key, const char *value);
+
+    /**
+     * @brief Escribe una hora como "HH:MM"
+     */
+    JsonWriter &time(const char *key, uint8_t hour, uint8_t minute);
+
+    /**
+     * @brief Escribe los campos de un struct según su tabla
+     * @param record Puntero al struct (puede estar desalineado)
+     * @param table Tabla de campos
+     * @param count Cantidad de campos de la tabla
+     */
+    JsonWriter &fields(const void *record, const JsonField *table, uint8_t count);
+
+    /**
+     * @brief false si algún elemento no entró en el buffer
+     */
+    bool ok() const;
+
+    /**
+     * @brief Bytes escritos (sin el '\0')
+     */
+    size_t length() const;
+
+    /**
+     * @brief Niveles abiertos
+     */
+    uint8_t depth() const;
+
+    const char *c_str() const;
+
+    Mark mark() const;
+
+    /**
+     * @brief Vuelve al estado de mark(), incluido ok()
+     */
+    void rewind(const Mark &m);
+
+private:
+    char *buf;
+    size_t size;
+    size_t len;
+    uint8_t level;     ///< Niveles abiertos
+    uint16_t hasItems; ///< Bit por nivel (0 = raíz): ya tiene elementos, el próximo lleva coma
+    bool good;
+
+    bool fits(size_t n, uint8_t extraClosers = 0) const;
+    bool key(const char *key, size_t valueLen, uint8_t extraClosers = 0);
+    void raw(const char *s, size_t n);
+    void close(char c);
+    JsonWriter &value(const char *key, bool negative, uint32_t magnitude, uint8_t decimals);
+    static size_t formatFixed(char *out, bool negative, uint32_t magnitude, uint8_t decimals);
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,168 @@
+/**
+ * @file link_adr.cpp
+ * @brief Implementación del ADR por enlace
+ */
+
+#include "link_adr.h"
+
+namespace {
+    const int16_t NO_SAMPLE = INT16_MIN;   ///< Enlace sin mediciones
+    const int16_t FALLBACK_PENALTY = 30;   ///< Décimas de dB que se descuentan al volver al default
+
+    /** SNR que se pierde por ancho de banda respecto de 125 kHz, en décimas de dB. */
+    int16_t bandwidthPenalty(uint8_t profile)
+    {
+        int16_t penalty = 0;
+        for (uint16_t bw = 125; bw < Protocol::RADIO_PROFILES[profile].bandwidthKhz; bw *= 2) {
+            penalty += 30;
+        }
+        return penalty;
+    }
+
+    /** Enlace de un ID sin registrar: perfil default, sin mediciones. */
+    const LinkAdr::Link UNREGISTERED = {NO_SAMPLE, 0, Protocol::RADIO_PROFILE_DEFAULT, RADIO_TX_POWER, 0, 0};
+}
+
+LinkAdr::LinkAdr(const NodeTable &table) : nodes(table)
+{
+    for (uint16_t slot = 0; slot < NodeTable::CAPACITY; slot++) {
+        links[slot] = UNREGISTERED;
+    }
+}
+
+LinkAdr::Link *LinkAdr::find(uint8_t id)
+{
+    uint8_t slot = nodes.slotOf(id);
+    return slot == NodeTable::NO_SLOT ? nullptr : &links[slot];
+}
+
+const LinkAdr::Link *LinkAdr::find(uint8_t id) const
+{
+    uint8_t slot = nodes.slotOf(id);
+    return slot == NodeTable::NO_SLOT ? nullptr : &links[slot];
+}
+
+void LinkAdr::reset(uint8_t id)
+{
+    Link *found = find(id);
+    if (found != nullptr) {
+        *found = UNREGISTERED;
+    }
+}
+
+void LinkAdr::onFrame(uint8_t id, uint8_t hops, int8_t snr, int16_t rssi, uint8_t profile, int8_t txPower)
+{
+    Link *found = find(id);
+    if (found == nullptr || hops != 0 || profile >= Protocol::RADIO_PROFILE_COUNT) {
+        return;
+    }
+    Link &l = *found;
+    // Lo que se habría medido en el perfil default con la potencia de control
+    int16_t powerDelta = (int16_t)(txPower - RADIO_TX_POWER);
+    int16_t normSnr = (int16_t)(snr * 10 - powerDelta * 10 + bandwidthPenalty(profile));
+    int16_t normRssi = (int16_t)(rssi - powerDelta);
+    if (l.snr == NO_SAMPLE) {
+        l.snr = normSnr;
+        l.rssi = normRssi;
+    } else {
+        l.snr += (normSnr - l.snr) / 4;
+        l.rssi += (normRssi - l.rssi) / 4;
+    }
+    if (l.samples < 255) {
+        l.samples++;
+    }
+}
+
+bool LinkAdr::evaluate(uint8_t id, uint8_t &profile, int8_t &txPower) const
+{
+    const Link &l = link(id);
+    if (l.snr == NO_SAMPLE || l.samples < ADR_MIN_SAMPLES) {
+        return false;
+    }
+
+    profile = 0;
+    txPower = ADR_TX_POWER_MAX;
+    for (int8_t p = Protocol::RADIO_PROFILE_COUNT - 1; p >= 0; p--) {
+        int16_t margin = l.snr + (ADR_TX_POWER_MAX - RADIO_TX_POWER) * 10 - bandwidthPenalty((uint8_t)p) -
+                         requiredSnr(Protocol::RADIO_PROFILES[p].spreadingFactor) - ADR_MARGIN_DB * 10;
+        if (margin >= 0) {
+            profile = (uint8_t)p;
+            int16_t power = ADR_TX_POWER_MAX - margin / 10;
+            txPower = (int8_t)(power < ADR_TX_POWER_MIN ? ADR_TX_POWER_MIN : power);
+            break;
+        }
+    }
+
+    // Diferencias de potencia menores a 3 dB son ruido de la medición
+    if (profile == l.profile) {
+        int8_t delta = (int8_t)(txPower - l.txPower);
+        return delta >= 3 || delta <= -3;
+    }
+    return true;
+}
+
+void LinkAdr::apply(uint8_t id, uint8_t profile, int8_t txPower)
+{
+    Link *found = find(id);
+    if (found == nullptr) {
+        return;
+    }
+    Link &l = *found;
+    l.profile = profile;
+    l.txPower = txPower;
+    l.samples = 0;
+    l.failures = 0;
+}
+
+void LinkAdr::onReplyOk(uint8_t id)
+{
+    Link *found = find(id);
+    if (found != nullptr) {
+        found->failures = 0;
+    }
+}
+
+bool LinkAdr::onReplyLost(uint8_t id)
+{
+    Link *found = find(id);
+    if (found == nullptr || !usesLinkProfile(id) || ++found->failures < ADR_MAX_FAILURES) {
+        return false;
+    }
+    Link &l = *found;
+    // El nodo también vuelve solo al default; la próxima elección es más conservadora
+    if (l.snr != NO_SAMPLE) {
+        l.snr -= FALLBACK_PENALTY;
+    }
+    l.profile = Protocol::RADIO_PROFILE_DEFAULT;
+    l.txPower = RADIO_TX_POWER;
+    l.samples = 0;
+    l.failures = 0;
+    return true;
+}
+
+uint8_t LinkAdr::profile(uint8_t id) const
+{
+    return link(id).profile;
+}
+
+int8_t LinkAdr::txPower(uint8_t id) const
+{
+    return link(id).txPower;
+}
+
+bool LinkAdr::usesLinkProfile(uint8_t id) const
+{
+    const Link &l = link(id);
+    return l.profile != Protocol::RADIO_PROFILE_DEFAULT || l.txPower != RADIO_TX_POWER;
+}
+
+const LinkAdr::Link &LinkAdr::link(uint8_t id) const
+{
+    const Link *found = find(id);
+    return found != nullptr ? *found : UNREGISTERED;
+}
+
+int16_t LinkAdr::requiredSnr(uint8_t spreadingFactor)
+{
+    return (int16_t)(-75 - (spreadingFactor - 7) * 25);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file link_adr.h
+ * @brief ADR por enlace: elige perfil de radio y potencia de cada vecino directo
+ * @date 2025
+ *
+ * El gateway mide SNR y RSSI de cada trama que recibe de un vecino directo
+ * (hops == 0; en las reenviadas la SNR es la del último salto) y mantiene un
+ * promedio normalizado a RADIO_PROFILE_DEFAULT con RADIO_TX_POWER. Con ese
+ * promedio elige:
+ *
+ * 1. El perfil más rápido de Protocol::RADIO_PROFILES que, a ADR_TX_POWER_MAX,
+ *    deja ADR_MARGIN_DB sobre la SNR mínima de demodulación de su SF. Duplicar
+ *    el ancho de banda cuesta 3 dB de SNR.
+ * 2. La menor potencia que mantiene ese margen en el perfil elegido.
+ *
+ * Si ningún perfil alcanza se usa el más robusto a potencia máxima. El cálculo
+ * es determinista sobre el promedio, así que un enlace estable converge en un
+ * solo cambio y no oscila; se reevalúa cada ADR_MIN_SAMPLES tramas.
+ *
+ * Si un enlace pierde ADR_MAX_FAILURES respuestas seguidas en su perfil vuelve
+ * al default; el nodo hace lo mismo de su lado al no recibir ACK.
+ */
+
+#ifndef LINK_ADR_H
+#define LINK_ADR_H
+
+#include <Arduino.h>
+#include "protocol.h"
+#include "node_table.h"
+#include "config.h"
+
+/**
+ * @class LinkAdr
+ * @brief Estado ADR de los nodos registrados (8 bytes por slot de NodeTable).
+ *
+ * Un ID sin registrar no tiene entrada: sus tramas no se miden y responde
+ * con el perfil default.
+ *
+ * @example
+ * ```cpp
+ * adr.onFrame(from, hops, radio.lastSnr(), radio.lastRssi(), radio.getProfile(), radio.getTxPower());
+ * uint8_t profile;
+ * int8_t power;
+ * if (adr.evaluate(from, profile, power) && enviarLinkProfile(from, profile, power)) {
+ *     adr.apply(from, profile, power);
+ * }
+ * ```
+ */
+class LinkAdr
+{
+public:
+    /**
+     * @struct Link
+     * @brief Estado de un enlace.
+     */
+    struct Link {
+        int16_t snr;       ///< SNR promedio normalizada al perfil default, en décimas de dB
+        int16_t rssi;      ///< RSSI promedio en dBm
+        uint8_t profile;   ///< Perfil asignado (índice en Protocol::RADIO_PROFILES)
+        int8_t txPower;    ///< Potencia asignada en dBm
+        uint8_t samples;   ///< Tramas medidas desde el último cambio (satura en 255)
+        uint8_t failures;  ///< Respuestas perdidas seguidas en el perfil asignado
+    };
+
+    /**
+     * @param table Tabla de nodos que asigna el slot de cada ID
+     */
+    explicit LinkAdr(const NodeTable &table);
+
+    /**
+     * @brief Vuelve el enlace al perfil default y borra sus mediciones
+     */
+    void reset(uint8_t id);
+
+    /**
+     * @brief Registra la calidad de una trama recibida
+     * @param id Remitente
+     * @param hops Saltos de la trama; solo se miden las directas (0)
+     * @param snr SNR informada por la radio en dB
+     * @param rssi RSSI informado por la radio en dBm
+     * @param profile Perfil en que estaba la radio del gateway al recibir
+     * @param txPower Potencia con que transmitió el nodo
+     */
+    void onFrame(uint8_t id, uint8_t hops, int8_t snr, int16_t rssi, uint8_t profile, int8_t txPower);
+
+    /**
+     * @brief Calcula el perfil y la potencia que corresponden al enlace
+     * @return true si difieren de los asignados y hay mediciones suficientes
+     */
+    bool evaluate(uint8_t id, uint8_t &profile, int8_t &txPower) const;
+
+    /**
+     * @brief Registra el perfil confirmado por el nodo (LINK_PROFILE con ACK)
+     */
+    void apply(uint8_t id, uint8_t profile, int8_t txPower);
+
+    /**
+     * @brief Respuesta recibida en el perfil del enlace
+     */
+    void onReplyOk(uint8_t id);
+
+    /**
+     * @brief Respuesta perdida en el perfil del enlace
+     * @return true si el enlace volvió al perfil default
+     */
+    bool onReplyLost(uint8_t id);
+
+    /**
+     * @brief Perfil asignado al enlace
+     */
+    uint8_t profile(uint8_t id) const;
+
+    /**
+     * @brief Potencia asignada al enlace en dBm
+     */
+    int8_t txPower(uint8_t id) const;
+
+    /**
+     * @brief Indica si el enlace responde con perfil o potencia distintos de los de control
+     */
+    bool usesLinkProfile(uint8_t id) const;
+
+    const Link &link(uint8_t id) const;
+
+    /**
+     * @brief SNR mínima de demodulación del SF en décimas de dB (hoja de datos SX1276)
+     */
+    static int16_t requiredSnr(uint8_t spreadingFactor);
+
+private:
+    const NodeTable &nodes;
+    Link links[NodeTable::CAPACITY];
+
+    /**
+     * @brief Entrada del ID, o nullptr si no está registrado
+     */
+    Link *find(uint8_t id);
+    const Link *find(uint8_t id) const;
+};
+
+#endif // LINK_ADR_H
@@ -0,0 +1,117 @@
+/**
+ * @file link_stats.cpp
+ * @brief Implementación de las estadísticas de enlace por nodo
+ */
+
+#include "link_stats.h"
+#include "json_writer.h"
+
+namespace {
+    /**
+     * Promedio exponencial con peso 1/8 para la muestra nueva. El paso se
+     * redondea alejándose de cero: truncado, un promedio a menos de 8 de la
+     * muestra no se movía (retryRate quedaba en 7/255 para siempre).
+     */
+    int32_t ewma(int32_t average, int32_t sample)
+    {
+        int32_t diff = sample - average;
+        return average + (diff + (diff > 0 ? 7 : diff < 0 ? -7 : 0)) / 8;
+    }
+
+    /** Entrada de un ID sin registrar o recién registrado. */
+    const LinkStats::Entry EMPTY = {0, 0, 0, 0, LinkStats::NEVER_SEEN, 0};
+}
+
+const char LinkStats::HEADER_FORMAT[] =
+    "{\"uptime\":%lu,\"fields\":[\"id\",\"hops\",\"rssi\",\"snr\",\"retry\",\"rtt\",\"age\"],\"links\":[";
+const char LinkStats::FOOTER[] = "]}";
+
+LinkStats::LinkStats(const NodeTable &table) : nodes(table)
+{
+    for (uint16_t slot = 0; slot < NodeTable::CAPACITY; slot++) {
+        entries[slot] = EMPTY;
+    }
+}
+
+LinkStats::Entry *LinkStats::find(uint8_t id)
+{
+    uint8_t slot = nodes.slotOf(id);
+    return slot == NodeTable::NO_SLOT ? nullptr : &entries[slot];
+}
+
+void LinkStats::reset(uint8_t id)
+{
+    Entry *found = find(id);
+    if (found != nullptr) {
+        *found = EMPTY;
+    }
+}
+
+void LinkStats::onFrame(uint8_t id, int16_t rssi, int8_t snr, uint8_t hops, unsigned long now)
+{
+    Entry *found = find(id);
+    if (found == nullptr) {
+        return;
+    }
+    Entry &e = *found;
+    if (e.hops == NEVER_SEEN) {
+        e.rssi = (int16_t)(rssi * 16);
+        e.snr = (int16_t)(snr * 16);
+    } else {
+        e.rssi = (int16_t)ewma(e.rssi, rssi * 16);
+        e.snr = (int16_t)ewma(e.snr, snr * 16);
+    }
+    e.hops = hops < NEVER_SEEN ? hops : NEVER_SEEN - 1;
+    e.lastSeen = now;
+}
+
+void LinkStats::onRequest(uint8_t id, bool retry)
+{
+    Entry *found = find(id);
+    if (found == nullptr) {
+        return;
+    }
+    Entry &e = *found;
+    e.retryRate = (uint8_t)ewma(e.retryRate, retry ? 255 : 0);
+}
+
+void LinkStats::onReply(uint8_t id, unsigned long rttMs)
+{
+    Entry *found = find(id);
+    if (found == nullptr) {
+        return;
+    }
+    Entry &e = *found;
+    int32_t sample = rttMs > 0xFFFF ? 0xFFFF : (int32_t)rttMs;
+    e.rttMs = (uint16_t)(e.rttMs == 0 ? sample : ewma(e.rttMs, sample));
+}
+
+bool LinkStats::seen(uint8_t id) const
+{
+    return entry(id).hops != NEVER_SEEN;
+}
+
+const LinkStats::Entry &LinkStats::entry(uint8_t id) const
+{
+    uint8_t slot = nodes.slotOf(id);
+    return slot == NodeTable::NO_SLOT ? EMPTY : entries[slot];
+}
+
+size_t LinkStats::formatRow(uint8_t id, unsigned long now, char *out, size_t size) const
+{
+    const Entry &e = entry(id);
+    if (!seen(id)) {
+        return 0;
+    }
+    JsonWriter row(out, size);
+    row.beginArray()
+        .number(nullptr, id)
+        .number(nullptr, e.hops)
+        .fixed(nullptr, e.rssi * 10 / 16, 1)
+        .fixed(nullptr, e.snr * 10 / 16, 1)
+        .fixed(nullptr, e.retryRate * 100 / 255, 2)
+        .number(nullptr, e.rttMs)
+        .number(nullptr, (uint32_t)((now - e.lastSeen) / 1000))
+        .endArray();
+    return row.ok() ? row.length() : 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file link_stats.h
+ * @brief Estadísticas de calidad de enlace por nodo, publicadas por MQTT
+ * @date 2025
+ *
+ * Una entrada de 12 bytes por slot de NodeTable (1.2 KB con 100 nodos): no
+ * hay reservas en el heap y cada actualización es O(1). Las tramas de un ID
+ * sin registrar no se cuentan. Los promedios son EWMA
+ * con peso 1/8 para la muestra nueva:
+ *
+ * - RSSI y SNR de cada trama recibida del nodo (en punto fijo, 1/16 dB).
+ * - Tasa de reintentos: fracción de los REQUEST_DATA_ATMOSPHERIC enviados
+ *   al nodo que fueron reintentos (0-255 = 0-100%).
+ * - RTT: desde el último REQUEST_DATA_ATMOSPHERIC hasta su respuesta, en ms.
+ * - Saltos y millis() de la última trama.
+ *
+ * AppLogic publica la tabla cada LINK_STATS_PUBLISH_INTERVAL_MS en
+ * MQTT_TOPIC_LINKS, una fila por nodo (ver HEADER y formatRow()):
+ *
+ *   {"uptime":S,"fields":["id","hops","rssi","snr","retry","rtt","age"],
+ *    "links":[[12,0,-87.3,6.5,0.12,840,35],...]}
+ */
+
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <Arduino.h>
+#include "node_table.h"
+
+/**
+ * @class LinkStats
+ * @brief Tabla de calidad de enlace indexada por ID de nodo.
+ *
+ * @example
+ * ```cpp
+ * stats.onFrame(from, radio.lastRssi(), radio.lastSnr(), radio.lastHops(), millis());
+ * stats.onRequest(id, esReintento);
+ * stats.onReply(id, rttMs);
+ * char row[LinkStats::ROW_MAX_LEN];
+ * size_t n = stats.formatRow(id, millis(), row, sizeof(row));
+ * ```
+ */
+class LinkStats
+{
+public:
+    /**
+     * @struct Entry
+     * @brief Estadísticas de un nodo.
+     */
+    struct Entry {
+        int16_t rssi;       ///< RSSI promedio en 1/16 dBm
+        int16_t snr;        ///< SNR promedio en 1/16 dB
+        uint16_t rttMs;     ///< RTT promedio en ms (0 = sin medición)
+        uint8_t retryRate;  ///< Fracción de pedidos que fueron reintentos (255 = 100%)
+        uint8_t hops;       ///< Saltos de la última trama (NEVER_SEEN = ninguna)
+        uint32_t lastSeen;  ///< millis() de la última trama
+    };
+
+    static const uint8_t NEVER_SEEN = 0xFF;  ///< hops de un nodo sin tramas recibidas
+    static const size_t ROW_MAX_LEN = 48;    ///< Largo máximo de una fila con su '\0'
+    static const size_t HEADER_MAX_LEN = 112;///< Largo máximo del inicio del mensaje con su '\0'
+    static const char HEADER_FORMAT[];       ///< Inicio del mensaje; %lu = segundos desde el arranque
+    static const char FOOTER[];              ///< Cierre del mensaje
+
+    /**
+     * @param table Tabla de nodos que asigna el slot de cada ID
+     */
+    explicit LinkStats(const NodeTable &table);
+
+    /**
+     * @brief Borra las estadísticas del nodo (nodo nuevo o dado de baja)
+     */
+    void reset(uint8_t id);
+
+    /**
+     * @brief Registra una trama recibida
+     */
+    void onFrame(uint8_t id, int16_t rssi, int8_t snr, uint8_t hops, unsigned long now);
+
+    /**
+     * @brief Registra un pedido enviado
+     * @param retry true si es un reintento
+     */
+    void onRequest(uint8_t id, bool retry);
+
+    /**
+     * @brief Registra el tiempo de respuesta de un pedido
+     */
+    void onReply(uint8_t id, unsigned long rttMs);
+
+    /**
+     * @brief Indica si se recibió alguna trama del nodo
+     */
+    bool seen(uint8_t id) const;
+
+    const Entry &entry(uint8_t id) const;
+
+    /**
+     * @brief Escribe la fila JSON del nodo: [id,hops,rssi,snr,retry,rtt,age]
+     * @param now millis() actual, para la antigüedad en segundos
+     * @return Largo escrito, o 0 si el nodo no tiene tramas o no entra en out
+     */
+    size_t formatRow(uint8_t id, unsigned long now, char *out, size_t size) const;
+
+private:
+    const NodeTable &nodes;
+    Entry entries[NodeTable::CAPACITY];
+
+    /**
+     * @brief Entrada del ID, o nullptr si no está registrado
+     */
+    Entry *find(uint8_t id);
+};
+
+#endif // LINK_STATS_H
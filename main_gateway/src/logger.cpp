@@ -0,0 +1,69 @@
+/**
+ * @file logger.cpp
+ * @brief Anillo de registros y volcado por Serial
+ */
+
+#include "logger.h"
+
+namespace {
+    Log::Record ring[LOG_RING_ENTRIES];
+    uint16_t next = 0;          ///< Próxima posición a escribir
+    uint16_t used = 0;          ///< Registros válidos
+    uint32_t overwrittenCount = 0;
+
+    const char LEVEL_CHARS[] = {'-', 'E', 'W', 'I', 'D'};
+
+    void print(const Log::Record &r)
+    {
+        Serial.printf("[%8lu %c] ", (unsigned long)r.ms, LEVEL_CHARS[r.level < sizeof(LEVEL_CHARS) ? r.level : 0]);
+        // Los argumentos que el formato no usa se ignoran
+        Serial.printf(r.format, r.args[0], r.args[1], r.args[2], r.args[3], r.args[4]);
+        Serial.printf("\n");
+    }
+}
+
+void Log::record(uint8_t level, const char *format, const uintptr_t *args, uint8_t argc)
+{
+    Record &r = ring[next];
+    r.ms = millis();
+    r.format = format;
+    r.level = level;
+    r.argc = argc;
+    for (uint8_t i = 0; i < LOG_MAX_ARGS; i++) {
+        r.args[i] = i < argc ? args[i] : 0;
+    }
+
+    next = (uint16_t)((next + 1) % LOG_RING_ENTRIES);
+    if (used < LOG_RING_ENTRIES) {
+        used++;
+    } else {
+        overwrittenCount++;
+    }
+
+    if (level <= LOG_SERIAL_LEVEL) {
+        print(r);
+    }
+}
+
+void Log::dump(bool clear)
+{
+    Serial.printf("--- Log: %u mensajes (%lu pisados) ---\n", used, (unsigned long)overwrittenCount);
+    uint16_t first = (uint16_t)((next + LOG_RING_ENTRIES - used) % LOG_RING_ENTRIES);
+    for (uint16_t i = 0; i < used; i++) {
+        print(ring[(first + i) % LOG_RING_ENTRIES]);
+    }
+    Serial.printf("--- Fin del log ---\n");
+    if (clear) {
+        used = 0;
+    }
+}
+
+uint16_t Log::count()
+{
+    return used;
+}
+
+uint32_t Log::overwritten()
+{
+    return overwrittenCount;
+}
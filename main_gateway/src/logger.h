@@ -0,0 +1,124 @@
+/**
+ * @file logger.h
+ * @brief Registro por niveles filtrado en compilación, con anillo binario en RAM
+ * @date 2025
+ *
+ * Reemplaza los Serial.printf sueltos de AppLogic, RadioManager y RtcManager.
+ * A 115200 baudios cada carácter cuesta ~87 us; volcar todas las muestras
+ * en cada respuesta dominaba el tiempo de ciclo con muchos nodos.
+ *
+ * - LOG_E/LOG_W/LOG_I/LOG_D(fmt, ...): un mensaje por nivel. Los niveles por
+ *   encima de LOG_LEVEL quedan dentro de un if (0): se revisan los tipos de
+ *   los argumentos pero no se evalúan, y ni el formato ni la llamada llegan
+ *   al binario.
+ * - Cada mensaje habilitado se guarda en un anillo de LOG_RING_ENTRIES
+ *   registros: millis(), nivel, puntero al formato y hasta LOG_MAX_ARGS
+ *   argumentos crudos. El texto se arma recién al volcar (Log::dump()).
+ * - Los mensajes de nivel <= LOG_SERIAL_LEVEL además se imprimen en el momento.
+ *
+ * Como el formato se aplica después, los argumentos solo pueden ser enteros,
+ * enums o cadenas de vida estática (literales, tablas const). float, String
+ * y buffers char[] no compilan; para una cadena armada en el momento hay que
+ * usar Serial directamente.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#include "config.h"
+
+#define LOG_MAX_ARGS 5 /**< @brief Argumentos por mensaje */
+
+namespace Log {
+
+    /**
+     * @struct Record
+     * @brief Entrada del anillo (32 bytes en el ESP8266).
+     */
+    struct Record {
+        uint32_t ms;                      ///< millis() al registrar
+        const char *format;               ///< Formato printf (literal)
+        uintptr_t args[LOG_MAX_ARGS];     ///< Argumentos crudos
+        uint8_t level;                    ///< LOG_LEVEL_*
+        uint8_t argc;                     ///< Argumentos válidos
+    };
+
+    /**
+     * @brief Guarda un mensaje en el anillo y lo imprime si su nivel llega a LOG_SERIAL_LEVEL
+     * @note Usar las macros LOG_*, que además filtran por LOG_LEVEL.
+     */
+    void record(uint8_t level, const char *format, const uintptr_t *args, uint8_t argc);
+
+    /**
+     * @brief Imprime por Serial el contenido del anillo, del más viejo al más nuevo
+     * @param clear Vaciar el anillo después de imprimir
+     */
+    void dump(bool clear = true);
+
+    /**
+     * @brief Mensajes en el anillo
+     */
+    uint16_t count();
+
+    /**
+     * @brief Mensajes pisados por anillo lleno desde el arranque
+     */
+    uint32_t overwritten();
+
+    template <typename T>
+    inline uintptr_t arg(T value)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                      "LOG_*: solo enteros, enums o cadenas literales (el formato se aplica al volcar)");
+        return (uintptr_t)value;
+    }
+
+    inline uintptr_t arg(const char *value)
+    {
+        return (uintptr_t)value;
+    }
+
+    template <typename... Args>
+    inline void write(uint8_t level, const char *format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "LOG_*: demasiados argumentos (ver LOG_MAX_ARGS)");
+        const uintptr_t values[sizeof...(Args) + 1] = {arg(args)..., 0};
+        record(level, format, values, (uint8_t)sizeof...(Args));
+    }
+
+} // namespace Log
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(format, ...) Log::write(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_E(format, ...) do { if (0) { Log::write(0, format, ##__VA_ARGS__); } } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(format, ...) Log::write(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define LOG_W(format, ...) do { if (0) { Log::write(0, format, ##__VA_ARGS__); } } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(format, ...) Log::write(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_I(format, ...) do { if (0) { Log::write(0, format, ##__VA_ARGS__); } } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(format, ...) Log::write(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_D(format, ...) do { if (0) { Log::write(0, format, ##__VA_ARGS__); } } while (0)
+#endif
+
+#endif // LOGGER_H
@@ -5,6 +5,7 @@
  */
 
 #include "node_identity.h"
+#include "crc8.h"
 
 /**
  * @brief Constructor de NodeIdentity
@@ -147,19 +148,7 @@ uint8_t NodeIdentity::generateSafeHash(
  */
 uint8_t NodeIdentity::crc8(const uint8_t *data, size_t len)
 {
-    uint8_t crc = 0x00;
-    for (size_t i = 0; i < len; ++i)
-    {
-        crc ^= data[i];
-        for (uint8_t j = 0; j < 8; ++j)
-        {
-            if (crc & 0x80)
-                crc = (crc << 1) ^ 0x07;
-            else
-                crc <<= 1;
-        }
-    }
-    return crc;
+    return Crc8::compute(data, len, 0x00);  // Valor inicial 0x00: mismo ID que calcula el nodo
 }
 
 /**
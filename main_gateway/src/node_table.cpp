@@ -0,0 +1,163 @@
+/**
+ * @file node_table.cpp
+ * @brief Implementación de la tabla estática de nodos del gateway
+ */
+
+#include "node_table.h"
+
+NodeTable::NodeTable() : nodeCount(0)
+{
+    memset(presence, 0, sizeof(presence));
+    memset(slots, NO_SLOT, sizeof(slots));
+    memset(owners, NO_SLOT, sizeof(owners));
+    memset(macs, 0, sizeof(macs));
+    memset(versions, 0, sizeof(versions));
+    memset(caps, 0, sizeof(caps));
+    memset(atmosSamples, 0, sizeof(atmosSamples));
+    memset(groundSamples, 0, sizeof(groundSamples));
+}
+
+bool NodeTable::contains(uint8_t id) const
+{
+    return (presence[id >> 3] & (1 << (id & 7))) != 0;
+}
+
+bool NodeTable::add(uint8_t id, const uint8_t *mac)
+{
+    if (contains(id)) {
+        memcpy(macs[slots[id]], mac, MAC_LEN);
+        return false;
+    }
+    uint8_t slot = 0;
+    while (slot < CAPACITY && owners[slot] != NO_SLOT) {
+        slot++;
+    }
+    if (slot == CAPACITY) {
+        return false;
+    }
+    owners[slot] = id;
+    slots[id] = slot;
+    presence[id >> 3] |= (uint8_t)(1 << (id & 7));
+    memcpy(macs[slot], mac, MAC_LEN);
+    versions[slot] = 0;
+    caps[slot] = 0;
+    memset(atmosSamples[slot], 0, sizeof(atmosSamples[slot]));
+    memset(groundSamples[slot], 0, sizeof(groundSamples[slot]));
+    nodeCount++;
+    return true;
+}
+
+void NodeTable::remove(uint8_t id)
+{
+    if (!contains(id)) {
+        return;
+    }
+    owners[slots[id]] = NO_SLOT;
+    slots[id] = NO_SLOT;
+    presence[id >> 3] &= (uint8_t)~(1 << (id & 7));
+    nodeCount--;
+}
+
+uint16_t NodeTable::count() const
+{
+    return nodeCount;
+}
+
+bool NodeTable::empty() const
+{
+    return nodeCount == 0;
+}
+
+bool NodeTable::full() const
+{
+    return nodeCount >= CAPACITY;
+}
+
+uint8_t NodeTable::slotOf(uint8_t id) const
+{
+    return slots[id];
+}
+
+const uint8_t *NodeTable::mac(uint8_t id) const
+{
+    return macs[slots[id]];
+}
+
+bool NodeTable::macEquals(uint8_t id, const uint8_t *mac) const
+{
+    return contains(id) && memcmp(macs[slots[id]], mac, MAC_LEN) == 0;
+}
+
+void NodeTable::setInfo(uint8_t id, uint8_t protocolVersion, uint8_t capabilities)
+{
+    if (!contains(id)) {
+        return;
+    }
+    versions[slots[id]] = protocolVersion;
+    caps[slots[id]] = capabilities;
+}
+
+uint8_t NodeTable::protocolVersion(uint8_t id) const
+{
+    return contains(id) ? versions[slots[id]] : 0;
+}
+
+bool NodeTable::hasCapability(uint8_t id, uint8_t capability) const
+{
+    return contains(id) && (caps[slots[id]] & capability) != 0;
+}
+
+Protocol::AtmosphericSample *NodeTable::atmospheric(uint8_t id)
+{
+    return atmosSamples[slots[id]];
+}
+
+Protocol::GroundGpsPacket *NodeTable::ground(uint8_t id)
+{
+    return groundSamples[slots[id]];
+}
+
+bool NodeTable::next(uint16_t start, uint8_t &id) const
+{
+    while (start < 256) {
+        // Bits del byte actual a partir de start
+        uint8_t bits = presence[start >> 3] & (uint8_t)(0xFF << (start & 7));
+        if (bits != 0) {
+            id = (uint8_t)((start & ~7) + __builtin_ctz(bits));
+            return true;
+        }
+        start = (start | 7) + 1;
+    }
+    return false;
+}
+
+const uint8_t *NodeTable::bitmap() const
+{
+    return presence;
+}
+
+bool NodeTable::parseMac(const char *text, uint8_t *mac)
+{
+    for (uint8_t i = 0; i < MAC_LEN; i++) {
+        uint8_t value = 0;
+        for (uint8_t j = 0; j < 2; j++) {
+            char c = *text++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else return false;
+        }
+        mac[i] = value;
+        if (i < MAC_LEN - 1 && *text++ != ':') {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NodeTable::formatMac(const uint8_t *mac, char *out)
+{
+    snprintf(out, MAC_STR_LEN_WITH_NULL, "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
@@ -0,0 +1,171 @@
+/**
+ * @file node_table.h
+ * @brief Tabla estática de nodos del gateway indexada por ID de nodo
+ * @date 2025
+ *
+ * Reemplaza los std::map de AppLogic (MAC y muestras por nodo). Un bitmap de
+ * presencia indica qué IDs están registrados y un índice de 256 bytes da la
+ * posición (slot) de cada ID en los arreglos, que tienen MAX_NODES
+ * posiciones: los IDs son hashes de la MAC repartidos en 0-254, pero la red
+ * no pasa de MAX_NODES nodos. No hay reservas en el heap después de construir
+ * la tabla y el consumo de RAM se conoce en compilación: sizeof(NodeTable).
+ *
+ * LinkAdr, LinkStats y SequenceTracker usan el mismo slot para sus entradas
+ * por nodo (slotOf()), así que todas las tablas por nodo del gateway miden
+ * MAX_NODES y no 256.
+ *
+ * Con la configuración de producción (100 nodos, 8 muestras atmosféricas, 2 de suelo):
+ * 32 + 256 + 100 + 100*6 + 100*2 + 100*48 + 100*60 + 2 = 11990 bytes.
+ */
+
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <Arduino.h>
+#include "protocol.h"
+#include "config.h"
+
+/**
+ * @class NodeTable
+ * @brief Registro de nodos en formato estructura-de-arreglos.
+ *
+ * @example
+ * ```cpp
+ * uint8_t mac[NodeTable::MAC_LEN];
+ * NodeTable::parseMac("24:0A:C4:00:00:2A", mac);
+ * table.add(0x2A, mac);
+ * uint8_t id;
+ * for (uint16_t c = 0; table.next(c, id); c = id + 1) {
+ *     Protocol::AtmosphericSample *s = table.atmospheric(id);
+ * }
+ * ```
+ */
+class NodeTable
+{
+public:
+    static const uint16_t CAPACITY = MAX_NODES; ///< Nodos registrados como máximo
+    static const uint8_t MAC_LEN = 6;           ///< MAC en binario
+    static const uint8_t NO_SLOT = 0xFF;        ///< slotOf() de un ID no registrado
+
+    /**
+     * @brief Constructor: tabla vacía
+     */
+    NodeTable();
+
+    /**
+     * @brief Indica si el ID está registrado
+     */
+    bool contains(uint8_t id) const;
+
+    /**
+     * @brief Registra un nodo o actualiza su MAC
+     * @param id ID del nodo
+     * @param mac MAC en binario (MAC_LEN bytes)
+     * @return true si el nodo es nuevo
+     * @details Las muestras del slot se limpian al registrar un nodo nuevo.
+     * Con la tabla llena un ID nuevo no se registra (ver full()).
+     */
+    bool add(uint8_t id, const uint8_t *mac);
+
+    /**
+     * @brief Da de baja un nodo
+     */
+    void remove(uint8_t id);
+
+    /**
+     * @brief Cantidad de nodos registrados
+     */
+    uint16_t count() const;
+
+    /**
+     * @brief Indica si no hay nodos registrados
+     */
+    bool empty() const;
+
+    /**
+     * @brief Indica si ya hay CAPACITY nodos registrados
+     */
+    bool full() const;
+
+    /**
+     * @brief Posición del nodo en los arreglos por nodo (0 a CAPACITY - 1)
+     * @return NO_SLOT si el ID no está registrado
+     */
+    uint8_t slotOf(uint8_t id) const;
+
+    /**
+     * @brief MAC registrada del nodo (MAC_LEN bytes); el ID debe estar registrado
+     */
+    const uint8_t *mac(uint8_t id) const;
+
+    /**
+     * @brief Compara la MAC registrada con la recibida
+     */
+    bool macEquals(uint8_t id, const uint8_t *mac) const;
+
+    /**
+     * @brief Guarda versión de protocolo y capacidades informadas en el HELLO
+     */
+    void setInfo(uint8_t id, uint8_t protocolVersion, uint8_t capabilities);
+
+    /**
+     * @brief Versión de protocolo del nodo (1 = HELLO en texto)
+     */
+    uint8_t protocolVersion(uint8_t id) const;
+
+    /**
+     * @brief Indica si el nodo declaró la capacidad (Protocol::Capability)
+     */
+    bool hasCapability(uint8_t id, uint8_t capability) const;
+
+    /**
+     * @brief Muestras atmosféricas del nodo (NUMERO_MUESTRAS_ATMOSFERICAS elementos); el ID debe estar registrado
+     */
+    Protocol::AtmosphericSample *atmospheric(uint8_t id);
+
+    /**
+     * @brief Muestras de suelo/GPS del nodo (CANTIDAD_MUESTRAS_SUELO elementos); el ID debe estar registrado
+     */
+    Protocol::GroundGpsPacket *ground(uint8_t id);
+
+    /**
+     * @brief Busca el primer ID registrado mayor o igual a start
+     * @param start ID inicial (0-256)
+     * @param id ID encontrado
+     * @return false si no hay más nodos
+     * @details Recorre el bitmap de a 8 IDs, saltando bytes vacíos
+     */
+    bool next(uint16_t start, uint8_t &id) const;
+
+    /**
+     * @brief Bitmap de presencia (mismo formato que Protocol::SlotSchedule::nodes)
+     */
+    const uint8_t *bitmap() const;
+
+    /**
+     * @brief Convierte "AA:BB:CC:DD:EE:FF" a binario
+     * @return false si el texto no es una MAC válida
+     */
+    static bool parseMac(const char *text, uint8_t *mac);
+
+    /**
+     * @brief Convierte una MAC binaria a "AA:BB:CC:DD:EE:FF"
+     * @param out Buffer de al menos MAC_STR_LEN_WITH_NULL bytes
+     */
+    static void formatMac(const uint8_t *mac, char *out);
+
+private:
+    static_assert(CAPACITY < NO_SLOT, "MAX_NODES debe ser menor que 255");
+
+    uint8_t presence[Protocol::SLOT_BITMAP_BYTES];                                   ///< Bit por ID registrado
+    uint8_t slots[256];                                                              ///< Slot de cada ID (NO_SLOT = ninguno)
+    uint8_t owners[CAPACITY];                                                        ///< ID dueño de cada slot (NO_SLOT = libre)
+    uint8_t macs[CAPACITY][MAC_LEN];                                                 ///< MAC por slot
+    uint8_t versions[CAPACITY];                                                      ///< Versión de protocolo por slot
+    uint8_t caps[CAPACITY];                                                          ///< Protocol::Capability por slot
+    Protocol::AtmosphericSample atmosSamples[CAPACITY][NUMERO_MUESTRAS_ATMOSFERICAS]; ///< Última tanda atmosférica por slot
+    Protocol::GroundGpsPacket groundSamples[CAPACITY][CANTIDAD_MUESTRAS_SUELO];     ///< Muestras de suelo del día por slot
+    uint16_t nodeCount;                                                              ///< Nodos registrados
+};
+
+#endif // NODE_TABLE_H
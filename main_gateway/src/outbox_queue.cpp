@@ -0,0 +1,179 @@
+/**
+ * @file outbox_queue.cpp
+ * @brief Implementación de la cola persistente de publicaciones pendientes
+ */
+
+#include "outbox_queue.h"
+#include "crc8.h"
+#include "logger.h"
+
+namespace {
+    const char *OUTBOX_FILE = "/outbox.bin";
+    const char *OUTBOX_TAIL_FILE = "/outbox.tail";
+
+    bool validType(uint8_t type)
+    {
+        return type == Protocol::DATA_ATMOSPHERIC || type == Protocol::DATA_GPS_CROUND;
+    }
+}
+
+OutboxQueue::OutboxQueue() : ready(false), head(0), tail(0), savedTail(0), droppedCount(0)
+{
+}
+
+bool OutboxQueue::begin()
+{
+    if (!LittleFS.begin()) {
+        LOG_W("OutboxQueue::begin(): LittleFS no montó, formateando...");
+        if (!LittleFS.format() || !LittleFS.begin()) {
+            LOG_E("OutboxQueue::begin(): Sin LittleFS, cola deshabilitada.");
+            return false;
+        }
+    }
+
+    const size_t fileSize = (size_t)OUTBOX_CAPACITY * sizeof(OutboxRecord);
+    if (!LittleFS.exists(OUTBOX_FILE)) {
+        // Se reserva el archivo completo una sola vez: después solo se sobrescriben slots
+        File created = LittleFS.open(OUTBOX_FILE, "w");
+        OutboxRecord empty;
+        memset(&empty, 0, sizeof(empty));
+        for (uint16_t i = 0; created && i < OUTBOX_CAPACITY; i++) {
+            created.write(reinterpret_cast<const uint8_t *>(&empty), sizeof(empty));
+        }
+        created.close();
+    }
+    file = LittleFS.open(OUTBOX_FILE, "r+");
+    if (!file || file.size() != fileSize) {
+        LOG_E("OutboxQueue::begin(): %s invalido, cola deshabilitada.", OUTBOX_FILE);
+        return false;
+    }
+
+    File tailFile = LittleFS.open(OUTBOX_TAIL_FILE, "r");
+    if (tailFile) {
+        if (tailFile.read(reinterpret_cast<uint8_t *>(&tail), sizeof(tail)) != sizeof(tail)) {
+            tail = 0;
+        }
+        tailFile.close();
+    }
+    savedTail = tail;
+    head = tail;
+    ready = true;
+
+    // La cabeza es la mayor secuencia válida; los registros anteriores a tail ya se publicaron
+    OutboxRecord record;
+    for (uint16_t slot = 0; slot < OUTBOX_CAPACITY; slot++) {
+        file.seek((uint32_t)slot * sizeof(OutboxRecord), SeekSet);
+        if (file.read(reinterpret_cast<uint8_t *>(&record), sizeof(record)) != sizeof(record)) {
+            break;
+        }
+        if (validType(record.type) && record.crc == checksum(record) &&
+            (int32_t)(record.seq - tail) >= 0 && (int32_t)(record.seq + 1 - head) > 0) {
+            head = record.seq + 1;
+        }
+    }
+    if (head - tail > OUTBOX_CAPACITY) {
+        tail = head - OUTBOX_CAPACITY;
+    }
+    LOG_I("OutboxQueue::begin(): %u registros pendientes.", count());
+    return true;
+}
+
+bool OutboxQueue::push(uint8_t type, uint8_t nodeId, const void *data, uint8_t len)
+{
+    if (!ready || len > OUTBOX_PAYLOAD_BYTES) {
+        return false;
+    }
+    if (count() >= OUTBOX_CAPACITY) {
+        tail++;  // Cola llena: se pisa el más viejo
+        droppedCount++;
+    }
+
+    OutboxRecord record;
+    memset(&record, 0, sizeof(record));
+    record.seq = head;
+    record.type = type;
+    record.nodeId = nodeId;
+    record.len = len;
+    memcpy(record.data, data, len);
+    record.crc = checksum(record);
+
+    file.seek((head % OUTBOX_CAPACITY) * sizeof(OutboxRecord), SeekSet);
+    if (file.write(reinterpret_cast<const uint8_t *>(&record), sizeof(record)) != sizeof(record)) {
+        LOG_E("OutboxQueue::push(): Error de escritura en %s.", OUTBOX_FILE);
+        return false;
+    }
+    file.flush();
+    head++;
+    return true;
+}
+
+bool OutboxQueue::readSlot(uint32_t seq, OutboxRecord &record)
+{
+    file.seek((seq % OUTBOX_CAPACITY) * sizeof(OutboxRecord), SeekSet);
+    if (file.read(reinterpret_cast<uint8_t *>(&record), sizeof(record)) != sizeof(record)) {
+        return false;
+    }
+    return record.seq == seq && validType(record.type) && record.crc == checksum(record);
+}
+
+bool OutboxQueue::peek(OutboxRecord &record)
+{
+    // Los registros dañados (corte durante la escritura) se saltean
+    while (ready && tail != head) {
+        if (readSlot(tail, record)) {
+            return true;
+        }
+        tail++;
+    }
+    return false;
+}
+
+void OutboxQueue::pop()
+{
+    if (tail != head) {
+        tail++;
+    }
+}
+
+void OutboxQueue::discard()
+{
+    if (tail != head) {
+        tail++;
+        droppedCount++;
+    }
+}
+
+void OutboxQueue::commit()
+{
+    if (!ready || tail == savedTail) {
+        return;
+    }
+    File tailFile = LittleFS.open(OUTBOX_TAIL_FILE, "w");
+    if (!tailFile) {
+        return;
+    }
+    tailFile.write(reinterpret_cast<const uint8_t *>(&tail), sizeof(tail));
+    tailFile.close();
+    savedTail = tail;
+}
+
+uint16_t OutboxQueue::count() const
+{
+    return (uint16_t)(head - tail);
+}
+
+uint32_t OutboxQueue::dropped() const
+{
+    return droppedCount;
+}
+
+/**
+ * @brief CRC-8 (polinomio 0x07, valor inicial 0xFF) del registro con crc = 0
+ * @details El valor inicial distinto de cero evita que un slot borrado (todo ceros) parezca válido.
+ */
+uint8_t OutboxQueue::checksum(const OutboxRecord &record)
+{
+    OutboxRecord copy = record;
+    copy.crc = 0;
+    return Crc8::compute(&copy, sizeof(copy));
+}
@@ -0,0 +1,124 @@
+/**
+ * @file outbox_queue.h
+ * @brief Cola persistente en LittleFS para lecturas que no se pudieron publicar por MQTT
+ * @date 2025
+ *
+ * Cuando WiFi o el broker no están disponibles, AppLogic guarda aquí el
+ * paquete binario recibido del nodo (no el JSON) y lo publica al reconectar.
+ *
+ * Formato en flash:
+ * - /outbox.bin: OUTBOX_CAPACITY registros de tamaño fijo (OutboxRecord). El
+ *   registro con secuencia s vive en el slot s % OUTBOX_CAPACITY.
+ * - /outbox.tail: secuencia del registro más viejo no publicado (4 bytes).
+ *
+ * Cada registro lleva su secuencia y un CRC-8, así que no hay índice que se
+ * pueda corromper: al arrancar se recorren los slots y la cabeza es la mayor
+ * secuencia válida + 1. Un corte de energía en medio de una escritura solo
+ * pierde ese registro. Si el corte ocurre entre publicar y guardar la cola,
+ * los registros de esa tanda se publican de nuevo (al menos una vez).
+ */
+
+#ifndef OUTBOX_QUEUE_H
+#define OUTBOX_QUEUE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "protocol.h"
+#include "config.h"
+
+/**
+ * @brief Bytes de payload por registro: alcanza para una tanda atmosférica o un paquete de suelo
+ */
+#define OUTBOX_PAYLOAD_BYTES (sizeof(Protocol::AtmosphericSample) * NUMERO_MUESTRAS_ATMOSFERICAS)
+
+#pragma pack(push, 1)
+/**
+ * @struct OutboxRecord
+ * @brief Registro de la cola (56 bytes con 8 muestras atmosféricas).
+ */
+struct OutboxRecord {
+    uint32_t seq;                        ///< Secuencia global (nunca se reutiliza)
+    uint8_t type;                        ///< Protocol::DATA_ATMOSPHERIC o Protocol::DATA_GPS_CROUND
+    uint8_t nodeId;                      ///< Nodo de origen
+    uint8_t len;                         ///< Bytes válidos de data
+    uint8_t crc;                         ///< CRC-8 de todo el registro con crc = 0
+    uint8_t data[OUTBOX_PAYLOAD_BYTES];  ///< Paquete tal como llegó por radio
+};
+#pragma pack(pop)
+
+/**
+ * @class OutboxQueue
+ * @brief Cola circular FIFO de registros fijos persistida en LittleFS.
+ *
+ * @example
+ * ```cpp
+ * outbox.push(Protocol::DATA_GPS_CROUND, nodeId, &packet, sizeof(packet));
+ * // al reconectar, de a tandas:
+ * OutboxRecord rec;
+ * while (outbox.peek(rec) && publicar(rec)) outbox.pop();
+ * outbox.commit();
+ * ```
+ */
+class OutboxQueue
+{
+public:
+    OutboxQueue();
+
+    /**
+     * @brief Monta LittleFS, crea el archivo si no existe y recupera la cola
+     * @return false si no hay sistema de archivos (la cola queda deshabilitada)
+     */
+    bool begin();
+
+    /**
+     * @brief Agrega un registro al final
+     * @details Si la cola está llena se descarta el más viejo.
+     * @return false si la cola está deshabilitada o len no entra en un registro
+     */
+    bool push(uint8_t type, uint8_t nodeId, const void *data, uint8_t len);
+
+    /**
+     * @brief Lee el registro más viejo sin quitarlo
+     * @return false si la cola está vacía
+     */
+    bool peek(OutboxRecord &record);
+
+    /**
+     * @brief Quita el registro más viejo (en RAM; ver commit())
+     */
+    void pop();
+
+    /**
+     * @brief Quita el registro más viejo sin publicarlo y lo cuenta en dropped()
+     * @details Para registros que nunca van a poder publicarse; como pop(), en RAM hasta commit().
+     */
+    void discard();
+
+    /**
+     * @brief Guarda en flash la posición de la cola tras una tanda de pop()
+     */
+    void commit();
+
+    /**
+     * @brief Registros pendientes
+     */
+    uint16_t count() const;
+
+    /**
+     * @brief Registros descartados por cola llena o con discard() desde el arranque
+     */
+    uint32_t dropped() const;
+
+private:
+    File file;           ///< /outbox.bin abierto en r+
+    bool ready;          ///< LittleFS montado y archivo listo
+    uint32_t head;       ///< Secuencia del próximo registro a escribir
+    uint32_t tail;       ///< Secuencia del registro más viejo pendiente
+    uint32_t savedTail;  ///< Último tail guardado en /outbox.tail
+    uint32_t droppedCount;
+
+    bool readSlot(uint32_t seq, OutboxRecord &record);
+    static uint8_t checksum(const OutboxRecord &record);
+};
+
+#endif // OUTBOX_QUEUE_H
@@ -0,0 +1,159 @@
+/**
+ * @file poll_engine.cpp
+ * @brief Implementación de la tabla de solicitudes pendientes del gateway
+ */
+
+#include "poll_engine.h"
+
+PollEngine::PollEngine(uint8_t requestType, uint16_t timeoutMs, uint8_t maxRetries)
+    : inFlight(0), nextNode(256), active(false), reqType(requestType),
+      timeout(timeoutMs), retries(maxRetries)
+{
+    memset(slots, 0, sizeof(slots));
+    memset(&cycle, 0, sizeof(cycle));
+}
+
+bool PollEngine::startCycle(unsigned long now)
+{
+    if (active) {
+        return false;
+    }
+    memset(slots, 0, sizeof(slots));
+    memset(&cycle, 0, sizeof(cycle));
+    cycle.startedAt = now;
+    inFlight = 0;
+    nextNode = 0;
+    active = true;
+    return true;
+}
+
+bool PollEngine::isActive() const
+{
+    return active;
+}
+
+bool PollEngine::hasFreeSlot() const
+{
+    return active && inFlight < POLL_MAX_IN_FLIGHT;
+}
+
+uint8_t PollEngine::pending() const
+{
+    return inFlight;
+}
+
+uint16_t PollEngine::cursor() const
+{
+    return nextNode;
+}
+
+void PollEngine::closeQueue()
+{
+    nextNode = 256;
+}
+
+bool PollEngine::track(uint8_t nodeId, unsigned long now, uint16_t timeoutMs)
+{
+    if (!hasFreeSlot()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < POLL_MAX_IN_FLIGHT; i++) {
+        if (!slots[i].inUse) {
+            slots[i].inUse = true;
+            slots[i].nodeId = nodeId;
+            slots[i].attempts = 1;
+            slots[i].timeout = timeoutMs != 0 ? timeoutMs : timeout;
+            slots[i].deadline = now + slots[i].timeout;
+            inFlight++;
+            cycle.requests++;
+            nextNode = (uint16_t)nodeId + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PollEngine::expire(uint8_t nodeId, unsigned long now)
+{
+    Slot *slot = find(nodeId);
+    if (slot != nullptr) {
+        slot->deadline = now;
+    }
+}
+
+PollEngine::Expiry PollEngine::checkExpired(unsigned long now, uint8_t &nodeId)
+{
+    for (uint8_t i = 0; i < POLL_MAX_IN_FLIGHT; i++) {
+        Slot &slot = slots[i];
+        // Comparación con signo para tolerar el desborde de millis()
+        if (!slot.inUse || (long)(now - slot.deadline) < 0) {
+            continue;
+        }
+        nodeId = slot.nodeId;
+        if (slot.attempts <= retries) {
+            slot.attempts++;
+            slot.deadline = now + slot.timeout;
+            cycle.retries++;
+            return RETRY;
+        }
+        slot.inUse = false;
+        inFlight--;
+        cycle.failures++;
+        return FAILED;
+    }
+    return NONE;
+}
+
+bool PollEngine::elapsed(uint8_t nodeId, unsigned long now, unsigned long &elapsed) const
+{
+    for (uint8_t i = 0; i < POLL_MAX_IN_FLIGHT; i++) {
+        if (slots[i].inUse && slots[i].nodeId == nodeId) {
+            // El intento actual se envió un timeout antes de su vencimiento
+            elapsed = now - (slots[i].deadline - slots[i].timeout);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PollEngine::complete(uint8_t nodeId)
+{
+    Slot *slot = find(nodeId);
+    if (slot == nullptr) {
+        return false;
+    }
+    slot->inUse = false;
+    inFlight--;
+    cycle.replies++;
+    return true;
+}
+
+bool PollEngine::finishIfDone(unsigned long now)
+{
+    if (!active || inFlight > 0 || nextNode <= 255) {
+        return false;
+    }
+    cycle.duration = now - cycle.startedAt;
+    active = false;
+    return true;
+}
+
+uint8_t PollEngine::requestType() const
+{
+    return reqType;
+}
+
+const PollEngine::CycleStats &PollEngine::stats() const
+{
+    return cycle;
+}
+
+PollEngine::Slot *PollEngine::find(uint8_t nodeId)
+{
+    for (uint8_t i = 0; i < POLL_MAX_IN_FLIGHT; i++) {
+        if (slots[i].inUse && slots[i].nodeId == nodeId) {
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
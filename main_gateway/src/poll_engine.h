@@ -0,0 +1,184 @@
+/**
+ * @file poll_engine.h
+ * @brief Tabla de solicitudes pendientes para el sondeo no bloqueante de nodos
+ * @date 2025
+ *
+ * El PollEngine no envía ni recibe nada por sí mismo: solo lleva la cuenta de
+ * qué nodos tienen una solicitud en vuelo, cuándo vence cada una y cuántos
+ * reintentos lleva. AppLogic lo consulta desde update() para decidir a quién
+ * enviar (nuevo pedido o reintento) y le informa las respuestas recibidas.
+ *
+ * De esta forma varios nodos pueden estar en vuelo a la vez y el tiempo de un
+ * ciclo depende del tiempo de aire, no de la suma de los timeouts.
+ */
+
+#ifndef POLL_ENGINE_H
+#define POLL_ENGINE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @class PollEngine
+ * @brief Planificador de solicitudes con deadline por nodo.
+ *
+ * @example
+ * ```cpp
+ * PollEngine poll(Protocol::REQUEST_DATA_ATMOSPHERIC);
+ * poll.startCycle(millis());
+ * // en cada update():
+ * uint8_t id;
+ * if (poll.checkExpired(millis(), id) == PollEngine::RETRY) enviarSolicitud(id);
+ * ```
+ */
+class PollEngine
+{
+public:
+    /**
+     * @enum Expiry
+     * @brief Resultado de revisar los deadlines de la tabla.
+     */
+    enum Expiry : uint8_t {
+        NONE = 0,  ///< Ninguna solicitud vencida
+        RETRY,     ///< Solicitud vencida con reintentos disponibles (ya rearmada)
+        FAILED     ///< Solicitud vencida sin reintentos (slot liberado)
+    };
+
+    /**
+     * @struct CycleStats
+     * @brief Métricas del último ciclo de sondeo.
+     */
+    struct CycleStats {
+        unsigned long startedAt; ///< millis() al iniciar el ciclo
+        unsigned long duration;  ///< Duración total del ciclo en ms
+        uint16_t requests;       ///< Solicitudes enviadas (sin contar reintentos)
+        uint16_t retries;        ///< Reintentos enviados
+        uint16_t replies;        ///< Respuestas válidas recibidas
+        uint16_t failures;       ///< Nodos que agotaron los reintentos
+    };
+
+    /**
+     * @brief Constructor
+     * @param requestType Tipo de mensaje de solicitud (Protocol::MessageType)
+     * @param timeoutMs Tiempo máximo de espera de respuesta por intento
+     * @param maxRetries Reintentos permitidos después del primer envío
+     */
+    PollEngine(uint8_t requestType, uint16_t timeoutMs = POLL_REPLY_TIMEOUT, uint8_t maxRetries = POLL_MAX_RETRIES);
+
+    /**
+     * @brief Inicia un nuevo ciclo recorriendo los nodos desde el ID 0
+     * @param now Tiempo actual (millis())
+     * @return false si todavía hay un ciclo en curso
+     */
+    bool startCycle(unsigned long now);
+
+    /**
+     * @brief Indica si hay un ciclo en curso
+     */
+    bool isActive() const;
+
+    /**
+     * @brief Indica si se puede poner en vuelo otra solicitud
+     */
+    bool hasFreeSlot() const;
+
+    /**
+     * @brief Solicitudes en vuelo
+     */
+    uint8_t pending() const;
+
+    /**
+     * @brief Próximo ID de nodo a considerar para un pedido nuevo
+     * @return 0-255, o 256 si ya se recorrieron todos los nodos
+     */
+    uint16_t cursor() const;
+
+    /**
+     * @brief Marca que no quedan nodos por pedir en este ciclo
+     */
+    void closeQueue();
+
+    /**
+     * @brief Registra una solicitud nueva en vuelo y avanza el cursor
+     * @param nodeId Nodo al que se envió la solicitud
+     * @param now Tiempo actual (millis())
+     * @param timeoutMs Timeout por intento para este nodo (0 = el del constructor)
+     * @return false si no hay slot libre
+     */
+    bool track(uint8_t nodeId, unsigned long now, uint16_t timeoutMs = 0);
+
+    /**
+     * @brief Fuerza el vencimiento inmediato de la solicitud a un nodo
+     * @param nodeId Nodo consultado
+     * @param now Tiempo actual (millis())
+     * @details Se usa cuando el envío falla (sin ruta o sin ACK de salto)
+     */
+    void expire(uint8_t nodeId, unsigned long now);
+
+    /**
+     * @brief Revisa la tabla y procesa como máximo una solicitud vencida
+     * @param now Tiempo actual (millis())
+     * @param nodeId Nodo afectado (válido si el resultado no es NONE)
+     * @return NONE, RETRY (hay que reenviar) o FAILED (nodo descartado)
+     */
+    Expiry checkExpired(unsigned long now, uint8_t &nodeId);
+
+    /**
+     * @brief Tiempo desde el último envío de la solicitud en vuelo a un nodo
+     * @param nodeId Nodo consultado
+     * @param now Tiempo actual (millis())
+     * @param elapsed Milisegundos desde el último intento
+     * @return false si el nodo no tiene solicitud en vuelo
+     */
+    bool elapsed(uint8_t nodeId, unsigned long now, unsigned long &elapsed) const;
+
+    /**
+     * @brief Informa la respuesta de un nodo y libera su slot
+     * @param nodeId Remitente de la respuesta
+     * @return true si el nodo tenía una solicitud en vuelo
+     */
+    bool complete(uint8_t nodeId);
+
+    /**
+     * @brief Cierra el ciclo si no quedan nodos por pedir ni solicitudes en vuelo
+     * @param now Tiempo actual (millis())
+     * @return true solo en la llamada en la que el ciclo termina
+     */
+    bool finishIfDone(unsigned long now);
+
+    /**
+     * @brief Tipo de mensaje de solicitud asociado
+     */
+    uint8_t requestType() const;
+
+    /**
+     * @brief Métricas del ciclo actual o del último terminado
+     */
+    const CycleStats &stats() const;
+
+private:
+    /**
+     * @struct Slot
+     * @brief Entrada de la tabla de solicitudes en vuelo.
+     */
+    struct Slot {
+        unsigned long deadline; ///< millis() en que vence el intento actual
+        uint8_t nodeId;         ///< Nodo consultado
+        uint8_t attempts;       ///< Envíos realizados (1 = primer envío)
+        uint16_t timeout;       ///< Timeout por intento de este nodo en ms
+        bool inUse;             ///< Slot ocupado
+    };
+
+    Slot slots[POLL_MAX_IN_FLIGHT]; ///< Solicitudes en vuelo
+    uint8_t inFlight;               ///< Cantidad de slots ocupados
+    uint16_t nextNode;              ///< Próximo ID a pedir (256 = cola cerrada)
+    bool active;                    ///< Ciclo en curso
+    uint8_t reqType;                ///< Tipo de mensaje de solicitud
+    uint16_t timeout;               ///< Timeout por intento por defecto en ms
+    uint8_t retries;                ///< Reintentos permitidos
+    CycleStats cycle;               ///< Métricas del ciclo
+
+    Slot *find(uint8_t nodeId);
+};
+
+#endif // POLL_ENGINE_H
@@ -23,6 +23,8 @@ namespace Protocol {
 
     /**
      * @brief Clave de seguridad del protocolo para validación de mensajes.
+     * @details Es un byte fijo: solo distingue el formato. La autenticidad de
+     * las tramas la da FrameAuth (AUTH_ENABLED), que sella todo el payload.
      */
     const uint8_t KEY = 0x69;
 
@@ -39,7 +41,9 @@ namespace Protocol {
         DATA_ATMOSPHERIC = 0x04,         /**< Envío de datos atmosféricos. */
         DATA_GPS_CROUND = 0x05,          /**< Envío de datos gps y ground. */
         HELLO = 0x06,                    /**< Mensaje de saludo/conexión inicial. */
-        ERROR_DIRECCION = 0x07           /**< Mensaje de dirección de nodo repetida. */
+        ERROR_DIRECCION = 0x07,          /**< Mensaje de dirección de nodo repetida. */
+        LINK_PROFILE = 0x08,             /**< Perfil de radio (ADR) para las respuestas del nodo. */
+        BATCH_ACK = 0x09                 /**< El gateway guardó el lote atmosférico (BatchAck). */
     };
 
     #pragma pack(push, 1)
@@ -122,8 +126,200 @@ namespace Protocol {
         GpsSensor gps;      ///< Datos GPS
         EnergyData energy;  ///< Datos energéticos
     };
+
+    /**
+     * @brief Bytes del bitmap de nodos del calendario de slots (un bit por ID 0-255).
+     */
+    const uint8_t SLOT_BITMAP_BYTES = 32;
+
+    /**
+     * @struct SlotSchedule
+     * @brief Calendario de slots (TDMA) que viaja en el payload del ANNOUNCE.
+     *
+     * Cada nodo cuyo bit esté en `nodes` envía DATA_ATMOSPHERIC sin esperar
+     * pedido, en el slot que corresponde a su posición entre los IDs marcados
+     * (el ID marcado más bajo usa el slot 0). El tiempo se cuenta desde la
+     * recepción del ANNOUNCE:
+     *
+     *   inicio = recepción + firstSlotMs + posición * slotMs
+     *
+     * Un ANNOUNCE de un solo byte (solo KEY) no asigna slots. Los gateways de
+     * protocolo 2 no envían `features`: un calendario sin ese byte vale 0.
+     */
+    struct SlotSchedule {
+        uint8_t key;                       ///< Protocol::KEY
+        uint16_t slotMs;                   ///< Duración de cada slot en ms
+        uint16_t firstSlotMs;              ///< Espera desde el ANNOUNCE hasta el slot 0 en ms
+        uint8_t nodes[SLOT_BITMAP_BYTES];  ///< Bit (id % 8) del byte (id / 8) = nodo con slot
+        uint8_t features;                  ///< Bitmap de GatewayFeature
+    };
+
+    /**
+     * @struct PollWindow
+     * @brief Ventana de respuesta de un REQUEST_DATA_ATMOSPHERIC enviado a RH_BROADCAST_ADDRESS.
+     *
+     * Un solo pedido para todos los vecinos directos: como en SlotSchedule,
+     * cada nodo marcado en `nodes` responde en el slot de su posición entre
+     * los IDs marcados, contado desde la recepción del pedido:
+     *
+     *   inicio = recepción + firstSlotMs + posición * slotMs
+     *
+     * Los IDs son el CRC-8 de la MAC y no son consecutivos: la posición en el
+     * bitmap da un slot distinto a cada nodo. El gateway marca solo a los
+     * nodos a un salto (un broadcast no se retransmite); los demás, y los que
+     * no respondan, se piden después de a uno. Los nodos con un perfil de
+     * radio propio (LINK_PROFILE) responden en su slot con el perfil default.
+     *
+     * Empieza igual que el pedido unicast ([KEY, features]): un nodo sin
+     * CAP_BROADCAST_POLL responde enseguida como si fuera para él.
+     */
+    struct PollWindow {
+        uint8_t key;                       ///< Protocol::KEY
+        uint8_t features;                  ///< Bitmap de GatewayFeature
+        uint16_t slotMs;                   ///< Duración de cada slot en ms
+        uint16_t firstSlotMs;              ///< Espera desde el pedido hasta el slot 0 en ms
+        uint8_t nodes[SLOT_BITMAP_BYTES];  ///< Bit (id % 8) del byte (id / 8) = nodo con slot
+    };
+
+    /**
+     * @enum GatewayFeature
+     * @brief Formatos que el gateway acepta, en `SlotSchedule::features` y en
+     * el segundo byte de REQUEST_DATA_ATMOSPHERIC y REQUEST_DATA_GPC_GROUND ([KEY, features]).
+     */
+    enum GatewayFeature : uint8_t {
+        FEATURE_PACKED_ATMOSPHERIC = 0x01, /**< Decodifica DATA_ATMOSPHERIC comprimido (AtmosCodec). */
+        FEATURE_BATCH_SEQUENCE = 0x02,     /**< Espera BatchHeader delante de DATA_ATMOSPHERIC y DATA_GPS_CROUND. */
+        FEATURE_GROUND_AGE = 0x04,         /**< Acepta GroundAge detrás del GroundGpsPacket de DATA_GPS_CROUND. */
+        FEATURE_BATCH_ACK = 0x08           /**< Confirma con BATCH_ACK cada DATA_ATMOSPHERIC numerado que guarda. */
+    };
+
+    /**
+     * @struct BatchHeader
+     * @brief Número de lote que antecede al payload de DATA_ATMOSPHERIC y DATA_GPS_CROUND.
+     *
+     * Lo agregan los nodos con CAP_BATCH_SEQUENCE cuando el gateway anuncia
+     * FEATURE_BATCH_SEQUENCE. Un solo contador por nodo para los dos tipos:
+     * avanza con cada lote nuevo (una muestra atmosférica nueva desde el último
+     * envío, o una lectura de suelo/GPS) y un reenvío del mismo lote repite el
+     * número. El gateway descarta así los duplicados y cuenta los lotes perdidos.
+     *
+     * 0 es el primer lote desde el arranque del nodo; después de 65535 sigue en 1.
+     */
+    struct BatchHeader {
+        uint16_t seq;  ///< Número de lote (little-endian)
+    };
+
+    /**
+     * @struct BatchAck
+     * @brief Payload de BATCH_ACK: el gateway guardó el DATA_ATMOSPHERIC con ese número de lote.
+     *
+     * El ACK de RadioHead solo confirma el primer salto; con
+     * FEATURE_BATCH_ACK el nodo avanza la cola de su anillo de muestras
+     * recién con este mensaje. También se envía para un lote duplicado: el
+     * BATCH_ACK anterior pudo perderse.
+     */
+    struct BatchAck {
+        uint8_t key;   ///< Protocol::KEY
+        uint16_t seq;  ///< BatchHeader::seq del lote guardado (little-endian)
+    };
+
+    /**
+     * @struct GroundRequest
+     * @brief Payload de REQUEST_DATA_GPC_GROUND.
+     *
+     * Empieza como el pedido atmosférico ([KEY, features]); los nodos
+     * anteriores solo leen esos dos bytes. Un nodo con CAP_GROUND_CACHE usa
+     * `intervalS` para leer el RS485 justo antes del próximo pedido. 0 (o un
+     * pedido de dos bytes) = el gateway no pide a intervalo fijo.
+     */
+    struct GroundRequest {
+        uint8_t key;         ///< Protocol::KEY
+        uint8_t features;    ///< Bitmap de GatewayFeature
+        uint16_t intervalS;  ///< Segundos hasta el próximo pedido de suelo (little-endian)
+    };
+
+    /**
+     * @struct GroundAge
+     * @brief Antigüedad de la lectura que sigue al GroundGpsPacket de DATA_GPS_CROUND.
+     *
+     * La agregan los nodos con CAP_GROUND_CACHE cuando el gateway anuncia
+     * FEATURE_GROUND_AGE: responden de la última lectura, no de una hecha al
+     * recibir el pedido.
+     */
+    struct GroundAge {
+        uint16_t ageS;  ///< Segundos desde la lectura (65535 = más)
+    };
+
+    /**
+     * @brief Versión del protocolo mesh que anuncia el HELLO binario.
+     * @details La versión 1 es el HELLO original con la MAC en texto (MAC_STR_LEN_WITH_NULL bytes).
+     * La 3 agrega GatewayFeature y DATA_ATMOSPHERIC comprimido.
+     */
+    const uint8_t PROTOCOL_VERSION = 3;
+
+    /**
+     * @enum Capability
+     * @brief Bits del campo `capabilities` de HelloPacket.
+     */
+    enum Capability : uint8_t {
+        CAP_ATMOSPHERIC = 0x01,   /**< Responde DATA_ATMOSPHERIC. */
+        CAP_GROUND_GPS = 0x02,    /**< Responde DATA_GPS_CROUND (RS485 + GPS). */
+        CAP_SLOT_SCHEDULE = 0x04,     /**< Envía en su slot si el ANNOUNCE trae SlotSchedule. */
+        CAP_PACKED_ATMOSPHERIC = 0x08, /**< Comprime DATA_ATMOSPHERIC si el gateway lo acepta. */
+        CAP_LINK_ADR = 0x10,           /**< Responde en el perfil de radio ordenado por LINK_PROFILE. */
+        CAP_BROADCAST_POLL = 0x20,     /**< Responde en su slot el REQUEST_DATA_ATMOSPHERIC broadcast (PollWindow). */
+        CAP_BATCH_SEQUENCE = 0x40,     /**< Numera sus lotes con BatchHeader si el gateway lo acepta. */
+        CAP_GROUND_CACHE = 0x80        /**< Lee suelo/GPS de antemano y responde DATA_GPS_CROUND enseguida. */
+    };
+
+    /**
+     * @struct HelloPacket
+     * @brief Payload binario del HELLO (9 bytes contra 18 de la MAC en texto).
+     *
+     * Se envía y se recibe tal cual: no tiene campos multibyte que convertir.
+     */
+    struct HelloPacket {
+        uint8_t mac[6];           ///< MAC WiFi del nodo en binario
+        uint8_t protocolVersion;  ///< PROTOCOL_VERSION del firmware del nodo
+        uint8_t firmwareVersion;  ///< Versión del firmware del nodo (FIRMWARE_VERSION)
+        uint8_t capabilities;     ///< Bitmap de Capability
+    };
+
+    /**
+     * @struct LinkProfileCommand
+     * @brief Payload de LINK_PROFILE: perfil y potencia que el nodo usa para responder pedidos.
+     */
+    struct LinkProfileCommand {
+        uint8_t key;      ///< Protocol::KEY
+        uint8_t profile;  ///< Índice en RADIO_PROFILES
+        int8_t txPower;   ///< Potencia de transmisión en dBm
+    };
     #pragma pack(pop)
 
+    /**
+     * @struct RadioProfile
+     * @brief Modulación de un perfil de radio del ADR (siempre CR 4/5).
+     */
+    struct RadioProfile {
+        uint8_t spreadingFactor;  ///< SF 7-12
+        uint16_t bandwidthKhz;    ///< 125, 250 o 500 kHz
+    };
+
+    /**
+     * @brief Perfiles del ADR, del más robusto al más rápido.
+     *
+     * El tráfico de control (ANNOUNCE, HELLO, pedidos, rutas y reenvíos mesh)
+     * viaja siempre en RADIO_PROFILE_DEFAULT, la configuración por defecto de
+     * RH_RF95 (Bw125Cr45Sf128): un SX127x demodula un solo SF/BW a la vez y los
+     * nodos que reenvían tienen que escucharse entre sí. El perfil de un enlace
+     * solo se usa para la respuesta DATA_ATMOSPHERIC a un pedido y su ACK.
+     */
+    const RadioProfile RADIO_PROFILES[] = {
+        {12, 125}, {11, 125}, {10, 125}, {9, 125}, {8, 125}, {7, 125}, {7, 250}, {7, 500}
+    };
+    const uint8_t RADIO_PROFILE_COUNT = sizeof(RADIO_PROFILES) / sizeof(RADIO_PROFILES[0]);
+    const uint8_t RADIO_PROFILE_DEFAULT = 5;  ///< SF7 / 125 kHz
+
 } // namespace Protocol
 
 /**
@@ -1,21 +1,47 @@
 // RadioManager.cpp
 #include "radio_manager.h"
+#include "logger.h"
+
+namespace {
+    const uint8_t MESH_HEADER_LEN = RH_RF95_HEADER_LEN + 5 + 1;  ///< Cabeceras RH_RF95 + RHRouter + RHMesh
+    const uint8_t ACK_FRAME_LEN = RH_RF95_HEADER_LEN + 1;        ///< ACK de RHReliableDatagram
+    const uint8_t ROUTE_REQUEST_LEN = MESH_HEADER_LEN + 2;       ///< Pedido de ruta de RHMesh (destlen + dest)
+    const uint8_t AUTH_TRAILER_LEN = AUTH_ENABLED == 1 ? FrameAuth::OVERHEAD : 0;  ///< Contador + tag de FrameAuth
+    const uint8_t NETWORK_KEY[FrameAuth::KEY_LEN] = AUTH_NETWORK_KEY;
+
+    /** Tramas que FrameAuth sella como saludo (sal, desafío y eco). */
+    inline bool isGreeting(uint8_t flag)
+    {
+        return flag == Protocol::MessageType::HELLO || flag == Protocol::MessageType::ANNOUNCE;
+    }
+}
+
+static_assert(RX_QUEUE_FRAME_LEN >= sizeof(Protocol::BatchHeader) +
+                                        sizeof(Protocol::AtmosphericSample) * NUMERO_MUESTRAS_ATMOSFERICAS +
+                                        AUTH_TRAILER_LEN &&
+              RX_QUEUE_FRAME_LEN >= sizeof(Protocol::BatchHeader) + sizeof(Protocol::GroundGpsPacket) +
+                                        AUTH_TRAILER_LEN &&
+              RX_QUEUE_FRAME_LEN >= MAC_STR_LEN_WITH_NULL + AUTH_TRAILER_LEN &&
+              RX_QUEUE_FRAME_LEN >= sizeof(Protocol::HelloPacket) + FrameAuth::GREETING_OVERHEAD,
+              "RX_QUEUE_FRAME_LEN no alcanza para los mensajes del protocolo");
 
 RadioManager::RadioManager(uint8_t address)
-    : driver(RFM95_CS, RFM95_INT), manager(driver, address), failureCount(0)
+    : driver(RFM95_CS, RFM95_INT), manager(driver, address), dutyCycle(RADIO_FREQUENCY_KHZ),
+      auth(NETWORK_KEY, AUTH_COUNTER_BLOCK), greetingCount(0), routesSavedAt(0),
+      failureCount(0), profile(Protocol::RADIO_PROFILE_DEFAULT), hops(0), rssi(0), snr(0)
 {
 }
 
 bool RadioManager::init()
 {
-  Serial.println("[DEBUG] RadioManager::init INICIO");
+  LOG_D("RadioManager::init INICIO");
   // Configurar el pin de RESET como OUTPUT
   pinMode(RFM95_RST, OUTPUT);
   // Iniciar SPI
   
   while (!manager.init())
   {
-    Serial.println(" RF95 MESH init failed");
+    LOG_E("RF95 MESH init failed");
     // Baja el pin RST para poner el módulo en reset
     digitalWrite(RFM95_RST, LOW);
     delay(10); // Mantenerlo bajo por un corto tiempo
@@ -25,18 +51,67 @@ bool RadioManager::init()
     delay(100);
   }
 
-      Serial.printf("RF95 MESH init okay[DEBUG] RadioManager::init FIN\n");
+  LOG_I("RF95 MESH init okay");
+  driver.setFrequency(RADIO_FREQUENCY_KHZ / 1000.0f);
+  routes.begin();
+  if (AUTH_ENABLED == 1 && !auth.begin()) {
+    LOG_W("[RadioManager] Sin contador de FrameAuth guardado: contador desde 0 con la sal nueva");
+  }
   return true;
 }
 
 bool RadioManager::sendMessage(uint8_t to, uint8_t *data, uint8_t len, uint8_t flag)
 {
-    Serial.println("[DEBUG] RadioManager::sendMessage INICIO");
-    
+    LOG_D("RadioManager::sendMessage a 0x%02X, %u bytes, flag 0x%02X", to, len, flag);
+
     // Envía el mensaje y espera un acuse de recibo.
     // RH_ROUTER_ERROR_NONE indica una transmisión y acuse de recibo exitosos.
  
+    // Un HELLO o ANNOUNCE devuelve el desafío pendiente de to: ya no hace falta el saludo vacío
+    uint32_t echo = AUTH_ENABLED == 1 && isGreeting(flag) ? takeGreeting(to) : 0;
+    if (DUTY_CYCLE_ENFORCE == 1 && !canTransmit(len)) {
+        return false;  // No es un fallo de la radio: no cuenta para el reset
+    }
+    uint8_t sealed[RH_MESH_MAX_MESSAGE_LEN];
+    if (AUTH_ENABLED == 1) {
+        if (len > sizeof(sealed) - (isGreeting(flag) ? FrameAuth::GREETING_OVERHEAD : FrameAuth::OVERHEAD)) {
+            return false;
+        }
+        memcpy(sealed, data, len);
+        len = isGreeting(flag) ? auth.sealGreeting(manager.thisAddress(), to, flag, sealed, len, echo)
+                               : auth.seal(manager.thisAddress(), to, flag, sealed, len);
+        if (len == 0) {
+            LOG_E("[RadioManager] No se pudo reservar contador de FrameAuth en flash");
+            return false;
+        }
+        data = sealed;
+    }
+    fillRxQueue();  // sendtoWait() descarta lo que encuentre sin leer
+    bool hadRoute = true;
+    if (to != RH_BROADCAST_ADDRESS) {
+        seedRoute(to);
+        hadRoute = manager.getRouteTo(to) != nullptr;
+    }
+    uint32_t retransmissions = manager.retransmissions();
     uint8_t result = manager.sendtoWait(data, len, to, flag);
+    if (!hadRoute) {
+        // Pedido de ruta (broadcast) y ACK de la respuesta si llegó
+        recordAirtime(ROUTE_REQUEST_LEN);
+        if (result != RH_ROUTER_ERROR_NO_ROUTE) {
+            recordAirtime(ACK_FRAME_LEN);
+        }
+    }
+    if (result != RH_ROUTER_ERROR_NO_ROUTE) {
+        recordAirtime(MESH_HEADER_LEN + len, 1 + (manager.retransmissions() - retransmissions));
+    }
+    if (to != RH_BROADCAST_ADDRESS) {
+        // RHMesh borra la ruta si el próximo salto no confirmó; se olvida también la guardada
+        if (result == RH_ROUTER_ERROR_NONE) {
+            learnRoute(to);
+        } else if (result == RH_ROUTER_ERROR_NO_ROUTE || result == RH_ROUTER_ERROR_UNABLE_TO_DELIVER) {
+            routes.forget(to);
+        }
+    }
     
     if (result == RH_ROUTER_ERROR_NONE)
     {
@@ -48,7 +123,7 @@ bool RadioManager::sendMessage(uint8_t to, uint8_t *data, uint8_t len, uint8_t f
     {
         // Fallo: incrementar contador y verificar si necesita reset
         if (handleTransmissionFailure()) {
-            Serial.println("[RadioManager] Módulo reseteado automáticamente");
+            LOG_W("[RadioManager] Módulo reseteado automáticamente");
         }
         return false;
     }
@@ -56,63 +131,277 @@ bool RadioManager::sendMessage(uint8_t to, uint8_t *data, uint8_t len, uint8_t f
 
 bool RadioManager::recvMessage(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flag)
 {
-  uint8_t dest;
-  uint8_t id;
-  // Intenta recibir un mensaje reconocido.
-  if (manager.recvfromAck(buf, len, from, &dest, &id, flag))
-  {
-    return true; // Mensaje recibido con éxito.
+  fillRxQueue();
+  RxFrame frame;
+  if (!rxQueue.pop(frame)) {
+    return false; // No hay mensajes recibidos.
   }
-  return false; // No se recibió ningún mensaje o falló el acuse de recibo.
+  uint8_t copy = frame.len < *len ? frame.len : *len;
+  memcpy(buf, frame.data, copy);
+  *len = copy;
+  *from = frame.from;
+  *flag = frame.flag;
+  hops = frame.hops;
+  rssi = frame.rssi;
+  snr = frame.snr;
+  return true;
 }
 
 bool RadioManager::recvMessageTimeout(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flag, uint16_t timeout)
 {
-  uint8_t dest;      // Variable interna para la dirección de destino
-  uint8_t messageId; // Variable interna para el ID del mensaje de RadioHead
+  fillRxQueue();
+  if (rxQueue.count() == 0) {
+    // Cola vacía: claim() no puede fallar; se espera la próxima trama directamente en ella
+    if (!receiveFrame(*rxQueue.claim(), timeout)) {
+      return false; // No se recibió un mensaje reconocido dentro del tiempo
+    }
+    rxQueue.commit();
+  }
+  return recvMessage(buf, len, from, flag);
+}
 
-  // Llama a manager.recvfromAckTimeout con los parámetros adecuados
-  // Los punteros 'from', 'dest', 'messageId' y 'flags' deben ser proporcionados a la función.
-  // En tu caso, necesitas el 'from' y el 'flag' que se pasan,
-  // y 'dest' y 'messageId' se pueden usar como variables temporales internas.
-  // La función recvfromAckTimeout es:
-  // bool recvfromAckTimeout(uint8_t* buf, uint8_t* len, uint16_t timeout, uint8_t* from = NULL, uint8_t* dest = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
+/**
+ * @brief Persiste las rutas aprendidas.
+ *
+ * RHMesh maneja internamente el reintento y el enrutamiento; aquí solo se
+ * guarda RouteCache en flash, como mucho una vez cada
+ * ROUTE_CACHE_SAVE_INTERVAL_MS para no gastar la flash con cada cambio.
+ */
+void RadioManager::update()
+{
+  fillRxQueue();
+  // Saludos vacíos pendientes; sendMessage() saca cada uno de la cola aunque no salga
+  for (uint8_t i = 0; i < GREETING_QUEUE && greetingCount > 0; i++) {
+    uint8_t empty[1];
+    sendMessage(greetings[0].peer, empty, 0, Protocol::MessageType::HELLO);
+  }
+  unsigned long now = millis();
+  if (routes.dirty() && now - routesSavedAt >= ROUTE_CACHE_SAVE_INTERVAL_MS) {
+    routesSavedAt = now;
+    if (!routes.save()) {
+      LOG_W("[RadioManager] No se pudieron guardar las rutas");
+    }
+  }
+}
 
-  // Aquí, 'flag' del parámetro de tu función se mapea a 'flags' de recvfromAckTimeout
-  // y 'from' de tu función se mapea a 'from' de recvfromAckTimeout.
-  // 'dest' y 'messageId' son variables temporales que no necesitas devolver.
-  if (manager.recvfromAckTimeout(buf, len, timeout, from, &dest, &messageId, flag))
-  {
-    // Mensaje recibido y reconocido con éxito dentro del tiempo
+/**
+ * @brief Descubre la ruta a un nodo fuera de un ciclo de sondeo.
+ *
+ * Es el mismo pedido de ruta que haría sendtoWait() en el primer envío, pero
+ * lo lanza AppLogic en un momento ocioso.
+ */
+bool RadioManager::discoverRoute(uint8_t to)
+{
+  uint8_t nextHop;
+  if (routes.lookup(to, nextHop)) {
     return true;
   }
-  // No se recibió un mensaje reconocido dentro del tiempo
-  return false;
+  if (DUTY_CYCLE_ENFORCE == 1 && !canTransmit(ROUTE_REQUEST_LEN - MESH_HEADER_LEN)) {
+    return false;
+  }
+  fillRxQueue();
+  recordAirtime(ROUTE_REQUEST_LEN);
+  if (!manager.discoverRoute(to)) {
+    LOG_D("[RadioManager] Sin ruta a 0x%02X", to);
+    return false;
+  }
+  recordAirtime(ACK_FRAME_LEN);
+  learnRoute(to);
+  return true;
+}
+
+const RouteCache &RadioManager::getRoutes() const
+{
+  return routes;
+}
+
+uint32_t RadioManager::timeOnAirUs(uint8_t len) const
+{
+  const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[profile];
+  return DutyCycle::timeOnAirUs(MESH_HEADER_LEN + len + AUTH_TRAILER_LEN, p.spreadingFactor, p.bandwidthKhz);
+}
+
+bool RadioManager::canTransmit(uint8_t len)
+{
+  return DUTY_CYCLE_ENFORCE != 1 || dutyCycle.allows(timeOnAirUs(len), millis());
+}
+
+DutyCycle &RadioManager::getDutyCycle()
+{
+  return dutyCycle;
+}
+
+const RxQueue &RadioManager::getRxQueue() const
+{
+  return rxQueue;
+}
+
+const FrameAuth &RadioManager::getAuth() const
+{
+  return auth;
+}
+
+void RadioManager::fillRxQueue()
+{
+  for (uint8_t i = 0; i < RX_QUEUE_DEPTH && manager.available(); i++) {
+    RxFrame *slot = rxQueue.claim();
+    if (slot == nullptr) {
+      return;  // Cola llena: la trama espera en la radio
+    }
+    if (receiveFrame(*slot, 0)) {
+      rxQueue.commit();
+    }
+  }
+}
+
+bool RadioManager::receiveFrame(RxFrame &frame, uint16_t timeout)
+{
+  uint8_t dest;
+  uint8_t id;
+  uint8_t len = sizeof(frame.data);
+  bool ok = timeout == 0
+      ? manager.recvfromAck(frame.data, &len, &frame.from, &dest, &id, &frame.flag, &frame.hops)
+      : manager.recvfromAckTimeout(frame.data, &len, timeout, &frame.from, &dest, &id, &frame.flag, &frame.hops);
+  if (!ok) {
+    return false;  // Nada recibido, o tráfico interno de RHMesh (rutas, reenvíos)
+  }
+  if (dest != RH_BROADCAST_ADDRESS) {
+    recordAirtime(ACK_FRAME_LEN);
+  }
+  if (AUTH_ENABLED == 1) {
+    uint32_t challenge = 0;
+    FrameAuth::Result result = isGreeting(frame.flag)
+        ? auth.openGreeting(frame.from, dest, frame.flag, frame.data, len, challenge)
+        : auth.open(frame.from, dest, frame.flag, frame.data, len);
+    if (result == FrameAuth::UNKNOWN || result == FrameAuth::FORGED || result == FrameAuth::STALE ||
+        (result == FrameAuth::OK && challenge != 0)) {
+      // Sin sesión con el remitente, o pidió una: se le responde con un saludo
+      queueGreeting(frame.from, challenge);
+    }
+    if (result != FrameAuth::OK) {
+      LOG_W("[RadioManager] Trama 0x%02X de 0x%02X descartada por FrameAuth (%u)", frame.flag, frame.from, result);
+      return false;
+    }
+    if (isGreeting(frame.flag) && len == 0) {
+      learnRoute(frame.from);
+      return false;  // Saludo vacío: solo abre la sesión, no es para la aplicación
+    }
+  }
+  frame.len = len;
+  frame.rssi = driver.lastRssi();
+  frame.snr = (int8_t)driver.lastSNR();
+  learnRoute(frame.from);
+  return true;
+}
+
+void RadioManager::queueGreeting(uint8_t to, uint32_t echo)
+{
+  if (to == RH_BROADCAST_ADDRESS) {
+    return;
+  }
+  for (uint8_t i = 0; i < greetingCount; i++) {
+    if (greetings[i].peer == to) {
+      if (echo != 0) {
+        greetings[i].echo = echo;
+      }
+      return;
+    }
+  }
+  if (greetingCount == GREETING_QUEUE) {
+    return;  // El remitente vuelve a pedir con su próxima trama
+  }
+  greetings[greetingCount].peer = to;
+  greetings[greetingCount].echo = echo;
+  greetingCount++;
+}
+
+uint32_t RadioManager::takeGreeting(uint8_t to)
+{
+  for (uint8_t i = 0; i < greetingCount; i++) {
+    if (greetings[i].peer == to) {
+      uint32_t echo = greetings[i].echo;
+      memmove(&greetings[i], &greetings[i + 1], (greetingCount - i - 1) * sizeof(Greeting));
+      greetingCount--;
+      return echo;
+    }
+  }
+  return 0;
+}
+
+void RadioManager::recordAirtime(uint8_t frameLen, uint32_t frames)
+{
+  const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[profile];
+  dutyCycle.record(DutyCycle::timeOnAirUs(frameLen, p.spreadingFactor, p.bandwidthKhz) * frames, millis());
+}
+
+void RadioManager::seedRoute(uint8_t to)
+{
+  uint8_t nextHop;
+  if (manager.getRouteTo(to) == nullptr && routes.lookup(to, nextHop)) {
+    // Si la tabla está llena RHRouter descarta la más vieja; también está en routes
+    manager.addRouteTo(to, nextHop);
+  }
+}
+
+void RadioManager::learnRoute(uint8_t to)
+{
+  RHRouter::RoutingTableEntry *route = manager.getRouteTo(to);
+  if (route != nullptr && route->state == RHRouter::Valid) {
+    routes.learn(to, route->next_hop);
+  }
 }
 
 /**
- * @brief Método de marcador de posición para actualizar el estado interno del gestor de radio.
+ * @brief Cambia SF, ancho de banda y potencia sin reiniciar el módulo.
  *
- * Actualmente, la librería RHMesh maneja la mayoría de sus procesos internos (como
- * retransmisión, actualizaciones de la tabla de enrutamiento y manejo de acuses de recibo) automáticamente.
- * Este método se proporciona como un marcador de posición vacío para futuras expansiones o
- * si son necesarias tareas periódicas específicas relacionadas con la gestión de radio.
- * Por ejemplo, podría usarse para la gestión de energía personalizada, sondeo de estado,
- * o lógica de enrutamiento avanzada si el comportamiento predeterminado de RHMesh es insuficiente.
+ * Parte de Bw125Cr45Sf128 (default de RH_RF95) para dejar CR 4/5 y CRC; el
+ * driver ajusta LowDataRateOptimize según SF y ancho de banda.
  */
-void RadioManager::update()
+bool RadioManager::applyProfile(uint8_t newProfile, int8_t txPower)
+{
+    if (newProfile >= Protocol::RADIO_PROFILE_COUNT) {
+        return false;
+    }
+    const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[newProfile];
+    driver.setModemConfig(RH_RF95::Bw125Cr45Sf128);
+    driver.setSignalBandwidth((long)p.bandwidthKhz * 1000);
+    driver.setSpreadingFactor(p.spreadingFactor);
+    driver.setTxPower(txPower);
+    // El ACK dura ~25 símbolos: a SF12/125 kHz el timeout por defecto reenviaría antes de recibirlo
+    uint32_t symbolUs = ((uint32_t)1 << p.spreadingFactor) * 1000UL / p.bandwidthKhz;
+    manager.setTimeout(RH_DEFAULT_TIMEOUT + (uint16_t)(30 * symbolUs / 1000));
+    profile = newProfile;
+    LOG_D("[RadioManager] Perfil %u: SF%u, %u kHz, %d dBm", newProfile, p.spreadingFactor, p.bandwidthKhz, txPower);
+    return true;
+}
+
+uint8_t RadioManager::getProfile() const
+{
+    return profile;
+}
+
+int8_t RadioManager::lastSnr()
+{
+    return snr;
+}
+
+int16_t RadioManager::lastRssi()
+{
+    return rssi;
+}
+
+uint8_t RadioManager::lastHops() const
 {
-  // RHMesh maneja internamente el reintento y enrutamiento.
-  // Este método se reserva para futuras ampliaciones si se requiere.
+    return hops;
 }
 
 bool RadioManager::handleTransmissionFailure()
 {
     failureCount++;
-    Serial.printf("[RadioManager] Fallo de transmisión #%d/%d\n", failureCount, RADIO_MAX_FAILURES);
+    LOG_W("[RadioManager] Fallo de transmisión #%d/%d", failureCount, RADIO_MAX_FAILURES);
     
     if (failureCount >= RADIO_MAX_FAILURES) {
-        Serial.println("[RadioManager] Máximo de fallos alcanzado, reseteando módulo...");
+        LOG_E("[RadioManager] Máximo de fallos alcanzado, reseteando módulo...");
         forceRadioReset();
         return true;
     }
@@ -122,7 +411,7 @@ bool RadioManager::handleTransmissionFailure()
 void RadioManager::resetFailureCounter()
 {
     if (failureCount > 0) {
-        Serial.printf("[RadioManager] Reset contador de fallos (era %d)\n", failureCount);
+        LOG_D("[RadioManager] Reset contador de fallos (era %d)", failureCount);
         failureCount = 0;
     }
 }
@@ -134,7 +423,7 @@ uint8_t RadioManager::getFailureCount() const
 
 void RadioManager::forceRadioReset()
 {
-    Serial.println("[RadioManager] Iniciando reset forzado del módulo radio...");
+    LOG_W("[RadioManager] Iniciando reset forzado del módulo radio...");
     
     // Reset del módulo usando el pin RST
     digitalWrite(RFM95_RST, LOW);
@@ -144,9 +433,11 @@ void RadioManager::forceRadioReset()
     
     // Reinicializar el módulo
     if (manager.init()) {
-        Serial.println("[RadioManager] Reset exitoso, módulo reinicializado");
+        LOG_I("[RadioManager] Reset exitoso, módulo reinicializado");
+        driver.setFrequency(RADIO_FREQUENCY_KHZ / 1000.0f);
+        profile = Protocol::RADIO_PROFILE_DEFAULT;  // init() deja la configuración por defecto
         failureCount = 0; // Resetear contador después del reset exitoso
     } else {
-        Serial.println("[RadioManager] ERROR: Fallo en reinicialización después del reset");
+        LOG_E("[RadioManager] Fallo en reinicialización después del reset");
     }
 }
@@ -6,6 +6,27 @@
 #include <RH_RF95.h>
 #include <SPI.h>
 #include "config.h"
+#include "protocol.h"
+#include "route_cache.h"
+#include "duty_cycle.h"
+#include "rx_queue.h"
+#include "frame_auth.h"
+
+/**
+ * @class GatewayMesh
+ * @brief RHMesh con el descubrimiento de ruta expuesto (doArp() es protegido).
+ */
+class GatewayMesh : public RHMesh
+{
+public:
+    using RHMesh::RHMesh;
+
+    /**
+     * @brief Descubre la ruta a un nodo sin enviarle datos
+     * @details Bloquea hasta la respuesta o RH_MESH_ARP_TIMEOUT.
+     */
+    bool discoverRoute(uint8_t address) { return doArp(address); }
+};
 
 /**
  * @class RadioManager
@@ -38,12 +59,14 @@ public:
      * @param data Puntero al buffer de datos a enviar.
      * @param len Longitud del mensaje en bytes.
      * @param flag Tipo de mensaje/protocolo (ver protocol.h).
-     * @return true si el mensaje fue enviado y reconocido, false en caso contrario.
+     * @return true si el mensaje fue enviado y reconocido, false en caso contrario
+     * (también si no entra en el presupuesto de ciclo de trabajo, sin contar como fallo).
      */
     bool sendMessage(uint8_t to, uint8_t *data, uint8_t len, uint8_t flag);
 
     /**
-     * @brief Intenta recibir un mensaje de la red mesh LoRa.
+     * @brief Saca el próximo mensaje recibido de la cola (después de vaciar la radio en ella).
+     * @details lastRssi(), lastSnr() y lastHops() pasan a ser los de este mensaje.
      * @param buf Buffer donde se almacenará el mensaje recibido.
      * @param len Puntero a la longitud máxima; al regresar, contiene la longitud real.
      * @param from Puntero a la dirección del remitente.
@@ -53,7 +76,7 @@ public:
     bool recvMessage(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flag);
 
     /**
-     * @brief Intenta recibir un mensaje con timeout.
+     * @brief Como recvMessage(), pero si la cola está vacía espera el próximo mensaje.
      * @param buf Buffer donde se almacenará el mensaje recibido.
      * @param len Puntero a la longitud máxima; al regresar, contiene la longitud real.
      * @param from Puntero a la dirección del remitente.
@@ -64,9 +87,78 @@ public:
     bool recvMessageTimeout(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flag, uint16_t timeout);
 
     /**
-     * @brief Actualiza el estado interno del gestor de radio (placeholder para futuras extensiones).
+     * @brief Envía los saludos de FrameAuth pendientes y guarda las rutas en flash si cambiaron y pasó
+     * ROUTE_CACHE_SAVE_INTERVAL_MS.
      */
     void update();
+
+    /**
+     * @brief Descubre la ruta a un nodo si no hay una conocida.
+     * @return true si hay ruta al terminar.
+     */
+    bool discoverRoute(uint8_t to);
+
+    /**
+     * @brief Próximos saltos conocidos (diagnóstico; ver RouteCache::dump()).
+     */
+    const RouteCache &getRoutes() const;
+
+    /**
+     * @brief Tiempo en el aire de un mensaje con el perfil actual.
+     * @param len Bytes de payload (sin las cabeceras de RadioHead ni el sello de FrameAuth).
+     * @return Microsegundos de una transmisión, sin reintentos.
+     */
+    uint32_t timeOnAirUs(uint8_t len) const;
+
+    /**
+     * @brief Indica si un mensaje de len bytes entra en el presupuesto de ciclo de trabajo.
+     * @details Para que quien planifica posponga el envío en lugar de que
+     * sendMessage() lo rechace. Siempre true con DUTY_CYCLE_ENFORCE en 0.
+     */
+    bool canTransmit(uint8_t len);
+
+    /**
+     * @brief Tiempo en el aire transmitido por el gateway y presupuesto de la sub-banda.
+     */
+    DutyCycle &getDutyCycle();
+
+    /**
+     * @brief Tramas recibidas que todavía no se despacharon (diagnóstico).
+     */
+    const RxQueue &getRxQueue() const;
+
+    /**
+     * @brief Contador propio y tramas rechazadas por FrameAuth (diagnóstico)
+     */
+    const FrameAuth &getAuth() const;
+
+    /**
+     * @brief Cambia la modulación y la potencia de la radio.
+     * @param profile Índice en Protocol::RADIO_PROFILES.
+     * @param txPower Potencia de transmisión en dBm.
+     * @return false si el perfil no existe.
+     */
+    bool applyProfile(uint8_t profile, int8_t txPower = RADIO_TX_POWER);
+
+    /**
+     * @brief Perfil actual de la radio (índice en Protocol::RADIO_PROFILES).
+     */
+    uint8_t getProfile() const;
+
+    /**
+     * @brief SNR en dB de la última trama recibida.
+     */
+    int8_t lastSnr();
+
+    /**
+     * @brief RSSI en dBm de la última trama recibida.
+     */
+    int16_t lastRssi();
+
+    /**
+     * @brief Saltos de la última trama recibida (0 = vecino directo).
+     */
+    uint8_t lastHops() const;
     
     /**
      * @brief Incrementa el contador de fallos y resetea el módulo si es necesario.
@@ -91,9 +183,69 @@ public:
     void forceRadioReset();
 
 private:
+    static const uint8_t GREETING_QUEUE = 8;  ///< Saludos vacíos de FrameAuth esperando update()
+
+    /** Saludo vacío (HELLO del gateway) que abre una sesión de FrameAuth con un nodo. */
+    struct Greeting {
+        uint8_t peer;    ///< Nodo destino
+        uint32_t echo;   ///< Desafío del nodo que se devuelve (0 = ninguno)
+    };
+
     RH_RF95 driver;  ///< Controlador de radio LoRa (bajo nivel)
-    RHMesh manager;  ///< Gestor de red mesh (enrutamiento y lógica mesh)
+    GatewayMesh manager;  ///< Gestor de red mesh (enrutamiento y lógica mesh)
+    RouteCache routes;    ///< Rutas de todos los nodos; RHRouter solo guarda RH_ROUTING_TABLE_SIZE
+    DutyCycle dutyCycle;  ///< Tiempo en el aire de todo lo que transmite el gateway
+    RxQueue rxQueue;      ///< Tramas recibidas en espera de recvMessage()
+    FrameAuth auth;       ///< Sellado de lo enviado y verificación de lo recibido (AUTH_ENABLED)
+    Greeting greetings[GREETING_QUEUE];  ///< Saludos pendientes, en orden de llegada
+    uint8_t greetingCount;               ///< Entradas en uso de greetings
+    unsigned long routesSavedAt;  ///< millis() del último guardado de routes
     uint8_t failureCount;  ///< Contador de fallos consecutivos
+    uint8_t profile;       ///< Perfil actual (Protocol::RADIO_PROFILES)
+    uint8_t hops;          ///< Saltos de la última trama recibida
+    int16_t rssi;          ///< RSSI de la última trama recibida
+    int8_t snr;            ///< SNR de la última trama recibida
+
+    /**
+     * @brief Carga en RHRouter la ruta guardada si la tabla no la tiene
+     */
+    void seedRoute(uint8_t to);
+
+    /**
+     * @brief Copia a routes la ruta que RHRouter tiene hacia un nodo
+     */
+    void learnRoute(uint8_t to);
+
+    /**
+     * @brief Agenda un saludo a un nodo sin sesión o que pidió una (lo envía update())
+     * @param echo Desafío que trajo su saludo (0 = ninguno)
+     */
+    void queueGreeting(uint8_t to, uint32_t echo);
+
+    /**
+     * @brief Saca de la cola el saludo pendiente para to
+     * @return Desafío a devolver (0 si no había saludo o no trae eco)
+     */
+    uint32_t takeGreeting(uint8_t to);
+
+    /**
+     * @brief Anota en dutyCycle frames tramas de frameLen bytes con el perfil actual
+     */
+    void recordAirtime(uint8_t frameLen, uint32_t frames = 1);
+
+    /**
+     * @brief Pasa a rxQueue las tramas que esperan en la radio
+     * @details Se llama antes de cada transmisión: RHReliableDatagram::sendtoWait()
+     * y el descubrimiento de ruta leen y descartan sin ACK lo que encuentren.
+     */
+    void fillRxQueue();
+
+    /**
+     * @brief Recibe (y confirma) una trama de la radio
+     * @param timeout 0 = solo si ya hay una; si no, espera hasta timeout ms
+     * @return false si no llegó una trama para la aplicación o no abrió con FrameAuth
+     */
+    bool receiveFrame(RxFrame &frame, uint16_t timeout);
 };
 
 #endif // RADIO_MANAGER_H
@@ -0,0 +1,127 @@
+/**
+ * @file route_cache.cpp
+ * @brief Implementación de la tabla persistente de próximos saltos
+ */
+
+#include "route_cache.h"
+#include "crc8.h"
+#include "logger.h"
+
+namespace {
+    const char *ROUTE_CACHE_FILE = "/routes.bin";
+}
+
+RouteCache::RouteCache() : routeCount(0), changed(false), mounted(false)
+{
+    memset(nextHops, NO_ROUTE, sizeof(nextHops));
+}
+
+bool RouteCache::begin()
+{
+    // OutboxQueue formatea si no monta; aquí solo se lee lo que haya
+    mounted = LittleFS.begin();
+    if (!mounted || !LittleFS.exists(ROUTE_CACHE_FILE)) {
+        return false;
+    }
+    File file = LittleFS.open(ROUTE_CACHE_FILE, "r");
+    uint8_t crc = 0;
+    bool ok = file && file.read(nextHops, sizeof(nextHops)) == sizeof(nextHops) &&
+              file.read(&crc, 1) == 1 && crc == checksum();
+    file.close();
+    if (!ok) {
+        LOG_W("RouteCache::begin(): %s invalido, se descarta.", ROUTE_CACHE_FILE);
+        memset(nextHops, NO_ROUTE, sizeof(nextHops));
+        return false;
+    }
+    routeCount = 0;
+    for (uint16_t dest = 0; dest < 256; dest++) {
+        if (nextHops[dest] != NO_ROUTE) {
+            routeCount++;
+        }
+    }
+    LOG_I("RouteCache: %u rutas restauradas", routeCount);
+    return true;
+}
+
+bool RouteCache::learn(uint8_t dest, uint8_t nextHop)
+{
+    if (nextHop == NO_ROUTE || nextHops[dest] == nextHop) {
+        return false;
+    }
+    if (nextHops[dest] == NO_ROUTE) {
+        routeCount++;
+    }
+    nextHops[dest] = nextHop;
+    changed = true;
+    return true;
+}
+
+void RouteCache::forget(uint8_t dest)
+{
+    if (nextHops[dest] != NO_ROUTE) {
+        nextHops[dest] = NO_ROUTE;
+        routeCount--;
+        changed = true;
+    }
+}
+
+bool RouteCache::lookup(uint8_t dest, uint8_t &nextHop) const
+{
+    nextHop = nextHops[dest];
+    return nextHop != NO_ROUTE;
+}
+
+uint16_t RouteCache::count() const
+{
+    return routeCount;
+}
+
+bool RouteCache::dirty() const
+{
+    return changed;
+}
+
+bool RouteCache::save()
+{
+    if (!mounted && !(mounted = LittleFS.begin())) {
+        return false;
+    }
+    File file = LittleFS.open(ROUTE_CACHE_FILE, "w");
+    if (!file) {
+        return false;
+    }
+    uint8_t crc = checksum();
+    bool ok = file.write(nextHops, sizeof(nextHops)) == sizeof(nextHops) && file.write(&crc, 1) == 1;
+    file.close();
+    if (ok) {
+        changed = false;
+        LOG_D("RouteCache: %u rutas guardadas", routeCount);
+    }
+    return ok;
+}
+
+void RouteCache::dump() const
+{
+    const bool viaRing = LOG_SERIAL_LEVEL < LOG_LEVEL_INFO;
+    LOG_I("--- Rutas: %u ---", routeCount);
+    for (uint16_t dest = 0; dest < 256; dest++) {
+        if (nextHops[dest] != NO_ROUTE) {
+            if (viaRing && Log::count() == LOG_RING_ENTRIES) {
+                Log::dump();
+            }
+            LOG_I("0x%02X -> 0x%02X%s", dest, nextHops[dest], nextHops[dest] == dest ? " (directo)" : "");
+        }
+    }
+    LOG_I("--- Fin de rutas ---");
+    if (viaRing) {
+        Log::dump();
+    }
+}
+
+/**
+ * @brief CRC-8 (polinomio 0x07, valor inicial 0xFF) de la tabla
+ */
+uint8_t RouteCache::checksum() const
+{
+    return Crc8::compute(nextHops, sizeof(nextHops));
+}
@@ -0,0 +1,100 @@
+/**
+ * @file route_cache.h
+ * @brief Próximo salto hacia cada nodo, persistido en LittleFS
+ * @date 2025
+ *
+ * La tabla de RHRouter tiene RH_ROUTING_TABLE_SIZE (10) entradas y se vacía
+ * en cada init(): con más nodos, o después de un reinicio, cada envío a un
+ * nodo fuera de la tabla dispara un descubrimiento de ruta (una inundación de
+ * toda la red). RouteCache guarda el próximo salto de los 256 IDs posibles
+ * (256 bytes) y RadioManager lo carga en RHRouter antes de cada envío, así
+ * que solo se descubre la ruta de un nodo nuevo o de uno cuya ruta falló.
+ *
+ * Formato en flash (/routes.bin): 256 bytes de próximo salto
+ * (NO_ROUTE = sin ruta) seguidos de un CRC-8. Si el archivo no existe o el CRC
+ * no coincide (corte de energía al guardar) se arranca sin rutas.
+ */
+
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "config.h"
+
+/**
+ * @class RouteCache
+ * @brief Tabla de próximos saltos indexada por ID de nodo.
+ *
+ * @example
+ * ```cpp
+ * routes.begin();                      // carga /routes.bin
+ * routes.learn(from, route->next_hop); // tras recibir o enviar
+ * uint8_t hop;
+ * if (routes.lookup(dest, hop)) manager.addRouteTo(dest, hop);
+ * if (routes.dirty()) routes.save();
+ * ```
+ */
+class RouteCache
+{
+public:
+    static const uint8_t NO_ROUTE = 0xFF;  ///< Sin ruta (el broadcast nunca es próximo salto)
+
+    RouteCache();
+
+    /**
+     * @brief Monta LittleFS y carga las rutas guardadas
+     * @return false si no hay sistema de archivos o no hay rutas válidas guardadas
+     */
+    bool begin();
+
+    /**
+     * @brief Registra el próximo salto hacia un nodo
+     * @return true si la ruta es nueva o cambió
+     */
+    bool learn(uint8_t dest, uint8_t nextHop);
+
+    /**
+     * @brief Olvida la ruta hacia un nodo (falló la entrega o el descubrimiento)
+     */
+    void forget(uint8_t dest);
+
+    /**
+     * @brief Próximo salto conocido hacia un nodo
+     * @return false si no hay ruta
+     */
+    bool lookup(uint8_t dest, uint8_t &nextHop) const;
+
+    /**
+     * @brief Cantidad de nodos con ruta
+     */
+    uint16_t count() const;
+
+    /**
+     * @brief Hay cambios sin guardar en flash
+     */
+    bool dirty() const;
+
+    /**
+     * @brief Escribe la tabla completa en /routes.bin
+     * @return false si no hay sistema de archivos o falló la escritura
+     */
+    bool save();
+
+    /**
+     * @brief Registra la tabla con LOG_I ("destino -> próximo salto") y la imprime
+     * @details Si LOG_SERIAL_LEVEL no imprime LOG_I en el momento, el anillo de
+     * Log se vuelca cada vez que se llena y al final, así que ninguna ruta se pisa.
+     */
+    void dump() const;
+
+private:
+    uint8_t nextHops[256];
+    uint16_t routeCount;
+    bool changed;
+    bool mounted;
+
+    uint8_t checksum() const;
+};
+
+#endif // ROUTE_CACHE_H
@@ -5,6 +5,7 @@
  */
 
 #include "rtc_manager.h"
+#include "logger.h"
 
 // Constructor
 RtcManager::RtcManager() : initialized(false) {
@@ -12,7 +13,7 @@ RtcManager::RtcManager() : initialized(false) {
 
 // Inicializa el RTC
 bool RtcManager::begin() {
-    Serial.printf("RtcManager::begin() - Iniciando DS1307\n");
+    LOG_D("RtcManager::begin() - Iniciando DS1307");
     
     // Inicializar I2C
     Wire.begin();
@@ -33,19 +34,19 @@ bool RtcManager::begin() {
     }
     
     if (!foundDS1307) {
-        Serial.printf("RtcManager::begin() - ERROR: DS1307 no encontrado\n");
+        LOG_E("RtcManager::begin() - DS1307 no encontrado");
         return false;
     }
     
     // Inicializar RTC DS1307
     if (!rtc.begin()) {
-        Serial.printf("RtcManager::begin() - ERROR: No se pudo inicializar DS1307\n");
+        LOG_E("RtcManager::begin() - No se pudo inicializar DS1307");
         return false;
     }
     
     // Verificar si el RTC está funcionando
     if (!rtc.isrunning()) {
-        Serial.printf("RtcManager::begin() - Configurando RTC con fecha de compilación\n");
+        LOG_W("RtcManager::begin() - Configurando RTC con fecha de compilación");
         
         // Configurar con fecha de compilación
         rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
@@ -53,7 +54,7 @@ bool RtcManager::begin() {
         // Verificar que se configuró correctamente
         delay(100);
         if (!rtc.isrunning()) {
-            Serial.printf("RtcManager::begin() - ERROR: RTC no responde después de configuración\n");
+            LOG_E("RtcManager::begin() - RTC no responde después de configuración");
             return false;
         }
     }
@@ -63,16 +64,16 @@ bool RtcManager::begin() {
     
     // Verificar que la fecha sea válida
     if (now.year() < 2000 || now.year() > 2100) {
-        Serial.printf("RtcManager::begin() - ADVERTENCIA: Año fuera de rango válido (%d)\n", now.year());
+        LOG_W("RtcManager::begin() - Año fuera de rango válido (%d)", now.year());
     }
     
     // Verificar que la hora sea razonable
     if (now.hour() > 23 || now.minute() > 59 || now.second() > 59) {
-        Serial.printf("RtcManager::begin() - ERROR: Hora inválida\n");
+        LOG_E("RtcManager::begin() - Hora inválida");
         return false;
     }
     
-    Serial.printf("RtcManager::begin() - DS1307 inicializado correctamente\n");
+    LOG_I("RtcManager::begin() - DS1307 inicializado correctamente");
     
     initialized = true;
     return true;
@@ -164,11 +165,7 @@ bool RtcManager::compareHsAndMs(const String& time1, const String& time2) {
 
 // Imprime la fecha y hora en formato legible
 void RtcManager::printDateTime(const DateTime& dt) {
-    char datestring[26];
-    sprintf(datestring, "%04d-%02d-%02d %02d:%02d:%02d", 
-            dt.year(), dt.month(), dt.day(), 
-            dt.hour(), dt.minute(), dt.second());
-    Serial.printf("%s", datestring);
+    LOG_I("%04d-%02d-%02d %02d:%02d", dt.year(), dt.month(), dt.day(), dt.hour(), dt.minute());
 }
 
 // Verifica si el RTC está funcionando
@@ -177,4 +174,4 @@ bool RtcManager::isRunning() {
         return false;
     }
     return rtc.isrunning();
-}
\ No newline at end of file
+}
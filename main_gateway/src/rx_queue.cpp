@@ -0,0 +1,57 @@
+/**
+ * @file rx_queue.cpp
+ * @brief Implementación de la cola de tramas recibidas
+ */
+
+#include "rx_queue.h"
+
+static_assert(RX_QUEUE_DEPTH > 0 && RX_QUEUE_DEPTH <= 255, "RX_QUEUE_DEPTH debe entrar en uint8_t");
+
+RxQueue::RxQueue() : head(0), queued(0), maxQueued(0), fullCount(0)
+{
+}
+
+RxFrame *RxQueue::claim()
+{
+    if (queued >= RX_QUEUE_DEPTH) {
+        fullCount++;
+        return nullptr;
+    }
+    return &frames[(head + queued) % RX_QUEUE_DEPTH];
+}
+
+void RxQueue::commit()
+{
+    if (queued < RX_QUEUE_DEPTH) {
+        queued++;
+        if (queued > maxQueued) {
+            maxQueued = queued;
+        }
+    }
+}
+
+bool RxQueue::pop(RxFrame &frame)
+{
+    if (queued == 0) {
+        return false;
+    }
+    frame = frames[head];
+    head = (uint8_t)((head + 1) % RX_QUEUE_DEPTH);
+    queued--;
+    return true;
+}
+
+uint8_t RxQueue::count() const
+{
+    return queued;
+}
+
+uint8_t RxQueue::peak() const
+{
+    return maxQueued;
+}
+
+uint32_t RxQueue::overflows() const
+{
+    return fullCount;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file rx_queue.h
+ * @brief Cola acotada de tramas recibidas entre la radio y el despacho de AppLogic
+ * @date 2025
+ *
+ * El RF95 guarda una sola trama recibida y RHReliableDatagram::sendtoWait()
+ * descarta sin ACK la que encuentre sin leer mientras espera el ACK propio:
+ * cada envío del gateway podía costar una trama ajena, que el nodo tenía que
+ * reintentar. RadioManager vacía el buffer de la radio en esta cola antes de
+ * cada transmisión y en cada update(); AppLogic despacha después las tramas
+ * según su Protocol::MessageType.
+ *
+ * Las tramas se guardan por valor en un anillo de RX_QUEUE_DEPTH entradas de
+ * RX_QUEUE_FRAME_LEN bytes, sin heap.
+ */
+
+#ifndef RX_QUEUE_H
+#define RX_QUEUE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @struct RxFrame
+ * @brief Trama recibida con los datos del enlace al momento de recibirla.
+ */
+struct RxFrame {
+    uint8_t from;                     ///< Remitente
+    uint8_t flag;                     ///< Protocol::MessageType
+    uint8_t len;                      ///< Bytes válidos en data
+    uint8_t hops;                     ///< Saltos (0 = vecino directo)
+    int16_t rssi;                     ///< RSSI del último salto en dBm
+    int8_t snr;                       ///< SNR del último salto en dB
+    uint8_t data[RX_QUEUE_FRAME_LEN]; ///< Payload
+};
+
+/**
+ * @class RxQueue
+ * @brief Anillo FIFO de RxFrame.
+ *
+ * @example
+ * ```cpp
+ * RxFrame *slot = queue.claim();
+ * if (slot != nullptr && recibir(slot)) queue.commit();
+ * RxFrame frame;
+ * while (queue.pop(frame)) despachar(frame);
+ * ```
+ */
+class RxQueue
+{
+public:
+    RxQueue();
+
+    /**
+     * @brief Entrada libre al final de la cola para recibir directamente en ella
+     * @return nullptr si la cola está llena (la trama queda en la radio)
+     */
+    RxFrame *claim();
+
+    /**
+     * @brief Agrega a la cola la entrada devuelta por claim()
+     */
+    void commit();
+
+    /**
+     * @brief Saca la trama más vieja
+     * @return false si la cola está vacía
+     */
+    bool pop(RxFrame &frame);
+
+    uint8_t count() const;
+
+    /**
+     * @brief Mayor cantidad de tramas en espera desde el arranque
+     */
+    uint8_t peak() const;
+
+    /**
+     * @brief Veces que una trama quedó en la radio por estar la cola llena
+     */
+    uint32_t overflows() const;
+
+private:
+    RxFrame frames[RX_QUEUE_DEPTH];
+    uint8_t head;       ///< Próxima trama a sacar
+    uint8_t queued;     ///< Tramas en espera
+    uint8_t maxQueued;
+    uint32_t fullCount;
+};
+
+#endif // RX_QUEUE_H
@@ -0,0 +1,77 @@
+/**
+ * @file sequence_tracker.cpp
+ * @brief Implementación de la tabla de números de lote por nodo
+ */
+
+#include "sequence_tracker.h"
+
+SequenceTracker::SequenceTracker(const NodeTable &table)
+    : nodes(table), duplicateCount(0), gapCount(0), restartCount(0)
+{
+    memset(entries, 0, sizeof(entries));
+}
+
+void SequenceTracker::reset(uint8_t id)
+{
+    uint8_t slot = nodes.slotOf(id);
+    if (slot != NodeTable::NO_SLOT) {
+        entries[slot].seen = false;
+    }
+}
+
+SequenceTracker::Verdict SequenceTracker::check(uint8_t id, uint16_t seq)
+{
+    uint8_t slot = nodes.slotOf(id);
+    if (slot == NodeTable::NO_SLOT) {
+        return NEW;
+    }
+    Entry &e = entries[slot];
+    int16_t ahead = (int16_t)(seq - e.last);
+
+    if (!e.seen || (seq == 0 && e.last != 0) || ahead < -(int16_t)SEQUENCE_WINDOW) {
+        Verdict verdict = e.seen ? RESTART : NEW;
+        if (verdict == RESTART) {
+            restartCount++;
+        }
+        e.last = seq;
+        e.window = 0;
+        e.seen = true;
+        return verdict;
+    }
+    if (ahead == 0) {
+        duplicateCount++;
+        return DUPLICATE;
+    }
+    if (ahead > 0) {
+        gapCount += (uint32_t)(ahead - 1);
+        // El último pasa a la ventana en la posición ahead - 1
+        e.window = ahead > SEQUENCE_WINDOW ? 0 : (uint8_t)(((uint16_t)e.window << ahead) | (1 << (ahead - 1)));
+        e.last = seq;
+        return NEW;
+    }
+    uint8_t bit = (uint8_t)(1 << (-ahead - 1));
+    if (e.window & bit) {
+        duplicateCount++;
+        return DUPLICATE;
+    }
+    e.window |= bit;
+    if (gapCount > 0) {
+        gapCount--;
+    }
+    return LATE;
+}
+
+uint32_t SequenceTracker::duplicates() const
+{
+    return duplicateCount;
+}
+
+uint32_t SequenceTracker::gaps() const
+{
+    return gapCount;
+}
+
+uint32_t SequenceTracker::restarts() const
+{
+    return restartCount;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file sequence_tracker.h
+ * @brief Último número de lote visto por nodo: descarte de duplicados y conteo de lotes perdidos
+ * @date 2025
+ *
+ * Los nodos con Protocol::CAP_BATCH_SEQUENCE numeran cada lote
+ * (Protocol::BatchHeader). Un mismo lote puede llegar dos veces: respuesta
+ * tardía a un pedido que ya se reintentó, envío en slot y sondeo de respaldo,
+ * o un pedido repetido antes de que el nodo tome otra muestra.
+ *
+ * Una entrada de 4 bytes por slot de NodeTable, como LinkStats: el último
+ * número aceptado y un bitmap de los SEQUENCE_WINDOW anteriores. Cada consulta
+ * es O(1); un ID sin registrar se acepta siempre como NEW:
+ *
+ * - Número nuevo: se acepta; los saltados cuentan como huecos.
+ * - Número dentro de la ventana ya visto: duplicado.
+ * - Número dentro de la ventana no visto: llegó tarde, se acepta y deja de ser hueco.
+ * - 0, o más viejo que la ventana: el nodo se reinició y la cuenta empieza de nuevo.
+ */
+
+#ifndef SEQUENCE_TRACKER_H
+#define SEQUENCE_TRACKER_H
+
+#include <Arduino.h>
+#include "node_table.h"
+
+/**
+ * @class SequenceTracker
+ * @brief Tabla de números de lote indexada por ID de nodo.
+ *
+ * @example
+ * ```cpp
+ * if (tracker.check(from, header.seq) == SequenceTracker::DUPLICATE) {
+ *     return;  // ya publicado
+ * }
+ * ```
+ */
+class SequenceTracker
+{
+public:
+    /**
+     * @enum Verdict
+     * @brief Resultado de check().
+     */
+    enum Verdict : uint8_t {
+        NEW,        ///< Lote nuevo
+        LATE,       ///< Lote que se había contado como hueco
+        DUPLICATE,  ///< Lote ya aceptado: no se publica
+        RESTART     ///< Primer lote tras un reinicio del nodo
+    };
+
+    static const uint8_t SEQUENCE_WINDOW = 8;  ///< Lotes anteriores al último que se recuerdan
+
+    /**
+     * @param table Tabla de nodos que asigna el slot de cada ID
+     */
+    explicit SequenceTracker(const NodeTable &table);
+
+    /**
+     * @brief Olvida el nodo (nodo nuevo): su próximo lote se acepta sin contar huecos
+     */
+    void reset(uint8_t id);
+
+    /**
+     * @brief Clasifica un lote y, salvo que sea duplicado, lo registra
+     */
+    Verdict check(uint8_t id, uint16_t seq);
+
+    /**
+     * @brief Lotes descartados por duplicados desde el arranque
+     */
+    uint32_t duplicates() const;
+
+    /**
+     * @brief Lotes saltados que todavía no llegaron
+     */
+    uint32_t gaps() const;
+
+    /**
+     * @brief Reinicios de nodos detectados desde el arranque
+     */
+    uint32_t restarts() const;
+
+private:
+    /**
+     * @struct Entry
+     * @brief Estado de un nodo.
+     */
+    struct Entry {
+        uint16_t last;   ///< Último número aceptado
+        uint8_t window;  ///< Bit i = se aceptó last - 1 - i
+        bool seen;       ///< Hay un lote aceptado
+    };
+
+    const NodeTable &nodes;
+    Entry entries[NodeTable::CAPACITY];
+    uint32_t duplicateCount;
+    uint32_t gapCount;
+    uint32_t restartCount;
+};
+
+#endif // SEQUENCE_TRACKER_H
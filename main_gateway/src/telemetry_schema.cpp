@@ -0,0 +1,38 @@
+/**
+ * @file telemetry_schema.cpp
+ * @brief Tablas de campos de los paquetes del protocolo
+ */
+
+#include "telemetry_schema.h"
+
+#include <stddef.h>
+
+namespace Telemetry {
+
+    using Protocol::AtmosphericSample;
+    using Protocol::GroundGpsPacket;
+
+    const JsonField ATMOSPHERIC_FIELDS[] = {
+        {"time",        offsetof(AtmosphericSample, hour),     JsonType::TIME_HM, 0},
+        {"temperature", offsetof(AtmosphericSample, temp),     JsonType::INT16,   1},
+        {"moisture",    offsetof(AtmosphericSample, moisture), JsonType::UINT16,  1},
+    };
+    const uint8_t ATMOSPHERIC_FIELD_COUNT = sizeof(ATMOSPHERIC_FIELDS) / sizeof(ATMOSPHERIC_FIELDS[0]);
+
+    const JsonField GROUND_FIELDS[] = {
+        {"temperature", offsetof(GroundGpsPacket, ground.temp),     JsonType::INT16,  1},
+        {"moisture",    offsetof(GroundGpsPacket, ground.moisture), JsonType::UINT16, 1},
+        {"n",           offsetof(GroundGpsPacket, ground.n),        JsonType::UINT16, 0},
+        {"p",           offsetof(GroundGpsPacket, ground.p),        JsonType::UINT16, 0},
+        {"k",           offsetof(GroundGpsPacket, ground.k),        JsonType::UINT16, 0},
+        {"ec",          offsetof(GroundGpsPacket, ground.EC),       JsonType::UINT16, 0},
+        {"ph",          offsetof(GroundGpsPacket, ground.PH),       JsonType::UINT8,  1},
+        {"volt",        offsetof(GroundGpsPacket, energy.volt),     JsonType::UINT16, 2},
+        {"latitude",    offsetof(GroundGpsPacket, gps.latitude),    JsonType::INT32,  7},
+        {"longitude",   offsetof(GroundGpsPacket, gps.longitude),   JsonType::INT32,  7},
+    };
+    const uint8_t GROUND_FIELD_COUNT = sizeof(GROUND_FIELDS) / sizeof(GROUND_FIELDS[0]);
+
+    static_assert(sizeof(AtmosphericSample) <= 255 && sizeof(GroundGpsPacket) <= 255, "JsonField::offset es de 8 bits");
+
+} // namespace Telemetry
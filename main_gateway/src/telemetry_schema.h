@@ -0,0 +1,34 @@
+/**
+ * @file telemetry_schema.h
+ * @brief Tablas de campos JSON de los paquetes del protocolo publicados por MQTT
+ * @date 2025
+ *
+ * Cada tabla indica nombre, offset, tipo y decimales de punto fijo de los
+ * campos de un struct de Protocol. JsonWriter::fields() las recorre para
+ * escribir el paquete sin float ni String. Agregar un campo al JSON es
+ * agregar una línea a la tabla.
+ */
+
+#ifndef TELEMETRY_SCHEMA_H
+#define TELEMETRY_SCHEMA_H
+
+#include "json_writer.h"
+#include "protocol.h"
+
+namespace Telemetry {
+
+    /**
+     * @brief Campos de Protocol::AtmosphericSample: time, temperature, moisture
+     */
+    extern const JsonField ATMOSPHERIC_FIELDS[];
+    extern const uint8_t ATMOSPHERIC_FIELD_COUNT;
+
+    /**
+     * @brief Campos de Protocol::GroundGpsPacket: suelo, pH, voltaje y coordenadas
+     */
+    extern const JsonField GROUND_FIELDS[];
+    extern const uint8_t GROUND_FIELD_COUNT;
+
+} // namespace Telemetry
+
+#endif // TELEMETRY_SCHEMA_H
@@ -0,0 +1,161 @@
+/**
+ * @file uplink_manager.cpp
+ * @brief Implementación de la conexión WiFi + MQTT no bloqueante
+ */
+
+#include "uplink_manager.h"
+#include "logger.h"
+
+UplinkManager::UplinkManager(WiFiClient &wifiClient, PubSubClient &mqtt)
+    : wifiClient(wifiClient), mqtt(mqtt), state(WIFI_DOWN), retryAt(0), deadline(0),
+      backoff(UPLINK_BACKOFF_MIN_MS), gotIp(false), lostWifi(false)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void UplinkManager::begin()
+{
+    // La reconexión la maneja esta clase, con backoff; el SDK no debe reintentar solo
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+
+    gotIpHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP &) {
+        gotIp = true;
+    });
+    disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected &) {
+        lostWifi = true;
+    });
+
+    wifiClient.setTimeout(UPLINK_SOCKET_TIMEOUT_MS);
+    mqtt.setClient(wifiClient);
+    mqtt.setServer(MQTT_SERVER, MQTT_PORT);
+    mqtt.setSocketTimeout((UPLINK_SOCKET_TIMEOUT_MS + 999) / 1000);
+
+    resetBackoff();
+    retryAt = millis();
+    setState(WIFI_DOWN);
+}
+
+void UplinkManager::update(unsigned long now)
+{
+    if (lostWifi) {
+        lostWifi = false;
+        if (state != WIFI_DOWN) {
+            if (state != WIFI_CONNECTING) {
+                LOG_W("UplinkManager: WiFi perdido.");
+                stats.drops++;
+            }
+            mqtt.disconnect();
+            WiFi.disconnect();
+            setState(WIFI_DOWN);
+            scheduleRetry(now);
+        }
+    }
+
+    switch (state) {
+        case WIFI_DOWN:
+            if ((long)(now - retryAt) >= 0) {
+                LOG_D("UplinkManager: Conectando a WiFi: " WIFI_SSID);
+                stats.wifiAttempts++;
+                gotIp = false;
+                deadline = now + UPLINK_WIFI_CONNECT_TIMEOUT_MS;
+                setState(WIFI_CONNECTING);
+                WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+            }
+            break;
+
+        case WIFI_CONNECTING:
+            if (gotIp) {
+                gotIp = false;
+                LOG_I("UplinkManager: WiFi conectado, IP: %u.%u.%u.%u",
+                      WiFi.localIP()[0], WiFi.localIP()[1], WiFi.localIP()[2], WiFi.localIP()[3]);
+                resetBackoff();
+                retryAt = now;
+                setState(MQTT_DOWN);
+            } else if ((long)(now - deadline) >= 0) {
+                LOG_W("UplinkManager: Timeout de WiFi.");
+                WiFi.disconnect();
+                setState(WIFI_DOWN);
+                scheduleRetry(now);
+            }
+            break;
+
+        case MQTT_DOWN:
+            if ((long)(now - retryAt) >= 0) {
+                LOG_D("UplinkManager: Conectando a MQTT: " MQTT_SERVER ":%d", MQTT_PORT);
+                stats.mqttAttempts++;
+                if (mqtt.connect(MQTT_CLIENT_ID)) {
+                    resetBackoff();
+                    setState(ONLINE);
+                } else {
+                    LOG_W("UplinkManager: Error al conectar MQTT (estado %d)", mqtt.state());
+                    scheduleRetry(millis());
+                }
+            }
+            break;
+
+        case ONLINE:
+            if (!mqtt.loop()) {
+                LOG_W("UplinkManager: Sesión MQTT perdida (estado %d)", mqtt.state());
+                stats.drops++;
+                setState(MQTT_DOWN);
+                scheduleRetry(now);
+            }
+            break;
+    }
+}
+
+bool UplinkManager::isOnline() const
+{
+    return state == ONLINE;
+}
+
+UplinkManager::State UplinkManager::getState() const
+{
+    return state;
+}
+
+const UplinkManager::Stats &UplinkManager::getStats() const
+{
+    return stats;
+}
+
+const char *UplinkManager::stateName(State state)
+{
+    switch (state) {
+        case WIFI_DOWN:
+            return "WIFI_DOWN";
+        case WIFI_CONNECTING:
+            return "WIFI_CONNECTING";
+        case MQTT_DOWN:
+            return "MQTT_DOWN";
+        case ONLINE:
+            return "ONLINE";
+    }
+    return "?";
+}
+
+void UplinkManager::setState(State next)
+{
+    if (next != state) {
+        LOG_I("UplinkManager: %s -> %s", stateName(state), stateName(next));
+        state = next;
+    }
+}
+
+/**
+ * @brief Programa el próximo intento entre backoff/2 y backoff ms y duplica backoff
+ */
+void UplinkManager::scheduleRetry(unsigned long now)
+{
+    uint32_t wait = backoff / 2 + (uint32_t)random((long)(backoff / 2 + 1));
+    retryAt = now + wait;
+    LOG_D("UplinkManager: Reintento en %u ms", (unsigned)wait);
+    backoff = backoff >= UPLINK_BACKOFF_MAX_MS / 2 ? UPLINK_BACKOFF_MAX_MS : backoff * 2;
+}
+
+void UplinkManager::resetBackoff()
+{
+    backoff = UPLINK_BACKOFF_MIN_MS;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file uplink_manager.h
+ * @brief Conexión WiFi + MQTT no bloqueante con reintentos exponenciales
+ * @date 2025
+ *
+ * Reemplaza a connectWiFi()/connectMQTT(), que esperaban hasta 10 s con
+ * delay() en medio del sondeo y hacían perder tramas LoRa. La máquina de
+ * estados avanza desde AppLogic::update() y nunca espera:
+ *
+ * - WIFI_DOWN: sin WiFi; al vencer el reintento llama a WiFi.begin().
+ * - WIFI_CONNECTING: esperando el evento GotIP (o el timeout).
+ * - MQTT_DOWN: con IP pero sin sesión MQTT; reintenta connect() al vencer.
+ * - ONLINE: sesión activa; mqtt.loop() en cada update().
+ *
+ * Los cambios de estado del WiFi llegan por los callbacks de eventos del
+ * ESP8266 (onStationModeGotIP / onStationModeDisconnected), que solo marcan
+ * banderas; el trabajo se hace en update().
+ *
+ * Entre intentos fallidos la espera se duplica desde UPLINK_BACKOFF_MIN_MS
+ * hasta UPLINK_BACKOFF_MAX_MS, con jitter (se espera entre la mitad y el
+ * total) para que varios gateways no reintenten sincronizados contra el
+ * mismo broker.
+ *
+ * mqtt.connect() sigue siendo bloqueante (conexión TCP + CONNACK); se acota
+ * con UPLINK_SOCKET_TIMEOUT_MS y solo se llama al vencer el reintento.
+ */
+
+#ifndef UPLINK_MANAGER_H
+#define UPLINK_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <PubSubClient.h>
+#include "config.h"
+
+/**
+ * @class UplinkManager
+ * @brief Máquina de estados de la conexión WiFi/MQTT del gateway.
+ *
+ * @example
+ * ```cpp
+ * UplinkManager uplink(wifiClient, mqttClient);
+ * uplink.begin();
+ * // en cada update():
+ * uplink.update(millis());
+ * if (uplink.isOnline()) mqttClient.publish(topic, payload);
+ * else encolar(payload);
+ * ```
+ */
+class UplinkManager
+{
+public:
+    /**
+     * @enum State
+     * @brief Estado de la conexión.
+     */
+    enum State : uint8_t {
+        WIFI_DOWN = 0,    ///< Sin WiFi, esperando el próximo intento
+        WIFI_CONNECTING,  ///< WiFi.begin() en curso
+        MQTT_DOWN,        ///< WiFi conectado, sin sesión MQTT
+        ONLINE            ///< WiFi y MQTT conectados
+    };
+
+    /**
+     * @struct Stats
+     * @brief Contadores desde el arranque.
+     */
+    struct Stats {
+        uint16_t wifiAttempts;  ///< Llamadas a WiFi.begin()
+        uint16_t mqttAttempts;  ///< Llamadas a mqtt.connect()
+        uint16_t drops;         ///< Caídas estando conectado (WiFi o MQTT)
+    };
+
+    /**
+     * @brief Constructor
+     * @param wifiClient Socket TCP que usa el cliente MQTT
+     * @param mqtt Cliente MQTT a mantener conectado
+     */
+    UplinkManager(WiFiClient &wifiClient, PubSubClient &mqtt);
+
+    /**
+     * @brief Registra los eventos WiFi y programa el primer intento
+     */
+    void begin();
+
+    /**
+     * @brief Avanza la máquina de estados (no bloquea salvo mqtt.connect())
+     * @param now Tiempo actual (millis())
+     */
+    void update(unsigned long now);
+
+    /**
+     * @brief true si se puede publicar
+     */
+    bool isOnline() const;
+
+    State getState() const;
+
+    const Stats &getStats() const;
+
+    /**
+     * @brief Nombre del estado para logs
+     */
+    static const char *stateName(State state);
+
+private:
+    WiFiClient &wifiClient;
+    PubSubClient &mqtt;
+    State state;
+    unsigned long retryAt;   ///< millis() del próximo intento
+    unsigned long deadline;  ///< millis() límite de WIFI_CONNECTING
+    uint32_t backoff;        ///< Espera máxima del próximo reintento en ms
+    Stats stats;
+
+    volatile bool gotIp;     ///< Marcada por el evento GotIP
+    volatile bool lostWifi;  ///< Marcada por el evento Disconnected
+    WiFiEventHandler gotIpHandler;        ///< Hay que conservarlo: al destruirse se desregistra
+    WiFiEventHandler disconnectedHandler;
+
+    void setState(State next);
+    void scheduleRetry(unsigned long now);
+    void resetBackoff();
+};
+
+#endif // UPLINK_MANAGER_H
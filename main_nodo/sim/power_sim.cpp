@@ -0,0 +1,243 @@
+/**
+ * @file power_sim.cpp
+ * @brief Simulación nativa del consumo del nodo con LOW_POWER_MODE (env:native_power_sim)
+ *
+ * Corre el PowerManager del firmware contra un gateway modelado que abre un
+ * ciclo (ANNOUNCE con slots o pedido broadcast) cada --period ms más un
+ * atraso al azar de hasta --lag ms. El nodo escucha el ciclo si tiene la
+ * radio encendida y la trama no se pierde (--loss); su slot empieza
+ * --slot-offset ms después. Lo que hace el firmware despierto se modela con
+ * duraciones fijas (muestra, envío, HELLO); cuándo despierta, cuánto escucha
+ * y cuánto duerme lo decide PowerManager igual que en el ESP32, con el reloj
+ * RTC desviado --drift ppm.
+ *
+ * Informa la corriente media del modelo (LOW_POWER_CURRENT_*_UA), la
+ * autonomía con una batería de --battery mAh y la misma cuenta con el nodo
+ * siempre despierto. Con --max-ua el código de salida es 2 si la corriente
+ * media la supera (para usarlo como prueba).
+ *
+ * @example
+ * ```
+ * pio run -e native_power_sim
+ * .pio/build/native_power_sim/program --hours 24 --period 90000 --loss 0.05
+ * ```
+ */
+
+#include <Arduino.h>
+#include <random>
+#include "config.h"
+#include "power_manager.h"
+
+namespace {
+
+    const uint32_t STEP_MS = 5;          ///< Paso del bucle despierto
+    const uint32_t RADIO_INIT_MS = 10;   ///< RadioManager::init() con el RFM95 dormido
+    const uint32_t DHT_READ_MS = 25;     ///< Lectura del DHT11
+    const uint32_t SEND_MS = 120;        ///< DATA_ATMOSPHERIC comprimido y sellado a SF7 más el ACK
+    const uint32_t HELLO_MS = 110;       ///< HELLO más el ACK
+
+    struct Options {
+        double hours = 24;
+        uint32_t periodMs = 90000;       ///< INTERVALOATMOSPHERIC del gateway
+        uint32_t lagMs = 300;            ///< Atraso máximo del ciclo (bucle del gateway ocupado)
+        double loss = 0.05;              ///< Probabilidad de no escuchar un ciclo
+        uint32_t slotOffsetMs = 3000;    ///< firstSlotMs + posición * slotMs
+        double driftPpm = 5000;          ///< Desvío del oscilador RTC en deep sleep
+        double downFrom = -1;            ///< Gateway apagado desde la hora
+        double downTo = -1;              ///< hasta la hora
+        uint32_t batteryMah = 2000;
+        uint32_t maxUa = 0;
+        uint32_t seed = 1;
+    };
+
+    bool parse(int argc, char **argv, Options &o)
+    {
+        for (int i = 1; i < argc; i++) {
+            const char *arg = argv[i];
+            const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (value == nullptr) {
+                return false;
+            }
+            if (strcmp(arg, "--hours") == 0) {
+                o.hours = atof(value);
+            } else if (strcmp(arg, "--period") == 0) {
+                o.periodMs = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--lag") == 0) {
+                o.lagMs = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--loss") == 0) {
+                o.loss = atof(value);
+            } else if (strcmp(arg, "--slot-offset") == 0) {
+                o.slotOffsetMs = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--drift") == 0) {
+                o.driftPpm = atof(value);
+            } else if (strcmp(arg, "--gateway-down") == 0) {
+                if (sscanf(value, "%lf:%lf", &o.downFrom, &o.downTo) != 2) {
+                    return false;
+                }
+            } else if (strcmp(arg, "--battery") == 0) {
+                o.batteryMah = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--max-ua") == 0) {
+                o.maxUa = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--seed") == 0) {
+                o.seed = strtoul(value, nullptr, 10);
+            } else {
+                return false;
+            }
+            i++;
+        }
+        return o.periodMs > 0 && o.hours > 0;
+    }
+
+    /** Días de autonomía con una corriente media dada. */
+    double days(uint32_t batteryMah, double averageUa)
+    {
+        return averageUa <= 0 ? 0 : batteryMah * 1000.0 / averageUa / 24.0;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options o;
+    if (!parse(argc, argv, o)) {
+        printf("Uso: %s [--hours H] [--period MS] [--lag MS] [--loss P] [--slot-offset MS] [--drift PPM]\n"
+               "          [--gateway-down A:B] [--battery MAH] [--max-ua UA] [--seed N]\n", argv[0]);
+        return 1;
+    }
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    PowerManager::Memory memory;
+    memset(&memory, 0, sizeof(memory));
+    PowerManager power(memory);
+
+    const double endMs = o.hours * 3600000.0;
+    double nextCycle = unit(rng) * o.periodMs;  // Tiempo real del próximo ciclo del gateway
+    double wakeStart = 0;                        // Tiempo real en que millis() vale 0
+    bool timerWake = false;
+    uint32_t gatewayCycles = 0;
+    uint32_t cyclesHeard = 0;
+    uint32_t slotsSent = 0;
+    uint32_t slotsDelivered = 0;
+    uint32_t hellos = 0;
+    uint32_t samples = 0;
+    uint32_t wakes[PowerManager::WAKE_SEARCH + 1] = {};
+    uint32_t maxAwakeMs = 0;
+
+    while (wakeStart < endMs) {
+        power.begin(timerWake, 0);
+        wakes[power.wakeReason()]++;
+        PowerManager::Memory &m = power.memory();
+        bool slotPending = m.slotPending;
+        uint32_t slotAt = m.slotAt;
+        uint32_t helloAt = m.helloAt;
+        unsigned long uptime = 0;
+        unsigned long radioSince = 0;
+        bool radioReady = false;
+        uint32_t txMs = 0;
+
+        for (;;) {
+            uint32_t now = power.clock(uptime);
+            double trueNow = wakeStart + uptime;
+            power.tick(now);
+            if (!radioReady && power.needsRadio(now, slotPending, slotAt)) {
+                radioReady = true;
+                radioSince = uptime;
+                uptime += RADIO_INIT_MS;
+                continue;
+            }
+            bool gatewayOn = !(trueNow >= o.downFrom * 3600000.0 && trueNow < o.downTo * 3600000.0);
+            if (trueNow >= nextCycle) {
+                if (gatewayOn) {
+                    gatewayCycles++;
+                    if (radioReady && unit(rng) >= o.loss) {
+                        cyclesHeard++;
+                        power.cycleHeard(now);
+                        slotPending = true;
+                        slotAt = now + o.slotOffsetMs;
+                    }
+                }
+                nextCycle += o.periodMs + unit(rng) * o.lagMs;
+                continue;
+            }
+            if (power.sampleDue(now)) {
+                uptime += DHT_READ_MS + (unsigned long)(unit(rng) * 1000);  // Hasta la próxima frase NMEA
+                power.sampled(now);
+                samples++;
+                continue;
+            }
+            if (slotPending && (int32_t)(now - slotAt) >= 0) {
+                slotPending = false;
+                uptime += SEND_MS;
+                txMs += SEND_MS;
+                slotsSent++;
+                slotsDelivered += gatewayOn ? 1 : 0;
+                power.listen(power.clock(uptime) + LOW_POWER_RX_WINDOW_MS);
+                continue;
+            }
+            if (radioReady && gatewayOn && now - helloAt >= INTERVALOHELLO) {
+                helloAt = now;
+                uptime += HELLO_MS;
+                txMs += HELLO_MS;
+                hellos++;
+                power.listen(power.clock(uptime) + LOW_POWER_RX_WINDOW_MS);
+                continue;
+            }
+            uint32_t wakeAt;
+            if (power.planSleep(now, slotPending, slotAt, wakeAt) || wakeStart + uptime >= endMs) {
+                if (wakeStart + uptime >= endMs) {
+                    wakeAt = now;  // Fin de la simulación: se cierra la cuenta del despertar
+                }
+                m.slotPending = slotPending;
+                m.slotAt = slotAt;
+                m.helloAt = helloAt;
+                uint32_t radioMs = radioReady ? uptime - radioSince : 0;
+                power.account(PowerManager::TX, txMs);
+                power.account(PowerManager::RX, radioMs - txMs);
+                power.account(PowerManager::CPU, uptime - radioMs);
+                power.sleep(now, wakeAt);
+                maxAwakeMs = uptime > maxAwakeMs ? uptime : maxAwakeMs;
+                // El timer RTC cuenta en ticks del oscilador: el sueño real se estira con el desvío
+                wakeStart += uptime + (wakeAt - now) * (1.0 + o.driftPpm / 1e6) + LOW_POWER_BOOT_MS;
+                timerWake = true;
+                break;
+            }
+            uptime += STEP_MS;
+        }
+    }
+
+    uint64_t totalMs = 0;
+    for (uint8_t s = 0; s < PowerManager::POWER_STATE_COUNT; s++) {
+        totalMs += power.stateMs((PowerManager::PowerState)s);
+    }
+    const char *names[PowerManager::POWER_STATE_COUNT] = {"CPU", "RX", "TX", "SLEEP"};
+    double tx = (double)power.stateMs(PowerManager::TX);
+    double alwaysOnUa = (LOW_POWER_CURRENT_RX_UA * (totalMs - tx) + LOW_POWER_CURRENT_TX_UA * tx) / totalMs;
+    uint32_t averageUa = power.averageCurrentUa();
+
+    printf("Gateway: ciclo cada %u ms + hasta %u ms, pérdida %.2f, slot a %u ms; RTC %+.0f ppm\n", o.periodMs,
+           o.lagMs, o.loss, o.slotOffsetMs, o.driftPpm);
+    printf("Nodo: muestra cada %u ms, HELLO cada %u ms, margen %u ms, ventana tras envío %u ms\n\n",
+           SAMPLEINTERVALMSATMOSPHERIC, INTERVALOHELLO, LOW_POWER_RX_GUARD_MS, LOW_POWER_RX_WINDOW_MS);
+    printf("Tiempo simulado: %.1f h\n", totalMs / 3600000.0);
+    printf("Despertares: %u muestra, %u ciclo, %u slot, %u búsqueda (despertar más largo %u ms)\n",
+           wakes[PowerManager::WAKE_SAMPLE], wakes[PowerManager::WAKE_CYCLE], wakes[PowerManager::WAKE_SLOT],
+           wakes[PowerManager::WAKE_SEARCH], maxAwakeMs);
+    printf("Muestras: %u de %u\n", samples, (uint32_t)(totalMs / SAMPLEINTERVALMSATMOSPHERIC) + 1);
+    printf("Ciclos del gateway: %u, escuchados %u (%.1f%%), lotes en slot %u entregados %u, HELLO %u\n",
+           gatewayCycles, cyclesHeard, gatewayCycles ? 100.0 * cyclesHeard / gatewayCycles : 0.0, slotsSent,
+           slotsDelivered, hellos);
+    for (uint8_t s = 0; s < PowerManager::POWER_STATE_COUNT; s++) {
+        uint64_t ms = power.stateMs((PowerManager::PowerState)s);
+        printf("  %-5s %10.1f s %6.2f%% %8u uA\n", names[s], ms / 1000.0, 100.0 * ms / totalMs,
+               PowerManager::CURRENT_UA[s]);
+    }
+    printf("\nCorriente media: %u uA -> %.1f días con %u mAh\n", averageUa, days(o.batteryMah, averageUa),
+           o.batteryMah);
+    printf("Siempre despierto: %.0f uA -> %.1f días\n", alwaysOnUa, days(o.batteryMah, alwaysOnUa));
+    if (o.maxUa != 0 && averageUa > o.maxUa) {
+        printf("Corriente media mayor que --max-ua %u\n", o.maxUa);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,501 @@
+/**
+ * @file rs485_sim.cpp
+ * @brief Simulación nativa del bus RS485 del nodo con RS485_HW_UART (env:native_rs485_sim)
+ *
+ * Corre el RS485Manager del firmware con el transporte por UART (el
+ * driver/uart.h del shim, sobre el esclavo de un pty) contra una sonda
+ * simulada en el maestro del pty: un hilo que responde como
+ * simulation_measures_ground (PING -> PONG, REQ_GROUND_DATA -> DATA_GROUND
+ * con GroundSensorBinary), con su espera antes de transmitir (--probe-delay)
+ * y los bytes espaciados a RS485_BAUDRATE.
+ *
+ * Verifica que begin() deje el UART en UART_MODE_RS485_HALF_DUPLEX con RTS
+ * en RS485_RE_DE, que el PING responda y que cada requestSensorData()
+ * devuelva exactamente lo que envió la sonda. Informa la duración de las
+ * transacciones y la vuelta a recepción, junto a las esperas fijas del
+ * transporte SoftwareSerial. Con --drop la sonda ignora pedidos al azar para
+ * ejercitar el timeout y el reintento.
+ *
+ * Con --modbus la sonda son los esclavos Modbus RTU de RS485_MODBUS_SLAVE_IDS
+ * (su CRC es el bit a bit de la especificación, independiente de la tabla del
+ * firmware) y cada transacción es una ronda de pollProbes(); --mute calla una
+ * dirección para ver que solo cuesta su timeout.
+ *
+ * El código de salida es 2 si algún dato no coincide o alguna transacción
+ * falló sin --drop ni --mute (para usarlo como prueba).
+ *
+ * @example
+ * ```
+ * pio run -e native_rs485_sim
+ * .pio/build/native_rs485_sim/program --transactions 200 --drop 0.05
+ * .pio/build/native_rs485_sim/program --modbus --mute 2
+ * ```
+ */
+
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <random>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "config.h"
+#include "protocol.h"
+#include "rs485_manager.h"
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Options {
+        uint32_t transactions = 100;
+        uint32_t probeDelayMs = 3;       ///< RS485_TX_DELAY de la sonda: DE arriba antes del primer byte
+        double drop = 0;                 ///< Probabilidad de que la sonda ignore un pedido
+        uint32_t timeoutMs = 200;        ///< Timeout de RS485Manager por espera (RS485_TIMEOUT_MS en el firmware)
+        uint32_t seed = 1;
+        bool modbus = false;             ///< Esclavos Modbus RTU en vez del protocolo de un byte
+        int mute = -1;                   ///< Dirección Modbus que no responde
+        bool verbose = false;
+    };
+
+    const uint8_t SLAVE_IDS[] = RS485_MODBUS_SLAVE_IDS;
+
+    /** CRC16 Modbus bit a bit, como en la especificación */
+    uint16_t referenceCrc(const uint8_t *data, size_t len)
+    {
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+            }
+        }
+        return crc;
+    }
+
+    double airMs(size_t bytes) { return bytes * 10000.0 / RS485_BAUDRATE; }
+
+    bool parse(int argc, char **argv, Options &o)
+    {
+        for (int i = 1; i < argc; i++) {
+            const char *arg = argv[i];
+            if (strcmp(arg, "--verbose") == 0) {
+                o.verbose = true;
+                continue;
+            }
+            if (strcmp(arg, "--modbus") == 0) {
+                o.modbus = true;
+                continue;
+            }
+            const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (value == nullptr) {
+                return false;
+            }
+            if (strcmp(arg, "--transactions") == 0) {
+                o.transactions = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--probe-delay") == 0) {
+                o.probeDelayMs = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--drop") == 0) {
+                o.drop = atof(value);
+            } else if (strcmp(arg, "--timeout") == 0) {
+                o.timeoutMs = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--seed") == 0) {
+                o.seed = strtoul(value, nullptr, 10);
+            } else if (strcmp(arg, "--mute") == 0) {
+                o.mute = atoi(value);
+            } else {
+                return false;
+            }
+            i++;
+        }
+        return o.transactions > 0 && o.timeoutMs > 0;
+    }
+
+    /**
+     * @brief Sonda RS485 simulada en el maestro del pty.
+     */
+    class Probe
+    {
+    public:
+        Probe(int fd, const Options &o) : fd(fd), opt(o), rng(o.seed) {}
+
+        void start() { worker = std::thread([this]() { run(); }); }
+
+        void stop()
+        {
+            running = false;
+            worker.join();
+        }
+
+        /** Último GroundSensorBinary enviado. */
+        Protocol::GroundSensorBinary last()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return lastSent;
+        }
+
+        /** Últimos registros enviados por un esclavo Modbus (vacío si nunca respondió). */
+        std::vector<uint16_t> lastRegisters(uint8_t slave)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sentRegisters[slave];
+        }
+
+        uint32_t badRequests = 0;
+
+        uint32_t requests = 0;
+        uint32_t dropped = 0;
+
+    private:
+        int fd;
+        Options opt;
+        std::mt19937 rng;
+        std::atomic<bool> running{true};
+        std::thread worker;
+        std::mutex mutex;
+        Protocol::GroundSensorBinary lastSent = {};
+        std::map<uint8_t, std::vector<uint16_t>> sentRegisters;
+        Clock::time_point requestEnd;  ///< Cuándo sale del bus el último bit del pedido
+
+        void run()
+        {
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            while (running) {
+                pollfd p = {fd, POLLIN, 0};
+                uint8_t command;
+                if (poll(&p, 1, 20) <= 0 || read(fd, &command, 1) != 1) {
+                    continue;
+                }
+                // El pty entrega el pedido enseguida; en el bus termina después
+                size_t requestSize = opt.modbus ? ModbusRtu::REQUEST_SIZE : 1;
+                requestEnd = Clock::now() + std::chrono::microseconds((uint64_t)(airMs(requestSize) * 1000));
+                if (opt.modbus) {
+                    if (unit(rng) < opt.drop) {
+                        requests++;
+                        dropped++;
+                        readRest(7);  // El pedido entero, sin responder
+                        continue;
+                    }
+                    modbusRequest(command);
+                    continue;
+                }
+                if (command == Protocol::RS485Type::PING) {
+                    uint8_t pong = Protocol::RS485Type::PONG;
+                    reply(&pong, 1);
+                } else if (command == Protocol::RS485Type::REQ_GROUND_DATA) {
+                    requests++;
+                    if (unit(rng) < opt.drop) {
+                        dropped++;
+                        continue;
+                    }
+                    uint8_t frame[1 + sizeof(Protocol::GroundSensorBinary)];
+                    Protocol::GroundSensorBinary data = reading();
+                    frame[0] = Protocol::RS485Type::DATA_GROUND;
+                    memcpy(frame + 1, &data, sizeof(data));
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        lastSent = data;
+                    }
+                    reply(frame, sizeof(frame));
+                }
+            }
+        }
+
+        Protocol::GroundSensorBinary reading()
+        {
+            Protocol::GroundSensorBinary data;
+            data.temp = (int16_t)(rng() % 1201) - 400;
+            data.moisture = (uint16_t)(rng() % 1001);
+            data.n = (uint16_t)(rng() % 2000);
+            data.p = (uint16_t)(rng() % 2000);
+            data.k = (uint16_t)(rng() % 2000);
+            data.EC = (uint16_t)(rng() % 20001);
+            data.PH = (uint8_t)(30 + rng() % 61);
+            return data;
+        }
+
+        /** Lee lo que falta de un pedido; sin bytes nuevos en 20 ms se da por terminado */
+        std::vector<uint8_t> readRest(size_t len)
+        {
+            std::vector<uint8_t> bytes;
+            while (bytes.size() < len) {
+                pollfd p = {fd, POLLIN, 0};
+                uint8_t byte;
+                if (poll(&p, 1, 20) <= 0 || read(fd, &byte, 1) != 1) {
+                    break;
+                }
+                bytes.push_back(byte);
+            }
+            return bytes;
+        }
+
+        /** Esclavo Modbus: responde la lectura de holding registers a su dirección */
+        void modbusRequest(uint8_t slave)
+        {
+            std::vector<uint8_t> request(1, slave);
+            std::vector<uint8_t> rest = readRest(7);
+            request.insert(request.end(), rest.begin(), rest.end());
+            bool known = false;
+            for (uint8_t id : SLAVE_IDS) {
+                known = known || id == slave;
+            }
+            if (!known || slave == opt.mute) {
+                return;
+            }
+            // Fin de trama Modbus: el esclavo responde tras 3,5 caracteres de silencio
+            requestEnd += std::chrono::microseconds(ModbusRtu::interFrameUs(RS485_BAUDRATE));
+            requests++;
+            uint16_t count = request.size() == 8 ? (uint16_t)(request[4] << 8 | request[5]) : 0;
+            if (request.size() != 8 || request[1] != 0x03 || referenceCrc(request.data(), 8) != 0 || count == 0 ||
+                count > 125) {
+                badRequests++;
+                return;
+            }
+            std::vector<uint16_t> regs(count);
+            for (uint16_t i = 0; i < count; i++) {
+                regs[i] = (uint16_t)rng();
+            }
+            if (count >= 7) {
+                // Los valores de la sonda 7 en 1 en sus rangos
+                Protocol::GroundSensorBinary data = reading();
+                const uint16_t probe[7] = {data.moisture, (uint16_t)data.temp, data.EC, data.PH, data.n, data.p, data.k};
+                memcpy(regs.data(), probe, sizeof(probe));
+            }
+            std::vector<uint8_t> frame = {slave, 0x03, (uint8_t)(2 * count)};
+            for (uint16_t value : regs) {
+                frame.push_back((uint8_t)(value >> 8));
+                frame.push_back((uint8_t)value);
+            }
+            uint16_t crc = referenceCrc(frame.data(), frame.size());
+            frame.push_back((uint8_t)crc);
+            frame.push_back((uint8_t)(crc >> 8));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                sentRegisters[slave] = regs;
+            }
+            reply(frame.data(), frame.size());
+        }
+
+        /** Como la sonda: DE arriba, espera, y los bytes al ritmo del bus. */
+        void reply(const uint8_t *data, size_t len)
+        {
+            // Cada byte cuando llega su bit de parada; con horas absolutas los
+            // retrasos del planificador no se acumulan
+            Clock::time_point next = requestEnd + std::chrono::milliseconds(opt.probeDelayMs);
+            for (size_t i = 0; i < len; i++) {
+                next += std::chrono::microseconds(10000000UL / RS485_BAUDRATE);
+                std::this_thread::sleep_until(next);
+                if (write(fd, data + i, 1) != 1) {
+                    return;
+                }
+            }
+        }
+    };
+
+    bool openPty(int &master, int &slave)
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+            return false;
+        }
+        slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+        if (slave < 0) {
+            return false;
+        }
+        // Crudo en los dos extremos: sin eco ni edición de línea
+        termios raw;
+        for (int fd : {master, slave}) {
+            tcgetattr(fd, &raw);
+            cfmakeraw(&raw);
+            tcsetattr(fd, TCSANOW, &raw);
+        }
+        return true;
+    }
+
+    bool sameReading(const Protocol::GroundSensor &got, const Protocol::GroundSensorBinary &sent)
+    {
+        return got.temp == sent.temp && got.moisture == sent.moisture && got.n == sent.n && got.p == sent.p &&
+               got.k == sent.k && got.EC == sent.EC && got.PH == sent.PH;
+    }
+
+    /** Mismo mapa que la sonda 7 en 1 de modbusRequest() */
+    bool sameRegisters(const Protocol::GroundSensor &got, const std::vector<uint16_t> &sent)
+    {
+        return sent.size() >= 7 && got.moisture == sent[0] && got.temp == (int16_t)sent[1] && got.EC == sent[2] &&
+               got.PH == sent[3] && got.n == sent[4] && got.p == sent[5] && got.k == sent[6];
+    }
+
+    /**
+     * @brief Rondas de pollProbes() contra los esclavos Modbus simulados
+     * @return Problemas encontrados
+     */
+    uint32_t runModbus(RS485Manager &rs485, Probe &probe, const Options &o)
+    {
+        uint32_t problems = 0;
+        // Vector de prueba de la especificación: "123456789" -> 0x4B37
+        const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+        if (ModbusRtu::crc16(check, sizeof(check)) != 0x4B37) {
+            printf("CRC16 de la tabla distinto del de referencia\n");
+            problems++;
+        }
+
+        const uint8_t slaves = rs485.getProbeCount();
+        uint32_t complete = 0;
+        uint32_t answered = 0;
+        uint32_t mismatches = 0;
+        double totalMs = 0;
+        double maxMs = 0;
+        for (uint32_t i = 0; i < o.transactions; i++) {
+            Clock::time_point start = Clock::now();
+            uint8_t responded = rs485.pollProbes();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            totalMs += ms;
+            maxMs = ms > maxMs ? ms : maxMs;
+            answered += responded;
+            complete += responded == slaves ? 1 : 0;
+            for (uint8_t s = 0; s < slaves; s++) {
+                const RS485Manager::ModbusProbe *p = rs485.getProbe(s);
+                if (p->fresh && !sameRegisters(p->reading, probe.lastRegisters(p->slaveId))) {
+                    mismatches++;
+                }
+                if (p->slaveId == o.mute && p->fresh) {
+                    mismatches++;  // Respuesta de un esclavo callado
+                }
+            }
+        }
+
+        // Piso de la ronda por esclavo: pedido, silencio de fin de trama,
+        // espera de la sonda y respuesta; el callado cuesta su pedido y su
+        // timeout menos un tick: uart_read_bytes() cuenta ticks de 1 ms
+        // (pdMS_TO_TICKS) y puede volver dentro del último. El silencio del
+        // maestro antes del pedido siguiente es un delayMicroseconds() que el
+        // shim no duerme
+        const size_t response = ModbusRtu::responseSize(RS485_MODBUS_REGISTER_COUNT);
+        const double gapMs = ModbusRtu::interFrameUs(RS485_BAUDRATE) / 1000.0;
+        const double tickMs = 1.0;
+        const double toleranceMs = 0.05;  // Resolución de la medición con Clock
+        double floorMs = 0;
+        for (uint8_t s = 0; s < slaves; s++) {
+            const RS485Manager::ModbusProbe *p = rs485.getProbe(s);
+            floorMs += airMs(ModbusRtu::REQUEST_SIZE);
+            floorMs += p->slaveId == o.mute ? p->timeoutMs - tickMs : gapMs + o.probeDelayMs + airMs(response);
+        }
+
+        printf("Bus: UART%d Modbus RTU, %d baudios, %u esclavos, %d registros por pedido (%u bytes de respuesta)\n",
+               RS485_UART_NUM, RS485_BAUDRATE, slaves, RS485_MODBUS_REGISTER_COUNT, (unsigned)response);
+        for (uint8_t s = 0; s < slaves; s++) {
+            const RS485Manager::ModbusProbe *p = rs485.getProbe(s);
+            printf("  Esclavo %3u: timeout %u ms%s\n", p->slaveId, p->timeoutMs, p->slaveId == o.mute ? ", callado" : "");
+        }
+        printf("Rondas: %u de %u completas, %u respuestas, %u datos distintos de los enviados, %u pedidos inválidos, "
+               "%u ignorados\n",
+               complete, o.transactions, answered, mismatches, probe.badRequests, probe.dropped);
+        printf("Duración de la ronda: media %.2f ms, máxima %.2f ms (piso %.2f ms)\n", totalMs / o.transactions, maxMs,
+               floorMs);
+
+        // Una ronda completa no baja del piso: si la más larga queda debajo, el piso está mal
+        if (o.transactions > 0 && maxMs < floorMs - toleranceMs) {
+            printf("Ronda más corta que el piso del bus\n");
+            problems++;
+        }
+        problems += mismatches + probe.badRequests;
+        if (o.drop == 0) {
+            bool muteConfigured = false;
+            for (uint8_t id : SLAVE_IDS) {
+                muteConfigured = muteConfigured || id == o.mute;
+            }
+            uint32_t expected = (slaves - (muteConfigured ? 1 : 0)) * o.transactions;
+            problems += answered < expected ? expected - answered : 0;
+        }
+        return problems;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options o;
+    if (!parse(argc, argv, o)) {
+        printf("Uso: %s [--transactions N] [--probe-delay MS] [--drop P] [--timeout MS] [--seed N] [--modbus] "
+               "[--mute ID] [--verbose]\n",
+               argv[0]);
+        return 1;
+    }
+    int master, slave;
+    if (!openPty(master, slave)) {
+        perror("pty");
+        return 1;
+    }
+    Serial.setEnabled(o.verbose);
+    SimUart::attach(RS485_UART_NUM, slave);
+
+    Probe probe(master, o);
+    probe.start();
+
+    uint32_t problems = 0;
+    RS485Manager rs485(nullptr, RS485_RE_DE, RS485_BAUDRATE, o.timeoutMs, RS485_RETRY_COUNT);
+    const SimUart::State &uart = SimUart::state(RS485_UART_NUM);
+    if (!rs485.begin() || uart.mode != UART_MODE_RS485_HALF_DUPLEX || uart.rtsPin != RS485_RE_DE ||
+        uart.baudRate != RS485_BAUDRATE) {
+        printf("begin(): UART%d sin RS485 half duplex a %d baudios con RTS en el pin %d\n", RS485_UART_NUM,
+               RS485_BAUDRATE, RS485_RE_DE);
+        probe.stop();
+        return 2;
+    }
+    if (o.modbus) {
+        problems += runModbus(rs485, probe, o);
+        probe.stop();
+        return problems == 0 ? 0 : 2;
+    }
+    if (!rs485.sendPing()) {
+        printf("PING sin PONG\n");
+        problems++;
+    }
+
+    uint32_t ok = 0;
+    uint32_t mismatches = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    double maxTurnaroundUs = 0;
+    for (uint32_t i = 0; i < o.transactions; i++) {
+        Protocol::GroundSensor got = {};
+        Clock::time_point start = Clock::now();
+        bool done = rs485.requestSensorData(got);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        maxTurnaroundUs = uart.lastTurnaroundUs > maxTurnaroundUs ? uart.lastTurnaroundUs : maxTurnaroundUs;
+        if (!done) {
+            continue;
+        }
+        ok++;
+        totalMs += ms;
+        maxMs = ms > maxMs ? ms : maxMs;
+        if (!sameReading(got, probe.last())) {
+            mismatches++;
+        }
+    }
+    probe.stop();
+
+    const uint32_t frameBytes = 1 + 1 + sizeof(Protocol::GroundSensorBinary);
+    double busMs = frameBytes * 10000.0 / RS485_BAUDRATE;
+    printf("Bus: UART%d RS485 half duplex, %d baudios, RTS en el pin %d; sonda espera %u ms antes de responder\n",
+           RS485_UART_NUM, RS485_BAUDRATE, RS485_RE_DE, o.probeDelayMs);
+    printf("Transacciones: %u de %u correctas, %u datos distintos de los enviados, %u pedidos ignorados por la sonda\n",
+           ok, o.transactions, mismatches, probe.dropped);
+    printf("Duración: media %.2f ms, máxima %.2f ms (piso: %u bytes en el bus %.2f ms + sonda %u ms)\n",
+           ok ? totalMs / ok : 0.0, maxMs, frameBytes, busMs, o.probeDelayMs);
+    printf("Vuelta a recepción tras el último bit: máxima %.1f us\n", maxTurnaroundUs);
+    printf("SoftwareSerial: %u ms de esperas fijas por intento (RS485_TX_DELAY + 12) y %u bytes con bit-banging\n",
+           RS485_TX_DELAY + 12, frameBytes);
+
+    problems += mismatches;
+    if (o.drop == 0) {
+        problems += o.transactions - ok;
+    }
+    return problems == 0 ? 0 : 2;
+}
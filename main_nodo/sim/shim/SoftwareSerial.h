@@ -0,0 +1,32 @@
+/**
+ * @file SoftwareSerial.h
+ * @brief Shim mínimo de EspSoftwareSerial para compilar RS485Manager en Linux
+ *
+ * Con RS485_HW_UART el transporte es el driver UART (driver/uart.h) y este
+ * puerto no se abre: solo tiene que compilar. No recibe nada.
+ */
+
+#ifndef SIM_SOFTWARE_SERIAL_H
+#define SIM_SOFTWARE_SERIAL_H
+
+#include <Arduino.h>
+
+#define SWSERIAL_8N1 0
+
+class SoftwareSerial
+{
+public:
+    SoftwareSerial(int8_t rxPin, int8_t txPin) { (void)rxPin; (void)txPin; }
+    void begin(uint32_t baud, int config, int8_t rxPin, int8_t txPin, bool invert, int bufferSize)
+    {
+        (void)baud; (void)config; (void)rxPin; (void)txPin; (void)invert; (void)bufferSize;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t byte) { (void)byte; return 1; }
+    size_t write(const uint8_t *data, size_t len) { (void)data; return len; }
+    size_t readBytes(char *data, size_t len) { (void)data; (void)len; return 0; }
+    void flush() {}
+};
+
+#endif // SIM_SOFTWARE_SERIAL_H
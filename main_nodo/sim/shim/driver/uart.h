@@ -0,0 +1,100 @@
+/**
+ * @file uart.h
+ * @brief Shim del driver UART del ESP-IDF sobre un descriptor POSIX (env:native_rs485_sim)
+ *
+ * Implementa solo lo que usa RS485Manager con RS485_HW_UART. Cada puerto se
+ * conecta con SimUart::attach() a un descriptor (el esclavo de un pty) y las
+ * lecturas y escrituras van a él en tiempo real: uart_read_bytes() bloquea
+ * hasta tener los bytes o vencer el timeout, como con FreeRTOS.
+ *
+ * uart_wait_tx_done() espera lo que la trama tarda en el bus (10 bits por
+ * byte al baudrate configurado). En UART_MODE_RS485_HALF_DUPLEX el shim
+ * lleva RTS como el driver: alto desde uart_write_bytes() hasta el fin de la
+ * transmisión; SimUart::state() deja ver el modo, los pines y el tiempo de
+ * vuelta a recepción.
+ */
+
+#ifndef SIM_DRIVER_UART_H
+#define SIM_DRIVER_UART_H
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_TIMEOUT 0x107
+
+#ifndef pdMS_TO_TICKS
+typedef uint32_t TickType_t;
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))  ///< Un tick por milisegundo
+#endif
+
+typedef int uart_port_t;
+#define UART_NUM_MAX 3
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0, UART_PARITY_EVEN = 2, UART_PARITY_ODD = 3 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5 = 2, UART_STOP_BITS_2 = 3 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0, UART_HW_FLOWCTRL_RTS, UART_HW_FLOWCTRL_CTS } uart_hw_flowcontrol_t;
+typedef enum {
+    UART_MODE_UART = 0,
+    UART_MODE_RS485_HALF_DUPLEX,
+    UART_MODE_IRDA,
+    UART_MODE_RS485_COLLISION_DETECT,
+    UART_MODE_RS485_APP_CTRL
+} uart_mode_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+} uart_config_t;
+
+esp_err_t uart_driver_install(uart_port_t port, int rxBufferSize, int txBufferSize, int queueSize,
+                              void *queue, int intrFlags);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t port, int txPin, int rxPin, int rtsPin, int ctsPin);
+esp_err_t uart_set_mode(uart_port_t port, uart_mode_t mode);
+esp_err_t uart_flush_input(uart_port_t port);
+int uart_write_bytes(uart_port_t port, const void *src, size_t size);
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticksToWait);
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticksToWait);
+
+namespace SimUart {
+
+    /**
+     * @struct State
+     * @brief Configuración recibida y actividad de un puerto.
+     */
+    struct State {
+        bool installed;
+        int fd;                  ///< Descriptor conectado con attach() (-1 = ninguno)
+        int baudRate;
+        int txPin;
+        int rxPin;
+        int rtsPin;
+        uart_mode_t mode;
+        bool rtsHigh;            ///< DE/RE en transmisión (solo RS485 half duplex)
+        uint32_t bytesWritten;
+        uint32_t bytesRead;
+        double lastTurnaroundUs; ///< Del último bit enviado a RTS bajo, medido en el host
+    };
+
+    /**
+     * @brief Conecta el puerto a un descriptor abierto en modo crudo
+     */
+    void attach(uart_port_t port, int fd);
+
+    /**
+     * @brief Estado del puerto
+     */
+    const State &state(uart_port_t port);
+}
+
+#endif // SIM_DRIVER_UART_H
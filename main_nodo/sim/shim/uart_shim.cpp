@@ -0,0 +1,169 @@
+/**
+ * @file uart_shim.cpp
+ * @brief Implementación del shim del driver UART sobre descriptores POSIX
+ */
+
+#include "driver/uart.h"
+
+#include <chrono>
+#include <thread>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    SimUart::State ports[UART_NUM_MAX] = {};
+    Clock::time_point txEnd[UART_NUM_MAX];  ///< Cuándo sale del bus el último bit escrito
+    bool initialized = false;
+
+    SimUart::State *port(uart_port_t num)
+    {
+        if (!initialized) {
+            for (SimUart::State &s : ports) {
+                s.fd = -1;
+                s.txPin = s.rxPin = s.rtsPin = UART_PIN_NO_CHANGE;
+            }
+            initialized = true;
+        }
+        return num >= 0 && num < UART_NUM_MAX ? &ports[num] : nullptr;
+    }
+
+    /** @brief Microsegundos que tardan len bytes en el bus (8N1: 10 bits por byte) */
+    uint64_t airUs(const SimUart::State &s, size_t len)
+    {
+        return s.baudRate > 0 ? (uint64_t)len * 10000000ULL / (uint64_t)s.baudRate : 0;
+    }
+}
+
+void SimUart::attach(uart_port_t num, int fd)
+{
+    SimUart::State *s = port(num);
+    if (s != nullptr) {
+        s->fd = fd;
+    }
+}
+
+const SimUart::State &SimUart::state(uart_port_t num)
+{
+    return *port(num);
+}
+
+esp_err_t uart_driver_install(uart_port_t num, int rxBufferSize, int, int, void *, int)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || rxBufferSize <= 128 || s->fd < 0) {
+        return ESP_ERR_INVALID_ARG;  // El IDF exige un buffer mayor que la FIFO
+    }
+    s->installed = true;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t num, const uart_config_t *config)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || config == nullptr || config->baud_rate <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s->baudRate = config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t num, int txPin, int rxPin, int rtsPin, int)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s->txPin = txPin;
+    s->rxPin = rxPin;
+    s->rtsPin = rtsPin;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_mode(uart_port_t num, uart_mode_t mode)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || !s->installed) {
+        return ESP_FAIL;
+    }
+    s->mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t num)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || !s->installed) {
+        return ESP_FAIL;
+    }
+    tcflush(s->fd, TCIFLUSH);
+    return ESP_OK;
+}
+
+int uart_write_bytes(uart_port_t num, const void *src, size_t size)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || !s->installed) {
+        return -1;
+    }
+    if (s->mode == UART_MODE_RS485_HALF_DUPLEX) {
+        s->rtsHigh = true;
+    }
+    txEnd[num] = Clock::now() + std::chrono::microseconds(airUs(*s, size));
+    ssize_t written = write(s->fd, src, size);
+    if (written > 0) {
+        s->bytesWritten += (uint32_t)written;
+    }
+    return (int)written;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t num, TickType_t ticksToWait)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || !s->installed) {
+        return ESP_FAIL;
+    }
+    // El pty entrega enseguida: se espera a que el último envío salga del bus
+    Clock::time_point lastBit = txEnd[num];
+    if (lastBit > Clock::now() + std::chrono::milliseconds(ticksToWait)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    std::this_thread::sleep_until(lastBit);
+    tcdrain(s->fd);
+    if (s->rtsHigh) {
+        s->rtsHigh = false;  // Lo que hace el driver en la interrupción de fin de transmisión
+        s->lastTurnaroundUs = std::chrono::duration<double, std::micro>(Clock::now() - lastBit).count();
+    }
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t num, void *buf, uint32_t length, TickType_t ticksToWait)
+{
+    SimUart::State *s = port(num);
+    if (s == nullptr || !s->installed) {
+        return -1;
+    }
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(ticksToWait);
+    uint8_t *out = static_cast<uint8_t *>(buf);
+    uint32_t got = 0;
+    while (got < length) {
+        long remaining = (long)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (remaining < 0) {
+            break;
+        }
+        pollfd p = {s->fd, POLLIN, 0};
+        if (poll(&p, 1, (int)remaining) <= 0) {
+            break;
+        }
+        ssize_t n = read(s->fd, out + got, length - got);
+        if (n <= 0) {
+            break;
+        }
+        got += (uint32_t)n;
+    }
+    s->bytesRead += got;
+    return (int)got;
+}
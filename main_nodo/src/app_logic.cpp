@@ -1,6 +1,7 @@
 // 03:00 16/6/2025
 //  AppLogic.cpp (Lógica para un nodo sensor)
 #include "app_logic.h" // Incluye la definición de la clase AppLogic.
+#include <esp_sleep.h>
 
 // TODO:queda implementar logica  errores y posible reinicio si se acomulan
 /**
@@ -18,6 +19,7 @@
  * @param identity Referencia al objeto NodeIdentity.
  * @param radioMgr Referencia al objeto RadioManager.
  * @param data Referencia al objeto SensorManager (formalmente GetData).
+ * @param powerMgr Referencia al PowerManager (estado retenido en RTC y deep sleep).
  * @note La declaración en el .h es `AppLogic(NodeIdentity &identity, RadioManager &radioMgr, SensorManager &data, uint8_t gwAddress);`
  * La implementación aquí es `AppLogic(NodeIdentity &identity, RadioManager &radioMgr, SensorManager &data)`.
  * Para que coincida, esta implementación debería aceptar y usar `gwAddress`.
@@ -25,10 +27,11 @@
  * debería ser actualizada para tomar `gwAddress`. Por ahora, documento la versión actual del .cpp
  * e inicializo `gatewayAddress` a un valor por defecto o inválido si no se proporciona.
  */
-AppLogic::AppLogic(SensorManager &data, NodeIdentity &identity, RadioManager &radioMgr)
+AppLogic::AppLogic(SensorManager &data, NodeIdentity &identity, RadioManager &radioMgr, PowerManager &powerMgr)
     : getData(data),
       nodeIdentity(identity),
-      radio(radioMgr)
+      radio(radioMgr),
+      power(powerMgr)
 {
     begin();
 }
@@ -47,21 +50,38 @@ void AppLogic::begin()
     nodeID = nodeIdentity.getNodeID();
     Serial.println("nodeID:");
     Serial.print(String(nodeID));
-    gatwayRegistred = nodeIdentity.getGetway(gatewayAddress);
+    if (LOW_POWER_MODE == 1 && power.wakeReason() != PowerManager::WAKE_COLD)
+    {
+        resume(); // Despertar de deep sleep: el gateway y las muestras están en RTC
+    }
+    else
+    {
+        gatwayRegistred = nodeIdentity.getGetway(gatewayAddress);
+    }
     Serial.println("gatewayAddress:");
     Serial.print(String(gatewayAddress));
-    // Array donde se almacenará la MAC de forma global o en el ámbito necesario
-
-    // Paso 1: Obtener la String de la MAC y guardarla
-    String macStringTemporal = nodeIdentity.getDeviceMAC();
-
-    // Paso 2: Usar toCharArray() sobre esa String para copiarla al array de char
-    // toCharArray() automáticamente añade el '\0' si hay suficiente espacio.
-    macStringTemporal.toCharArray(MacNodeID, MAC_STR_LEN_WITH_NULL);
-    Serial.println("MacNodeID:");
-    Serial.print(MacNodeID);
-    Serial.println("MacNodeID size:");
-    Serial.println(sizeof(MacNodeID));
+    // El HELLO no cambia: MAC en binario, versiones y capacidades
+    nodeIdentity.getDeviceMAC(helloPacket.mac);
+    helloPacket.protocolVersion = Protocol::PROTOCOL_VERSION;
+    helloPacket.firmwareVersion = FIRMWARE_VERSION;
+    helloPacket.capabilities = Protocol::CAP_ATMOSPHERIC | Protocol::CAP_GROUND_GPS | Protocol::CAP_SLOT_SCHEDULE;
+    if (ATMOS_PACKED_ENCODING == 1)
+    {
+        helloPacket.capabilities |= Protocol::CAP_PACKED_ATMOSPHERIC;
+    }
+    helloPacket.capabilities |= Protocol::CAP_LINK_ADR | Protocol::CAP_BROADCAST_POLL;
+    if (BATCH_SEQUENCE_ENABLED == 1)
+    {
+        helloPacket.capabilities |= Protocol::CAP_BATCH_SEQUENCE;
+    }
+    if (NODE_TASKS_ENABLED == 1 && LOW_POWER_MODE != 1)
+    {
+        helloPacket.capabilities |= Protocol::CAP_GROUND_CACHE; // La tarea RS485 de NodeTasks lee de antemano
+    }
+    Serial.printf("MAC: %02X:%02X:%02X:%02X:%02X:%02X, protocolo v%u, firmware v%u, capacidades 0x%02X\n",
+                  helloPacket.mac[0], helloPacket.mac[1], helloPacket.mac[2],
+                  helloPacket.mac[3], helloPacket.mac[4], helloPacket.mac[5],
+                  helloPacket.protocolVersion, helloPacket.firmwareVersion, helloPacket.capabilities);
     Serial.println("[DEBUG] AppLogic::begin FIN");
 }
 
@@ -83,8 +103,18 @@ void AppLogic::update()
     uint8_t from = 0;
     uint8_t flag = 0;
 
+    if (LOW_POWER_MODE == 1)
+    {
+        uint32_t ahora = clockMs();
+        power.tick(ahora);
+        if (!radio.isReady() && power.needsRadio(ahora, slotPending, slotAt))
+        {
+            wakeRadio();
+        }
+    }
+
     // Intenta recibir un mensaje.
-    if (radio.recvMessage(buf, &len, &from, &flag))
+    if (radio.isReady() && radio.recvMessage(buf, &len, &from, &flag))
     {
         Serial.print(F("---------------[AppLogic] Mensaje recibido de 0x"));
         Serial.print(String(from));
@@ -108,9 +138,40 @@ void AppLogic::update()
                 Serial.print("----------------Tipo de mensaje-------------------/n: 0x");
                 Serial.println(String(flag));
                 Serial.print("REQUEST_DATA_ATMOSPHERIC: 0x");
-                sendAtmosphericData();
+                if (len >= 2)
+                {
+                    gatewayFeatures = buf[1]; // [KEY, features] desde protocolo 3
+                }
+                if (len >= sizeof(Protocol::PollWindow))
+                {
+                    applyPollWindow(buf, len); // Pedido broadcast: se responde en el slot
+                }
+                else
+                {
+                    power.cycleHeard(clockMs()); // Sondeo unicast: también marca el ciclo
+                    sendAtmosphericData(true);
+                }
+                break;
+            case Protocol::MessageType::LINK_PROFILE:
+                handleLinkProfile(buf, len);
+                break;
+            case Protocol::MessageType::BATCH_ACK:
+                handleBatchAck(buf, len);
                 break;
             case Protocol::MessageType::REQUEST_DATA_GPC_GROUND:
+                if (len >= 2)
+                {
+                    gatewayFeatures = buf[1]; // [KEY, features] como el pedido atmosférico
+                }
+                if (len >= sizeof(Protocol::GroundRequest) && getData.isTaskMode())
+                {
+                    Protocol::GroundRequest request;
+                    memcpy(&request, buf, sizeof(request));
+                    if (request.intervalS != 0)
+                    {
+                        getData.alignGroundReads(request.intervalS); // Próxima lectura justo antes del próximo pedido
+                    }
+                }
                 sendGroungGpsData();
                 break;
             case Protocol::MessageType::ERROR_DIRECCION:
@@ -123,23 +184,48 @@ void AppLogic::update()
             }
         }
     }
+    radio.update(); // Saludo de FrameAuth pendiente con el gateway
 
-    getData.update();
+    unsigned long tiempoActual = clockMs();
+    if (LOW_POWER_MODE == 1)
+    {
+        if (power.sampleDue(tiempoActual))
+        {
+            getData.sampleAtmospheric(LOW_POWER_GPS_WAIT_MS);
+            power.sampled(tiempoActual);
+        }
+    }
+    else if (getData.isTaskMode())
+    {
+        getData.drainAtmosphericQueue(); // Las muestras las toma la tarea atmosférica (NodeTasks)
+    }
+    else
+    {
+        getData.update();
+    }
 
-    unsigned long tiempoActual = millis();
-    if (tiempoActual - temBuf >= INTERVALOHELLO && gatwayRegistred == true)
+    tiempoActual = clockMs();
+    if (slotPending && (long)(tiempoActual - slotAt) >= 0)
+    {
+        slotPending = false;
+        sendAtmosphericData(false);
+    }
+    if (tiempoActual - temBuf >= INTERVALOHELLO && gatwayRegistred == true && radio.isReady())
     {
         temBuf = tiempoActual;
         sendHello();
     }
+
+    if (LOW_POWER_MODE == 1)
+    {
+        sleepIfIdle(clockMs());
+    }
 }
 /**
  * @brief Envía un mensaje HELLO al Gateway.
  *
- * Crea un mensaje de tipo `Protocol::HELLO`.
- * Establece el `nodeID` del mensaje con la identidad de este nodo.
- * El `jsonPayload` para un mensaje HELLO es actualmente una cadena JSON vacía "{}".
- * Serializa el mensaje y lo envía a través de `radio.sendMessage()` al `gatewayAddress`.
+ * Envía `helloPacket` (Protocol::HelloPacket, armado en begin()) con tipo
+ * `Protocol::HELLO` a través de `radio.sendMessage()` al `gatewayAddress`.
  * Registra el envío en la consola serial.
  */
 void AppLogic::sendHello()
@@ -152,7 +238,7 @@ void AppLogic::sendHello()
 
     // 1. Debug del buffer y su tamaño
     Serial.print(F("[AppLogic] Tamano del buffer (sizeof): "));
-    Serial.println(MAC_STR_LEN_WITH_NULL);
+    Serial.println(sizeof(helloPacket));
 
     // 2. Debug de la dirección del gateway
     Serial.print(F("[AppLogic] Direccion del Gateway (gatewayAddress): "));
@@ -167,7 +253,7 @@ void AppLogic::sendHello()
     bool sendResult = false;
     unsigned long sendStartTime = millis();
 
-    sendResult = radio.sendMessage(gatewayAddress, reinterpret_cast<uint8_t*>(MacNodeID), MAC_STR_LEN_WITH_NULL, static_cast<uint8_t>(Protocol::MessageType::HELLO));
+    sendResult = radio.sendMessage(gatewayAddress, reinterpret_cast<uint8_t*>(&helloPacket), sizeof(helloPacket), static_cast<uint8_t>(Protocol::MessageType::HELLO));
 
     unsigned long totalTime = millis() - startTime;
     Serial.print(F("[AppLogic] Tiempo total: "));
@@ -182,6 +268,7 @@ void AppLogic::sendHello()
 
 
 
+    power.listen(clockMs() + LOW_POWER_RX_WINDOW_MS); // Un ERROR_DIRECCION llegaría enseguida
     if (sendResult)
     {
         Serial.println(F("[AppLogic] HELLO enviado exitosamente."));
@@ -210,7 +297,8 @@ void AppLogic::handleAnnounce(uint8_t *buf, uint8_t len, uint8_t from)
 
     if (gatwayRegistred == true && gatewayAddress == from)
     {
-        Serial.println("Gateway ya registrado y es el mismo remitente. Ignorando ANNOUNCE.");
+        Serial.println("Gateway ya registrado y es el mismo remitente. Solo se actualiza el slot.");
+        applySlotSchedule(buf, len);
         Serial.println("--- handleAnnounce FIN ---");
         return; // Salir de la función si el gateway ya está registrado y es el mismo
     }
@@ -234,6 +322,7 @@ void AppLogic::handleAnnounce(uint8_t *buf, uint8_t len, uint8_t from)
         Serial.print("Nueva gatewayAddress establecida: ");
         Serial.println(String(gatewayAddress)); // Convierte uint8_t a String
         Serial.println("Gateway registrado: TRUE");
+        applySlotSchedule(buf, len);
     }
     else
     {
@@ -245,42 +334,217 @@ void AppLogic::handleAnnounce(uint8_t *buf, uint8_t len, uint8_t from)
 }
 
 /**
- * @brief Envía los datos actuales del sensor al Gateway.
+ * @brief Agenda el envío atmosférico en el slot asignado por el gateway.
+ *
+ * El slot es la posición de este nodo entre los IDs marcados en el bitmap
+ * del calendario; el tiempo se cuenta desde ahora (recepción del ANNOUNCE).
+ * Si el ANNOUNCE no trae calendario o el nodo no figura (todavía no fue
+ * registrado por su HELLO) no se agenda nada y se espera el pedido del gateway.
+ * Un calendario sin el byte `features` (gateway de protocolo 2) lo deja en 0.
+ */
+void AppLogic::applySlotSchedule(const uint8_t *buf, uint8_t len)
+{
+    slotPending = false;
+    if (len < offsetof(Protocol::SlotSchedule, features))
+    {
+        return;
+    }
+    uint32_t ahora = clockMs();
+    power.cycleHeard(ahora); // Con o sin slot propio, el ANNOUNCE abre el ciclo
+    Protocol::SlotSchedule schedule = {};
+    memcpy(&schedule, buf, len < sizeof(schedule) ? len : sizeof(schedule));
+    gatewayFeatures = schedule.features;
+    uint16_t position;
+    if (!slotPosition(schedule.nodes, position))
+    {
+        Serial.println("[AppLogic] ANNOUNCE sin slot para este nodo.");
+        return;
+    }
 
+    slotAt = ahora + schedule.firstSlotMs + (unsigned long)position * schedule.slotMs;
+    slotPending = true;
+    Serial.printf("[AppLogic] Slot %u asignado, envío en %lu ms.\n", position, slotAt - ahora);
+}
+
+/**
+ * @brief Agenda la respuesta a un REQUEST_DATA_ATMOSPHERIC broadcast.
+ *
+ * Igual que el calendario del ANNOUNCE: el slot es la posición de este nodo
+ * entre los IDs marcados en el bitmap del pedido. Con un perfil de enlace
+ * propio también se responde en el slot: el envío en slot sale en el perfil
+ * default. Si el nodo no está marcado, el gateway lo pide después unicast.
+ */
+void AppLogic::applyPollWindow(const uint8_t *buf, uint8_t len)
+{
+    Protocol::PollWindow window;
+    if (len < sizeof(window))
+    {
+        return;
+    }
+    memcpy(&window, buf, sizeof(window));
+    uint32_t ahora = clockMs();
+    power.cycleHeard(ahora);
+    uint16_t slot;
+    if (!slotPosition(window.nodes, slot))
+    {
+        Serial.println("[AppLogic] Pedido broadcast sin slot para este nodo.");
+        return;
+    }
+    slotAt = ahora + window.firstSlotMs + (unsigned long)slot * window.slotMs;
+    slotPending = true;
+    Serial.printf("[AppLogic] Pedido broadcast: slot %u, envío en %lu ms.\n", slot, slotAt - ahora);
+}
+
+bool AppLogic::slotPosition(const uint8_t *nodes, uint16_t &position) const
+{
+    if ((nodes[nodeID / 8] & (1 << (nodeID % 8))) == 0)
+    {
+        return false;
+    }
+    position = 0;
+    for (uint8_t i = 0; i < nodeID / 8; i++)
+    {
+        position += __builtin_popcount(nodes[i]);
+    }
+    position += __builtin_popcount(nodes[nodeID / 8] & ((1 << (nodeID % 8)) - 1));
+    return true;
+}
+
+/**
+ * @brief Guarda el perfil de radio del enlace ordenado por el gateway.
+ *
+ * LINK_PROFILE llega en el perfil default; el perfil guardado solo se usa
+ * para responder REQUEST_DATA_ATMOSPHERIC (ver sendAtmosphericData()).
  */
-void AppLogic::sendAtmosphericData()
+void AppLogic::handleLinkProfile(const uint8_t *buf, uint8_t len)
 {
+    Protocol::LinkProfileCommand command;
+    if (len != sizeof(command))
+    {
+        Serial.println("[AppLogic] LINK_PROFILE con largo inválido.");
+        return;
+    }
+    memcpy(&command, buf, sizeof(command));
+    if (command.key != Protocol::KEY || command.profile >= Protocol::RADIO_PROFILE_COUNT ||
+        command.txPower < 2 || command.txPower > 20)
+    {
+        Serial.println("[AppLogic] LINK_PROFILE inválido.");
+        return;
+    }
+    linkProfile = command.profile;
+    linkTxPower = command.txPower;
+    linkFailures = 0;
+    Serial.printf("[AppLogic] Perfil del enlace: SF%u, %u kHz, %d dBm.\n",
+                  Protocol::RADIO_PROFILES[linkProfile].spreadingFactor,
+                  Protocol::RADIO_PROFILES[linkProfile].bandwidthKhz, linkTxPower);
+}
+
+/**
+ * @brief Envía los datos actuales del sensor al Gateway.
+ *
+ * El lote es SampleRing::window(): las últimas NUMERO_MUESTRAS_ATMOSFERICAS
+ * muestras o, si quedaron pendientes de pedidos sin ACK, las más viejas sin
+ * confirmar. Se arma directo desde los dos tramos del anillo, sin juntarlo
+ * antes, y la confirmación avanza la cola: las muestras no se repiten ni se
+ * pierden entre pedidos (salvo que el anillo se llene, ver SampleRing::dropped()).
+ *
+ * El ACK de RadioHead solo confirma el primer salto. Si el gateway anunció
+ * FEATURE_BATCH_ACK y el lote lleva número, la cola avanza recién con el
+ * BATCH_ACK de ese número (handleBatchAck()); si no llega, el próximo envío
+ * repite el lote. Con un gateway sin BATCH_ACK basta el ACK de RadioHead.
+ *
+ * Si el gateway anunció FEATURE_PACKED_ATMOSPHERIC el lote viaja comprimido
+ * con AtmosCodec (~25-30 bytes contra 48); si no lo anunció o la compresión
+ * no ahorra nada se envía el lote crudo.
+ *
+ * Con useLinkProfile y un perfil asignado la respuesta sale en ese perfil y
+ * la radio vuelve al default al terminar. Tras ADR_NODE_MAX_FAILURES envíos
+ * sin ACK el nodo vuelve al default; el gateway hace lo mismo al no recibirlos.
+ */
+void AppLogic::sendAtmosphericData(bool useLinkProfile)
+{
+    if (getData.isTaskMode())
+    {
+        getData.drainAtmosphericQueue(); // Lo último de la tarea atmosférica
+        if (getData.atmosRing.written() < NUMERO_MUESTRAS_ATMOSFERICAS)
+        {
+            Serial.println(F("[AppLogic] Todavía no hay un lote atmosférico completo; no se responde."));
+            return;
+        }
+    }
+    else
+    {
+        getData.readSensorsAtmospheric(); // Tras el arranque en frío completa el primer lote
+    }
+    SampleRing &ring = getData.atmosRing;
+    SampleRing::Segment first, second;
+    uint32_t end;
+    uint8_t count = ring.window(NUMERO_MUESTRAS_ATMOSFERICAS, first, second, end);
+
     // Imprimir información de depuración antes de enviar
     Serial.println("[DEBUG] ---- DEPURACIÓN DE ENVÍO DE DATA ATMOSFÉRICA ----");
-
-    Serial.print("Tamaño de DATA atmosferica a enviar: ");
-    Serial.println(sizeof(getData.atmosSamples));
     Serial.print("RH_MESH_MAX_MESSAGE_LEN: ");
     Serial.println(RH_MESH_MAX_MESSAGE_LEN);
-    Serial.print("Número de muestras atmosféricas: ");
-    Serial.println(getData.atmosSampleCount);
-    // Imprimir las primeras muestras para ver su contenido
-
-    for (int i = 0; i <= getData.atmosSampleCount; ++i)
-    {
-        Serial.print("Muestra ");
-        Serial.print(i);
-        Serial.print(": temp=");
-        Serial.print(getData.atmosSamples[i].temp);
-        Serial.print(", humedad=");
-        Serial.print(getData.atmosSamples[i].moisture);
-        Serial.print(", hora=");
-        Serial.print(getData.atmosSamples[i].hour);
-        Serial.print(":");
-        Serial.println(getData.atmosSamples[i].minute);
-    }
-    // Enviar el mensaje con la estructura de prueba
+    Serial.printf("Lote: muestras %lu a %lu, %lu sin confirmar, %lu pisadas sin ACK\n", (unsigned long)(end - count),
+                  (unsigned long)(end - 1), (unsigned long)ring.pending(), (unsigned long)ring.dropped());
+    for (uint32_t i = end - count; i < end; ++i)
+    {
+        const Protocol::AtmosphericSample &s = ring.sample(i);
+        Serial.printf("Muestra %lu: temp=%d, humedad=%u, hora=%u:%u, unix=%lu\n", (unsigned long)i, s.temp,
+                      s.moisture, s.hour, s.minute, (unsigned long)ring.timestamp(i));
+    }
+
+    // Sin muestra nueva ni ACK desde el último envío es el mismo lote: el gateway descarta el repetido
+    const size_t sampleLen = sizeof(Protocol::AtmosphericSample);
+    uint8_t payload[sizeof(Protocol::BatchHeader) + NUMERO_MUESTRAS_ATMOSFERICAS * sizeof(Protocol::AtmosphericSample)];
+    uint8_t headerLen = batchHeader(end != batchReadings, payload);
+    batchReadings = end;
+    uint8_t *body = payload + headerLen;
+    size_t bodyLen = 0;
+    if (ATMOS_PACKED_ENCODING == 1 && (gatewayFeatures & Protocol::FEATURE_PACKED_ATMOSPHERIC))
+    {
+        bodyLen = AtmosCodec::encode(first.samples, first.count, second.samples, second.count,
+                                     SAMPLEINTERVALMSATMOSPHERIC / 1000, body, sizeof(payload) - headerLen);
+        Serial.printf("Lote comprimido: %u bytes\n", (unsigned)bodyLen);
+    }
+    if (bodyLen == 0)
+    {
+        memcpy(body, first.samples, first.count * sampleLen);
+        memcpy(body + first.count * sampleLen, second.samples, second.count * sampleLen);
+        bodyLen = count * sampleLen;
+    }
+    uint8_t payloadLen = (uint8_t)(headerLen + bodyLen);
+    bool linkSwitched = useLinkProfile && (linkProfile != Protocol::RADIO_PROFILE_DEFAULT || linkTxPower != RADIO_TX_POWER);
+    if (linkSwitched)
+    {
+        delay(ADR_SWITCH_GUARD_MS);
+        radio.applyProfile(linkProfile, linkTxPower);
+    }
     Serial.println("[DEBUG] 7. Antes de radio.sendMessage (DATA_ATMOSPHERIC)");
-    bool ok = radio.sendMessage(gatewayAddress, reinterpret_cast<uint8_t *>(&getData.atmosSamples), sizeof(getData.atmosSamples), Protocol::MessageType::DATA_ATMOSPHERIC);
+    bool ok = radio.sendMessage(gatewayAddress, payload, payloadLen, Protocol::MessageType::DATA_ATMOSPHERIC);
     Serial.println("[DEBUG] 8. Después de radio.sendMessage (DATA_ATMOSPHERIC)");
+    if (linkSwitched)
+    {
+        radio.applyProfile(Protocol::RADIO_PROFILE_DEFAULT);
+        linkFailures = ok ? 0 : linkFailures + 1;
+        if (linkFailures >= ADR_NODE_MAX_FAILURES)
+        {
+            Serial.println("[AppLogic] Enlace sin ACK en su perfil, vuelve al default.");
+            linkProfile = Protocol::RADIO_PROFILE_DEFAULT;
+            linkTxPower = RADIO_TX_POWER;
+            linkFailures = 0;
+        }
+    }
 
+    power.listen(clockMs() + LOW_POWER_RX_WINDOW_MS); // BATCH_ACK y pedidos del gateway tras el lote
+    atmosSeq = batchSeq;
+    atmosAckPending = headerLen > 0 && (gatewayFeatures & Protocol::FEATURE_BATCH_ACK);
     if (ok)
     {
+        if (!atmosAckPending)
+        {
+            ring.ack(end); // Gateway sin BATCH_ACK: vale el ACK del primer salto
+        }
         Serial.println(F("[AppLogic] DATA atmosferica enviado exitosamente."));
     }
     else
@@ -291,28 +555,78 @@ void AppLogic::sendAtmosphericData()
 }
 
 /**
- * @brief Envía los datos actuales del sensor al Gateway.
+ * @brief Avanza la cola del anillo con la confirmación del gateway.
+ *
+ * Solo vale para el último lote atmosférico enviado: un BATCH_ACK de un lote
+ * anterior llega tarde y el último ya lo incluye o lo repetirá. El número se
+ * compara contra atmosSeq y no contra batchSeq, que también avanza con los
+ * lotes de suelo.
+ */
+void AppLogic::handleBatchAck(const uint8_t *buf, uint8_t len)
+{
+    Protocol::BatchAck ack;
+    if (len < sizeof(ack))
+    {
+        Serial.println("[AppLogic] BATCH_ACK con largo inválido.");
+        return;
+    }
+    memcpy(&ack, buf, sizeof(ack));
+    if (ack.key != Protocol::KEY || !atmosAckPending || ack.seq != atmosSeq)
+    {
+        Serial.printf("[AppLogic] BATCH_ACK del lote %u ignorado (esperado %u).\n", ack.seq, atmosSeq);
+        return;
+    }
+    atmosAckPending = false;
+    getData.atmosRing.ack(batchReadings);
+    Serial.printf("[AppLogic] Lote %u guardado por el gateway; %lu muestras sin confirmar.\n", ack.seq,
+                  (unsigned long)getData.atmosRing.pending());
+}
 
+/**
+ * @brief Envía los datos actuales del sensor al Gateway.
+ *
+ * Con NodeTasks responde enseguida con la última lectura de la tarea RS485
+ * (CAP_GROUND_CACHE) y, si el gateway lo acepta, su antigüedad
+ * (Protocol::GroundAge); un reintento con la misma lectura repite el número de
+ * lote. Sin tareas lee suelo, energía y GPS ahora (hasta ~3 s por RS485).
  */
 void AppLogic::sendGroungGpsData()
 {
-    getData.readGroundGpsSensors();
     Protocol::GroundGpsPacket packet;
-    packet.ground = getData.groundData;
-    // Usar la última coordenada guardada
-    auto lastCoord = getData.getLastGpsCoordinate();
-    packet.gps.latitude = lastCoord.latitude;
-    packet.gps.longitude = lastCoord.longitude;
-    packet.gps.hour = lastCoord.hour;
-    packet.gps.minute = lastCoord.minute;
-    // Mantener altitud y flags como estaban
-    packet.gps.altitude = getData.gpsData.altitude;
-    packet.gps.flags = getData.gpsData.flags;
-    // Agregar datos de energía
-    packet.energy = getData.energyData;
+    bool newBatch = true; // Sin tareas cada pedido es una lectura nueva
+    Protocol::GroundAge age = {0};
+    bool withAge = false;
+    if (getData.isTaskMode())
+    {
+        SensorManager::GroundReading reading;
+        if (!getData.latestGroundGps(reading))
+        {
+            Serial.println(F("[AppLogic] La tarea RS485 todavía no terminó una lectura; no se responde."));
+            return;
+        }
+        packet = reading.packet;
+        newBatch = reading.number != groundSent;
+        groundSent = reading.number;
+        uint32_t ageS = (millis() - reading.readAt) / 1000UL;
+        age.ageS = ageS < 0xFFFF ? (uint16_t)ageS : 0xFFFF;
+        withAge = (gatewayFeatures & Protocol::FEATURE_GROUND_AGE) != 0;
+    }
+    else
+    {
+        getData.readGroundGpsSensors();
+        packet = getData.groundGpsPacket();
+    }
+    uint8_t payload[sizeof(Protocol::BatchHeader) + sizeof(packet) + sizeof(age)];
+    uint8_t payloadLen = withBatchHeader(newBatch, reinterpret_cast<uint8_t *>(&packet), sizeof(packet), payload);
+    if (withAge)
+    {
+        memcpy(payload + payloadLen, &age, sizeof(age));
+        payloadLen += sizeof(age);
+    }
     Serial.println("[DEBUG] Antes de radio.sendMessage (DATA_GPS_CROUND)");
-    bool ok = radio.sendMessage(gatewayAddress, reinterpret_cast<uint8_t *>(&packet), sizeof(packet), Protocol::MessageType::DATA_GPS_CROUND);
+    bool ok = radio.sendMessage(gatewayAddress, payload, payloadLen, Protocol::MessageType::DATA_GPS_CROUND);
     Serial.println("[DEBUG] Después de radio.sendMessage (DATA_GPS_CROUND)");
+    power.listen(clockMs() + LOW_POWER_RX_WINDOW_MS);
     if (ok)
     {
         Serial.println(F("[AppLogic] DATA gps, ground y energía enviado exitosamente."));
@@ -323,6 +637,36 @@ void AppLogic::sendGroungGpsData()
     }
 }
 
+/**
+ * @brief Numera el lote con Protocol::BatchHeader.
+ *
+ * Un contador para DATA_ATMOSPHERIC y DATA_GPS_CROUND. El primer lote desde
+ * el arranque lleva 0 (el gateway reinicia su cuenta) y al dar la vuelta se
+ * salta el 0.
+ */
+uint8_t AppLogic::withBatchHeader(bool newBatch, const uint8_t *data, uint8_t len, uint8_t *out)
+{
+    uint8_t headerLen = batchHeader(newBatch, out);
+    memcpy(out + headerLen, data, len);
+    return (uint8_t)(headerLen + len);
+}
+
+uint8_t AppLogic::batchHeader(bool newBatch, uint8_t *out)
+{
+    if (BATCH_SEQUENCE_ENABLED != 1 || !(gatewayFeatures & Protocol::FEATURE_BATCH_SEQUENCE))
+    {
+        return 0;
+    }
+    if (newBatch && batchSent && ++batchSeq == 0)
+    {
+        batchSeq = 1;
+    }
+    batchSent = true;
+    Protocol::BatchHeader header = {batchSeq};
+    memcpy(out, &header, sizeof(header));
+    return sizeof(header);
+}
+
 void AppLogic::changeID(uint8_t *buf, uint8_t len)
 {
     Serial.println("Error de dirección detectado.");
@@ -337,4 +681,96 @@ void AppLogic::changeID(uint8_t *buf, uint8_t len)
         nodeID = nodeIdentity.changeNodeID(1, blacklist);
     }
     sendHello(); // envio de Hello nuevamente
-}
\ No newline at end of file
+}
+
+uint32_t AppLogic::clockMs() const
+{
+    return power.clock(millis());
+}
+
+void AppLogic::resume()
+{
+    PowerManager::Memory &m = power.memory();
+    getData.atmosRing = m.atmosRing;
+    gatewayAddress = m.gatewayAddress;
+    gatwayRegistred = m.gatewayRegistered;
+    gatewayFeatures = m.gatewayFeatures;
+    linkProfile = m.linkProfile;
+    linkTxPower = m.linkTxPower;
+    batchSeq = m.batchSeq;
+    batchSent = m.batchSent;
+    batchReadings = m.batchReadings;
+    slotPending = m.slotPending;
+    slotAt = m.slotAt;
+    temBuf = m.helloAt;
+}
+
+void AppLogic::suspend()
+{
+    PowerManager::Memory &m = power.memory();
+    m.atmosRing = getData.atmosRing;
+    m.gatewayAddress = gatewayAddress;
+    m.gatewayRegistered = gatwayRegistred;
+    m.gatewayFeatures = gatewayFeatures;
+    m.linkProfile = linkProfile;
+    m.linkTxPower = linkTxPower;
+    m.batchSeq = batchSeq;
+    m.batchSent = batchSent;
+    m.batchReadings = batchReadings;
+    m.slotPending = slotPending;
+    m.slotAt = slotAt;
+    m.helloAt = temBuf;
+    if (radio.isReady())
+    {
+        // Sin radio en este despertar quedan la ruta y los contadores del anterior
+        uint8_t nextHop;
+        m.gatewayNextHop = radio.getRoute(gatewayAddress, nextHop) ? nextHop : 0;
+        m.auth = radio.getAuth().snapshot(gatewayAddress);
+        m.authSaved = true;
+    }
+}
+
+void AppLogic::wakeRadio()
+{
+    radio.init();
+    PowerManager::Memory &m = power.memory();
+    if (AUTH_ENABLED == 1 && m.authSaved && !radio.restoreAuth(m.auth))
+    {
+        Serial.println("[AppLogic] Contadores de FrameAuth retenidos no coinciden con flash: se sigue desde flash.");
+    }
+    if (m.gatewayNextHop != 0)
+    {
+        radio.seedRoute(gatewayAddress, m.gatewayNextHop); // Sin descubrimiento de ruta en cada despertar
+    }
+}
+
+/**
+ * @brief Duerme hasta el próximo evento de PowerManager.
+ *
+ * Antes de dormir se guarda el estado en RTC y se suma al modelo de consumo
+ * lo que duró el despertar: radio encendida como RX, sendMessage() como TX
+ * (incluye la espera del ACK, así que sobreestima) y el resto como CPU.
+ */
+void AppLogic::sleepIfIdle(uint32_t now)
+{
+    uint32_t wakeAt;
+    if (!power.planSleep(now, slotPending, slotAt, wakeAt))
+    {
+        return;
+    }
+    suspend();
+    uint32_t awakeMs = millis();
+    uint32_t radioMs = radio.getOnTimeMs();
+    uint32_t txMs = radio.getTxTimeMs();
+    power.account(PowerManager::TX, txMs);
+    power.account(PowerManager::RX, radioMs - txMs);
+    power.account(PowerManager::CPU, awakeMs - radioMs);
+    radio.sleep();
+    power.sleep(now, wakeAt);
+    Serial.printf("[AppLogic] Deep sleep de %lu ms (motivo %u, despierto %lu ms, %lu uA promedio).\n",
+                  (unsigned long)(wakeAt - now), power.wakeReason(), (unsigned long)awakeMs,
+                  (unsigned long)power.averageCurrentUa());
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup((uint64_t)(wakeAt - now) * 1000ULL);
+    esp_deep_sleep_start();
+}
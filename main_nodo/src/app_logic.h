@@ -6,7 +6,9 @@
 #include "node_identity.h"  // Para NodeIdentity (dirección MAC, clave)
 #include "radio_manager.h"  // Para RadioManager (gestión de radio LoRa)
 #include "protocol.h"       // Para Protocol (serialización/deserialización de mensajes)
+#include "atmos_codec.h"    // Para AtmosCodec (DATA_ATMOSPHERIC comprimido)
 #include "sensor_manager.h" // Para GetData (obtención de datos de sensores)
+#include "power_manager.h"  // Para PowerManager (deep sleep con LOW_POWER_MODE)
 #include "config.h"
 
 /**
@@ -24,45 +26,134 @@ private:
     SensorManager& getData;      ///< Referencia al gestor de sensores
     NodeIdentity& nodeIdentity;  ///< Referencia a la identidad del nodo
     RadioManager& radio;         ///< Referencia al gestor de radio LoRa mesh
+    PowerManager& power;         ///< Calendario de despertares y estado retenido en RTC
     uint8_t gatewayAddress;      ///< Dirección del gateway asociado
     uint8_t nodeID;              ///< ID lógico del nodo
     bool gatwayRegistred = false;///< Flag de registro de gateway
-    unsigned long temBuf = 0;    ///< Buffer de tiempo para control de envíos
-    char MacNodeID[MAC_STR_LEN_WITH_NULL]; ///< MAC del nodo en formato char[]
+    unsigned long temBuf = 0;    ///< Reloj del nodo (PowerManager::clock()) del último HELLO
+    Protocol::HelloPacket helloPacket;   ///< Payload del HELLO, armado una vez en begin()
+    bool slotPending = false;    ///< Hay un envío atmosférico agendado por el calendario de slots
+    unsigned long slotAt = 0;    ///< Reloj del nodo (PowerManager::clock()) de inicio del slot asignado
+    uint8_t gatewayFeatures = 0; ///< Protocol::GatewayFeature del último ANNOUNCE o REQUEST
+    uint8_t linkProfile = Protocol::RADIO_PROFILE_DEFAULT; ///< Perfil ordenado por LINK_PROFILE para responder pedidos
+    int8_t linkTxPower = RADIO_TX_POWER;  ///< Potencia ordenada por LINK_PROFILE
+    uint8_t linkFailures = 0;    ///< Respuestas seguidas sin ACK en el perfil del enlace
+    uint16_t batchSeq = 0;       ///< Protocol::BatchHeader del último lote enviado
+    bool batchSent = false;      ///< Ya se envió un lote desde el arranque
+    uint32_t batchReadings = 0;  ///< Fin en SampleRing (SampleRing::window()) del último lote atmosférico
+    uint16_t atmosSeq = 0;       ///< Protocol::BatchHeader del último lote atmosférico enviado
+    bool atmosAckPending = false;///< Ese lote espera BATCH_ACK para avanzar el anillo
+    uint32_t groundSent = 0;     ///< GroundReading::number de la última respuesta de suelo (modo tareas)
 
     /**
      * @brief Maneja la recepción de mensajes ANNOUNCE del gateway.
      */
     void handleAnnounce(uint8_t *buf, uint8_t len, uint8_t from);
 
+    /**
+     * @brief Agenda el envío atmosférico según el calendario de slots del ANNOUNCE.
+     * @param buf Payload del ANNOUNCE.
+     * @param len Longitud del payload; si no alcanza para Protocol::SlotSchedule no hay slot.
+     */
+    void applySlotSchedule(const uint8_t *buf, uint8_t len);
+
+    /**
+     * @brief Agenda la respuesta a un REQUEST_DATA_ATMOSPHERIC broadcast.
+     * @param buf Payload del pedido (Protocol::PollWindow).
+     * @param len Longitud del payload; al menos sizeof(Protocol::PollWindow).
+     */
+    void applyPollWindow(const uint8_t *buf, uint8_t len);
+
+    /**
+     * @brief Posición de este nodo entre los IDs marcados en un bitmap de slots.
+     * @param nodes Bitmap de Protocol::SLOT_BITMAP_BYTES bytes (SlotSchedule o PollWindow).
+     * @param position Slot asignado (el ID marcado más bajo usa el 0).
+     * @return false si el nodo no está marcado.
+     */
+    bool slotPosition(const uint8_t *nodes, uint16_t &position) const;
+
     /**
      * @brief Envía un mensaje HELLO al gateway para anunciar el nodo.
      */
     void sendHello();
 
     /**
-     * @brief Envía los datos atmosféricos actuales al gateway.
+     * @brief Guarda el perfil de radio que el gateway asignó a este enlace.
      */
-    void sendAtmosphericData();
+    void handleLinkProfile(const uint8_t *buf, uint8_t len);
+
+    /**
+     * @brief Envía al gateway el lote de SampleRing::window(); la confirmación del gateway avanza la cola del anillo.
+     * @param useLinkProfile true al responder un REQUEST (el gateway espera en el perfil
+     * del enlace); false en el slot, que siempre va en el perfil default.
+     */
+    void sendAtmosphericData(bool useLinkProfile);
+
+    /**
+     * @brief El gateway guardó un lote atmosférico: si es el último enviado avanza la cola del anillo.
+     * @param buf Payload (Protocol::BatchAck).
+     * @param len Longitud del payload.
+     */
+    void handleBatchAck(const uint8_t *buf, uint8_t len);
 
     /**
      * @brief Envía los datos de suelo y GPS actuales al gateway.
      */
     void sendGroungGpsData();
 
+    /**
+     * @brief Antepone Protocol::BatchHeader al payload si el gateway anunció FEATURE_BATCH_SEQUENCE.
+     * @param newBatch false si los datos son los del envío anterior: se repite el número.
+     * @param out Destino; al menos sizeof(Protocol::BatchHeader) + len bytes.
+     * @return Largo escrito en out.
+     */
+    uint8_t withBatchHeader(bool newBatch, const uint8_t *data, uint8_t len, uint8_t *out);
+
+    /**
+     * @brief Escribe solo Protocol::BatchHeader, para armar el resto del payload en su lugar.
+     * @return Bytes escritos en out: 0 si el gateway no anunció FEATURE_BATCH_SEQUENCE.
+     */
+    uint8_t batchHeader(bool newBatch, uint8_t *out);
+
     /**
      * @brief Cambia el ID del nodo en caso de conflicto de dirección.
      */
     void changeID(uint8_t *buf, uint8_t len);
 
+    /**
+     * @brief Reloj del nodo: millis() más lo dormido (igual a millis() sin LOW_POWER_MODE).
+     */
+    uint32_t clockMs() const;
+
+    /**
+     * @brief Recupera del estado retenido en RTC muestras, gateway, lotes y slot.
+     */
+    void resume();
+
+    /**
+     * @brief Guarda en el estado retenido lo que resume() recupera, más la ruta y los contadores de FrameAuth.
+     */
+    void suspend();
+
+    /**
+     * @brief Enciende la radio tras un despertar y le devuelve la ruta y los contadores retenidos.
+     */
+    void wakeRadio();
+
+    /**
+     * @brief Con LOW_POWER_MODE, duerme en deep sleep si PowerManager no pide seguir despierto.
+     */
+    void sleepIfIdle(uint32_t now);
+
 public:
     /**
      * @brief Constructor de AppLogic.
      * @param data Referencia al gestor de sensores.
      * @param identity Referencia a la identidad del nodo.
      * @param radioMgr Referencia al gestor de radio LoRa mesh.
+     * @param powerMgr Referencia al calendario de despertares (LOW_POWER_MODE).
      */
-    AppLogic(SensorManager& data, NodeIdentity& identity, RadioManager& radioMgr);
+    AppLogic(SensorManager& data, NodeIdentity& identity, RadioManager& radioMgr, PowerManager& powerMgr);
 
     /**
      * @brief Inicializa la lógica del nodo (debe llamarse en setup()).
@@ -69,6 +69,169 @@
 // #define RH_MESH_MAX_MESSAGE_LEN 50  // Comentado para evitar conflicto con RadioHead
 #define MAC_STR_LEN_WITH_NULL 18
 
+/**
+ * @def FIRMWARE_VERSION
+ * @brief Versión del firmware del nodo informada en el HELLO (Protocol::HelloPacket).
+ */
+#define FIRMWARE_VERSION 1
+
+/**
+ * @def ATMOS_PACKED_ENCODING
+ * @brief 1: comprimir DATA_ATMOSPHERIC con AtmosCodec si el gateway anuncia Protocol::FEATURE_PACKED_ATMOSPHERIC.
+ */
+#define ATMOS_PACKED_ENCODING 1
+
+/**
+ * @def BATCH_SEQUENCE_ENABLED
+ * @brief 1: numerar los lotes (Protocol::BatchHeader) si el gateway anuncia Protocol::FEATURE_BATCH_SEQUENCE.
+ */
+#define BATCH_SEQUENCE_ENABLED 1
+
+/**
+ * @def ATMOS_RING_CAPACITY
+ * @brief Muestras atmosféricas que guarda el nodo sin BATCH_ACK del gateway (SampleRing); al menos NUMERO_MUESTRAS_ATMOSFERICAS.
+ */
+#define ATMOS_RING_CAPACITY 32
+
+/**
+ * @def AUTH_ENABLED
+ * @brief 1: sellar con FrameAuth (ChaCha20-Poly1305) todo lo que se envía y descartar lo que no abre. Debe coincidir con el gateway.
+ */
+#define AUTH_ENABLED 1
+
+/**
+ * @def AUTH_COUNTER_BLOCK
+ * @brief Contadores de FrameAuth reservados por escritura de /auth_counter.bin (un reinicio salta el resto del bloque).
+ */
+#define AUTH_COUNTER_BLOCK 256
+
+/**
+ * @def AUTH_MAX_PEERS
+ * @brief Remitentes con sesión de FrameAuth (sal y último contador). El nodo solo abre tramas del gateway.
+ */
+#define AUTH_MAX_PEERS 4
+
+/**
+ * @def AUTH_NETWORK_KEY
+ * @brief Clave de red de 32 bytes (FrameAuth::KEY_LEN). Cambiarla en cada instalación; la misma que en el gateway.
+ */
+#define AUTH_NETWORK_KEY { \
+    0x3a, 0x91, 0x5c, 0x07, 0xe2, 0x48, 0xbd, 0x16, 0x6f, 0xd3, 0x20, 0x8e, 0x54, 0xc9, 0x7b, 0x02, \
+    0xa5, 0x1e, 0x63, 0xf8, 0x39, 0xd0, 0x4c, 0xb7, 0x12, 0x86, 0xeb, 0x5f, 0x70, 0x2d, 0x94, 0xc1 }
+
+/**
+ * @def RADIO_TX_POWER
+ * @brief Potencia del tráfico de control en dBm (default de RH_RF95). Debe coincidir con el gateway.
+ */
+#define RADIO_TX_POWER 13
+
+/**
+ * @def ADR_NODE_MAX_FAILURES
+ * @brief Respuestas seguidas sin ACK en el perfil del enlace antes de volver al perfil default.
+ */
+#define ADR_NODE_MAX_FAILURES 2
+
+/**
+ * @def ADR_SWITCH_GUARD_MS
+ * @brief Espera antes de responder en el perfil del enlace, para que el gateway termine de cambiar el suyo.
+ */
+#define ADR_SWITCH_GUARD_MS 30
+
+// --- Modo de bajo consumo (deep sleep) ---
+/**
+ * @def LOW_POWER_MODE
+ * @brief 1: dormir en deep sleep entre muestras y ventanas de radio (ver PowerManager); 0: siempre despierto.
+ * @details Solo para nodos hoja: dormido no retransmite tramas de otros nodos ni
+ * atiende pedidos fuera de sus ventanas. El gateway y el nodo deben compilarse
+ * con RH_ENABLE_EXPLICIT_RETRY_DEDUP (platformio.ini): cada despertar reinicia
+ * los números de secuencia de RHReliableDatagram.
+ */
+#define LOW_POWER_MODE 0
+
+/**
+ * @def LOW_POWER_RX_GUARD_MS
+ * @brief Margen de escucha antes y después del ciclo previsto (ANNOUNCE o pedido broadcast).
+ */
+#define LOW_POWER_RX_GUARD_MS 1500
+
+/**
+ * @def LOW_POWER_RX_WINDOW_MS
+ * @brief Escucha tras cada envío, para pedidos y LINK_PROFILE del gateway.
+ */
+#define LOW_POWER_RX_WINDOW_MS 1000
+
+/**
+ * @def LOW_POWER_MIN_SLEEP_MS
+ * @brief Sueño mínimo: si el próximo evento está más cerca el nodo sigue despierto (despertar cuesta LOW_POWER_BOOT_MS).
+ */
+#define LOW_POWER_MIN_SLEEP_MS 2000
+
+/**
+ * @def LOW_POWER_BOOT_MS
+ * @brief Tiempo desde que vence el timer de deep sleep hasta setup() (bootloader y arranque).
+ */
+#define LOW_POWER_BOOT_MS 300
+
+/**
+ * @def LOW_POWER_WAKE_LEAD_MS
+ * @brief Anticipación del despertar a un evento de radio: arranque más init del RFM95.
+ */
+#define LOW_POWER_WAKE_LEAD_MS 400
+
+/**
+ * @def LOW_POWER_MIN_CYCLE_MS
+ * @brief Separación mínima entre dos ciclos para tomarla como período (descarta reintentos del gateway).
+ */
+#define LOW_POWER_MIN_CYCLE_MS 5000
+
+/**
+ * @def LOW_POWER_MAX_MISSED_CYCLES
+ * @brief Ciclos seguidos sin escuchar antes de olvidar el período y buscar al gateway.
+ */
+#define LOW_POWER_MAX_MISSED_CYCLES 3
+
+/**
+ * @def LOW_POWER_SEARCH_MS
+ * @brief Escucha continua sin período conocido: alcanza para tres ciclos del gateway (INTERVALOATMOSPHERIC).
+ */
+#define LOW_POWER_SEARCH_MS 300000
+
+/**
+ * @def LOW_POWER_SEARCH_SLEEP_MS
+ * @brief Sueño entre búsquedas sin gateway (las muestras siguen).
+ */
+#define LOW_POWER_SEARCH_SLEEP_MS 600000
+
+/**
+ * @def LOW_POWER_GPS_WAIT_MS
+ * @brief Espera máxima de una hora válida del GPS al muestrear tras un despertar (NMEA sale a 1 Hz).
+ */
+#define LOW_POWER_GPS_WAIT_MS 1100
+
+/**
+ * @def LOW_POWER_CURRENT_CPU_UA
+ * @brief Modelo de consumo: ESP32 a 240 MHz sin WiFi, radio dormida (µA).
+ */
+#define LOW_POWER_CURRENT_CPU_UA 40000
+
+/**
+ * @def LOW_POWER_CURRENT_RX_UA
+ * @brief Modelo de consumo: CPU más RFM95 en recepción (10.8 mA) (µA).
+ */
+#define LOW_POWER_CURRENT_RX_UA 51000
+
+/**
+ * @def LOW_POWER_CURRENT_TX_UA
+ * @brief Modelo de consumo: CPU más RFM95 transmitiendo a RADIO_TX_POWER por PA_BOOST (µA).
+ */
+#define LOW_POWER_CURRENT_TX_UA 69000
+
+/**
+ * @def LOW_POWER_CURRENT_SLEEP_UA
+ * @brief Modelo de consumo: deep sleep con timer RTC, RFM95 dormido y DHT11 en reposo (µA). No incluye el GPS.
+ */
+#define LOW_POWER_CURRENT_SLEEP_UA 160
+
 
 
 // --- Configuración de reset automático del módulo radio ---
@@ -167,6 +330,7 @@
  * @def RS485_RE_DE
  * @brief Pin para control de dirección RE/DE del transceptor RS485.
  * Un solo pin controla tanto DE como RE (HIGH=Transmitir, LOW=Recibir).
+ * Con RS485_HW_UART es la salida RTS del UART y la maneja el driver.
  */
 #define RS485_RE_DE 2
 
@@ -190,7 +354,69 @@
  */
 #define RS485_RETRY_COUNT 2
 
-// Delays para RS485 binario
+/**
+ * @def RS485_HW_UART
+ * @brief 1: RS485 por un UART del ESP32 en modo UART_MODE_RS485_HALF_DUPLEX: el driver del IDF
+ * maneja DE/RE por RTS (RS485_RE_DE) al empezar y terminar cada envío, sin las esperas fijas ni el
+ * bit-banging de SoftwareSerial. Usa los pines RS485_RX_SOFTWARE y RS485_TX_SOFTWARE.
+ * 0: SoftwareSerial con DE/RE a mano (RS485_TX_DELAY y respiro antes de leer).
+ */
+#define RS485_HW_UART 1
+
+/**
+ * @def RS485_UART_NUM
+ * @brief UART del ESP32 para RS485 con RS485_HW_UART (el 0 es el monitor serie y el 2 el GPS).
+ */
+#define RS485_UART_NUM 1
+
+/**
+ * @def RS485_UART_RX_BUFFER
+ * @brief Buffer de recepción del driver UART en bytes (el IDF pide más que la FIFO de 128).
+ */
+#define RS485_UART_RX_BUFFER 256
+
+/**
+ * @def RS485_MODBUS
+ * @brief 1: las sondas de suelo son esclavos Modbus RTU (sondas NPK/pH/EC comerciales), varias en el
+ * mismo bus a distintas profundidades; cada lectura es una ronda por RS485_MODBUS_SLAVE_IDS.
+ * 0: un solo esclavo con el protocolo de un byte de simulation_measures_ground.
+ */
+#define RS485_MODBUS 0
+
+/**
+ * @def RS485_MODBUS_SLAVE_IDS
+ * @brief Direcciones Modbus de las sondas, de la menos a la más profunda. La lectura de suelo que se
+ * envía al gateway es la de la primera que responde; hasta RS485_MODBUS_MAX_SLAVES.
+ */
+#define RS485_MODBUS_SLAVE_IDS { 1, 2, 3 }
+
+/**
+ * @def RS485_MODBUS_SLAVE_TIMEOUTS_MS
+ * @brief Espera del primer byte de respuesta de cada sonda, en el orden de RS485_MODBUS_SLAVE_IDS.
+ * Una sonda caída solo cuesta su timeout en la ronda; el resto de la trama se espera según su largo.
+ */
+#define RS485_MODBUS_SLAVE_TIMEOUTS_MS { 100, 100, 150 }
+
+/**
+ * @def RS485_MODBUS_MAX_SLAVES
+ * @brief Sondas Modbus como máximo en el bus.
+ */
+#define RS485_MODBUS_MAX_SLAVES 4
+
+/**
+ * @def RS485_MODBUS_FIRST_REGISTER
+ * @brief Primer holding register de la lectura. Se leen en un pedido, en el orden de las sondas 7 en 1:
+ * humedad (0,1 %), temperatura (0,1 °C, con signo), EC (µS/cm), pH (0,1), N, P y K (mg/kg).
+ */
+#define RS485_MODBUS_FIRST_REGISTER 0x0000
+
+/**
+ * @def RS485_MODBUS_REGISTER_COUNT
+ * @brief Holding registers por pedido (7 con el mapa de RS485_MODBUS_FIRST_REGISTER).
+ */
+#define RS485_MODBUS_REGISTER_COUNT 7
+
+// Delays para RS485 binario (solo SoftwareSerial)
 #ifndef RS485_TX_DELAY
 #define RS485_TX_DELAY 3   // ms
 #endif
@@ -321,6 +547,34 @@
  */
 #define TWDT_ENABLE_PANIC true
 
+// --- Tareas FreeRTOS (NodeTasks) ---
+/**
+ * @def NODE_TASKS_ENABLED
+ * @brief 1: radio, GPS, muestreo atmosférico y RS485 en tareas separadas en los dos núcleos (NodeTasks);
+ * 0: todo en loop(). Con LOW_POWER_MODE no se usa: cada despertar es corto y secuencial.
+ */
+#define NODE_TASKS_ENABLED 1
+
+/**
+ * @def ATMOS_QUEUE_DEPTH
+ * @brief Muestras en espera entre la tarea atmosférica y la de radio (potencia de dos).
+ */
+#define ATMOS_QUEUE_DEPTH 16
+
+/**
+ * @def GROUND_READ_INTERVAL_MS
+ * @brief Período de lectura de suelo (RS485), energía y GPS de la tarea RS485 hasta que un
+ * REQUEST_DATA_GPC_GROUND trae el intervalo del gateway (Protocol::GroundRequest).
+ */
+#define GROUND_READ_INTERVAL_MS 30000
+
+/**
+ * @def GROUND_PREFETCH_LEAD_MS
+ * @brief Con el intervalo del gateway, la tarea RS485 lee esto antes del próximo pedido:
+ * una transacción con sus timeouts (~3 s) más margen. La respuesta sale de esa lectura.
+ */
+#define GROUND_PREFETCH_LEAD_MS 5000
+
 // === Parámetros de mapeo y límites de voltaje para VoltageReader ===
 #define VOLTAGE_READER_MAX_INPUT_VOLTAGE 2.5f
 #define VOLTAGE_READER_MIN_INPUT_VOLTAGE 0.0f
@@ -0,0 +1,598 @@
+/**
+ * @file frame_auth.cpp
+ * @brief Implementación de ChaCha20-Poly1305 y del sellado de tramas
+ *
+ * Poly1305 en limbs de 26 bits con productos de 32x32->64 (poly1305-donna),
+ * sin tablas ni dependencias: el ESP8266 no tiene AES por hardware y las
+ * rotaciones y sumas de ChaCha20 son baratas en un núcleo de 32 bits.
+ */
+
+#include "frame_auth.h"
+#include <LittleFS.h>
+
+namespace {
+    const char *COUNTER_FILE = "/auth_counter.bin";
+    const uint32_t MASK26 = 0x3ffffff;
+
+    inline uint32_t load32(const uint8_t *p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    inline void store32(uint8_t *p, uint32_t v)
+    {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    inline uint32_t rotl(uint32_t v, int c)
+    {
+        return (v << c) | (v >> (32 - c));
+    }
+
+    inline void quarterRound(uint32_t *x, int a, int b, int c, int d)
+    {
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+    }
+
+    /** Bloque ChaCha20 de 64 bytes (RFC 8439, 2.3). */
+    void chachaBlock(const uint8_t *key, uint32_t counter, const uint8_t *nonce, uint8_t *out)
+    {
+        uint32_t in[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+        for (int i = 0; i < 8; i++) {
+            in[4 + i] = load32(key + 4 * i);
+        }
+        in[12] = counter;
+        in[13] = load32(nonce);
+        in[14] = load32(nonce + 4);
+        in[15] = load32(nonce + 8);
+
+        uint32_t x[16];
+        memcpy(x, in, sizeof(x));
+        for (int i = 0; i < 10; i++) {
+            quarterRound(x, 0, 4, 8, 12);
+            quarterRound(x, 1, 5, 9, 13);
+            quarterRound(x, 2, 6, 10, 14);
+            quarterRound(x, 3, 7, 11, 15);
+            quarterRound(x, 0, 5, 10, 15);
+            quarterRound(x, 1, 6, 11, 12);
+            quarterRound(x, 2, 7, 8, 13);
+            quarterRound(x, 3, 4, 9, 14);
+        }
+        for (int i = 0; i < 16; i++) {
+            store32(out + 4 * i, x[i] + in[i]);
+        }
+    }
+
+    /** XOR de data con el flujo de ChaCha20 desde el bloque 1. */
+    void chachaXor(const uint8_t *key, const uint8_t *nonce, uint8_t *data, size_t len)
+    {
+        uint8_t stream[64];
+        for (uint32_t block = 1; len > 0; block++) {
+            chachaBlock(key, block, nonce, stream);
+            size_t n = len < sizeof(stream) ? len : sizeof(stream);
+            for (size_t i = 0; i < n; i++) {
+                data[i] ^= stream[i];
+            }
+            data += n;
+            len -= n;
+        }
+    }
+
+    /**
+     * Poly1305 (RFC 8439, 2.5). En el AEAD cada segmento se completa con ceros
+     * hasta 16 bytes, así que todos los bloques son completos (bit 2^128).
+     */
+    class Poly1305
+    {
+    public:
+        explicit Poly1305(const uint8_t *otk)
+        {
+            r[0] = load32(otk) & 0x3ffffff;
+            r[1] = (load32(otk + 3) >> 2) & 0x3ffff03;
+            r[2] = (load32(otk + 6) >> 4) & 0x3ffc0ff;
+            r[3] = (load32(otk + 9) >> 6) & 0x3f03fff;
+            r[4] = (load32(otk + 12) >> 8) & 0x00fffff;
+            for (int i = 0; i < 4; i++) {
+                pad[i] = load32(otk + 16 + 4 * i);
+            }
+            memset(h, 0, sizeof(h));
+        }
+
+        /** Segmento completado con ceros hasta múltiplo de 16. */
+        void padded(const uint8_t *m, size_t len)
+        {
+            while (len >= 16) {
+                block(m);
+                m += 16;
+                len -= 16;
+            }
+            if (len > 0) {
+                uint8_t last[16] = {0};
+                memcpy(last, m, len);
+                block(last);
+            }
+        }
+
+        /** Bloque final con los largos de AAD y texto cifrado. */
+        void lengths(size_t aadLen, size_t len)
+        {
+            uint8_t b[16] = {0};
+            store32(b, (uint32_t)aadLen);
+            store32(b + 8, (uint32_t)len);
+            block(b);
+        }
+
+        void finish(uint8_t *mac)
+        {
+            uint32_t c;
+            c = h[1] >> 26; h[1] &= MASK26;
+            h[2] += c; c = h[2] >> 26; h[2] &= MASK26;
+            h[3] += c; c = h[3] >> 26; h[3] &= MASK26;
+            h[4] += c; c = h[4] >> 26; h[4] &= MASK26;
+            h[0] += c * 5; c = h[0] >> 26; h[0] &= MASK26;
+            h[1] += c;
+
+            // h - p = h + 5 - 2^130; se elige sin ramas
+            uint32_t g[5];
+            g[0] = h[0] + 5; c = g[0] >> 26; g[0] &= MASK26;
+            g[1] = h[1] + c; c = g[1] >> 26; g[1] &= MASK26;
+            g[2] = h[2] + c; c = g[2] >> 26; g[2] &= MASK26;
+            g[3] = h[3] + c; c = g[3] >> 26; g[3] &= MASK26;
+            g[4] = h[4] + c - (1UL << 26);
+            uint32_t mask = (g[4] >> 31) - 1;
+            for (int i = 0; i < 5; i++) {
+                h[i] = (h[i] & ~mask) | (g[i] & mask);
+            }
+
+            uint32_t w[4] = {
+                h[0] | (h[1] << 26),
+                (h[1] >> 6) | (h[2] << 20),
+                (h[2] >> 12) | (h[3] << 14),
+                (h[3] >> 18) | (h[4] << 8),
+            };
+            uint64_t f = 0;
+            for (int i = 0; i < 4; i++) {
+                f = (uint64_t)w[i] + pad[i] + (f >> 32);
+                store32(mac + 4 * i, (uint32_t)f);
+            }
+        }
+
+    private:
+        uint32_t r[5];
+        uint32_t h[5];
+        uint32_t pad[4];
+
+        void block(const uint8_t *m)
+        {
+            const uint32_t s1 = r[1] * 5, s2 = r[2] * 5, s3 = r[3] * 5, s4 = r[4] * 5;
+            uint32_t h0 = h[0] + (load32(m) & MASK26);
+            uint32_t h1 = h[1] + ((load32(m + 3) >> 2) & MASK26);
+            uint32_t h2 = h[2] + ((load32(m + 6) >> 4) & MASK26);
+            uint32_t h3 = h[3] + ((load32(m + 9) >> 6) & MASK26);
+            uint32_t h4 = h[4] + ((load32(m + 12) >> 8) | (1UL << 24));
+
+            uint64_t d0 = (uint64_t)h0 * r[0] + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 + (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+            uint64_t d1 = (uint64_t)h0 * r[1] + (uint64_t)h1 * r[0] + (uint64_t)h2 * s4 + (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+            uint64_t d2 = (uint64_t)h0 * r[2] + (uint64_t)h1 * r[1] + (uint64_t)h2 * r[0] + (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+            uint64_t d3 = (uint64_t)h0 * r[3] + (uint64_t)h1 * r[2] + (uint64_t)h2 * r[1] + (uint64_t)h3 * r[0] + (uint64_t)h4 * s4;
+            uint64_t d4 = (uint64_t)h0 * r[4] + (uint64_t)h1 * r[3] + (uint64_t)h2 * r[2] + (uint64_t)h3 * r[1] + (uint64_t)h4 * r[0];
+
+            uint32_t c = (uint32_t)(d0 >> 26); h[0] = (uint32_t)d0 & MASK26;
+            d1 += c; c = (uint32_t)(d1 >> 26); h[1] = (uint32_t)d1 & MASK26;
+            d2 += c; c = (uint32_t)(d2 >> 26); h[2] = (uint32_t)d2 & MASK26;
+            d3 += c; c = (uint32_t)(d3 >> 26); h[3] = (uint32_t)d3 & MASK26;
+            d4 += c; c = (uint32_t)(d4 >> 26); h[4] = (uint32_t)d4 & MASK26;
+            h[0] += c * 5; c = h[0] >> 26; h[0] &= MASK26;
+            h[1] += c;
+        }
+    };
+
+    /** Tag de RFC 8439, 2.8 sobre AAD y texto cifrado. */
+    void computeTag(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aadLen,
+                    const uint8_t *cipher, size_t len, uint8_t *tag)
+    {
+        uint8_t otk[64];
+        chachaBlock(key, 0, nonce, otk);
+        Poly1305 mac(otk);
+        mac.padded(aad, aadLen);
+        mac.padded(cipher, len);
+        mac.lengths(aadLen, len);
+        mac.finish(tag);
+    }
+
+    void frameNonce(const uint8_t *salt, uint8_t from, uint32_t counter, uint8_t *nonce)
+    {
+        store32(nonce, counter);
+        nonce[4] = from;
+        memcpy(nonce + 5, salt, FrameAuth::SALT_LEN);
+    }
+
+    /** Desafío al azar distinto de 0 (0 = ninguno). */
+    uint32_t randomChallenge()
+    {
+        uint32_t challenge;
+        do {
+            challenge = ((uint32_t)random(0x10000) << 16) | (uint32_t)random(0x10000);
+        } while (challenge == 0);
+        return challenge;
+    }
+}
+
+FrameAuth::FrameAuth(const uint8_t *networkKey, uint32_t counterBlock)
+    : blockSize(counterBlock > 0 ? counterBlock : 1), txCounter(0), txReserved(0), peerCount(0), peerEvict(0),
+      forgedCount(0), replayCount(0), staleCount(0), resyncCount(0)
+{
+    memcpy(key, networkKey, KEY_LEN);
+    memset(salt, 0, sizeof(salt));
+}
+
+bool FrameAuth::begin()
+{
+    // Sal nueva en cada arranque: el nonce no se repite aunque el contador vuelva atrás
+    for (uint8_t i = 0; i < SALT_LEN; i++) {
+        salt[i] = (uint8_t)random(256);
+    }
+    bool restored = false;
+    txCounter = 0;
+    if (LittleFS.begin() && LittleFS.exists(COUNTER_FILE)) {
+        File file = LittleFS.open(COUNTER_FILE, "r");
+        uint8_t raw[8];
+        if (file && file.read(raw, sizeof(raw)) == sizeof(raw) && load32(raw) == ~load32(raw + 4)) {
+            txCounter = load32(raw);
+            restored = true;
+        }
+        file.close();
+    }
+    txReserved = txCounter;
+    return restored;
+}
+
+uint8_t FrameAuth::seal(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t len)
+{
+    uint32_t counter;
+    if ((size_t)len + OVERHEAD > 0xFF || !nextCounter(counter)) {
+        return 0;
+    }
+    return sealFrame(key, salt, from, to, type, counter, frame, len);
+}
+
+uint8_t FrameAuth::sealGreeting(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t len, uint32_t echo)
+{
+    uint32_t counter;
+    if ((size_t)len + GREETING_OVERHEAD > 0xFF || !nextCounter(counter)) {
+        return 0;
+    }
+    const Peer *peer = findPeer(to);
+    return sealGreetingFrame(key, salt, from, to, type, counter, peer != nullptr ? peer->challenge : 0, echo,
+                             frame, len);
+}
+
+FrameAuth::Result FrameAuth::open(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t &len)
+{
+    if (len < OVERHEAD) {
+        forgedCount++;
+        return SHORT;
+    }
+    Peer *peer = findPeer(from);
+    if (peer == nullptr || peer->seen == 0) {
+        staleCount++;
+        requestSession(from);
+        return UNKNOWN;
+    }
+    // Antes que el tag: una repetición no cuesta un cálculo de Poly1305
+    uint32_t counter = load32(frame + len - OVERHEAD);
+    if (counter == 0xFFFFFFFFUL || counter < peer->seen) {
+        replayCount++;
+        return REPLAY;
+    }
+    if (!openFrame(key, peer->salt, from, to, type, frame, len, counter)) {
+        forgedCount++;
+        requestSession(from);  // Quizá el remitente se reinició con otra sal
+        return FORGED;
+    }
+    peer->seen = counter + 1;
+    return OK;
+}
+
+FrameAuth::Result FrameAuth::openGreeting(uint8_t from, uint8_t to, uint8_t type, uint8_t *frame, uint8_t &len,
+                                          uint32_t &challenge)
+{
+    challenge = 0;
+    if (len < GREETING_OVERHEAD) {
+        forgedCount++;
+        return SHORT;
+    }
+    uint8_t greetingSalt[SALT_LEN];
+    uint32_t counter;
+    uint32_t echo;
+    uint8_t payloadLen = len;
+    if (!openGreetingFrame(key, from, to, type, frame, payloadLen, greetingSalt, counter, challenge, echo)) {
+        challenge = 0;
+        forgedCount++;
+        return FORGED;
+    }
+    Peer *peer = findPeer(from);
+    bool sameSession = peer != nullptr && peer->seen != 0 && memcmp(peer->salt, greetingSalt, SALT_LEN) == 0;
+    if (sameSession && (counter == 0xFFFFFFFFUL || counter < peer->seen)) {
+        replayCount++;
+        return REPLAY;
+    }
+    if (!sameSession) {
+        // Otra sal: solo con el desafío vigente, que un saludo viejo no puede traer
+        if (peer == nullptr || peer->challenge == 0 || echo != peer->challenge || counter == 0xFFFFFFFFUL) {
+            staleCount++;
+            requestSession(from);
+            return STALE;
+        }
+        if (peer->seen != 0) {
+            resyncCount++;
+        }
+        memcpy(peer->salt, greetingSalt, SALT_LEN);
+    }
+    if (echo != 0 && echo == peer->challenge) {
+        peer->challenge = 0;
+    }
+    peer->seen = counter + 1;
+    len = payloadLen;
+    return OK;
+}
+
+void FrameAuth::requestSession(uint8_t peer)
+{
+    if (peer == 0xFF) {
+        return;  // Broadcast: no hay a quién pedirle
+    }
+    Peer *entry = addPeer(peer);
+    if (entry->challenge == 0) {
+        entry->challenge = randomChallenge();
+    }
+}
+
+uint8_t FrameAuth::sealFrame(const uint8_t *key, const uint8_t *salt, uint8_t from, uint8_t to, uint8_t type,
+                             uint32_t counter, uint8_t *frame, uint8_t len)
+{
+    if ((size_t)len + OVERHEAD > 0xFF) {
+        return 0;
+    }
+    uint8_t nonce[NONCE_LEN];
+    const uint8_t aad[3] = {from, to, type};
+    uint8_t tag[16];
+    frameNonce(salt, from, counter, nonce);
+    encrypt(key, nonce, aad, sizeof(aad), frame, len, tag);
+    store32(frame + len, counter);
+    memcpy(frame + len + COUNTER_LEN, tag, TAG_LEN);
+    return (uint8_t)(len + OVERHEAD);
+}
+
+bool FrameAuth::openFrame(const uint8_t *key, const uint8_t *salt, uint8_t from, uint8_t to, uint8_t type,
+                          uint8_t *frame, uint8_t &len, uint32_t &counter)
+{
+    if (len < OVERHEAD) {
+        return false;
+    }
+    uint8_t payloadLen = (uint8_t)(len - OVERHEAD);
+    counter = load32(frame + payloadLen);
+    uint8_t nonce[NONCE_LEN];
+    const uint8_t aad[3] = {from, to, type};
+    frameNonce(salt, from, counter, nonce);
+    if (!decrypt(key, nonce, aad, sizeof(aad), frame, payloadLen, frame + payloadLen + COUNTER_LEN, TAG_LEN)) {
+        return false;
+    }
+    len = payloadLen;
+    return true;
+}
+
+uint8_t FrameAuth::sealGreetingFrame(const uint8_t *key, const uint8_t *salt, uint8_t from, uint8_t to,
+                                     uint8_t type, uint32_t counter, uint32_t challenge, uint32_t echo,
+                                     uint8_t *frame, uint8_t len)
+{
+    if ((size_t)len + GREETING_OVERHEAD > 0xFF) {
+        return 0;
+    }
+    uint8_t nonce[NONCE_LEN];
+    uint8_t aad[3 + 2 * CHALLENGE_LEN] = {from, to, type};
+    store32(aad + 3, challenge);
+    store32(aad + 3 + CHALLENGE_LEN, echo);
+    uint8_t tag[16];
+    frameNonce(salt, from, counter, nonce);
+    encrypt(key, nonce, aad, sizeof(aad), frame, len, tag);
+    uint8_t *trailer = frame + len;
+    memcpy(trailer, salt, SALT_LEN);
+    memcpy(trailer + SALT_LEN, aad + 3, 2 * CHALLENGE_LEN);
+    store32(trailer + SALT_LEN + 2 * CHALLENGE_LEN, counter);
+    memcpy(trailer + SALT_LEN + 2 * CHALLENGE_LEN + COUNTER_LEN, tag, TAG_LEN);
+    return (uint8_t)(len + GREETING_OVERHEAD);
+}
+
+bool FrameAuth::openGreetingFrame(const uint8_t *key, uint8_t from, uint8_t to, uint8_t type, uint8_t *frame,
+                                  uint8_t &len, uint8_t *salt, uint32_t &counter, uint32_t &challenge,
+                                  uint32_t &echo)
+{
+    if (len < GREETING_OVERHEAD) {
+        return false;
+    }
+    uint8_t payloadLen = (uint8_t)(len - GREETING_OVERHEAD);
+    const uint8_t *trailer = frame + payloadLen;
+    memcpy(salt, trailer, SALT_LEN);
+    challenge = load32(trailer + SALT_LEN);
+    echo = load32(trailer + SALT_LEN + CHALLENGE_LEN);
+    counter = load32(trailer + SALT_LEN + 2 * CHALLENGE_LEN);
+    uint8_t nonce[NONCE_LEN];
+    uint8_t aad[3 + 2 * CHALLENGE_LEN] = {from, to, type};
+    memcpy(aad + 3, trailer + SALT_LEN, 2 * CHALLENGE_LEN);
+    frameNonce(salt, from, counter, nonce);
+    if (!decrypt(key, nonce, aad, sizeof(aad), frame, payloadLen,
+                 trailer + SALT_LEN + 2 * CHALLENGE_LEN + COUNTER_LEN, TAG_LEN)) {
+        return false;
+    }
+    len = payloadLen;
+    return true;
+}
+
+bool FrameAuth::hasSession(uint8_t peer) const
+{
+    const Peer *entry = findPeer(peer);
+    return entry != nullptr && entry->seen != 0;
+}
+
+uint32_t FrameAuth::counter() const
+{
+    return txCounter;
+}
+
+uint32_t FrameAuth::forged() const
+{
+    return forgedCount;
+}
+
+uint32_t FrameAuth::replays() const
+{
+    return replayCount;
+}
+
+uint32_t FrameAuth::stale() const
+{
+    return staleCount;
+}
+
+uint32_t FrameAuth::resyncs() const
+{
+    return resyncCount;
+}
+
+FrameAuth::Snapshot FrameAuth::snapshot(uint8_t peer) const
+{
+    Snapshot saved = {};
+    saved.txCounter = txCounter;
+    saved.txReserved = txReserved;
+    memcpy(saved.salt, salt, SALT_LEN);
+    saved.peer = peer;
+    const Peer *entry = findPeer(peer);
+    if (entry != nullptr && entry->seen != 0) {
+        memcpy(saved.peerSalt, entry->salt, SALT_LEN);
+        saved.peerSeen = entry->seen;
+    }
+    return saved;
+}
+
+bool FrameAuth::restore(const Snapshot &saved)
+{
+    // begin() deja txReserved en el fin del último bloque guardado en flash
+    if (saved.txReserved != txReserved || saved.txCounter > saved.txReserved) {
+        return false;
+    }
+    txCounter = saved.txCounter;
+    memcpy(salt, saved.salt, SALT_LEN);
+    const Peer *known = findPeer(saved.peer);
+    if (saved.peerSeen != 0 && (known == nullptr || known->seen == 0)) {
+        Peer *entry = addPeer(saved.peer);
+        memcpy(entry->salt, saved.peerSalt, SALT_LEN);
+        entry->seen = saved.peerSeen;
+    }
+    return true;
+}
+
+const FrameAuth::Peer *FrameAuth::findPeer(uint8_t from) const
+{
+    for (uint16_t i = 0; i < peerCount; i++) {
+        if (peers[i].id == from) {
+            return &peers[i];
+        }
+    }
+    return nullptr;
+}
+
+FrameAuth::Peer *FrameAuth::findPeer(uint8_t from)
+{
+    return const_cast<Peer *>(static_cast<const FrameAuth *>(this)->findPeer(from));
+}
+
+FrameAuth::Peer *FrameAuth::addPeer(uint8_t from)
+{
+    Peer *entry = findPeer(from);
+    if (entry != nullptr) {
+        return entry;
+    }
+    uint16_t i = peerCount;
+    if (peerCount < MAX_PEERS) {
+        peerCount++;
+    } else {
+        // Llena: primero una entrada sin sesión, así los pedidos de extraños no desalojan sesiones
+        i = 0;
+        while (i < MAX_PEERS && peers[i].seen != 0) {
+            i++;
+        }
+        if (i == MAX_PEERS) {
+            i = peerEvict;
+            peerEvict = (uint16_t)((peerEvict + 1) % MAX_PEERS);
+        }
+    }
+    entry = &peers[i];
+    memset(entry, 0, sizeof(*entry));
+    entry->id = from;
+    return entry;
+}
+
+bool FrameAuth::nextCounter(uint32_t &counter)
+{
+    if (txCounter == 0xFFFFFFFFUL) {
+        return false;
+    }
+    if (txCounter >= txReserved) {
+        uint32_t upTo = txCounter + blockSize < txCounter ? 0xFFFFFFFFUL : txCounter + blockSize;
+        if (!reserve(upTo)) {
+            return false;
+        }
+    }
+    counter = txCounter++;
+    return true;
+}
+
+void FrameAuth::encrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aadLen,
+                        uint8_t *data, size_t len, uint8_t *tag)
+{
+    chachaXor(key, nonce, data, len);
+    computeTag(key, nonce, aad, aadLen, data, len, tag);
+}
+
+bool FrameAuth::decrypt(const uint8_t *key, const uint8_t *nonce, const uint8_t *aad, size_t aadLen,
+                        uint8_t *data, size_t len, const uint8_t *tag, uint8_t tagLen)
+{
+    uint8_t expected[16];
+    computeTag(key, nonce, aad, aadLen, data, len, expected);
+    uint8_t diff = 0;
+    for (uint8_t i = 0; i < tagLen && i < sizeof(expected); i++) {
+        diff |= (uint8_t)(expected[i] ^ tag[i]);
+    }
+    if (diff != 0) {
+        return false;
+    }
+    chachaXor(key, nonce, data, len);
+    return true;
+}
+
+bool FrameAuth::reserve(uint32_t upTo)
+{
+    if (!LittleFS.begin()) {
+        return false;
+    }
+    File file = LittleFS.open(COUNTER_FILE, "w");
+    if (!file) {
+        return false;
+    }
+    uint8_t raw[8];
+    store32(raw, upTo);
+    store32(raw + 4, ~upTo);
+    bool ok = file.write(raw, sizeof(raw)) == sizeof(raw);
+    file.close();
+    if (ok) {
+        txReserved = upTo;
+    }
+    return ok;
+}
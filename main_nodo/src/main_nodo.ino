@@ -9,6 +9,8 @@
  *   - Inicialización de la comunicación LoRa mesh (RadioManager)
  *   - Inicialización y gestión de sensores (SensorManager)
  *   - Orquestación de la lógica de aplicación (AppLogic)
+ *   - Con LOW_POWER_MODE, deep sleep entre eventos (PowerManager); el estado retenido vive en rtcMemory
+ *   - Con NODE_TASKS_ENABLED, radio y sensores en tareas FreeRTOS en los dos núcleos (NodeTasks)
  *
  * El loop principal mantiene actualizado el nodo, gestionando la adquisición de datos y la comunicación mesh con el gateway central.
  *
@@ -16,6 +18,8 @@
  * @see RadioManager
  * @see SensorManager
  * @see AppLogic
+ * @see PowerManager
+ * @see NodeTasks
  */
 // main.cpp
 #include <Arduino.h>
@@ -24,21 +28,34 @@
 #include "radio_manager.h"
 #include "app_logic.h"
 #include "sensor_manager.h"
+#include "power_manager.h"
+#include "node_tasks.h"
 #include "config.h"
 #include <esp_task_wdt.h>
+#include <esp_sleep.h>
+
+// Estado que sobrevive al deep sleep (RTC slow memory); se pierde al cortar la alimentación
+RTC_DATA_ATTR PowerManager::Memory rtcMemory;
 
 // Declaración global de punteros
 NodeIdentity* identity = nullptr;
 RadioManager* radio = nullptr;
 SensorManager* data = nullptr;
 AppLogic* logic = nullptr;
+PowerManager* power = nullptr;
+NodeTasks* tasks = nullptr;
 
 // Variables para TWDT
 unsigned long lastWatchdogReset = 0;
 
 void setup() {
     Serial.begin(115200);
-    delay(600);
+    power = new PowerManager(rtcMemory);
+    bool resumed = power->begin(LOW_POWER_MODE == 1 && esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER,
+                                millis());
+    if (!resumed) {
+        delay(600);
+    }
     Serial.println("\n--- INICIO DE SETUP PRINCIPAL ---");
 
     // Configurar Task Watchdog Timer usando defines de config.h
@@ -53,19 +70,27 @@ void setup() {
     WiFi.mode(WIFI_OFF); // Evita interferencias de WiFi
 
     data = new SensorManager();
-    data->begin();
+    data->begin(resumed);
 
     // Inicializa SPI antes de crear RadioManager
     SPI.begin(VSPI_SCK, VSPI_MISO, VSPI_MOSI, VSPI_SS);
 
     radio = new RadioManager(nodeId);
-    if (!radio->init()) {
+    // Con LOW_POWER_MODE la radio queda dormida hasta que AppLogic la necesita
+    if (LOW_POWER_MODE != 1 && !radio->init()) {
         Serial.println("Error al inicializar RadioManager");
     }
 
-    logic = new AppLogic(*data, *identity, *radio);
+    logic = new AppLogic(*data, *identity, *radio, *power);
     logic->begin();
 
+    if (NODE_TASKS_ENABLED == 1 && LOW_POWER_MODE != 1) {
+        tasks = new NodeTasks(*logic, *data);
+        if (!tasks->begin()) {
+            Serial.println("Error al crear las tareas del nodo");
+        }
+    }
+
     Serial.println("todo ok en nodo");
     
     // Inicializar contador de watchdog
@@ -73,6 +98,12 @@ void setup() {
 }
 
 void loop() {
+    if (tasks) {
+        // Con NodeTasks todo corre en sus tareas: el loop de Arduino sobra
+        esp_task_wdt_delete(NULL);
+        vTaskDelete(NULL);
+    }
+
     // Reset del TWDT usando intervalo de config.h
     unsigned long currentTime = millis();
     if (currentTime - lastWatchdogReset >= TWDT_RESET_INTERVAL_MS) {
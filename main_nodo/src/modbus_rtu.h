@@ -0,0 +1,83 @@
+/**
+ * @file modbus_rtu.h
+ * @brief Tramas Modbus RTU del maestro: lectura de holding registers (función 0x03)
+ * @date 2025
+ *
+ * Pedido (8 bytes):    [esclavo][0x03][primero hi][lo][cantidad hi][lo][CRC lo][hi]
+ * Respuesta:           [esclavo][0x03][bytes = 2*cantidad][registros, big endian...][CRC lo][hi]
+ * Excepción (5 bytes): [esclavo][0x83][código][CRC lo][hi]
+ *
+ * Los tres primeros bytes de la respuesta dicen cuántos faltan
+ * (remainingAfterHeader()), así el maestro lee exactamente la trama y su
+ * tiempo en el bus crece con los registros pedidos, sin esperar un timeout
+ * fijo para darla por terminada.
+ *
+ * El CRC16 (polinomio 0xA001 reflejado, inicio 0xFFFF) se calcula con una
+ * tabla de 256 entradas: un acceso por byte en vez de ocho desplazamientos.
+ */
+
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <Arduino.h>
+
+namespace ModbusRtu {
+
+    const uint8_t FN_READ_HOLDING_REGISTERS = 0x03;
+    const uint8_t EXCEPTION_FLAG = 0x80;          ///< Bit alto de la función en una excepción
+    const uint16_t MAX_READ_REGISTERS = 125;      ///< Máximo de la especificación por pedido
+    const size_t REQUEST_SIZE = 8;
+    const size_t RESPONSE_HEADER_SIZE = 3;        ///< Esclavo, función y bytes (o código de excepción)
+
+    /**
+     * @enum Result
+     * @brief Resultado de validar una respuesta
+     */
+    enum Result : uint8_t {
+        OK = 0,
+        BAD_CRC,
+        WRONG_SLAVE,      ///< Respondió otra dirección (eco o colisión en el bus)
+        EXCEPTION,        ///< El esclavo devolvió un código de excepción
+        MALFORMED         ///< Función o cantidad de bytes distintas de las pedidas
+    };
+
+    /**
+     * @brief CRC16 Modbus de len bytes
+     * @details Se transmite byte bajo primero; el CRC de una trama completa
+     * (con su CRC al final) es 0.
+     */
+    uint16_t crc16(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Arma el pedido de lectura de holding registers
+     * @param out Buffer de al menos REQUEST_SIZE bytes
+     * @return REQUEST_SIZE, o 0 si count no está en [1, MAX_READ_REGISTERS]
+     */
+    size_t buildReadHoldingRegisters(uint8_t slave, uint16_t first, uint16_t count, uint8_t *out);
+
+    /**
+     * @brief Largo de la respuesta normal a un pedido de count registros
+     */
+    inline size_t responseSize(uint16_t count) { return RESPONSE_HEADER_SIZE + 2 * (size_t)count + 2; }
+
+    /**
+     * @brief Bytes que siguen a los RESPONSE_HEADER_SIZE primeros (datos y CRC)
+     */
+    size_t remainingAfterHeader(const uint8_t *header);
+
+    /**
+     * @brief Valida una respuesta completa y extrae los registros
+     * @param frame Trama recibida (cabecera, datos y CRC)
+     * @param out count registros en el orden del esclavo, ya en el orden de bytes del host
+     * @param exceptionCode Si no es nullptr, el código cuando el resultado es EXCEPTION
+     */
+    Result parseReadHoldingRegisters(const uint8_t *frame, size_t len, uint8_t slave, uint16_t count,
+                                     uint16_t *out, uint8_t *exceptionCode = nullptr);
+
+    /**
+     * @brief Silencio entre tramas (3,5 caracteres; 1750 µs fijos por encima de 19200 baudios)
+     */
+    uint32_t interFrameUs(uint32_t baudrate);
+}
+
+#endif // MODBUS_RTU_H
@@ -214,6 +214,11 @@ String NodeIdentity::getDeviceMAC()
   return macAddressString;
 }
 
+void NodeIdentity::getDeviceMAC(uint8_t *mac)
+{
+  WiFi.macAddress(mac);
+}
+
 bool NodeIdentity::getGetway(uint8_t &getwayAdress)
 {
     uint8_t value = GETWAY_NOT_SET;
@@ -55,6 +55,12 @@ public:
      */
     String getDeviceMAC();
 
+    /**
+     * @brief Recupera la dirección MAC del hardware en binario.
+     * @param mac Buffer de 6 bytes donde se copia la MAC.
+     */
+    void getDeviceMAC(uint8_t *mac);
+
     /**
      * @brief Guarda la dirección del gateway asociada a este nodo.
      * @param getwayAdress Dirección a guardar.
@@ -0,0 +1,91 @@
+/**
+ * @file node_tasks.cpp
+ * @brief Implementación de las tareas FreeRTOS del nodo
+ */
+
+#include "node_tasks.h"
+#include <esp_task_wdt.h>
+
+namespace {
+    const BaseType_t RADIO_CORE = 1;       ///< El de loop(): RadioManager::init() enganchó ahí la interrupción DIO0
+    const BaseType_t SENSOR_CORE = 0;
+    const UBaseType_t RADIO_PRIORITY = 3;
+    const UBaseType_t GPS_PRIORITY = 2;    ///< Mayor que sus lectores del núcleo 0 (ver Mailbox)
+    const UBaseType_t SENSOR_PRIORITY = 1;
+    const uint32_t RADIO_STACK = 8192;     ///< Tramas, FrameAuth y AtmosCodec en pila
+    const uint32_t SENSOR_STACK = 4096;
+    const uint32_t GPS_POLL_MS = 20;       ///< A 9600 baudios llegan ~20 bytes; el UART guarda 256
+    const uint32_t TASK_WDT_FEED_MS = 1000;
+
+    /**
+     * @brief Corre step cada periodMs alimentando el TWDT entre medio
+     * @details La primera vez corre enseguida.
+     */
+    template <typename Step>
+    void every(uint32_t periodMs, Step step)
+    {
+        esp_task_wdt_add(nullptr);
+        TickType_t wake = xTaskGetTickCount();
+        uint32_t dueAt = millis();
+        for (;;) {
+            if ((int32_t)(millis() - dueAt) >= 0) {
+                dueAt += periodMs;
+                step();
+            }
+            esp_task_wdt_reset();
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(periodMs < TASK_WDT_FEED_MS ? periodMs : TASK_WDT_FEED_MS));
+        }
+    }
+}
+
+NodeTasks::NodeTasks(AppLogic &logic, SensorManager &sensors) : logic(logic), sensors(sensors)
+{
+}
+
+bool NodeTasks::begin()
+{
+    sensors.enableTaskMode();
+    bool ok = xTaskCreatePinnedToCore(radioTask, "radio", RADIO_STACK, this, RADIO_PRIORITY, nullptr,
+                                      RADIO_CORE) == pdPASS;
+    ok = xTaskCreatePinnedToCore(gpsTask, "gps", SENSOR_STACK, this, GPS_PRIORITY, nullptr,
+                                 SENSOR_CORE) == pdPASS && ok;
+    ok = xTaskCreatePinnedToCore(atmosphericTask, "atmos", SENSOR_STACK, this, SENSOR_PRIORITY, nullptr,
+                                 SENSOR_CORE) == pdPASS && ok;
+    ok = xTaskCreatePinnedToCore(groundTask, "rs485", SENSOR_STACK, this, SENSOR_PRIORITY, nullptr,
+                                 SENSOR_CORE) == pdPASS && ok;
+    return ok;
+}
+
+void NodeTasks::radioTask(void *arg)
+{
+    NodeTasks *self = static_cast<NodeTasks *>(arg);
+    esp_task_wdt_add(nullptr);
+    for (;;) {
+        self->logic.update();
+        esp_task_wdt_reset();
+        vTaskDelay(1);  // Cede el núcleo a la tarea idle
+    }
+}
+
+void NodeTasks::gpsTask(void *arg)
+{
+    NodeTasks *self = static_cast<NodeTasks *>(arg);
+    every(GPS_POLL_MS, [self]() { self->sensors.gpsTaskStep(); });
+}
+
+void NodeTasks::atmosphericTask(void *arg)
+{
+    NodeTasks *self = static_cast<NodeTasks *>(arg);
+    // Primer lote completo enseguida, como verificFullAtmosSamples() sin tareas
+    for (uint8_t i = 1; i < NUMERO_MUESTRAS_ATMOSFERICAS; i++) {
+        self->sensors.atmosphericTaskStep();
+    }
+    every(SAMPLEINTERVALMSATMOSPHERIC, [self]() { self->sensors.atmosphericTaskStep(); });
+}
+
+void NodeTasks::groundTask(void *arg)
+{
+    NodeTasks *self = static_cast<NodeTasks *>(arg);
+    // El momento de cada lectura lo decide SensorManager (alignGroundReads)
+    every(TASK_WDT_FEED_MS, [self]() { self->sensors.groundTaskStep(); });
+}
@@ -0,0 +1,66 @@
+/**
+ * @file node_tasks.h
+ * @brief Reparto del nodo en tareas FreeRTOS fijadas a los núcleos del ESP32 (NODE_TASKS_ENABLED)
+ * @date 2025
+ *
+ * Con todo en loop(), una lectura RS485 (hasta ~3 s con sus timeouts) o la del
+ * DHT frenaban la radio: el gateway esperaba la respuesta de suelo y las
+ * tramas que llegaban mientras tanto quedaban en el RF95. Con NodeTasks:
+ *
+ * | Tarea | Núcleo | Prioridad | Hace                                                 |
+ * | ----- | ------ | --------- | ---------------------------------------------------- |
+ * | radio | 1      | 3         | AppLogic::update(): recibe, responde y envía         |
+ * | gps   | 0      | 2         | Vacía el UART del GPS y publica el fix               |
+ * | atmos | 0      | 1         | Muestra del DHT cada SAMPLEINTERVALMSATMOSPHERIC     |
+ * | rs485 | 0      | 1         | Suelo, energía y GPS antes del pedido del gateway    |
+ *
+ * Las tareas no comparten periféricos ni objetos: los datos cruzan por los
+ * canales sin bloqueo de task_channels.h que guarda SensorManager. La radio
+ * tiene el núcleo 1 para ella sola (con WiFi apagado el núcleo 0 queda para
+ * los sensores) y responde con la última muestra o lectura publicada, sin
+ * esperar ningún bus: el tiempo de respuesta es el de AppLogic y la radio.
+ * La tarea RS485 lee GROUND_PREFETCH_LEAD_MS antes del próximo
+ * REQUEST_DATA_GPC_GROUND según el intervalo que trae el pedido anterior.
+ *
+ * Cada tarea se suscribe al TWDT y lo alimenta al menos cada TASK_WDT_FEED_MS.
+ */
+
+#ifndef NODE_TASKS_H
+#define NODE_TASKS_H
+
+#include <Arduino.h>
+#include "app_logic.h"
+#include "sensor_manager.h"
+
+/**
+ * @class NodeTasks
+ * @brief Crea las tareas del nodo y corre en cada una su parte de AppLogic o SensorManager.
+ *
+ * @example
+ * ```cpp
+ * NodeTasks tasks(logic, sensors);
+ * tasks.begin();   // En setup(), después de AppLogic::begin()
+ * ```
+ */
+class NodeTasks
+{
+public:
+    NodeTasks(AppLogic &logic, SensorManager &sensors);
+
+    /**
+     * @brief Pasa SensorManager al modo tareas y crea las cuatro tareas
+     * @return false si alguna no se pudo crear (falta de heap)
+     */
+    bool begin();
+
+private:
+    AppLogic &logic;
+    SensorManager &sensors;
+
+    static void radioTask(void *arg);
+    static void gpsTask(void *arg);
+    static void atmosphericTask(void *arg);
+    static void groundTask(void *arg);
+};
+
+#endif // NODE_TASKS_H
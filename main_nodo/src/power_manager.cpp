@@ -0,0 +1,189 @@
+/**
+ * @file power_manager.cpp
+ * @brief Implementación del calendario de despertares y del modelo de consumo
+ */
+
+#include "power_manager.h"
+
+const uint32_t PowerManager::CURRENT_UA[POWER_STATE_COUNT] = {
+    LOW_POWER_CURRENT_CPU_UA,
+    LOW_POWER_CURRENT_RX_UA,
+    LOW_POWER_CURRENT_TX_UA,
+    LOW_POWER_CURRENT_SLEEP_UA,
+};
+
+PowerManager::PowerManager(Memory &memory) : mem(memory), listenUntil(0)
+{
+}
+
+bool PowerManager::begin(bool timerWake, unsigned long uptimeMs)
+{
+    listenUntil = 0;
+    if (timerWake && mem.magic == MEMORY_MAGIC) {
+        mem.wakes++;
+        account(CPU, LOW_POWER_BOOT_MS);
+        return true;
+    }
+    memset(&mem, 0, sizeof(mem));
+    mem.magic = MEMORY_MAGIC;
+    mem.wakeReason = WAKE_COLD;
+    startSearch(clock(uptimeMs));
+    return false;
+}
+
+PowerManager::Memory &PowerManager::memory()
+{
+    return mem;
+}
+
+uint32_t PowerManager::clock(unsigned long uptimeMs) const
+{
+    return mem.clockMs + (uint32_t)uptimeMs;
+}
+
+PowerManager::WakeReason PowerManager::wakeReason() const
+{
+    return (WakeReason)mem.wakeReason;
+}
+
+void PowerManager::tick(uint32_t now)
+{
+    if (!cycleKnown() && (int32_t)(now - (mem.searchUntil + LOW_POWER_SEARCH_SLEEP_MS)) >= 0) {
+        startSearch(now);  // La búsqueda anterior terminó sin oír al gateway
+    }
+    while (cycleKnown() && (int32_t)(now - (mem.expectedAt + LOW_POWER_RX_GUARD_MS)) > 0) {
+        mem.missedCycles++;
+        mem.expectedAt += mem.cyclePeriodMs;
+        if (mem.missedCycles >= LOW_POWER_MAX_MISSED_CYCLES) {
+            mem.cyclePeriodMs = 0;  // El gateway cambió de ritmo o no está: se vuelve a medir
+            startSearch(now);
+        }
+    }
+}
+
+void PowerManager::cycleHeard(uint32_t now)
+{
+    uint32_t elapsed = now - mem.cycleAt;
+    if (cycleKnown()) {
+        uint32_t n = (elapsed + mem.cyclePeriodMs / 2) / mem.cyclePeriodMs;
+        if (n == 0) {
+            return;  // Reintento o sondeo de respaldo del mismo ciclo
+        }
+        int32_t error = (int32_t)(elapsed - n * mem.cyclePeriodMs) / (int32_t)n;
+        // Un error mayor que el margen es un cambio de fase (reinicio del gateway): solo se reancla
+        if (error <= LOW_POWER_RX_GUARD_MS && error >= -LOW_POWER_RX_GUARD_MS) {
+            mem.cyclePeriodMs += error / 4;
+        }
+    } else if (mem.cycleSeen) {
+        if (elapsed < LOW_POWER_MIN_CYCLE_MS) {
+            return;  // Reintento del mismo ciclo
+        }
+        if (mem.candidateMs == 0) {
+            mem.candidateMs = elapsed;
+            mem.searchUntil = now + LOW_POWER_SEARCH_MS;
+        } else {
+            // El menor de dos intervalos: si se perdió un ciclo en medio, uno es el doble
+            mem.cyclePeriodMs = elapsed < mem.candidateMs ? elapsed : mem.candidateMs;
+        }
+    } else {
+        mem.searchUntil = now + LOW_POWER_SEARCH_MS;
+    }
+    mem.cycleSeen = true;
+    mem.cycleAt = now;
+    mem.expectedAt = now + mem.cyclePeriodMs;
+    mem.missedCycles = 0;
+}
+
+bool PowerManager::cycleKnown() const
+{
+    return mem.cyclePeriodMs != 0;
+}
+
+void PowerManager::listen(uint32_t until)
+{
+    if ((int32_t)(until - listenUntil) > 0) {
+        listenUntil = until;
+    }
+}
+
+bool PowerManager::needsRadio(uint32_t now, bool slotPending, uint32_t slotAt) const
+{
+    if (!cycleKnown() && (int32_t)(mem.searchUntil - now) > 0) {
+        return true;
+    }
+    if ((int32_t)(listenUntil - now) > 0) {
+        return true;
+    }
+    if (cycleKnown() && (int32_t)(mem.expectedAt - LOW_POWER_RX_GUARD_MS - now) < LOW_POWER_MIN_SLEEP_MS) {
+        return true;
+    }
+    return slotPending && (int32_t)(slotAt - now) < LOW_POWER_MIN_SLEEP_MS;
+}
+
+bool PowerManager::sampleDue(uint32_t now) const
+{
+    return (int32_t)(now - mem.nextSampleAt) >= 0;
+}
+
+void PowerManager::sampled(uint32_t now)
+{
+    mem.nextSampleAt += SAMPLEINTERVALMSATMOSPHERIC;
+    if ((int32_t)(mem.nextSampleAt - now) <= 0) {
+        mem.nextSampleAt = now + SAMPLEINTERVALMSATMOSPHERIC;  // Arranque en frío o despierto más de un intervalo
+    }
+}
+
+bool PowerManager::planSleep(uint32_t now, bool slotPending, uint32_t slotAt, uint32_t &wakeAt)
+{
+    if (needsRadio(now, slotPending, slotAt) || (int32_t)(mem.nextSampleAt - now) < LOW_POWER_MIN_SLEEP_MS) {
+        return false;
+    }
+    WakeReason reason = WAKE_SAMPLE;
+    wakeAt = mem.nextSampleAt;
+    uint32_t radioAt = cycleKnown() ? mem.expectedAt - LOW_POWER_RX_GUARD_MS - LOW_POWER_WAKE_LEAD_MS
+                                    : mem.searchUntil + LOW_POWER_SEARCH_SLEEP_MS;
+    if ((int32_t)(radioAt - wakeAt) < 0) {
+        wakeAt = radioAt;
+        reason = cycleKnown() ? WAKE_CYCLE : WAKE_SEARCH;
+    }
+    if (slotPending && (int32_t)(slotAt - LOW_POWER_WAKE_LEAD_MS - wakeAt) < 0) {
+        wakeAt = slotAt - LOW_POWER_WAKE_LEAD_MS;
+        reason = WAKE_SLOT;
+    }
+    mem.wakeReason = reason;
+    return true;
+}
+
+void PowerManager::account(PowerState state, uint32_t ms)
+{
+    mem.stateMs[state] += ms;
+}
+
+void PowerManager::sleep(uint32_t now, uint32_t wakeAt)
+{
+    account(SLEEP, wakeAt - now);
+    mem.clockMs = wakeAt + LOW_POWER_BOOT_MS;  // millis() vuelve a 0 al terminar el arranque
+}
+
+uint64_t PowerManager::stateMs(PowerState state) const
+{
+    return mem.stateMs[state];
+}
+
+uint32_t PowerManager::averageCurrentUa() const
+{
+    uint64_t totalMs = 0;
+    uint64_t chargeUaMs = 0;
+    for (uint8_t i = 0; i < POWER_STATE_COUNT; i++) {
+        totalMs += mem.stateMs[i];
+        chargeUaMs += mem.stateMs[i] * CURRENT_UA[i];
+    }
+    return totalMs == 0 ? 0 : (uint32_t)(chargeUaMs / totalMs);
+}
+
+void PowerManager::startSearch(uint32_t now)
+{
+    mem.cycleSeen = false;
+    mem.candidateMs = 0;
+    mem.searchUntil = now + LOW_POWER_SEARCH_MS;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file power_manager.h
+ * @brief Calendario de despertares y modelo de consumo del nodo en deep sleep (LOW_POWER_MODE)
+ * @date 2025
+ *
+ * Despierto, el nodo consume ~40 mA aunque no haga nada: AppLogic::update()
+ * sondea la radio y el UART del GPS todo el tiempo. Con LOW_POWER_MODE el
+ * nodo duerme en deep sleep y despierta por timer solo para:
+ *
+ * - Muestrear (cada SAMPLEINTERVALMSATMOSPHERIC), con la radio dormida.
+ * - El ciclo del gateway: el ANNOUNCE con calendario de slots o el pedido
+ *   broadcast (Protocol::PollWindow). El nodo no conoce INTERVALOATMOSPHERIC:
+ *   lo mide entre dos ciclos escuchados y despierta LOW_POWER_RX_GUARD_MS
+ *   antes del siguiente. El período se mide con el mismo reloj con que se
+ *   duerme, así que el error sistemático del oscilador RTC se cancela.
+ * - Su slot, que se cuenta desde el ciclo; tras cada envío escucha
+ *   LOW_POWER_RX_WINDOW_MS por si el gateway pide algo más.
+ *
+ * Sin período conocido (primer arranque, o LOW_POWER_MAX_MISSED_CYCLES
+ * ciclos seguidos sin escuchar) el nodo escucha LOW_POWER_SEARCH_MS seguidos
+ * y, si no oye nada, duerme LOW_POWER_SEARCH_SLEEP_MS antes de volver a buscar.
+ *
+ * El deep sleep borra la RAM: lo que debe sobrevivir vive en Memory, que
+ * main_nodo.ino declara con RTC_DATA_ATTR (RTC slow memory). millis() vuelve
+ * a 0 en cada despertar; el reloj del nodo es Memory::clockMs + millis().
+ *
+ * La clase no llama a nada del ESP32: recibe el tiempo como argumento (como
+ * DutyCycle en el gateway) para poder correr en el host (sim/power_sim.cpp).
+ * El modelo de consumo acumula tiempo por estado y lo multiplica por las
+ * corrientes LOW_POWER_CURRENT_*_UA.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "protocol.h"
+#include "frame_auth.h"
+#include "sample_ring.h"
+
+/**
+ * @class PowerManager
+ * @brief Decide cuándo dormir y hasta cuándo; lleva el tiempo en cada estado de consumo.
+ *
+ * @example
+ * ```cpp
+ * RTC_DATA_ATTR PowerManager::Memory rtcMemory;
+ * PowerManager power(rtcMemory);
+ * power.begin(esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER, millis());
+ * // En loop():
+ * uint32_t now = power.clock(millis());
+ * power.tick(now);
+ * uint32_t wakeAt;
+ * if (power.planSleep(now, slotPending, slotAt, wakeAt)) {
+ *     power.sleep(now, wakeAt);
+ *     esp_sleep_enable_timer_wakeup((uint64_t)(wakeAt - now) * 1000);
+ *     esp_deep_sleep_start();
+ * }
+ * ```
+ */
+class PowerManager
+{
+public:
+    /**
+     * @enum PowerState
+     * @brief Estados del modelo de consumo.
+     */
+    enum PowerState : uint8_t {
+        CPU,    ///< Despierto con la radio dormida (LOW_POWER_CURRENT_CPU_UA)
+        RX,     ///< Despierto con la radio escuchando (LOW_POWER_CURRENT_RX_UA)
+        TX,     ///< Transmitiendo (LOW_POWER_CURRENT_TX_UA)
+        SLEEP,  ///< Deep sleep (LOW_POWER_CURRENT_SLEEP_UA)
+        POWER_STATE_COUNT
+    };
+
+    /**
+     * @enum WakeReason
+     * @brief Para qué se programó el despertar.
+     */
+    enum WakeReason : uint8_t {
+        WAKE_COLD,    ///< Encendido o reinicio: nada retenido
+        WAKE_SAMPLE,  ///< Muestra atmosférica (radio dormida)
+        WAKE_CYCLE,   ///< Ciclo previsto del gateway
+        WAKE_SLOT,    ///< Slot de envío
+        WAKE_SEARCH   ///< Búsqueda del gateway sin período conocido
+    };
+
+    /**
+     * @struct Memory
+     * @brief Estado que sobrevive al deep sleep (RTC slow memory, ~500 bytes de 8 KB).
+     */
+    struct Memory {
+        uint32_t magic;          ///< MEMORY_MAGIC si el contenido es válido
+        uint32_t clockMs;        ///< Reloj del nodo cuando millis() vale 0
+        uint8_t wakeReason;      ///< WakeReason del despertar en curso
+        uint32_t wakes;          ///< Despertares desde el arranque en frío
+        uint64_t stateMs[POWER_STATE_COUNT]; ///< Tiempo acumulado en cada PowerState
+
+        uint32_t nextSampleAt;   ///< Próxima muestra atmosférica
+        bool cycleSeen;          ///< Se escuchó al menos un ciclo
+        uint32_t cycleAt;        ///< Último ciclo escuchado
+        uint32_t candidateMs;    ///< Primer intervalo medido en la búsqueda (0 = ninguno)
+        uint32_t cyclePeriodMs;  ///< Período medido entre ciclos (0 = desconocido)
+        uint32_t expectedAt;     ///< Próximo ciclo previsto
+        uint8_t missedCycles;    ///< Ciclos previstos seguidos sin escuchar
+        uint32_t searchUntil;    ///< Fin de la búsqueda en curso
+
+        // Estado del nodo (AppLogic y SensorManager)
+        SampleRing atmosRing;
+        uint8_t gatewayAddress;
+        bool gatewayRegistered;
+        uint8_t gatewayNextHop;  ///< Ruta RHMesh al gateway (0 = ninguna)
+        uint8_t gatewayFeatures;
+        uint8_t linkProfile;
+        int8_t linkTxPower;
+        uint16_t batchSeq;
+        bool batchSent;
+        uint32_t batchReadings;
+        bool slotPending;
+        uint32_t slotAt;
+        uint32_t helloAt;        ///< Último HELLO
+        bool authSaved;          ///< auth es válido
+        FrameAuth::Snapshot auth;
+    };
+
+    static const uint32_t MEMORY_MAGIC = 0x4C503032;  ///< "LP02"; cambiarlo si cambia Memory
+    static const uint32_t CURRENT_UA[POWER_STATE_COUNT];
+
+    /**
+     * @param memory Estado retenido (RTC_DATA_ATTR en el firmware)
+     */
+    explicit PowerManager(Memory &memory);
+
+    /**
+     * @brief Valida la memoria retenida o la reinicia
+     * @param timerWake true si el arranque fue un despertar por timer
+     * @param uptimeMs millis() actual
+     * @return true si se retomó el estado de antes de dormir
+     */
+    bool begin(bool timerWake, unsigned long uptimeMs);
+
+    /**
+     * @brief Estado retenido; AppLogic lo lee en begin() y lo escribe antes de dormir
+     */
+    Memory &memory();
+
+    /**
+     * @brief Reloj del nodo: ms desde el arranque en frío, sumando los sueños
+     */
+    uint32_t clock(unsigned long uptimeMs) const;
+
+    /**
+     * @brief Para qué se despertó
+     */
+    WakeReason wakeReason() const;
+
+    /**
+     * @brief Cuenta los ciclos previstos que pasaron sin escucharse
+     * @details Sin período, reinicia la búsqueda LOW_POWER_SEARCH_SLEEP_MS
+     * después de que terminó la anterior.
+     */
+    void tick(uint32_t now);
+
+    /**
+     * @brief Llegó el ANNOUNCE con slot, el pedido broadcast o el pedido unicast atmosférico
+     * @details Ajusta el período con el error respecto del ciclo previsto.
+     */
+    void cycleHeard(uint32_t now);
+
+    /**
+     * @brief Hay un período medido y vigente
+     */
+    bool cycleKnown() const;
+
+    /**
+     * @brief Mantiene la radio escuchando hasta until (p. ej. tras un envío)
+     */
+    void listen(uint32_t until);
+
+    /**
+     * @brief La radio tiene que estar encendida ahora
+     * @details Escuchando un ciclo, una búsqueda o una ventana de listen(), o
+     * con el ciclo o el slot más cerca que LOW_POWER_MIN_SLEEP_MS.
+     */
+    bool needsRadio(uint32_t now, bool slotPending, uint32_t slotAt) const;
+
+    /**
+     * @brief Toca tomar una muestra atmosférica
+     */
+    bool sampleDue(uint32_t now) const;
+
+    /**
+     * @brief Agenda la muestra siguiente
+     */
+    void sampled(uint32_t now);
+
+    /**
+     * @brief Decide si dormir y hasta cuándo
+     * @param wakeAt Despertar (reloj del nodo) si devuelve true
+     * @return false si hay que seguir despierto
+     */
+    bool planSleep(uint32_t now, bool slotPending, uint32_t slotAt, uint32_t &wakeAt);
+
+    /**
+     * @brief Suma tiempo a un estado del modelo de consumo
+     */
+    void account(PowerState state, uint32_t ms);
+
+    /**
+     * @brief Registra el sueño hasta wakeAt y deja el reloj listo para el próximo arranque
+     */
+    void sleep(uint32_t now, uint32_t wakeAt);
+
+    /**
+     * @brief Tiempo acumulado en un estado desde el arranque en frío
+     */
+    uint64_t stateMs(PowerState state) const;
+
+    /**
+     * @brief Corriente media del modelo desde el arranque en frío (µA)
+     */
+    uint32_t averageCurrentUa() const;
+
+private:
+    Memory &mem;
+    uint32_t listenUntil;  ///< Fin de la escucha pedida con listen()
+
+    /**
+     * @brief Sin período: escucha LOW_POWER_SEARCH_MS desde now
+     */
+    void startSearch(uint32_t now);
+};
+
+#endif // POWER_MANAGER_H
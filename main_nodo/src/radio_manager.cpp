@@ -1,8 +1,21 @@
 // RadioManager.cpp
 #include "radio_manager.h"
 
+namespace {
+    const uint8_t NETWORK_KEY[FrameAuth::KEY_LEN] = AUTH_NETWORK_KEY;
+    const uint16_t GREETING_JITTER_MS = 2000;  ///< Tras un ANNOUNCE broadcast no responden todos los nodos juntos
+
+    /** Tramas que FrameAuth sella como saludo (sal, desafío y eco). */
+    inline bool isGreeting(uint8_t flag)
+    {
+        return flag == Protocol::MessageType::HELLO || flag == Protocol::MessageType::ANNOUNCE;
+    }
+}
+
 RadioManager::RadioManager(uint8_t address)
-    : driver(RFM95_CS, RFM95_INT), manager(driver, address), failureCount(0)
+    : driver(RFM95_CS, RFM95_INT), manager(driver, address), failureCount(0),
+      profile(Protocol::RADIO_PROFILE_DEFAULT), auth(NETWORK_KEY, AUTH_COUNTER_BLOCK), ready(false),
+      readySince(0), txTimeMs(0), greetingPending(false), greetingPeer(0), greetingEcho(0), greetingAt(0)
 {
 }
 
@@ -27,6 +40,12 @@ bool RadioManager::init()
   }
 
   Serial.print("RF95 MESH init okay");
+  if (AUTH_ENABLED == 1 && !auth.begin()) {
+    Serial.println("[RadioManager] Sin contador de FrameAuth guardado: contador desde 0 con la sal nueva");
+  }
+  ready = true;
+  readySince = millis();
+  txTimeMs = 0;
   Serial.println("[DEBUG] RadioManager::init FIN");
   return true;
 }
@@ -38,7 +57,29 @@ bool RadioManager::sendMessage(uint8_t to, uint8_t *data, uint8_t len, uint8_t f
     // Envía el mensaje y espera un acuse de recibo.
     // RH_ROUTER_ERROR_NONE indica una transmisión y acuse de recibo exitosos.
  
+    uint8_t sealed[RH_MESH_MAX_MESSAGE_LEN];
+    if (AUTH_ENABLED == 1) {
+        if (len > sizeof(sealed) - (isGreeting(flag) ? FrameAuth::GREETING_OVERHEAD : FrameAuth::OVERHEAD)) {
+            return false;
+        }
+        memcpy(sealed, data, len);
+        uint32_t echo = 0;
+        if (isGreeting(flag) && greetingPending && greetingPeer == to) {
+            // El HELLO lleva el eco pendiente: ya no hace falta el saludo vacío
+            echo = greetingEcho;
+            greetingPending = false;
+        }
+        len = isGreeting(flag) ? auth.sealGreeting(manager.thisAddress(), to, flag, sealed, len, echo)
+                               : auth.seal(manager.thisAddress(), to, flag, sealed, len);
+        if (len == 0) {
+            Serial.println("[RadioManager] ERROR: no se pudo reservar contador de FrameAuth en flash");
+            return false;
+        }
+        data = sealed;
+    }
+    unsigned long sendStart = millis();
     uint8_t result = manager.sendtoWait(data, len, to, flag);
+    txTimeMs += millis() - sendStart;
     
     if (result == RH_ROUTER_ERROR_NONE)
     {
@@ -63,7 +104,7 @@ bool RadioManager::recvMessage(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_
   // Intenta recibir un mensaje reconocido.
   if (manager.recvfromAck(buf, len, from, &dest, &id, flag))
   {
-    return true; // Mensaje recibido con éxito.
+    return openReceived(buf, len, *from, dest, *flag); // Mensaje recibido con éxito si es auténtico.
   }
   return false; // No se recibió ningún mensaje o falló el acuse de recibo.
 }
@@ -85,27 +126,28 @@ bool RadioManager::recvMessageTimeout(uint8_t *buf, uint8_t *len, uint8_t *from,
   // 'dest' y 'messageId' son variables temporales que no necesitas devolver.
   if (manager.recvfromAckTimeout(buf, len, timeout, from, &dest, &messageId, flag))
   {
-    // Mensaje recibido y reconocido con éxito dentro del tiempo
-    return true;
+    // Mensaje recibido y reconocido con éxito dentro del tiempo; se descarta si no es auténtico
+    return openReceived(buf, len, *from, dest, *flag);
   }
   // No se recibió un mensaje reconocido dentro del tiempo
   return false;
 }
 
 /**
- * @brief Método de marcador de posición para actualizar el estado interno del gestor de radio.
+ * @brief Envía el saludo vacío de FrameAuth pendiente cuando vence su espera.
  *
- * Actualmente, la librería RHMesh maneja la mayoría de sus procesos internos (como
- * retransmisión, actualizaciones de la tabla de enrutamiento y manejo de acuses de recibo) automáticamente.
- * Este método se proporciona como un marcador de posición vacío para futuras expansiones o
- * si son necesarias tareas periódicas específicas relacionadas con la gestión de radio.
- * Por ejemplo, podría usarse para la gestión de energía personalizada, sondeo de estado,
- * o lógica de enrutamiento avanzada si el comportamiento predeterminado de RHMesh es insuficiente.
+ * RHMesh maneja internamente el reintento y enrutamiento; lo único periódico
+ * es abrir la sesión con el gateway cuando openReceived() la pidió.
  */
 void RadioManager::update()
 {
-  // RHMesh maneja internamente el reintento y enrutamiento.
-  // Este método se reserva para futuras ampliaciones si se requiere.
+  if (!greetingPending || !ready || (long)(millis() - greetingAt) < 0) {
+    return;
+  }
+  uint8_t empty[1];
+  Serial.printf("[RadioManager] Saludo de FrameAuth a 0x%02X\n", greetingPeer);
+  sendMessage(greetingPeer, empty, 0, Protocol::MessageType::HELLO);
+  greetingPending = false;  // Si no salió, la próxima trama del gateway lo vuelve a pedir
 }
 
 bool RadioManager::handleTransmissionFailure()
@@ -148,7 +190,105 @@ void RadioManager::forceRadioReset()
     if (manager.init()) {
         Serial.println("[RadioManager] Reset exitoso, módulo reinicializado");
         failureCount = 0; // Resetear contador después del reset exitoso
+        profile = Protocol::RADIO_PROFILE_DEFAULT; // init() deja el modem en SF7/125 kHz
     } else {
         Serial.println("[RadioManager] ERROR: Fallo en reinicialización después del reset");
     }
 }
+
+bool RadioManager::applyProfile(uint8_t newProfile, int8_t txPower)
+{
+    if (newProfile >= Protocol::RADIO_PROFILE_COUNT) {
+        return false;
+    }
+    const Protocol::RadioProfile &p = Protocol::RADIO_PROFILES[newProfile];
+    driver.setModemConfig(RH_RF95::Bw125Cr45Sf128);
+    driver.setSignalBandwidth((long)p.bandwidthKhz * 1000);
+    driver.setSpreadingFactor(p.spreadingFactor);
+    driver.setTxPower(txPower);
+    // El ACK dura ~25 símbolos: a SF12/125 kHz el timeout por defecto reenviaría antes de recibirlo
+    uint32_t symbolUs = ((uint32_t)1 << p.spreadingFactor) * 1000UL / p.bandwidthKhz;
+    manager.setTimeout(RH_DEFAULT_TIMEOUT + (uint16_t)(30 * symbolUs / 1000));
+    profile = newProfile;
+    return true;
+}
+
+const FrameAuth &RadioManager::getAuth() const
+{
+    return auth;
+}
+
+bool RadioManager::restoreAuth(const FrameAuth::Snapshot &saved)
+{
+    return auth.restore(saved);
+}
+
+bool RadioManager::getRoute(uint8_t to, uint8_t &nextHop)
+{
+    RHRouter::RoutingTableEntry *route = manager.getRouteTo(to);
+    if (route == nullptr || route->state != RHRouter::Valid) {
+        return false;
+    }
+    nextHop = route->next_hop;
+    return true;
+}
+
+void RadioManager::seedRoute(uint8_t to, uint8_t nextHop)
+{
+    manager.addRouteTo(to, nextHop);
+}
+
+void RadioManager::sleep()
+{
+    if (ready) {
+        driver.sleep();
+        ready = false;
+    }
+}
+
+bool RadioManager::isReady() const
+{
+    return ready;
+}
+
+uint32_t RadioManager::getOnTimeMs() const
+{
+    return ready ? millis() - readySince : 0;
+}
+
+uint32_t RadioManager::getTxTimeMs() const
+{
+    return txTimeMs;
+}
+
+bool RadioManager::openReceived(uint8_t *buf, uint8_t *len, uint8_t from, uint8_t dest, uint8_t flag)
+{
+    if (AUTH_ENABLED != 1) {
+        return true;
+    }
+    uint32_t challenge = 0;
+    FrameAuth::Result result = isGreeting(flag) ? auth.openGreeting(from, dest, flag, buf, *len, challenge)
+                                                : auth.open(from, dest, flag, buf, *len);
+    if (result == FrameAuth::UNKNOWN || result == FrameAuth::FORGED || result == FrameAuth::STALE ||
+        (result == FrameAuth::OK && challenge != 0))
+    {
+        // Sin sesión con el gateway (primer contacto o se reinició), o pidió una: se le responde con un saludo
+        if (!greetingPending || greetingPeer != from)
+        {
+            greetingPending = true;
+            greetingPeer = from;
+            greetingEcho = 0;
+            greetingAt = millis() + (uint32_t)random(GREETING_JITTER_MS);
+        }
+        if (challenge != 0)
+        {
+            greetingEcho = challenge;
+            greetingAt = millis(); // Espera el eco: se responde enseguida
+        }
+    }
+    if (result != FrameAuth::OK) {
+        Serial.printf("[RadioManager] Trama 0x%02X de 0x%02X descartada por FrameAuth (%u)\n", flag, from, result);
+        return false;
+    }
+    return !isGreeting(flag) || *len > 0;  // Un saludo vacío solo abre la sesión
+}
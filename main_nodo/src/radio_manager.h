@@ -6,6 +6,8 @@
 #include <RH_RF95.h>
 #include <SPI.h>
 #include "config.h"
+#include "protocol.h"
+#include "frame_auth.h"
 
 /**
  * @class RadioManager
@@ -64,7 +66,7 @@ public:
     bool recvMessageTimeout(uint8_t *buf, uint8_t *len, uint8_t *from, uint8_t *flag, uint16_t timeout);
 
     /**
-     * @brief Actualiza el estado interno del gestor de radio (placeholder para futuras extensiones).
+     * @brief Envía el saludo de FrameAuth pendiente (sesión con el gateway) cuando vence su espera.
      */
     void update();
     
@@ -90,10 +92,76 @@ public:
      */
     void forceRadioReset();
 
+    /**
+     * @brief Configura SF, ancho de banda y potencia de Protocol::RADIO_PROFILES.
+     * @param profile Índice en Protocol::RADIO_PROFILES.
+     * @param txPower Potencia en dBm.
+     * @return false si el perfil no existe.
+     */
+    bool applyProfile(uint8_t profile, int8_t txPower = RADIO_TX_POWER);
+
+    /**
+     * @brief Contador propio y tramas rechazadas por FrameAuth (diagnóstico).
+     */
+    const FrameAuth &getAuth() const;
+
+    /**
+     * @brief Retoma los contadores de FrameAuth guardados antes del deep sleep (tras init()).
+     * @return false si no coinciden con los de flash y se sigue con los de init().
+     */
+    bool restoreAuth(const FrameAuth::Snapshot &saved);
+
+    /**
+     * @brief Siguiente salto de la ruta RHMesh a to.
+     * @return false si no hay ruta válida.
+     */
+    bool getRoute(uint8_t to, uint8_t &nextHop);
+
+    /**
+     * @brief Carga una ruta conocida (la tabla de RHMesh no sobrevive al deep sleep).
+     */
+    void seedRoute(uint8_t to, uint8_t nextHop);
+
+    /**
+     * @brief Duerme el RFM95 (~0.2 uA); hasta otro init() no se puede usar.
+     */
+    void sleep();
+
+    /**
+     * @brief init() terminó y la radio no se durmió.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Tiempo con la radio encendida desde init() (0 si está dormida).
+     */
+    uint32_t getOnTimeMs() const;
+
+    /**
+     * @brief Tiempo dentro de sendMessage() desde init(): transmisión más espera del ACK.
+     */
+    uint32_t getTxTimeMs() const;
+
 private:
     RH_RF95 driver;  ///< Controlador de radio LoRa (bajo nivel)
     RHMesh manager;  ///< Gestor de red mesh (enrutamiento y lógica mesh)
     uint8_t failureCount;  ///< Contador de fallos consecutivos
+    uint8_t profile;       ///< Perfil de radio aplicado (Protocol::RADIO_PROFILES)
+    FrameAuth auth;        ///< Sellado de lo enviado y verificación de lo recibido (AUTH_ENABLED)
+    bool ready;            ///< init() hecho y radio despierta
+    unsigned long readySince; ///< millis() del último init()
+    uint32_t txTimeMs;     ///< Tiempo en sendMessage() desde init()
+    bool greetingPending;  ///< Hay que saludar a greetingPeer (sesión de FrameAuth)
+    uint8_t greetingPeer;  ///< Gateway al que se saluda
+    uint32_t greetingEcho; ///< Desafío suyo que se devuelve (0 = ninguno)
+    unsigned long greetingAt; ///< millis() desde el que update() envía el saludo
+
+    /**
+     * @brief Abre con FrameAuth una trama recibida en buf
+     * @details Si el gateway no tiene sesión o pide una, agenda un saludo para update().
+     * @return false si no es auténtica, es repetida o es un saludo vacío (se descarta)
+     */
+    bool openReceived(uint8_t *buf, uint8_t *len, uint8_t from, uint8_t dest, uint8_t flag);
 };
 
 #endif // RADIO_MANAGER_H
@@ -12,6 +12,7 @@
  */
 
 #include "rs485_manager.h"
+#include <driver/uart.h>
 
 // Códigos de error
 #define RS485_ERROR_NONE 0
@@ -20,14 +21,54 @@
 #define RS485_ERROR_COMMUNICATION -3
 #define RS485_ERROR_INVALID_DATA -4
 
+namespace {
+    // Orden de los registros de RS485_MODBUS_FIRST_REGISTER (sondas 7 en 1)
+    enum ProbeRegister : uint8_t {
+        REG_MOISTURE = 0,
+        REG_TEMP,
+        REG_EC,
+        REG_PH,
+        REG_N,
+        REG_P,
+        REG_K,
+        PROBE_REGISTERS
+    };
+    static_assert(RS485_MODBUS_REGISTER_COUNT >= PROBE_REGISTERS, "Faltan registros para GroundSensor");
+    static_assert(RS485_MODBUS_REGISTER_COUNT <= ModbusRtu::MAX_READ_REGISTERS, "Demasiados registros por pedido");
+
+    void registersToGround(const uint16_t* regs, Protocol::GroundSensor& data) {
+        data.moisture = regs[REG_MOISTURE];
+        data.temp = (int16_t)regs[REG_TEMP];
+        data.EC = regs[REG_EC];
+        data.PH = (uint8_t)regs[REG_PH];
+        data.n = regs[REG_N];
+        data.p = regs[REG_P];
+        data.k = regs[REG_K];
+    }
+}
+
 RS485Manager::RS485Manager(SoftwareSerial* serial, 
                            uint8_t controlPin,
                            uint32_t baudrate,
                            uint32_t timeout,
                            uint8_t retryCount) 
-    : serial(serial), controlPin(controlPin), baudrate(baudrate), 
+    : serial(serial), hardwareUart(false), controlPin(controlPin), baudrate(baudrate), 
       timeout(timeout), retryCount(retryCount), lastError(RS485_ERROR_NONE), 
-      failedAttempts(0) {
+      failedAttempts(0), probeCount(0), lastFrameEndUs(0) {
+    // Los pedidos de la ronda no cambian: se arman una vez con su CRC
+    const uint8_t ids[] = RS485_MODBUS_SLAVE_IDS;
+    const uint16_t timeouts[] = RS485_MODBUS_SLAVE_TIMEOUTS_MS;
+    static_assert(sizeof(ids) == sizeof(timeouts) / sizeof(timeouts[0]), "Un timeout por sonda Modbus");
+    for (uint8_t i = 0; i < sizeof(ids) && probeCount < RS485_MODBUS_MAX_SLAVES; i++) {
+        ModbusProbe& probe = probes[probeCount++];
+        probe.slaveId = ids[i];
+        probe.timeoutMs = timeouts[i];
+        probe.fresh = false;
+        probe.failures = 0;
+        probe.reading = {};
+        ModbusRtu::buildReadHoldingRegisters(ids[i], RS485_MODBUS_FIRST_REGISTER, RS485_MODBUS_REGISTER_COUNT,
+                                             probe.request);
+    }
     DEBUG_PRINTF("RS485Manager: Constructor inicializado\n");
 }
 
@@ -36,6 +77,9 @@ RS485Manager::~RS485Manager() {
 }
 
 bool RS485Manager::begin() {
+    if (RS485_HW_UART == 1) {
+        return beginHardwareUart();
+    }
     if (!serial) {
         DEBUG_PRINTF("RS485Manager: Error - Serial no inicializado\n");
         lastError = RS485_ERROR_COMMUNICATION;
@@ -55,36 +99,102 @@ bool RS485Manager::begin() {
     return true;
 }
 
+bool RS485Manager::beginHardwareUart() {
+    const uart_port_t port = (uart_port_t)RS485_UART_NUM;
+    uart_config_t config = {};
+    config.baud_rate = (int)baudrate;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+    // En UART_MODE_RS485_HALF_DUPLEX el driver sube RTS al cargar la FIFO y lo
+    // baja en la interrupción de fin de transmisión: DE/RE vuelve a recepción
+    // microsegundos después del último bit de parada
+    if (uart_driver_install(port, RS485_UART_RX_BUFFER, 0, 0, nullptr, 0) != ESP_OK ||
+        uart_param_config(port, &config) != ESP_OK ||
+        uart_set_pin(port, RS485_TX_SOFTWARE, RS485_RX_SOFTWARE, controlPin, UART_PIN_NO_CHANGE) != ESP_OK ||
+        uart_set_mode(port, UART_MODE_RS485_HALF_DUPLEX) != ESP_OK) {
+        DEBUG_PRINTF("RS485Manager: Error instalando el driver UART%d\n", RS485_UART_NUM);
+        lastError = RS485_ERROR_COMMUNICATION;
+        return false;
+    }
+    hardwareUart = true;
+    DEBUG_PRINTF("RS485Manager: UART%d RS485 half duplex en baudrate %d, DE/RE en RTS (pin %d)\n",
+                 RS485_UART_NUM, baudrate, controlPin);
+    return true;
+}
+
+void RS485Manager::discardInput() {
+    if (hardwareUart) {
+        uart_flush_input((uart_port_t)RS485_UART_NUM);
+        return;
+    }
+    while (serial->available()) serial->read();
+}
+
+bool RS485Manager::transmit(const uint8_t* data, size_t len) {
+    if (hardwareUart) {
+        const uart_port_t port = (uart_port_t)RS485_UART_NUM;
+        if (uart_write_bytes(port, (const char*)data, len) != (int)len) {
+            return false;
+        }
+        // Lo que dura la trama en el bus (10 bits por byte) más margen
+        uint32_t airMs = (uint32_t)(len * 10000UL / baudrate) + 10;
+        return uart_wait_tx_done(port, pdMS_TO_TICKS(airMs)) == ESP_OK;
+    }
+    digitalWrite(controlPin, HIGH); // TX
+    delay(RS485_TX_DELAY);
+    serial->write(data, len);
+    serial->flush();
+    digitalWrite(controlPin, LOW); // RX
+    delay(12); // respiro antes de leer
+    return true;
+}
+
+size_t RS485Manager::receive(uint8_t* data, size_t len, uint32_t timeoutMs) {
+    if (hardwareUart) {
+        // Bloquea solo esta tarea hasta tener len bytes o vencer el timeout
+        int got = uart_read_bytes((uart_port_t)RS485_UART_NUM, data, len, pdMS_TO_TICKS(timeoutMs));
+        return got > 0 ? (size_t)got : 0;
+    }
+    unsigned long startTime = millis();
+    while ((millis() - startTime) < timeoutMs && (size_t)serial->available() < len) {
+        yield();
+    }
+    if ((size_t)serial->available() < len) {
+        return 0;
+    }
+    return serial->readBytes((char*)data, len);
+}
+
 bool RS485Manager::requestSensorData(Protocol::GroundSensor& sensorData) {
+    if (RS485_MODBUS == 1) {
+        return requestModbusData(sensorData);
+    }
     for (uint8_t attempt = 0; attempt <= retryCount; attempt++) {
         if (attempt > 0) {
             delay(100); // Pequeña pausa entre reintentos
         }
 
         // Limpiar buffer antes de transmitir
-        while (serial->available()) serial->read();
+        discardInput();
 
         // Enviar solicitud binaria: 0x20
-        digitalWrite(controlPin, HIGH); // TX
-        delay(RS485_TX_DELAY);
         uint8_t req = (uint8_t)Protocol::RS485Type::REQ_GROUND_DATA;
-        serial->write(req);
-        serial->flush();
-        digitalWrite(controlPin, LOW); // RX
-        delay(12); // respiro antes de leer
+        if (!transmit(&req, 1)) {
+            lastError = RS485_ERROR_COMMUNICATION;
+            continue;
+        }
 
         // Esperar tipo de respuesta
-        unsigned long startTime = millis();
-        while ((millis() - startTime) < timeout && serial->available() < 1) {
-            yield();
-        }
-        if (serial->available() < 1) {
-            DEBUG_PRINTF("RS485Manager: Timeout esperando tipo de respuesta (%lu ms)\n", timeout);
+        uint8_t respType = 0;
+        if (receive(&respType, 1, timeout) < 1) {
+            DEBUG_PRINTF("RS485Manager: Timeout esperando tipo de respuesta (%lu ms)\n", (unsigned long)timeout);
             lastError = RS485_ERROR_TIMEOUT;
             continue; // reintentar
         }
 
-        uint8_t respType = (uint8_t)serial->read();
         DEBUG_PRINTF("RS485Manager: Tipo respuesta=0x%02X\n", respType);
         if (respType != (uint8_t)Protocol::RS485Type::DATA_GROUND) {
             DEBUG_PRINTF("RS485Manager: Tipo inesperado (esperado 0x30)\n");
@@ -95,21 +205,11 @@ bool RS485Manager::requestSensorData(Protocol::GroundSensor& sensorData) {
         // Leer payload binario exacto (13 bytes)
         Protocol::GroundSensorBinary payload;
         size_t expected = sizeof(Protocol::GroundSensorBinary);
-        startTime = millis();
-        while ((millis() - startTime) < timeout && (size_t)serial->available() < expected) {
-            yield();
-        }
-        if ((size_t)serial->available() < expected) {
-            DEBUG_PRINTF("RS485Manager: Timeout esperando %d bytes de payload\n", (int)expected);
-            lastError = RS485_ERROR_TIMEOUT;
-            continue; // reintentar
-        }
-
-        size_t got = serial->readBytes((char*)&payload, expected);
+        size_t got = receive((uint8_t*)&payload, expected, timeout);
         DEBUG_PRINTF("RS485Manager: Payload bytes leidos=%d (esperado=%d)\n", (int)got, (int)expected);
         if (got != expected) {
-            lastError = RS485_ERROR_COMMUNICATION;
-            continue;
+            lastError = got == 0 ? RS485_ERROR_TIMEOUT : RS485_ERROR_COMMUNICATION;
+            continue; // reintentar
         }
 
         // Mapear a estructura interna
@@ -133,7 +233,7 @@ bool RS485Manager::requestSensorData(Protocol::GroundSensor& sensorData) {
 // Métodos simplificados eliminados - ya no necesarios con el protocolo de texto
 
 bool RS485Manager::isAvailable() {
-    return (serial != nullptr && failedAttempts < 5);
+    return ((hardwareUart || serial != nullptr) && failedAttempts < 5);
 }
 
 int RS485Manager::getLastError() const {
@@ -145,25 +245,21 @@ uint8_t RS485Manager::getFailedAttempts() const {
 }
 
 bool RS485Manager::sendPing() {
+    if (RS485_MODBUS == 1) {
+        return pollProbes() > 0; // Modbus no tiene PING: alcanza con que responda una sonda
+    }
     // Limpiar buffer antes de transmitir
-    while (serial->available()) serial->read();
+    discardInput();
     
     // Enviar PING
-    digitalWrite(controlPin, HIGH); // Modo transmisión
-    delay(RS485_TX_DELAY);
-    serial->write((uint8_t)Protocol::RS485Type::PING);
-    serial->flush();
-    digitalWrite(controlPin, LOW); // Modo recepción
-    delay(12); // pequeño respiro antes de leer
-    
-    // Esperar PONG
-    unsigned long startTime = millis();
-    while ((millis() - startTime) < timeout && serial->available() < 1) {
-        yield();
+    uint8_t ping = (uint8_t)Protocol::RS485Type::PING;
+    if (!transmit(&ping, 1)) {
+        return false;
     }
     
-    if (serial->available() >= 1) {
-        uint8_t resp = serial->read();
+    // Esperar PONG
+    uint8_t resp = 0;
+    if (receive(&resp, 1, timeout) == 1) {
         DEBUG_PRINTF("RS485Manager: PING respuesta=0x%02X\n", resp);
         return (resp == (uint8_t)Protocol::RS485Type::PONG);
     }
@@ -171,4 +267,124 @@ bool RS485Manager::sendPing() {
     DEBUG_PRINTF("RS485Manager: PING timeout\n");
     return false;
 }
- 
\ No newline at end of file
+
+void RS485Manager::waitInterFrameGap() {
+    uint32_t gap = ModbusRtu::interFrameUs(baudrate);
+    uint32_t elapsed = micros() - lastFrameEndUs;
+    if (elapsed < gap) {
+        delayMicroseconds(gap - elapsed);
+    }
+}
+
+bool RS485Manager::modbusTransaction(const uint8_t* request, uint16_t count, uint16_t* out, uint32_t timeoutMs) {
+    const size_t header = ModbusRtu::RESPONSE_HEADER_SIZE;
+    uint8_t frame[ModbusRtu::RESPONSE_HEADER_SIZE + 2 * ModbusRtu::MAX_READ_REGISTERS + 2];
+
+    waitInterFrameGap();
+    discardInput();
+    if (!transmit(request, ModbusRtu::REQUEST_SIZE)) {
+        lastError = RS485_ERROR_COMMUNICATION;
+        lastFrameEndUs = micros();
+        return false;
+    }
+
+    // La espera de la sonda es solo hasta la cabecera; el resto ya está en
+    // camino y tarda lo que dicen sus bytes en el bus
+    size_t got = receive(frame, header, timeoutMs);
+    if (got < header) {
+        DEBUG_PRINTF("RS485Manager: Modbus esclavo %d sin respuesta (%lu ms)\n", request[0], (unsigned long)timeoutMs);
+        lastError = RS485_ERROR_TIMEOUT;
+        lastFrameEndUs = micros();
+        return false;
+    }
+    size_t rest = ModbusRtu::remainingAfterHeader(frame);
+    if (header + rest > sizeof(frame)) {
+        lastError = RS485_ERROR_INVALID_DATA;
+        lastFrameEndUs = micros();
+        return false;
+    }
+    uint32_t restMs = (uint32_t)(rest * 10000UL / baudrate) + 10;
+    got += receive(frame + header, rest, restMs);
+    lastFrameEndUs = micros();
+    if (got < header + rest) {
+        DEBUG_PRINTF("RS485Manager: Modbus esclavo %d trama incompleta (%d de %d bytes)\n",
+                     request[0], (int)got, (int)(header + rest));
+        lastError = RS485_ERROR_TIMEOUT;
+        return false;
+    }
+
+    uint8_t exception = 0;
+    ModbusRtu::Result result = ModbusRtu::parseReadHoldingRegisters(frame, got, request[0], count, out, &exception);
+    if (result != ModbusRtu::OK) {
+        DEBUG_PRINTF("RS485Manager: Modbus esclavo %d respuesta inválida (%d, excepción %d)\n",
+                     request[0], (int)result, exception);
+        lastError = result == ModbusRtu::BAD_CRC ? RS485_ERROR_CHECKSUM : RS485_ERROR_INVALID_DATA;
+        return false;
+    }
+    return true;
+}
+
+bool RS485Manager::readHoldingRegisters(uint8_t slave, uint16_t first, uint16_t count, uint16_t* out,
+                                        uint32_t timeoutMs) {
+    uint8_t request[ModbusRtu::REQUEST_SIZE];
+    if (ModbusRtu::buildReadHoldingRegisters(slave, first, count, request) == 0) {
+        lastError = RS485_ERROR_INVALID_DATA;
+        return false;
+    }
+    if (!modbusTransaction(request, count, out, timeoutMs)) {
+        return false;
+    }
+    lastError = RS485_ERROR_NONE;
+    return true;
+}
+
+uint8_t RS485Manager::pollProbes(bool onlyStale) {
+    uint16_t regs[RS485_MODBUS_REGISTER_COUNT];
+    uint8_t responded = 0;
+    for (uint8_t i = 0; i < probeCount; i++) {
+        ModbusProbe& probe = probes[i];
+        if (onlyStale && probe.fresh) {
+            responded++;
+            continue;
+        }
+        probe.fresh = modbusTransaction(probe.request, RS485_MODBUS_REGISTER_COUNT, regs, probe.timeoutMs);
+        if (!probe.fresh) {
+            if (probe.failures < 255) {
+                probe.failures++;
+            }
+            continue;
+        }
+        probe.failures = 0;
+        registersToGround(regs, probe.reading);
+        responded++;
+    }
+    return responded;
+}
+
+bool RS485Manager::requestModbusData(Protocol::GroundSensor& sensorData) {
+    // Los reintentos van solo a las sondas que fallaron, sin pausa: la ronda
+    // no se detiene por una sonda caída
+    uint8_t responded = 0;
+    for (uint8_t attempt = 0; attempt <= retryCount && responded < probeCount; attempt++) {
+        responded = pollProbes(attempt > 0);
+    }
+    DEBUG_PRINTF("RS485Manager: Ronda Modbus, %d de %d sondas respondieron\n", responded, probeCount);
+    for (uint8_t i = 0; i < probeCount; i++) {
+        if (probes[i].fresh) {
+            sensorData = probes[i].reading;
+            lastError = RS485_ERROR_NONE;
+            failedAttempts = 0;
+            return true;
+        }
+    }
+    failedAttempts++;
+    return false;
+}
+
+uint8_t RS485Manager::getProbeCount() const {
+    return probeCount;
+}
+
+const RS485Manager::ModbusProbe* RS485Manager::getProbe(uint8_t index) const {
+    return index < probeCount ? &probes[index] : nullptr;
+}
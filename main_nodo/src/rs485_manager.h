@@ -7,6 +7,12 @@
  * Utiliza el protocolo MAX485 para controlar la dirección de comunicación.
  *
  * Características principales:
+ * - Dos transportes (RS485_HW_UART): un UART del ESP32 en modo
+ *   UART_MODE_RS485_HALF_DUPLEX, con DE/RE en RTS manejado por el driver, o
+ *   SoftwareSerial con DE/RE a mano
+ * - Maestro Modbus RTU (RS485_MODBUS) para varias sondas en el mismo bus: una
+ *   ronda lee los registros de cada esclavo en un pedido, uno tras otro sin
+ *   esperas fijas, con el timeout de cada sonda
  * - Control de pines DE/RE para modo lectura/escritura
  * - Protocolo de comunicación robusto con timeouts
  * - Validación de checksum para integridad de datos
@@ -25,6 +31,7 @@
 #include <SoftwareSerial.h>
 #include "protocol.h"
 #include "config.h"
+#include "modbus_rtu.h"
 
 /** 
  * @class RS485Manager
@@ -49,13 +56,41 @@
  */
 class RS485Manager {
 private:
-    SoftwareSerial* serial;     ///< Puntero al puerto serial utilizado
-    uint8_t controlPin;         ///< Pin para control DE/RE (HIGH=Transmitir, LOW=Recibir)
+    SoftwareSerial* serial;     ///< Puerto serial con RS485_HW_UART 0
+    bool hardwareUart;          ///< begin() instaló el driver UART del IDF (RS485_HW_UART)
+    uint8_t controlPin;         ///< Pin para control DE/RE (HIGH=Transmitir, LOW=Recibir); RTS con RS485_HW_UART
     uint32_t baudrate;          ///< Velocidad de comunicación
     uint32_t timeout;           ///< Timeout para operaciones
     uint8_t retryCount;         ///< Número de reintentos
-    
-    // Métodos privados simplificados - protocolo de texto como en el ejemplo de Naylamp
+
+    // Transporte: UART del IDF o SoftwareSerial, según begin()
+    bool beginHardwareUart();
+    void discardInput();
+    // Envía y vuelve a recepción; con el UART el driver baja RTS al salir el último bit
+    bool transmit(const uint8_t* data, size_t len);
+    // Espera hasta len bytes por timeoutMs; devuelve los leídos
+    size_t receive(uint8_t* data, size_t len, uint32_t timeoutMs);
+    // Silencio Modbus de 3,5 caracteres desde la última trama del bus
+    void waitInterFrameGap();
+
+public:
+    /**
+     * @struct ModbusProbe
+     * @brief Una sonda Modbus del bus y su última lectura.
+     */
+    struct ModbusProbe {
+        uint8_t slaveId;
+        uint16_t timeoutMs;                        ///< Espera del primer byte de respuesta
+        uint8_t request[ModbusRtu::REQUEST_SIZE];  ///< Pedido armado una vez, con su CRC
+        bool fresh;                                ///< Respondió en la última ronda
+        uint8_t failures;                          ///< Rondas seguidas sin respuesta válida
+        Protocol::GroundSensor reading;            ///< Última lectura válida
+    };
+
+private:
+    bool requestModbusData(Protocol::GroundSensor& sensorData);
+    // Pedido armado (esclavo en request[0]), cabecera con timeoutMs y el resto según su largo
+    bool modbusTransaction(const uint8_t* request, uint16_t count, uint16_t* out, uint32_t timeoutMs);
 
 public:
     /**
@@ -79,12 +114,16 @@ public:
     
     /**
      * @brief Inicializa la comunicación RS485.
+     * @details Con RS485_HW_UART instala el driver en RS485_UART_NUM con RTS en
+     * controlPin y el puntero serial no se usa.
      * @return true si la inicialización fue exitosa, false en caso contrario
      */
     bool begin();
     
     /**
      * @brief Solicita datos de sensores al módulo externo.
+     * @details Con RS485_MODBUS hace una ronda por las sondas (y reintenta solo
+     * las que no respondieron) y devuelve la lectura de la primera que respondió.
      * @param sensorData Referencia donde se almacenarán los datos recibidos
      * @return true si se recibieron datos válidos, false en caso contrario
      */
@@ -114,9 +153,42 @@ public:
      */
     bool sendPing();
 
+    /**
+     * @brief Lee holding registers de un esclavo Modbus en una transacción.
+     * @details Lee la cabecera de la respuesta con timeoutMs y el resto según
+     * su largo: el tiempo en el bus crece con count, no con esperas fijas.
+     * @param out count registros
+     * @return true si la respuesta es válida (CRC, dirección y cantidad)
+     */
+    bool readHoldingRegisters(uint8_t slave, uint16_t first, uint16_t count, uint16_t* out, uint32_t timeoutMs);
+
+    /**
+     * @brief Ronda Modbus por las sondas de RS485_MODBUS_SLAVE_IDS.
+     * @details Cada pedido sale apenas termina la respuesta (o el timeout) del
+     * anterior más el silencio entre tramas; una sonda que no responde no se
+     * reintenta dentro de la ronda.
+     * @param onlyStale Solo las sondas que no respondieron en la ronda anterior
+     * @return Sondas con lectura de esta ronda
+     */
+    uint8_t pollProbes(bool onlyStale = false);
+
+    /**
+     * @brief Cantidad de sondas Modbus configuradas.
+     */
+    uint8_t getProbeCount() const;
+
+    /**
+     * @brief Sonda Modbus por índice (orden de RS485_MODBUS_SLAVE_IDS).
+     * @return nullptr si index no es válido
+     */
+    const ModbusProbe* getProbe(uint8_t index) const;
+
 private:
     int lastError;              ///< Último código de error
     uint8_t failedAttempts;     ///< Contador de intentos fallidos
+    ModbusProbe probes[RS485_MODBUS_MAX_SLAVES];  ///< Sondas Modbus (RS485_MODBUS)
+    uint8_t probeCount;
+    uint32_t lastFrameEndUs;    ///< micros() al terminar la última trama en el bus
 };
 
 #endif // RS485_MANAGER_H 
\ No newline at end of file
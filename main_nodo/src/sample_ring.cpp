@@ -0,0 +1,83 @@
+/**
+ * @file sample_ring.cpp
+ * @brief Implementación del buffer circular de muestras atmosféricas
+ */
+
+#include "sample_ring.h"
+
+static_assert(ATMOS_RING_CAPACITY >= NUMERO_MUESTRAS_ATMOSFERICAS && ATMOS_RING_CAPACITY <= 255,
+              "ATMOS_RING_CAPACITY debe alojar un lote y entrar en uint8_t");
+
+void SampleRing::clear()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void SampleRing::push(const Protocol::AtmosphericSample &sample, uint32_t timestamp)
+{
+    samples[head % CAPACITY] = sample;
+    timestamps[head % CAPACITY] = timestamp;
+    head++;
+    if (head - tail > CAPACITY) {
+        tail = head - CAPACITY;  // Se pisó la más vieja sin confirmar
+        droppedCount++;
+    }
+}
+
+uint32_t SampleRing::written() const
+{
+    return head;
+}
+
+uint32_t SampleRing::pending() const
+{
+    return head - tail;
+}
+
+uint32_t SampleRing::dropped() const
+{
+    return droppedCount;
+}
+
+uint32_t SampleRing::oldest() const
+{
+    return head > CAPACITY ? head - CAPACITY : 0;
+}
+
+uint8_t SampleRing::window(uint8_t n, Segment &first, Segment &second, uint32_t &end) const
+{
+    if (n > CAPACITY) {
+        n = CAPACITY;
+    }
+    end = head - tail > n ? tail + n : head;  // Atrasado: primero lo más viejo pendiente
+    uint32_t start = end >= n ? end - n : 0;
+    if (start < oldest()) {
+        start = oldest();
+    }
+    uint8_t count = (uint8_t)(end - start);
+    uint8_t at = (uint8_t)(start % CAPACITY);
+    first.samples = &samples[at];
+    first.count = count < CAPACITY - at ? count : (uint8_t)(CAPACITY - at);
+    second.samples = samples;
+    second.count = (uint8_t)(count - first.count);
+    return count;
+}
+
+bool SampleRing::ack(uint32_t end)
+{
+    if (end <= tail || end > head) {
+        return false;
+    }
+    tail = end;
+    return true;
+}
+
+const Protocol::AtmosphericSample &SampleRing::sample(uint32_t index) const
+{
+    return samples[index % CAPACITY];
+}
+
+uint32_t SampleRing::timestamp(uint32_t index) const
+{
+    return timestamps[index % CAPACITY];
+}
@@ -0,0 +1,128 @@
+/**
+ * @file sample_ring.h
+ * @brief Buffer circular de muestras atmosféricas con cola confirmada por el gateway
+ * @date 2025
+ *
+ * DATA_ATMOSPHERIC lleva siempre NUMERO_MUESTRAS_ATMOSFERICAS muestras en
+ * orden de toma. El anillo guarda ATMOS_RING_CAPACITY (más que un lote) con
+ * dos contadores absolutos:
+ *
+ * - cabeza (written()): muestras escritas desde clear(); la siguiente va en
+ *   written() % CAPACITY.
+ * - cola (acked): la primera muestra que el gateway todavía no confirmó.
+ *
+ * window() elige el lote sin copiar: si hay hasta un lote pendiente son las
+ * últimas N (completadas hacia atrás con muestras ya confirmadas); si hay más
+ * (pedidos perdidos), las N pendientes más viejas, y cada confirmación del
+ * gateway (Protocol::BATCH_ACK) avanza la cola un lote hasta ponerse al día.
+ * El lote puede cruzar el fin del arreglo: se devuelve en dos segmentos
+ * contiguos.
+ *
+ * Si el anillo se llena sin confirmaciones, push() pisa la muestra más vieja
+ * y la cuenta en dropped().
+ *
+ * Sin constructor ni punteros: vive en la memoria RTC de PowerManager::Memory
+ * y el estado todo en cero es un anillo vacío.
+ */
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "protocol.h"
+
+/**
+ * @class SampleRing
+ * @brief Muestras atmosféricas con marca de tiempo; lotes en orden y cola avanzada por BATCH_ACK.
+ *
+ * @example
+ * ```cpp
+ * ring.push(muestra, unixTime);
+ * SampleRing::Segment a, b;
+ * uint32_t end;
+ * ring.window(NUMERO_MUESTRAS_ATMOSFERICAS, a, b, end);
+ * // enviar a.samples[0..a.count) y b.samples[0..b.count)
+ * ring.ack(end);  // al llegar el BATCH_ACK del lote
+ * ```
+ */
+class SampleRing
+{
+public:
+    static const uint8_t CAPACITY = ATMOS_RING_CAPACITY;
+
+    /**
+     * @struct Segment
+     * @brief Tramo contiguo del anillo.
+     */
+    struct Segment {
+        const Protocol::AtmosphericSample *samples;
+        uint8_t count;
+    };
+
+    /**
+     * @brief Vacía el anillo
+     */
+    void clear();
+
+    /**
+     * @brief Agrega una muestra en la cabeza
+     * @param timestamp Hora UTC de la toma en segundos Unix (0 = desconocida)
+     */
+    void push(const Protocol::AtmosphericSample &sample, uint32_t timestamp);
+
+    /**
+     * @brief Muestras escritas desde clear(): índice absoluto de la cabeza
+     */
+    uint32_t written() const;
+
+    /**
+     * @brief Muestras todavía sin confirmar
+     */
+    uint32_t pending() const;
+
+    /**
+     * @brief Muestras pisadas sin confirmar por tener el anillo lleno
+     */
+    uint32_t dropped() const;
+
+    /**
+     * @brief Índice absoluto de la muestra más vieja que sigue en el anillo
+     */
+    uint32_t oldest() const;
+
+    /**
+     * @brief Lote de hasta n muestras en orden de toma, sin copiarlas
+     * @param n Muestras del lote (no más que CAPACITY)
+     * @param first Primer tramo
+     * @param second Continuación desde el inicio del arreglo (count 0 si no cruza)
+     * @param end Índice absoluto siguiente a la última muestra del lote, para ack()
+     * @return Muestras del lote; menos que n solo si todavía no se escribieron n
+     */
+    uint8_t window(uint8_t n, Segment &first, Segment &second, uint32_t &end) const;
+
+    /**
+     * @brief El gateway confirmó el lote que termina en end: avanza la cola
+     * @return false si end no avanza la cola (ACK repetido o viejo)
+     */
+    bool ack(uint32_t end);
+
+    /**
+     * @brief Muestra por índice absoluto, entre oldest() y written()
+     */
+    const Protocol::AtmosphericSample &sample(uint32_t index) const;
+
+    /**
+     * @brief Marca de tiempo de la muestra index (segundos Unix, 0 = desconocida)
+     */
+    uint32_t timestamp(uint32_t index) const;
+
+private:
+    Protocol::AtmosphericSample samples[CAPACITY];
+    uint32_t timestamps[CAPACITY];
+    uint32_t head;          ///< Muestras escritas desde clear()
+    uint32_t tail;          ///< Primera muestra sin confirmar
+    uint32_t droppedCount;
+};
+
+#endif // SAMPLE_RING_H
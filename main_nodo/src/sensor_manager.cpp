@@ -1,6 +1,20 @@
 // 03:00 16/6/2025
 #include "sensor_manager.h"
 
+namespace {
+  /** Segundos Unix de una fecha y hora UTC (días desde 1970 por el algoritmo de fechas civiles). */
+  uint32_t unixTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second)
+  {
+    int32_t y = (int32_t)year - (month <= 2);
+    int32_t era = y / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    uint32_t days = (uint32_t)(era * 146097 + (int32_t)doe - 719468);
+    return days * 86400UL + hour * 3600UL + minute * 60UL + second;
+  }
+}
+
 // Constructor (opcionalmente inicializar sensores aquí)
 SensorManager::SensorManager()
     : gpsSerial(2), dht(PIN_SENS_DHTT, DHTTYPE), gps() // UART2 para GPS
@@ -8,9 +22,10 @@ SensorManager::SensorManager()
     , rs485Manager(&rs485Serial, RS485_RE_DE) // Usar SoftwareSerial con pin de control RS485
 {
   simulationModeEnabled = (SENSOR_SIMULATION_ENABLED == 1); // Inicializar según flag de config
+  atmosRing.clear();
   // begin();
 }
-void SensorManager::begin()
+void SensorManager::begin(bool quick)
 {
   Serial.print("constructor sensor manage");
   gpsSerial.begin(GPS_BAUDRATE);
@@ -23,6 +38,9 @@ void SensorManager::begin()
   } else {
     DEBUG_PRINTF("SensorManager: Error inicializando RS485\n");
   }
+  if (quick) {
+    return;
+  }
   
   // Handshake RS485 - verificar que el esclavo está en línea
   DEBUG_PRINTF("SensorManager: Verificando conexión RS485...\n");
@@ -69,72 +87,52 @@ void SensorManager::readGroundSensors()
 
 bool bufferLlenoAdvertido = false; // Bandera global o estática para advertencia
 
-void SensorManager::readAtmosphericSensors()
+Protocol::AtmosphericSample SensorManager::takeAtmosphericSample(uint32_t &timestamp)
 {
-  if (atmosSampleCount < NUMERO_MUESTRAS_ATMOSFERICAS)
+  Protocol::AtmosphericSample sample;
+  GpsFix fix = currentFix();
+  timestamp = 0;
+  float h = dht.readHumidity();
+  float t = dht.readTemperature();
+  if (isnan(h) || isnan(t))
   {
-    float h = dht.readHumidity();
-    float t = dht.readTemperature();
-    if (isnan(h) || isnan(t))
-    {
-      Serial.println("ERROR: ¡Fallo al leer del sensor DHT11!");
-      atmosSamples[atmosSampleCount].temp = SENSOR_ERROR_TEMP;
-      atmosSamples[atmosSampleCount].moisture = SENSOR_ERROR_MOISTURE;
-    }
-    else
-    {
-      atmosSamples[atmosSampleCount].temp = (int16_t)(t * 10.0);
-      atmosSamples[atmosSampleCount].moisture = (uint16_t)(h * 10.0);
-    }
-    if (gps.time.isValid())
-    {
-      atmosSamples[atmosSampleCount].hour = gps.time.hour();
-      atmosSamples[atmosSampleCount].minute = gps.time.minute();
-    }
-    else
-    {
-      Serial.println("ADVERTENCIA: Tiempo GPS no válido para muestra atmosférica.");
-      debugGPS(); // Llamar al debugging detallado
-      atmosSamples[atmosSampleCount].hour = SENSOR_ERROR_TIME_COMPONENT;
-      atmosSamples[atmosSampleCount].minute = SENSOR_ERROR_TIME_COMPONENT;
-    }
-
-    atmosSampleCount++;
-    Serial.print("DEBUG: Muestra atmosferica #");
-    Serial.print(String(atmosSampleCount));
-    Serial.println(" guardada.");
+    Serial.println("ERROR: ¡Fallo al leer del sensor DHT11!");
+    sample.temp = SENSOR_ERROR_TEMP;
+    sample.moisture = SENSOR_ERROR_MOISTURE;
   }
   else
   {
-    // Si el buffer está lleno, sobrescribe la última posición
-    float h = dht.readHumidity();
-    float t = dht.readTemperature();
-    if (isnan(h) || isnan(t))
-    {
-      atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].temp = SENSOR_ERROR_TEMP;
-      atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].moisture = SENSOR_ERROR_MOISTURE;
-      atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].hour = SENSOR_ERROR_TIME_COMPONENT;
-      atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].minute = SENSOR_ERROR_TIME_COMPONENT;
-    }
-    else
+    sample.temp = (int16_t)(t * 10.0);
+    sample.moisture = (uint16_t)(h * 10.0);
+  }
+  if (fix.timeValid)
+  {
+    sample.hour = fix.hour;
+    sample.minute = fix.minute;
+    if (fix.dateValid)
     {
-      atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].temp = (int16_t)(t * 10.0);
-      atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].moisture = (uint16_t)(h * 10.0);
-      if (gps.time.isValid())
-      {
-        atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].hour = gps.time.hour();
-        atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].minute = gps.time.minute();
-      }
-      else
-      {
-        Serial.println("ADVERTENCIA: Tiempo GPS no válido para muestra atmosférica (sobrescritura).");
-        debugGPS(); // Llamar al debugging detallado
-        atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].hour = SENSOR_ERROR_TIME_COMPONENT;
-        atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS - 1].minute = SENSOR_ERROR_TIME_COMPONENT;
-      }
+      timestamp = unixTime(fix.year, fix.month, fix.day, fix.hour, fix.minute, fix.second);
     }
-    // No imprimir advertencia ni bloquear
   }
+  else
+  {
+    Serial.println("ADVERTENCIA: Tiempo GPS no válido para muestra atmosférica.");
+    debugGPS(); // Llamar al debugging detallado
+    sample.hour = SENSOR_ERROR_TIME_COMPONENT;
+    sample.minute = SENSOR_ERROR_TIME_COMPONENT;
+  }
+  return sample;
+}
+
+void SensorManager::readAtmosphericSensors()
+{
+  // Cada lectura entra en la cabeza del anillo; con el anillo lleno se pisa la más vieja
+  uint32_t timestamp;
+  Protocol::AtmosphericSample sample = takeAtmosphericSample(timestamp);
+  atmosRing.push(sample, timestamp);
+  Serial.print("DEBUG: Muestra atmosferica #");
+  Serial.print(String(atmosRing.written()));
+  Serial.println(" guardada.");
 }
 // Método privado para simular o leer sensores en tierra npk,humedad,temp,ph,ec(electroconductividad)
 
@@ -150,12 +148,13 @@ void SensorManager::readGpsSensors()
   gpsData.minute = SENSOR_ERROR_TIME_COMPONENT;
 
   bool hasErrors = false; // Flag para detectar si hay errores
+  GpsFix fix = currentFix();
 
   // --- Procesar Ubicación (Latitud y Longitud) ---
-  if (gps.location.isValid())
+  if (fix.locationValid)
   {
-    gpsData.latitude = gps.location.lat();
-    gpsData.longitude = gps.location.lng();
+    gpsData.latitude = fix.latitude;
+    gpsData.longitude = fix.longitude;
     gpsData.flags |= 0x01; // Establece el bit0: Ubicación válida
     Serial.printf("GPS - Ubicación VÁLIDA: Lat=%.7f, Lon=%.7f\n", 
                   gpsData.latitude, gpsData.longitude);
@@ -167,9 +166,9 @@ void SensorManager::readGpsSensors()
   }
 
   // --- Procesar Altitud ---
-  if (gps.altitude.isValid())
+  if (fix.altitudeValid)
   {
-    gpsData.altitude = gps.altitude.meters();
+    gpsData.altitude = fix.altitude;
     gpsData.flags |= 0x02; // Establece el bit1: Altitud válida
     Serial.printf("GPS - Altitud VÁLIDA: %.2f metros\n", gpsData.altitude);
   }
@@ -180,11 +179,11 @@ void SensorManager::readGpsSensors()
   }
 
   // --- Procesar Fecha y Hora ---
-  if (gps.date.isValid() && gps.time.isValid())
+  if (fix.dateValid && fix.timeValid)
   {
     // Hora UTC del GPS
-    gpsData.hour = gps.time.hour();
-    gpsData.minute = gps.time.minute();
+    gpsData.hour = fix.hour;
+    gpsData.minute = fix.minute;
 
     // --- OPCIONAL: Ajuste a la hora local de Buenos Aires (UTC-3) ---
     // Si necesitas la hora ajustada para el almacenamiento final, aplica aquí.
@@ -202,7 +201,7 @@ void SensorManager::readGpsSensors()
 
     gpsData.flags |= 0x04; // Establece el bit2: Fecha y Hora válidas
     Serial.printf("GPS - Fecha/Hora VÁLIDAS: %02d:%02d:%02d UTC\n", 
-                  gpsData.hour, gpsData.minute, gps.time.second());
+                  gpsData.hour, gpsData.minute, fix.second);
   }
   else
   {
@@ -217,20 +216,21 @@ void SensorManager::readGpsSensors()
 }
 
 void SensorManager::debugGPS() {
+  GpsFix fix = currentFix();
   Serial.println("=== DEBUG GPS DETALLADO ===");
   
   // Información general del GPS
-  Serial.printf("GPS - Caracteres procesados: %d\n", gps.charsProcessed());
-  Serial.printf("GPS - Sentencias con fix: %d\n", gps.sentencesWithFix());
-  Serial.printf("GPS - Checksums fallidos: %d\n", gps.failedChecksum());
-  Serial.printf("GPS - Checksums válidos: %d\n", gps.passedChecksum());
+  Serial.printf("GPS - Caracteres procesados: %d\n", fix.charsProcessed);
+  Serial.printf("GPS - Sentencias con fix: %d\n", fix.sentencesWithFix);
+  Serial.printf("GPS - Checksums fallidos: %d\n", fix.failedChecksum);
+  Serial.printf("GPS - Checksums válidos: %d\n", fix.passedChecksum);
   
   // Información de satélites
-  Serial.printf("GPS - Satélites visibles: %d\n", gps.satellites.value());
-  Serial.printf("GPS - HDOP: %.1f\n", gps.hdop.hdop());
+  Serial.printf("GPS - Satélites visibles: %d\n", fix.satellites);
+  Serial.printf("GPS - HDOP: %.1f\n", fix.hdop);
   
   // Estado de fix
-  if (gps.location.isValid()) {
+  if (fix.locationValid) {
     Serial.println("GPS - Estado: FIX VÁLIDO");
   } else {
     Serial.println("GPS - Estado: SIN FIX");
@@ -238,24 +238,24 @@ void SensorManager::debugGPS() {
   
   // Información de tiempo
   Serial.printf("GPS - Tiempo desde inicio: %lu ms\n", millis());
-  Serial.printf("GPS - Última actualización: %d ms\n", gps.location.age());
+  Serial.printf("GPS - Última actualización: %d ms\n", fix.locationAge);
   
-  // Información de velocidad y curso (si está disponible)
-  if (gps.speed.isValid()) {
+  // Información de velocidad y curso (si está disponible; con tareas TinyGPSPlus es de la tarea GPS)
+  if (!taskMode && gps.speed.isValid()) {
     Serial.printf("GPS - Velocidad: %.2f km/h\n", gps.speed.kmph());
   }
-  if (gps.course.isValid()) {
+  if (!taskMode && gps.course.isValid()) {
     Serial.printf("GPS - Curso: %.1f°\n", gps.course.deg());
   }
   
   // Información de fecha y hora
-  if (gps.date.isValid()) {
+  if (fix.dateValid) {
     Serial.printf("GPS - Fecha: %02d/%02d/%02d\n", 
-                  gps.date.month(), gps.date.day(), gps.date.year());
+                  fix.month, fix.day, fix.year);
   }
-  if (gps.time.isValid()) {
+  if (fix.timeValid) {
     Serial.printf("GPS - Hora: %02d:%02d:%02d UTC\n", 
-                  gps.time.hour(), gps.time.minute(), gps.time.second());
+                  fix.hour, fix.minute, fix.second);
   }
   
   Serial.println("===========================");
@@ -293,13 +293,31 @@ void SensorManager::update()
     gps.encode(gpsSerial.read());
   }
   saveGpsCoordinatePeriodically();
-  if (currentMillis - lastSampleTime >= SAMPLEINTERVALMSATMOSPHERIC || atmosSampleCount == 0)
+  if (currentMillis - lastSampleTime >= SAMPLEINTERVALMSATMOSPHERIC || atmosRing.written() == 0)
   {
     lastSampleTime = currentMillis; // Actualiza el tiempo de la última muestra
     readAtmosphericSensors();       // Toma una nueva muestra
   }
 }
 
+void SensorManager::sampleAtmospheric(unsigned long gpsWaitMs)
+{
+  unsigned long start = millis();
+  while (true)
+  {
+    while (gpsSerial.available())
+    {
+      gps.encode(gpsSerial.read());
+    }
+    if (gps.time.isValid() || millis() - start >= gpsWaitMs)
+    {
+      break;
+    }
+    delay(10);
+  }
+  readAtmosphericSensors();
+}
+
 void SensorManager::verificFullAtmosSamples()
 {
   const unsigned long TIMEOUT_MS = 3000; // Tiempo máximo permitido para llenar el buffer (3 segundos)
@@ -310,16 +328,15 @@ void SensorManager::verificFullAtmosSamples()
   errorSample.hour = SENSOR_ERROR_TIME_COMPONENT;
   errorSample.minute = SENSOR_ERROR_TIME_COMPONENT;
 
-  while (atmosSampleCount < NUMERO_MUESTRAS_ATMOSFERICAS)
+  while (atmosRing.written() < NUMERO_MUESTRAS_ATMOSFERICAS)
   {
     if (millis() - startTime > TIMEOUT_MS)
     {
-      // Timeout alcanzado: llenar todas las posiciones restantes del array con error
-      for (int i = atmosSampleCount; i < NUMERO_MUESTRAS_ATMOSFERICAS; ++i)
+      // Timeout alcanzado: completar el lote con muestras de error
+      while (atmosRing.written() < NUMERO_MUESTRAS_ATMOSFERICAS)
       {
-        atmosSamples[i] = errorSample;
+        atmosRing.push(errorSample, 0);
       }
-      atmosSampleCount = NUMERO_MUESTRAS_ATMOSFERICAS;
       Serial.println("ADVERTENCIA: Timeout llenando buffer atmosférico. Se completó con errores.");
       break;
     }
@@ -339,9 +356,7 @@ void SensorManager::readGroundGpsSensors()
 
 void SensorManager::readSensorsAtmospheric()
 {
-  update();                  // llamo  a update por cuestion de actualizacion de muestre
-  verificFullAtmosSamples(); // verifico
-  atmosSampleCount = 0;      // Reinicia el contador de muestras para limpiar el buffer lógico
+  verificFullAtmosSamples(); // El anillo no se vacía: los lotes avanzan con SampleRing::ack()
 }
 
 String SensorManager::getVoltageReaderDebugInfo()
@@ -390,5 +405,150 @@ String SensorManager::getRS485DebugInfo() {
     info += "RS485 disponible: " + String(rs485Manager.isAvailable() ? "SÍ" : "NO") + "\n";
     info += "Último error: " + String(rs485Manager.getLastError()) + "\n";
     info += "Intentos fallidos: " + String(rs485Manager.getFailedAttempts()) + "\n";
+    if (RS485_MODBUS == 1) {
+        for (uint8_t i = 0; i < rs485Manager.getProbeCount(); i++) {
+            const RS485Manager::ModbusProbe* probe = rs485Manager.getProbe(i);
+            info += "Sonda Modbus " + String(probe->slaveId) + ": " + String(probe->fresh ? "OK" : "sin respuesta") +
+                    ", rondas fallidas " + String(probe->failures) + "\n";
+        }
+    }
     return info;
+}
+
+Protocol::GroundGpsPacket SensorManager::groundGpsPacket()
+{
+  Protocol::GroundGpsPacket packet;
+  packet.ground = groundData;
+  // Usar la última coordenada guardada
+  GpsCoordinate lastCoord = currentFix().lastCoordinate;
+  packet.gps.latitude = lastCoord.latitude;
+  packet.gps.longitude = lastCoord.longitude;
+  packet.gps.hour = lastCoord.hour;
+  packet.gps.minute = lastCoord.minute;
+  // Mantener altitud y flags como estaban
+  packet.gps.altitude = gpsData.altitude;
+  packet.gps.flags = gpsData.flags;
+  // Agregar datos de energía
+  packet.energy = energyData;
+  return packet;
+}
+
+SensorManager::GpsFix SensorManager::captureFix()
+{
+  GpsFix fix;
+  fix.timeValid = gps.time.isValid();
+  fix.hour = gps.time.hour();
+  fix.minute = gps.time.minute();
+  fix.second = gps.time.second();
+  fix.dateValid = gps.date.isValid();
+  fix.year = gps.date.year();
+  fix.month = gps.date.month();
+  fix.day = gps.date.day();
+  fix.locationValid = gps.location.isValid();
+  fix.latitude = gps.location.lat();
+  fix.longitude = gps.location.lng();
+  fix.locationAge = gps.location.age();
+  fix.altitudeValid = gps.altitude.isValid();
+  fix.altitude = gps.altitude.meters();
+  fix.satellites = gps.satellites.value();
+  fix.hdop = gps.hdop.hdop();
+  fix.charsProcessed = gps.charsProcessed();
+  fix.sentencesWithFix = gps.sentencesWithFix();
+  fix.failedChecksum = gps.failedChecksum();
+  fix.passedChecksum = gps.passedChecksum();
+  fix.lastCoordinate = getLastGpsCoordinate();
+  return fix;
+}
+
+SensorManager::GpsFix SensorManager::currentFix()
+{
+  if (!taskMode)
+  {
+    return captureFix();
+  }
+  GpsFix fix = {};
+  gpsMailbox.read(fix); // Antes de la primera publicación de la tarea GPS todo queda inválido
+  return fix;
+}
+
+void SensorManager::enableTaskMode()
+{
+  taskMode = true;
+}
+
+bool SensorManager::isTaskMode() const
+{
+  return taskMode;
+}
+
+void SensorManager::gpsTaskStep()
+{
+  bool decoded = false;
+  while (gpsSerial.available())
+  {
+    decoded |= gps.encode(gpsSerial.read());
+  }
+  saveGpsCoordinatePeriodically();
+  if (decoded || gpsMailbox.version() == 0)
+  {
+    gpsMailbox.publish(captureFix()); // Solo con una frase NMEA completa: no se copia en cada vuelta
+  }
+}
+
+void SensorManager::atmosphericTaskStep()
+{
+  StampedSample stamped;
+  stamped.sample = takeAtmosphericSample(stamped.timestamp);
+  if (!atmosQueue.push(stamped))
+  {
+    Serial.println("ADVERTENCIA: cola atmosférica llena (la tarea de radio no la vacía), se descarta la muestra.");
+  }
+}
+
+void SensorManager::groundTaskStep()
+{
+  uint32_t due = groundDueAt.load();
+  if ((int32_t)(millis() - due) < 0)
+  {
+    return;
+  }
+  readGroundGpsSensors(); // RS485 con sus timeouts: bloquea solo esta tarea
+  GroundReading reading;
+  reading.packet = groundGpsPacket();
+  reading.readAt = millis();
+  reading.number = ++groundReadings;
+  groundMailbox.publish(reading);
+
+  // Siguiente desde el momento fijado, no desde el fin de la lectura: no se corre ~3 s por vuelta
+  uint32_t next = due + groundPeriodMs.load();
+  if ((int32_t)(next - reading.readAt) <= 0)
+  {
+    next = reading.readAt + groundPeriodMs.load(); // Primera lectura o vueltas salteadas
+  }
+  groundDueAt.compare_exchange_strong(due, next); // Si alignGroundReads() lo movió mientras tanto, gana ese
+}
+
+void SensorManager::alignGroundReads(uint16_t intervalS)
+{
+  uint32_t period = (uint32_t)intervalS * 1000UL;
+  uint32_t lead = GROUND_PREFETCH_LEAD_MS < period / 2 ? GROUND_PREFETCH_LEAD_MS : period / 2;
+  groundPeriodMs.store(period);
+  groundDueAt.store(millis() + period - lead);
+}
+
+uint8_t SensorManager::drainAtmosphericQueue()
+{
+  StampedSample stamped;
+  uint8_t moved = 0;
+  while (atmosQueue.pop(stamped))
+  {
+    atmosRing.push(stamped.sample, stamped.timestamp);
+    moved++;
+  }
+  return moved;
+}
+
+bool SensorManager::latestGroundGps(GroundReading &reading) const
+{
+  return groundMailbox.read(reading);
 }
\ No newline at end of file
@@ -12,6 +12,8 @@
 #include <DHT_U.h>     // Incluye la librería de utilidades para DHT (también de Adafruit)
 #include "voltage_reader.h" // Incluye la clase VoltageReader para lectura de voltaje
 #include "rs485_manager.h"  // Incluye la clase RS485Manager para comunicación con módulo sensor
+#include "sample_ring.h"
+#include "task_channels.h"   // Canales entre tareas con NodeTasks
 
 #define GPS_COORDINATE_HISTORY_SIZE 5 // Número de coordenadas a guardar (puedes ajustar)
 
@@ -52,6 +54,70 @@ private:
   GpsCoordinate gpsHistory[GPS_COORDINATE_HISTORY_SIZE];
   int gpsHistoryIndex = 0;
 
+public:
+  /**
+   * @struct GpsFix
+   * @brief Lo decodificado por TinyGPSPlus, copiado para leerlo desde otra tarea (NodeTasks).
+   */
+  struct GpsFix {
+      bool timeValid;
+      uint8_t hour;
+      uint8_t minute;
+      uint8_t second;
+      bool dateValid;
+      uint16_t year;
+      uint8_t month;
+      uint8_t day;
+      bool locationValid;
+      double latitude;
+      double longitude;
+      uint32_t locationAge;
+      bool altitudeValid;
+      double altitude;
+      uint32_t satellites;
+      double hdop;
+      uint32_t charsProcessed;
+      uint32_t sentencesWithFix;
+      uint32_t failedChecksum;
+      uint32_t passedChecksum;
+      GpsCoordinate lastCoordinate;  ///< Última coordenada de saveGpsCoordinatePeriodically()
+  };
+
+  /**
+   * @struct GroundReading
+   * @brief Lectura de suelo, energía y GPS de la tarea RS485, con su momento y número.
+   */
+  struct GroundReading {
+      Protocol::GroundGpsPacket packet;
+      uint32_t readAt;  ///< millis() al terminar la lectura
+      uint32_t number;  ///< Lecturas desde el arranque (1 = la primera)
+  };
+
+private:
+  /**
+   * @struct StampedSample
+   * @brief Muestra atmosférica con su marca de tiempo, de la tarea atmosférica a la de radio.
+   */
+  struct StampedSample {
+      Protocol::AtmosphericSample sample;
+      uint32_t timestamp;
+  };
+
+  bool taskMode = false;                                 ///< NodeTasks en marcha: ver enableTaskMode()
+  SpscQueue<StampedSample, ATMOS_QUEUE_DEPTH> atmosQueue; ///< Tarea atmosférica -> tarea de radio
+  Mailbox<GpsFix> gpsMailbox;                            ///< Tarea GPS -> tareas atmosférica y RS485
+  Mailbox<GroundReading> groundMailbox;                  ///< Tarea RS485 -> tarea de radio
+  uint32_t groundReadings = 0;                           ///< Lecturas de la tarea RS485 (solo ella lo escribe)
+  std::atomic<uint32_t> groundDueAt{0};                  ///< millis() de la próxima lectura RS485
+  std::atomic<uint32_t> groundPeriodMs{GROUND_READ_INTERVAL_MS}; ///< Intervalo del gateway o GROUND_READ_INTERVAL_MS
+
+  // Copia el estado de TinyGPSPlus; solo desde quien lee el UART del GPS
+  GpsFix captureFix();
+  // Fix vigente: el publicado por la tarea GPS o, sin tareas, el de TinyGPSPlus
+  GpsFix currentFix();
+  // Lee el DHT y arma la muestra con la hora del GPS
+  Protocol::AtmosphericSample takeAtmosphericSample(uint32_t &timestamp);
+
   // Método privado para simular o leer sensores atmosfera temp y humedad
   void readAtmosphericSensors();
   // Método privado para simular o leer sensores en tierra npk,humedad,temp,ph,ec(electroconductividad)
@@ -67,20 +133,31 @@ private:
 public:
   // Almacenamiento de los datos
   // Almacenamiento interno de los datos
-  Protocol::AtmosphericSample atmosSamples[NUMERO_MUESTRAS_ATMOSFERICAS]; // Ejemplo: array para 8 muestras
+  SampleRing atmosRing;                   ///< Muestras atmosféricas; written() cambia con cada muestra nueva
   Protocol::GroundSensor groundData;
   Protocol::GpsSensor gpsData;
   Protocol::EnergyData energyData;
-  int atmosSampleCount = 0;               ///< Contador de muestras atmosféricas almacenadas
   // Constructor (opcionalmente inicializar sensores aquí)
   SensorManager();
-  void begin();
+  /**
+   * @brief Inicializa GPS, DHT, VoltageReader y RS485.
+   * @param quick true tras un despertar de deep sleep: se omite el handshake RS485 (hasta 5 s), ya hecho en el arranque en frío.
+   */
+  void begin(bool quick = false);
   // actualiza recurrentemente lecturas atmosfericas
   void update(); // TODO: llamar recurentemente a clase para tomar valores atmosfericos cada x tiempo
   // Método para recolectar datos de los sensores
   void readGroundGpsSensors();
-  // Método para recolectar datos de los sensores
+  /**
+   * @brief Completa el anillo hasta un lote (NUMERO_MUESTRAS_ATMOSFERICAS) si todavía no lo hay.
+   * @details Solo actúa tras el arranque en frío: después el anillo siempre tiene un lote.
+   */
   void readSensorsAtmospheric();
+  /**
+   * @brief Toma una muestra atmosférica ahora (LOW_POWER_MODE, en lugar de update()).
+   * @param gpsWaitMs Espera máxima de una hora válida del GPS: tras un deep sleep TinyGPSPlus empieza sin datos.
+   */
+  void sampleAtmospheric(unsigned long gpsWaitMs);
   
   /**
    * @brief Obtiene información de debug del VoltageReader.
@@ -120,5 +197,46 @@ public:
   void debugGPS();
 
   GpsCoordinate getLastGpsCoordinate() const;
+
+  /**
+   * @brief Arma el paquete DATA_GPS_CROUND con la última lectura de suelo, energía y GPS.
+   */
+  Protocol::GroundGpsPacket groundGpsPacket();
+
+  // --- Modo tareas (NodeTasks) ---
+  /**
+   * @brief Pasa al modo tareas: cada tarea usa solo su periférico y los datos cruzan por task_channels.h.
+   * @details Desde entonces update() no se llama; lo reemplazan los *TaskStep().
+   */
+  void enableTaskMode();
+  bool isTaskMode() const;
+  /**
+   * @brief Tarea GPS: vacía el UART en TinyGPSPlus, guarda la coordenada periódica y publica el fix.
+   */
+  void gpsTaskStep();
+  /**
+   * @brief Tarea atmosférica: lee el DHT y encola la muestra para la tarea de radio.
+   */
+  void atmosphericTaskStep();
+  /**
+   * @brief Tarea RS485: si toca, lee suelo, energía y GPS y publica la lectura para la tarea de radio.
+   * @details Llamarla seguido (cada ~1 s); lee en el momento fijado por alignGroundReads().
+   */
+  void groundTaskStep();
+  /**
+   * @brief Tarea de radio: agenda la próxima lectura RS485 GROUND_PREFETCH_LEAD_MS antes
+   * del próximo pedido de suelo, que llega en intervalS segundos.
+   */
+  void alignGroundReads(uint16_t intervalS);
+  /**
+   * @brief Tarea de radio: pasa al anillo las muestras encoladas por la tarea atmosférica.
+   * @return Muestras pasadas.
+   */
+  uint8_t drainAtmosphericQueue();
+  /**
+   * @brief Última lectura publicada por la tarea RS485, sin esperar el bus.
+   * @return false si todavía no terminó ninguna lectura.
+   */
+  bool latestGroundGps(GroundReading &reading) const;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file task_channels.h
+ * @brief Canales sin bloqueo entre las tareas FreeRTOS del nodo (NodeTasks)
+ * @date 2025
+ *
+ * Las tareas corren en los dos núcleos del ESP32 y no comparten objetos: se
+ * pasan copias por estos canales, sin mutex ni secciones críticas, así una
+ * tarea lenta (una transacción RS485 de hasta ~3 s) nunca frena a la radio.
+ *
+ * - SpscQueue: FIFO de un productor y un consumidor (muestras atmosféricas).
+ * - Mailbox: el último valor publicado, un escritor y varios lectores (fix del
+ *   GPS, paquete de suelo). Es un seqlock: el lector copia y reintenta si la
+ *   copia se cruzó con una escritura. El escritor no debe poder ser desplazado
+ *   por un lector del mismo núcleo (prioridad mayor o igual, u otro núcleo).
+ *
+ * Solo usan std::atomic de 32 bits, que en el ESP32 son instrucciones sin bloqueo.
+ */
+
+#ifndef TASK_CHANNELS_H
+#define TASK_CHANNELS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * @class SpscQueue
+ * @brief Cola FIFO acotada de un productor y un consumidor, por valor.
+ * @tparam N Capacidad; potencia de dos para que los índices den la vuelta sin saltos.
+ *
+ * @example
+ * ```cpp
+ * SpscQueue<Muestra, 8> cola;
+ * cola.push(m);           // Tarea productora
+ * while (cola.pop(m)) {}  // Tarea consumidora
+ * ```
+ */
+template <typename T, uint8_t N>
+class SpscQueue
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue: N debe ser potencia de dos");
+
+public:
+    /**
+     * @brief Encola una copia (solo el productor)
+     * @return false si la cola está llena
+     */
+    bool push(const T &item)
+    {
+        uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) >= N) {
+            fullCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[tail % N] = item;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Saca el elemento más viejo (solo el consumidor)
+     * @return false si la cola está vacía
+     */
+    bool pop(T &item)
+    {
+        uint32_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[head % N];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint8_t count() const
+    {
+        return (uint8_t)(tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief push() rechazados por cola llena desde el arranque
+     */
+    uint32_t overflows() const
+    {
+        return fullCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    T items[N];
+    std::atomic<uint32_t> headIndex{0};  ///< Próximo a sacar; solo lo escribe el consumidor
+    std::atomic<uint32_t> tailIndex{0};  ///< Próximo a escribir; solo lo escribe el productor
+    std::atomic<uint32_t> fullCount{0};
+};
+
+/**
+ * @class Mailbox
+ * @brief Último valor publicado por una tarea, legible desde otras sin bloquear al escritor.
+ *
+ * @example
+ * ```cpp
+ * Mailbox<Fix> fix;
+ * fix.publish(actual);               // Tarea escritora
+ * Fix copia;
+ * if (fix.read(copia)) usar(copia);  // Cualquier otra tarea
+ * ```
+ */
+template <typename T>
+class Mailbox
+{
+public:
+    /**
+     * @brief Reemplaza el valor (solo el escritor)
+     */
+    void publish(const T &value)
+    {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);  // Impar: escritura en curso
+        std::atomic_thread_fence(std::memory_order_release);
+        data = value;
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copia el último valor publicado
+     * @return false si todavía no se publicó ninguno
+     */
+    bool read(T &value) const
+    {
+        for (;;) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            if (before & 1) {
+                continue;  // El escritor está a mitad de copia (en el otro núcleo)
+            }
+            value = data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief Publicaciones desde el arranque (cambia con cada publish())
+     */
+    uint32_t version() const
+    {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    T data;
+    std::atomic<uint32_t> sequence{0};  ///< Par: estable; impar: escribiendo
+};
+
+#endif // TASK_CHANNELS_H